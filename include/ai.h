@@ -0,0 +1,92 @@
+#ifndef __AI_H__
+#define __AI_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game.h"
+#include "lookahead.h"
+
+#define AI_SCAN_ANGLES 48 // headings swept for a bouncing shot, a few per tick
+
+/**
+ * One CPU player: the tank it drives and what it keeps between ticks.
+ */
+typedef struct ai_player {
+  bool enabled;
+  lookahead_t *lookahead; // searches the player's buttons instead, when not NULL
+  uint8_t held; // the buttons applied last tick
+  // the distance in cells from every cell to the target's, by cell index
+  uint16_t *distances;
+  size_t cells;
+  maze_t *maze; // the maze, generation and revision the distances were found in
+  size_t maze_generation;
+  size_t maze_revision;
+  size_t target_cell;
+  size_t path_builds;
+  // the sweep for a heading whose shot reaches the target, bounces included
+  size_t scan_next;
+  double aim_angle;
+  size_t aim_age; // ticks since the sweep last found aim_angle; above AI_SCAN_ANGLES it is stale
+  size_t fire_cooldown; // ticks until it may fire again
+  vector_t last_center;
+  size_t stuck_ticks;
+  size_t reverse_ticks; // ticks left backing out of a wall it drove into
+  // the time spent deciding
+  double think_time;
+  double worst_time;
+  size_t thinks;
+  size_t late; // ticks it took longer than the budget
+  size_t over_budget; // ticks it skipped the sweep to stay within the budget
+} ai_player_t;
+
+/**
+ * The CPU players of a match.
+ */
+typedef struct ai {
+  ai_player_t players[INPUT_PLAYERS]; // red, green, blue
+  double budget; // seconds each player may spend per tick
+} ai_t;
+
+/**
+ * Creates the CPU players of a match.
+ *
+ * @param tanks bit i set if tank i (0 red, 1 green, 2 blue) is driven by the computer
+ * @return the new players
+ */
+ai_t *ai_init(uint8_t tanks);
+
+/**
+ * Releases the memory allocated for the CPU players.
+ *
+ * @param ai a pointer returned from ai_init()
+ */
+void ai_free(ai_t *ai);
+
+/**
+ * Lets a CPU player choose its buttons by searching futures of the match
+ * on worker threads, with lookahead_tick(), instead of reacting to it.
+ *
+ * @param ai the CPU players
+ * @param state the match
+ * @param player the tank: 0 red, 1 green, 2 blue
+ * @param workers the number of worker threads searching for it
+ * @param min_rollouts the futures each of its decisions waits for; 0 never waits
+ * @return false, leaving the player as it was, if the match's maze is too large to search
+ */
+bool ai_use_lookahead(ai_t *ai, state_t *state, size_t player, size_t workers, size_t min_rollouts);
+
+/**
+ * Lets every CPU player choose its buttons and applies them with
+ * game_apply_buttons(), the way a human's keys are applied. Each player
+ * heads for the nearest enemy along the maze's cell graph, backs away
+ * from projectiles that would reach it, and fires when a shot, bounces
+ * included, would reach its target before itself.
+ * Must be called on the thread that runs game_tick(), before it.
+ *
+ * @param ai the CPU players
+ * @param state the match
+ */
+void ai_tick(ai_t *ai, state_t *state);
+
+#endif // #ifndef __AI_H__
@@ -0,0 +1,70 @@
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the longest asset name, including the terminating '\0'
+#define ASSET_NAME_LENGTH 56
+
+/**
+ * One entry of the index at the start of an archive.
+ * Offsets are from the start of the archive.
+ */
+typedef struct asset_entry {
+  char name[ASSET_NAME_LENGTH];
+  uint64_t offset;
+  uint64_t size;
+} asset_entry_t;
+
+/**
+ * A packed asset archive mapped into memory.
+ * The file starts with a header (magic, version, entry count), followed by
+ * the index sorted by name, followed by the raw contents of every asset.
+ * Lookups return pointers into the mapping, so no asset is copied.
+ */
+typedef struct asset_archive {
+  const uint8_t *data;
+  size_t size;
+  const asset_entry_t *entries;
+  size_t count;
+  bool mapped;
+} asset_archive_t;
+
+/**
+ * Maps an archive into memory.
+ *
+ * @param path the path of the archive
+ * @return the archive, or NULL if it is missing or malformed
+ */
+asset_archive_t *assets_open(const char *path);
+
+/**
+ * Unmaps an archive. Every pointer returned by assets_find() becomes invalid.
+ *
+ * @param archive a pointer returned from assets_open()
+ */
+void assets_close(asset_archive_t *archive);
+
+/**
+ * Looks up an asset by name.
+ *
+ * @param archive the archive, may be NULL
+ * @param name the name the asset was packed under (e.g. "assets/normalshot.wav")
+ * @param size receives the size of the asset in bytes
+ * @return a pointer to the contents of the asset, or NULL if it is not in the archive
+ */
+const void *assets_find(asset_archive_t *archive, const char *name, size_t *size);
+
+/**
+ * Packs files into an archive, naming each entry by its path.
+ *
+ * @param archive_path the path of the archive to write
+ * @param paths the files to pack
+ * @param count the number of files
+ * @return whether the archive was written
+ */
+bool assets_pack(const char *archive_path, const char **paths, size_t count);
+
+#endif // #ifndef __ASSETS_H__
@@ -0,0 +1,46 @@
+#ifndef __AUDIO_H__
+#define __AUDIO_H__
+
+#include <stddef.h>
+
+typedef enum {
+  SOUND_NORMAL_SHOT,
+  SOUND_RAILGUN_SHOT,
+  SOUND_LASER_SHOT,
+  SOUND_SHOTGUN_SHOT,
+  SOUND_MOON_SHOT,
+  SOUND_EMPTY_SHOT,
+  SOUND_DEATH,
+  SOUND_CANNON_EVENT,
+  SOUND_COUNT
+} sound_id_t;
+
+typedef void (*sound_player_t)(void *aux, sound_id_t id);
+
+/**
+ * Where the game sends its sound effects. The game only names the sound;
+ * the front end decides whether and how it is played, so the simulation
+ * runs the same without an audio device.
+ */
+typedef struct audio {
+  sound_player_t play;
+  void *aux;
+} audio_t;
+
+/**
+ * Returns an audio sink that drops every sound.
+ *
+ * @return the silent sink
+ */
+audio_t audio_silent();
+
+/**
+ * Plays a sound effect through an audio sink.
+ * Does nothing if the sink is silent.
+ *
+ * @param audio the sink
+ * @param id the sound to play
+ */
+void audio_play(const audio_t *audio, sound_id_t id);
+
+#endif // #ifndef __AUDIO_H__
@@ -0,0 +1,205 @@
+#ifndef __BOTLINK_H__
+#define __BOTLINK_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+#define BOTLINK_MAGIC 0x4b4e4c42 // "BLNK" in little-endian memory
+#define BOTLINK_VERSION 1
+#define BOTLINK_RING_CAPACITY 64 // observations; a power of two
+#define BOTLINK_MAX_PROJECTILES 256 // more are left out of an observation and counted in projectiles_left_out
+#define BOTLINK_MAX_POWERUPS 16
+#define BOTLINK_MAX_CELLS 1024
+#define BOTLINK_CACHE_LINE 64
+
+/**
+ * The layout below is the interface: every field has a fixed size and
+ * the structs have no implicit padding, so a Python (numpy, ctypes) or C++
+ * process can map the segment and read it without this header. An
+ * _Atomic uint64_t or uint32_t is laid out as the plain integer.
+ */
+
+typedef struct botlink_tank {
+  float x;
+  float y;
+  float angle;
+  float vx;
+  float vy;
+  uint8_t alive;
+  uint8_t flags; // the movement flags as buttons, 1 << INPUT_FORWARD and so on
+  uint8_t shot_kind; // the projectile_kind_t it fires next
+  uint8_t special_shots; // left of the powerup it holds
+  uint32_t bullets; // normal bullets on screen, at most BULLET_LIMIT
+} botlink_tank_t;
+
+typedef struct botlink_projectile {
+  float x;
+  float y;
+  float vx;
+  float vy;
+  uint8_t kind; // projectile_kind_t
+  uint8_t owner; // the tank that fired it, red, green, blue
+  uint16_t reserved;
+} botlink_projectile_t;
+
+typedef struct botlink_powerup {
+  float x;
+  float y;
+  uint32_t type; // powerup_type_t
+} botlink_powerup_t;
+
+/**
+ * The match after one tick. Tanks are in the order red, green, blue, the
+ * same order the control masks use.
+ */
+typedef struct botlink_observation {
+  uint64_t sequence; // 1 for the first observation published; controls answering it carry this number
+  uint64_t tick; // ticks the match has played
+  uint32_t maze_generation;
+  uint32_t maze_revision;
+  uint32_t tank_controls; // which tank each set of keyboard controls drives; bots address tanks directly
+  float countdown; // seconds until the next game, 0 during a game
+  uint32_t columns;
+  uint32_t rows;
+  float lower_left_x;
+  float lower_left_y;
+  float upper_right_x;
+  float upper_right_y;
+  uint32_t projectile_count;
+  uint32_t powerup_count;
+  uint32_t projectiles_left_out;
+  botlink_tank_t tanks[INPUT_PLAYERS];
+  botlink_projectile_t projectiles[BOTLINK_MAX_PROJECTILES];
+  botlink_powerup_t powerups[BOTLINK_MAX_POWERUPS];
+  uint8_t cell_walls[BOTLINK_MAX_CELLS]; // WALL_* bits by cell index, x + columns * y
+} botlink_observation_t;
+
+/**
+ * The shared segment. The game is the only writer of the ring and head,
+ * the bot the only writer of tail and the controls, so neither side ever
+ * takes a lock: each publishes with a release store and reads the other's
+ * counter with an acquire load.
+ */
+typedef struct botlink_shared {
+  _Atomic uint32_t magic; // written last by the game, so a bot reads the rest of the header only after it
+  uint32_t version;
+  uint32_t shared_size; // sizeof(botlink_shared_t)
+  uint32_t observation_size; // sizeof(botlink_observation_t)
+  uint32_t ring_capacity;
+  uint32_t lockstep; // 1 if the game waits each tick for controls answering its newest observation
+  uint8_t header_padding[BOTLINK_CACHE_LINE - 6 * sizeof(uint32_t)];
+  _Atomic uint64_t head; // observations published; written by the game
+  _Atomic uint32_t closed; // set by the game when it stops
+  uint8_t head_padding[BOTLINK_CACHE_LINE - sizeof(uint64_t) - sizeof(uint32_t)];
+  _Atomic uint64_t tail; // observations consumed; written by the bot
+  _Atomic uint64_t answered; // the sequence of the observation the controls answer, 0 before any; written after them
+  _Atomic uint32_t controls; // byte i holds the buttons of tank i; bit 7 of a byte is unused
+  _Atomic uint32_t attached; // set by the bot while it is connected
+  uint8_t tail_padding[BOTLINK_CACHE_LINE - 2 * sizeof(uint64_t) - 2 * sizeof(uint32_t)];
+  botlink_observation_t ring[BOTLINK_RING_CAPACITY]; // observation n is in slot n % ring_capacity
+} botlink_shared_t;
+
+/**
+ * One side's handle on the segment.
+ */
+typedef struct botlink {
+  botlink_shared_t *shared;
+  char name[64];
+  bool owner; // the game side, which created the segment and unlinks it
+  uint8_t held[INPUT_PLAYERS]; // the game side: buttons last applied to each tank, for shot edges
+  size_t dropped; // the game side: observations not published because the ring was full
+  bool bot_seen; // the game side: a bot has attached since the link was created
+} botlink_t;
+
+/**
+ * Creates the shared segment for a match, replacing any left over under
+ * the same name.
+ *
+ * @param name a POSIX shared memory name, such as "/tanks"
+ * @param lockstep whether the game waits for the bot every tick
+ * @param cells the number of cells in the match's maze
+ * @return the link, or NULL if the segment could not be created or the
+ *   maze has more than BOTLINK_MAX_CELLS cells
+ */
+botlink_t *botlink_create(const char *name, bool lockstep, size_t cells);
+
+/**
+ * Maps a segment created by botlink_create(), from the bot's process.
+ *
+ * @param name the name the game created it under
+ * @return the link, or NULL if there is no such segment or its layout differs
+ */
+botlink_t *botlink_attach(const char *name);
+
+/**
+ * Detaches from the segment; the game side also tells the bot it stopped
+ * and removes the name.
+ *
+ * @param link a pointer returned from botlink_create() or botlink_attach()
+ */
+void botlink_free(botlink_t *link);
+
+/**
+ * Fills an observation from a match.
+ *
+ * @param observation the observation to fill
+ * @param state the match
+ */
+void botlink_observe(botlink_observation_t *observation, state_t *state);
+
+/**
+ * Writes an observation of the match into the next free slot of the ring.
+ * If the bot has not consumed the oldest one yet, the observation is
+ * dropped and counted instead.
+ *
+ * @param link the game side of the link
+ * @param state the match
+ * @return the sequence number of the observation, 0 if it was dropped
+ */
+uint64_t botlink_publish(botlink_t *link, state_t *state);
+
+/**
+ * Waits until a bot has answered an observation, spinning briefly and
+ * then yielding the processor. Before the first bot attaches it waits
+ * however long that takes.
+ *
+ * @param link the game side of the link
+ * @param sequence the sequence number of the observation
+ * @param timeout seconds to wait once a bot is attached
+ * @return false if the bot did not answer in time or detached
+ */
+bool botlink_wait_controls(botlink_t *link, uint64_t sequence, double timeout);
+
+/**
+ * Drives each tank with the buttons the bot wrote for it, through
+ * game_apply_input() so a recorded match replays without the bot.
+ * Movement buttons are levels: a tank's flags are made to match them,
+ * including right after it spawns. Shoot is an edge: a tank fires when
+ * the bit is set and was clear the last time controls were applied.
+ *
+ * @param link the game side of the link
+ * @param state the match
+ */
+void botlink_apply_controls(botlink_t *link, state_t *state);
+
+/**
+ * Takes the oldest observation the bot has not read.
+ *
+ * @param link the bot side of the link
+ * @param observation where it is copied
+ * @return false if there is none
+ */
+bool botlink_next_observation(botlink_t *link, botlink_observation_t *observation);
+
+/**
+ * Publishes the buttons for every tank, answering an observation.
+ *
+ * @param link the bot side of the link
+ * @param buttons a bit (1 << action) for each input_action_t held, by tank
+ * @param sequence the sequence number of the observation answered
+ */
+void botlink_send_controls(botlink_t *link, const uint8_t buttons[INPUT_PLAYERS], uint64_t sequence);
+
+#endif // #ifndef __BOTLINK_H__
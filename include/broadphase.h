@@ -0,0 +1,88 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include <stddef.h>
+#include "vector.h"
+
+/**
+ * A uniform grid used to find pairs of nearby objects without testing every pair.
+ * Objects are approximated by bounding circles and bucketed by the cell of their
+ * center with a counting sort, so the grid is rebuilt from scratch every tick in
+ * O(objects + cells). Bounding circles must not be wider than a cell.
+ */
+typedef struct broadphase {
+  vector_t lower_left;
+  double cell_size;
+  size_t columns;
+  size_t rows;
+  size_t capacity;
+  size_t count;
+  size_t *ids;
+  size_t *groups;
+  float *x;
+  float *y;
+  float *radius;
+  size_t *cells;
+  size_t *sorted;
+  size_t *cell_start;
+} broadphase_t;
+
+/**
+ * Allocates a grid covering lower_left to upper_right.
+ *
+ * @param lower_left the lower left corner of the covered area
+ * @param upper_right the upper right corner of the covered area
+ * @param cell_size the edge length of a grid cell
+ * @param capacity the maximum number of objects
+ * @return the new grid
+ */
+broadphase_t *broadphase_init(vector_t lower_left, vector_t upper_right, double cell_size, size_t capacity);
+
+/**
+ * Releases the memory allocated for a grid.
+ *
+ * @param broadphase a pointer returned from broadphase_init()
+ */
+void broadphase_free(broadphase_t *broadphase);
+
+/**
+ * Removes every object from the grid.
+ *
+ * @param broadphase the grid
+ */
+void broadphase_clear(broadphase_t *broadphase);
+
+/**
+ * Adds an object to the grid. Objects past the capacity are ignored.
+ * broadphase_build() must be called before querying.
+ *
+ * @param broadphase the grid
+ * @param id a caller-defined identifier returned by the queries
+ * @param group objects of the same group are never paired; give each object its own to pair them all
+ * @param center the center of the bounding circle
+ * @param radius the radius of the bounding circle
+ */
+void broadphase_insert(broadphase_t *broadphase, size_t id, size_t group, vector_t center, double radius);
+
+/**
+ * Buckets the inserted objects by cell.
+ *
+ * @param broadphase the grid
+ */
+void broadphase_build(broadphase_t *broadphase);
+
+/**
+ * Finds the pairs of objects of different groups whose bounding circles
+ * overlap. Each pair is reported once; enumeration stops after max_pairs
+ * pairs, which bounds the cost of the narrow phase that follows. Pairs
+ * within a group are skipped before they count toward max_pairs.
+ *
+ * @param broadphase the grid
+ * @param first receives the id of the first object of each pair
+ * @param second receives the id of the second object of each pair
+ * @param max_pairs the size of first and second
+ * @return the number of pairs found
+ */
+size_t broadphase_pairs(broadphase_t *broadphase, size_t *first, size_t *second, size_t max_pairs);
+
+#endif // #ifndef __BROADPHASE_H__
@@ -0,0 +1,60 @@
+#ifndef __CAMERA_H__
+#define __CAMERA_H__
+
+#include <stddef.h>
+#include "vector.h"
+
+/**
+ * A view onto an arena that may be larger than the window.
+ * The view always has the window's aspect ratio, never shows the arena
+ * magnified, and never leaves the arena unless the arena is smaller than
+ * the view along some axis (then it is centered along that axis).
+ */
+typedef struct camera {
+  vector_t arena_lower_left;
+  vector_t arena_upper_right;
+  vector_t window;
+  vector_t center;
+  vector_t half_extent;
+} camera_t;
+
+/**
+ * Creates a camera showing as much of the arena as fits at the
+ * window's scale, centered on the arena.
+ *
+ * @param lower_left the lower left corner of the arena
+ * @param upper_right the upper right corner of the arena
+ * @param window the size of the window, in scene units at full scale
+ * @return the camera
+ */
+camera_t camera_init(vector_t lower_left, vector_t upper_right, vector_t window);
+
+/**
+ * Moves the camera towards a view containing every given point,
+ * zooming out as far as showing the whole arena if needed.
+ *
+ * @param camera the camera
+ * @param points the points to keep in view
+ * @param count the number of points
+ * @param margin the space to keep around each point
+ * @param dt the time since the last update; 0 snaps the camera to the target
+ */
+void camera_follow(camera_t *camera, const vector_t *points, size_t count, double margin, double dt);
+
+/**
+ * Returns the lower left corner of the area the camera shows.
+ *
+ * @param camera the camera
+ * @return the lower left corner of the view
+ */
+vector_t camera_lower_left(const camera_t *camera);
+
+/**
+ * Returns the upper right corner of the area the camera shows.
+ *
+ * @param camera the camera
+ * @return the upper right corner of the view
+ */
+vector_t camera_upper_right(const camera_t *camera);
+
+#endif // #ifndef __CAMERA_H__
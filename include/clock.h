@@ -0,0 +1,12 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+/**
+ * Returns the time on a monotonic clock, which every budget, timeout and
+ * timing of the game is measured on.
+ *
+ * @return the time, in seconds, from an arbitrary start
+ */
+double clock_now();
+
+#endif // #ifndef __CLOCK_H__
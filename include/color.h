@@ -1,6 +1,8 @@
 #ifndef __COLOR_H__
 #define __COLOR_H__
 
+#include <stddef.h>
+
 /**
  * A color to display on the screen.
  * The color is represented by its red, green, and blue components.
@@ -29,4 +31,20 @@ rgb_color_t hsv_to_rgb(hsv_color_t hsv);
 
 hsv_color_t rgb_to_hsv(rgb_color_t rgb);
 
+/**
+ * Converts count hsv colors given as separate arrays into rgb.
+ * The loop has no branches or table lookups, so the compiler vectorizes it.
+ * Hues may be outside 0~360 and are wrapped. The arrays must not overlap.
+ *
+ * @param h the hues
+ * @param s the saturations, 0~1
+ * @param v the values, 0~1
+ * @param r where the red components are stored
+ * @param g where the green components are stored
+ * @param b where the blue components are stored
+ * @param count the number of colors
+ */
+void hsv_to_rgb_batch(const float *restrict h, const float *restrict s, const float *restrict v,
+                      float *restrict r, float *restrict g, float *restrict b, size_t count);
+
 #endif // #ifndef __COLOR_H__
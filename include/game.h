@@ -0,0 +1,154 @@
+#ifndef __GAME_H__
+#define __GAME_H__
+
+#include "audio.h"
+#include "input.h"
+#include "powerups.h"
+#include "replay.h"
+#include "snapshot.h"
+
+// the window the game is laid out for; the arena is ARENA_SCALE windows wide and high
+#define GAME_WINDOW ((vector_t){.x = 1000., .y = 500.})
+
+/**
+ * Returns the default configuration: a 10 by 5 maze with the score not kept
+ * across runs.
+ *
+ * @param seed the seed of the match's random numbers
+ * @return the configuration
+ */
+game_config_t game_default_config(uint64_t seed);
+
+/**
+ * Creates a match: the maze, the three tanks and everything they need.
+ * Touches no window, audio device or clock, so the front end decides how
+ * the match is shown and paced. The front end keeps its own snapshots,
+ * pacers, key queue, recorder and CPU players beside the state.
+ *
+ * Everything random in the match is drawn from its own generator, so
+ * matches may run on several threads at once and the same configuration
+ * gives the same maze and spawns.
+ *
+ * @param config the maze size, seed and scorekeeping of the match
+ * @param audio where the sound effects go
+ * @return the new state
+ */
+state_t *game_init(game_config_t config, audio_t audio);
+
+/**
+ * Creates a tank and adds its bodies and its collision with the maze to
+ * the match's scene.
+ *
+ * @param state the state
+ * @param init_pos the center of the tank
+ * @param color the color of the tank
+ * @return the new tank
+ */
+tank_t *tank_player_init_force(state_t *state, vector_t init_pos, rgb_color_t color);
+
+/**
+ * Returns the tank a set of keyboard controls drives, which a cannon
+ * event can change.
+ *
+ * @param state the state
+ * @param controls the set of controls, as input_event_t.player
+ * @return the tank: 0 red, 1 green, 2 blue
+ */
+size_t game_input_tank(state_t *state, size_t controls);
+
+/**
+ * Applies a control pressed or released by a player, and logs it for
+ * game_record_tick().
+ * Must be called on the thread that runs game_tick().
+ *
+ * @param state the state
+ * @param event the input
+ */
+void game_apply_input(state_t *state, input_event_t event);
+
+/**
+ * Returns the movement flags a tank holds as buttons.
+ *
+ * @param tank the tank
+ * @return a bit (1 << action) for each movement input_action_t held
+ */
+uint8_t game_tank_buttons(tank_t *tank);
+
+/**
+ * Drives a tank with a set of buttons, through game_apply_input() so a
+ * recorded match replays without whatever chose them. Movement buttons
+ * are levels: the tank's flags are made to match them, including right
+ * after it spawns. Shoot is an edge: the tank fires when the bit is set
+ * and clear in the buttons applied before.
+ *
+ * @param state the state
+ * @param player the tank: 0 red, 1 green, 2 blue
+ * @param buttons a bit (1 << action) for each input_action_t held
+ * @param held the buttons applied to the tank the time before
+ */
+void game_apply_buttons(state_t *state, size_t player, uint8_t buttons, uint8_t held);
+
+/**
+ * Advances the match by one step: game over checks, the scene, particles,
+ * projectiles, powerup spawns and tank movement.
+ * The step is rounded to a whole 1 / REPLAY_DT_UNITS of a second, so a
+ * replay reproduces it exactly.
+ *
+ * @param state the state
+ * @param dt the length of the step, in seconds
+ */
+void game_tick(state_t *state, double dt);
+
+/**
+ * Records the last tick into a replay: the inputs applied before it, its
+ * dt and the hash of the state after it. Call it after every game_tick()
+ * of a recorded match.
+ *
+ * @param state the state
+ * @param recorder the replay being written
+ */
+void game_record_tick(state_t *state, replay_writer_t *recorder);
+
+/**
+ * Hashes what decides the outcome of a match: the tanks, the projectiles,
+ * the maze revision and the random streams. Two runs of a match agree on
+ * the hash after every tick unless they have diverged.
+ *
+ * @param state the state
+ * @return the hash
+ */
+uint32_t game_hash(state_t *state);
+
+/**
+ * Returns the configuration a replay of the match must start from.
+ *
+ * @param state the state
+ * @return the replay header
+ */
+replay_header_t game_replay_header(state_t *state);
+
+/**
+ * Returns the configuration of a recorded match.
+ *
+ * @param header the header of the replay
+ * @return the configuration
+ */
+game_config_t game_replay_config(replay_header_t header);
+
+/**
+ * Copies everything the renderer needs into a snapshot, including the
+ * tread poses and the HUD, which only the game knows how to fill.
+ *
+ * @param state the state
+ * @param snapshot the snapshot to fill
+ */
+void game_capture(state_t *state, frame_snapshot_t *snapshot);
+
+/**
+ * Frees the match.
+ *
+ * @param state a pointer returned from game_init()
+ */
+void game_free(state_t *state);
+
+#endif // #ifndef __GAME_H__
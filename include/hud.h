@@ -0,0 +1,29 @@
+#ifndef __HUD_H__
+#define __HUD_H__
+
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include "snapshot.h"
+
+/**
+ * Builds the glyph atlas texture. Must be called once, on the thread that
+ * renders, before hud_draw().
+ *
+ * @param renderer the renderer the HUD is drawn with
+ */
+void hud_init(SDL_Renderer *renderer);
+
+/**
+ * Draws the scoreboard, ammo, countdown and controls on top of the frame.
+ * Each line of text is a run of textured quads cut from the atlas; a line's
+ * vertices are kept between frames and rebuilt only when its text changes.
+ *
+ * @param renderer the renderer passed to hud_init()
+ * @param hud the HUD values of the snapshot being drawn
+ * @param width the width of the screen in pixels
+ * @param height the height of the screen in pixels
+ * @return the number of draw calls made
+ */
+size_t hud_draw(SDL_Renderer *renderer, const hud_snapshot_t *hud, int width, int height);
+
+#endif // #ifndef __HUD_H__
@@ -0,0 +1,30 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// the number of control sets; which tank a set drives depends on the cannon event
+#define INPUT_PLAYERS 3
+
+typedef enum {
+  INPUT_FORWARD,
+  INPUT_BACKWARD,
+  INPUT_LEFT,
+  INPUT_RIGHT,
+  INPUT_SHOOT,
+  INPUT_ACTION_COUNT
+} input_action_t;
+
+/**
+ * A control pressed or released by one player, independent of the device
+ * it came from. The SDL front end maps keys to these; the headless build
+ * reads them from a script.
+ */
+typedef struct input_event {
+  uint8_t player; // 0: awsd and q, 1: ijkl and u, 2: arrows and space
+  uint8_t action; // an input_action_t
+  bool pressed;
+} input_event_t;
+
+#endif // #ifndef __INPUT_H__
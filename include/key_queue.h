@@ -0,0 +1,54 @@
+#ifndef __KEY_QUEUE_H__
+#define __KEY_QUEUE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input.h"
+
+#define KEY_QUEUE_CAPACITY 256
+
+/**
+ * A lock-free ring of input events with one producer (the thread polling SDL
+ * key events) and one consumer (the simulation thread).
+ * Events that arrive while the ring is full are dropped.
+ */
+typedef struct key_queue {
+  input_event_t events[KEY_QUEUE_CAPACITY];
+  atomic_size_t head; // next event to read
+  atomic_size_t tail; // next slot to write
+} key_queue_t;
+
+/**
+ * Allocates an empty key queue.
+ *
+ * @return the new queue
+ */
+key_queue_t *key_queue_init();
+
+/**
+ * Releases a key queue.
+ *
+ * @param queue a pointer returned from key_queue_init()
+ */
+void key_queue_free(key_queue_t *queue);
+
+/**
+ * Appends an event. Producer thread only.
+ *
+ * @param queue the queue
+ * @param event the event
+ * @return false if the queue was full and the event was dropped
+ */
+bool key_queue_push(key_queue_t *queue, input_event_t event);
+
+/**
+ * Takes the oldest event. Consumer thread only.
+ *
+ * @param queue the queue
+ * @param event where the event is stored
+ * @return false if the queue was empty
+ */
+bool key_queue_pop(key_queue_t *queue, input_event_t *event);
+
+#endif // #ifndef __KEY_QUEUE_H__
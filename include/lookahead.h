@@ -0,0 +1,152 @@
+#ifndef __LOOKAHEAD_H__
+#define __LOOKAHEAD_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game.h"
+#include "rng.h"
+
+#define LOOKAHEAD_MAX_SHOTS 128 // projectiles followed in a future; more are left out
+#define LOOKAHEAD_MAX_CELLS 1024
+#define LOOKAHEAD_CANDIDATES 18 // nine ways to hold the movement buttons, each with and without firing
+
+typedef struct lookahead_worker lookahead_worker_t;
+
+/**
+ * A tank in a simulated future.
+ */
+typedef struct lookahead_tank {
+  vector_t center;
+  vector_t velocity; // applied by the next step, as the scene moves a body by the velocity of the tick before
+  vector_t last_move; // undone if the tank ends a step in a wall, as tank_maze_force() does
+  double angle;
+  uint8_t held; // the buttons of the last step
+  bool alive;
+  size_t bullets; // its shots in flight, at most BULLET_LIMIT
+} lookahead_tank_t;
+
+typedef struct lookahead_shot {
+  vector_t position;
+  vector_t velocity;
+  double radius;
+  double time_left;
+  size_t owner; // 0 red, 1 green, 2 blue
+} lookahead_shot_t;
+
+/**
+ * A match reduced to what its next second depends on. Every field is a
+ * plain value, so a clone is one copy of the used part, with none of the
+ * bodies, lists and forces that tank_init() and body_init_with_info() build.
+ * The walls are not in it: every future of a decision reads the same ones.
+ */
+typedef struct lookahead_world {
+  lookahead_tank_t tanks[INPUT_PLAYERS]; // red, green, blue
+  size_t shot_count;
+  lookahead_shot_t shots[LOOKAHEAD_MAX_SHOTS];
+} lookahead_world_t;
+
+/**
+ * The match a decision is searched from: its world, and the walls and
+ * distance field every future of it shares, read-only.
+ */
+typedef struct lookahead_root {
+  uint64_t serial; // 0 before the first
+  maze_t walls; // the match's bounds, with cell_walls pointing below
+  uint8_t cell_walls[LOOKAHEAD_MAX_CELLS];
+  uint16_t distances[LOOKAHEAD_MAX_CELLS]; // cells from each cell to the nearest enemy of the planned tank
+  uint16_t queue[LOOKAHEAD_MAX_CELLS];
+  lookahead_world_t world;
+} lookahead_root_t;
+
+/**
+ * A search for one tank's buttons. Worker threads play out random short
+ * futures of every candidate from the newest root; the game thread only
+ * publishes roots and reads the scores, so the search never holds up a tick.
+ */
+typedef struct lookahead {
+  size_t player; // the tank searched for: 0 red, 1 green, 2 blue
+  size_t min_rollouts; // futures a decision waits for, 0 to never wait
+  size_t max_rollouts; // futures after which the workers rest until the next root
+  pthread_mutex_t lock;
+  pthread_cond_t root_ready;
+  pthread_cond_t progress;
+  bool stopping;
+  // guarded by lock
+  lookahead_root_t root;
+  double scores[LOOKAHEAD_CANDIDATES]; // summed over the futures of the newest root
+  size_t counts[LOOKAHEAD_CANDIDATES];
+  size_t root_rollouts;
+  size_t rollouts; // every future played out, of any root
+  size_t rollout_ticks;
+  double busy_time; // seconds the workers spent playing them out
+  // the game thread's own
+  lookahead_root_t *staging;
+  size_t decisions;
+  size_t decided_rollouts; // futures behind the decisions made
+  size_t worker_count;
+  lookahead_worker_t **workers;
+} lookahead_t;
+
+/**
+ * Starts the worker threads of a search.
+ *
+ * @param player the tank to search for: 0 red, 1 green, 2 blue
+ * @param workers the number of worker threads, at least 1
+ * @param min_rollouts the futures each decision waits for; 0 never waits
+ *   and decides on what the workers found in the last tick
+ * @param cells the number of cells in the match's maze
+ * @return the new search, or NULL if the maze has more than
+ *   LOOKAHEAD_MAX_CELLS cells
+ */
+lookahead_t *lookahead_init(size_t player, size_t workers, size_t min_rollouts, size_t cells);
+
+/**
+ * Stops the workers and releases the memory allocated for a search.
+ *
+ * @param lookahead a pointer returned from lookahead_init()
+ */
+void lookahead_free(lookahead_t *lookahead);
+
+/**
+ * Reduces a match to a world, leaving out railgun blasts, which do not
+ * move, and the projectiles past LOOKAHEAD_MAX_SHOTS.
+ *
+ * @param world the world to fill
+ * @param state the match
+ */
+void lookahead_observe(lookahead_world_t *world, state_t *state);
+
+/**
+ * Copies the used part of a world.
+ *
+ * @param clone the copy
+ * @param world the world copied
+ */
+void lookahead_clone(lookahead_world_t *clone, const lookahead_world_t *world);
+
+/**
+ * Advances a world by one tick: every tank by its buttons, the way the
+ * game moves it, and every projectile along its bounces off the walls,
+ * killing the tanks it reaches.
+ *
+ * @param world the world
+ * @param walls the walls, with cell_walls and bounds only
+ * @param buttons a bit (1 << action) for each input_action_t each tank holds
+ * @param dt the length of the tick, in seconds
+ */
+void lookahead_step(lookahead_world_t *world, maze_t *walls, const uint8_t buttons[INPUT_PLAYERS], double dt);
+
+/**
+ * Chooses the buttons of the search's tank from the futures played out
+ * since the last call, and hands the workers the match as it is now.
+ * Must be called on the thread that runs game_tick(), before it.
+ *
+ * @param lookahead the search
+ * @param state the match
+ * @return the buttons of the best candidate, 0 before there is one
+ */
+uint8_t lookahead_tick(lookahead_t *lookahead, state_t *state);
+
+#endif // #ifndef __LOOKAHEAD_H__
@@ -2,19 +2,30 @@
 #define __MAZE_H__
 
 #include <stddef.h>
+#include <stdint.h>
 #include "scene.h"
 #include "forces.h"
 #include "body.h"
+#include "rng.h"
 
 typedef struct cell {
   size_t x; 
   size_t y; 
 } cell_t;
 
+// bits of maze_t.cell_walls
+#define WALL_LEFT 1
+#define WALL_RIGHT 2
+#define WALL_DOWN 4
+#define WALL_UP 8
+
 /**
  * A collection of bodies and force creators.
  * The scene automatically resizes to store
  * arbitrarily many bodies and force creators.
+ * The maze owns its wall bodies; they are not added to the scene,
+ * since collisions with them go through the maze and they are drawn
+ * from a cached render layer.
  */
 typedef struct maze {
   list_t *vertical_walls;
@@ -23,10 +34,12 @@ typedef struct maze {
   size_t rows;
   vector_t lower_left;
   vector_t upper_right;
+  uint8_t *cell_walls; // WALL_* bits of the walls present around each cell, by cell index
+  size_t revision; // incremented whenever a wall is destroyed
+  size_t *dirty_cells; // indices of cells whose walls changed since maze_clear_dirty()
+  size_t dirty_count;
 } maze_t;
 
-double rand_num();
-
 /**
  * Determines the center vector (position) of a given cell
  * 
@@ -79,9 +92,10 @@ list_t *get_walls_around(maze_t *maze, cell_t cell);
  * @param rows the number of rows
  * @param lower_left the coordinate of lower left
  * @param upper_right the coordinate of the upper right
+ * @param rng the generator the walls are drawn from
  * @return maze
  */
-maze_t *maze_init(size_t columns, size_t rows, vector_t lower_left, vector_t upper_right);
+maze_t *maze_init(size_t columns, size_t rows, vector_t lower_left, vector_t upper_right, rng_t *rng);
 
 /**
  * Releases memory allocated for a given maze
@@ -91,29 +105,41 @@ maze_t *maze_init(size_t columns, size_t rows, vector_t lower_left, vector_t upp
  */
 void maze_free(maze_t *maze);
 
+/**
+ * The aux of a body bouncing off the maze's walls.
+ */
+typedef struct body_maze_bool {
+  body_t *body;
+  maze_t *maze;
+  bool bol; // the body touched a wall last tick, so it is not bounced again until it leaves
+} body_maze_bool_t;
+
 /**
  * A function called when a collision occurs.
  * @param scene the scene
  * @param maze the maze (amazing I know)
  * @param body the body
+ * @return the aux, owned by the scene
  */
-void add_maze_collision(scene_t *scene, maze_t *maze, body_t *body);
+body_maze_bool_t *add_maze_collision(scene_t *scene, maze_t *maze, body_t *body);
 
 /**
  * Returns the center coordinate of a random cell in a given maze.
  * @param maze the maze
+ * @param rng the generator the cell is drawn from
  * @return random coordinate
  */
-vector_t get_random_cell_center(maze_t *maze);
+vector_t get_random_cell_center(maze_t *maze, rng_t *rng);
 
 /**
  * Returns the given number of center coordinates 
  * of a random cell in a given maze so that
  * none of them are overlapped.
  * @param maze the maze
+ * @param rng the generator the cells are drawn from
  * @return list of vectors
  */
-list_t *get_random_cell_centers(maze_t *maze, size_t num);
+list_t *get_random_cell_centers(maze_t *maze, size_t num, rng_t *rng);
 
 /** 
  * Checks if the given vector is outside of the maze
@@ -123,4 +149,122 @@ list_t *get_random_cell_centers(maze_t *maze, size_t num);
  */
 bool check_outside(maze_t *maze, vector_t vector);
 
+/**
+ * Destroys one wall segment and updates the per-cell wall bits and dirty cells.
+ * The wall body is turned into a null wall in place, so the scene and every
+ * force creator holding it stay valid. Walls on the border of the maze
+ * cannot be destroyed.
+ *
+ * @param maze the maze
+ * @param vertical whether the wall is in vertical_walls or horizontal_walls
+ * @param index the index of the wall in its list
+ * @return whether a wall was destroyed
+ */
+bool maze_destroy_wall(maze_t *maze, bool vertical, size_t index);
+
+/**
+ * Destroys every wall around a cell that collides with a shape.
+ *
+ * @param maze the maze
+ * @param cell the cell
+ * @param shape the shape hitting the walls
+ * @return the number of walls destroyed
+ */
+size_t maze_destroy_walls(maze_t *maze, cell_t cell, list_t *shape);
+
+/**
+ * Destroys every wall that collides with a convex shape, such as a
+ * railgun blast, testing each cell the shape covers.
+ *
+ * @param maze the maze
+ * @param shape the shape hitting the walls
+ * @return the number of walls destroyed
+ */
+size_t maze_destroy_walls_under(maze_t *maze, list_t *shape);
+
+/**
+ * Forgets the cells marked as changed, once every cache depending on them
+ * (such as the static render layer) has been updated.
+ *
+ * @param maze the maze
+ */
+void maze_clear_dirty(maze_t *maze);
+
+/**
+ * Traces a ray through the maze, reflecting it off walls.
+ * The ray walks the cell grid (DDA) and only looks at the wall bits of the
+ * cells it crosses, so its cost grows with the distance travelled and not
+ * with the number of walls. Walls are treated as axis-aligned boxes grown
+ * by half their thickness plus the given radius past their edge on every
+ * side, ends included, as maze_box_hits_wall() sees them, which is close to
+ * where a round projectile of that radius would bounce.
+ *
+ * @param maze the maze
+ * @param origin where the ray starts (must be inside the maze)
+ * @param direction the direction of the ray (need not be normalized)
+ * @param radius the radius of the projectile following the ray
+ * @param max_bounces the number of reflections allowed
+ * @param max_distance the total length of the ray
+ * @param hits receives the bounce points followed by the end point of the ray,
+ *   so it must hold max_bounces + 1 vectors
+ * @return the number of points written to hits
+ */
+size_t maze_raycast(maze_t *maze, vector_t origin, vector_t direction, double radius,
+                    size_t max_bounces, double max_distance, vector_t *hits);
+
+/**
+ * Casts many rays with maze_raycast() in one call.
+ *
+ * @param maze the maze
+ * @param origins the origin of each ray
+ * @param directions the direction of each ray
+ * @param count the number of rays
+ * @param radius the radius of the projectile following the rays
+ * @param max_bounces the number of reflections allowed per ray
+ * @param max_distance the total length of each ray
+ * @param hits receives max_bounces + 1 points per ray, ray i starting at i * (max_bounces + 1)
+ * @param hit_counts receives the number of points written for each ray
+ */
+void maze_raycast_batch(maze_t *maze, const vector_t *origins, const vector_t *directions,
+                        size_t count, double radius, size_t max_bounces, double max_distance,
+                        vector_t *hits, size_t *hit_counts);
+
+/**
+ * Tells whether a square, such as a tank's hitbox, overlaps one of the
+ * walls around the cell holding its center, which are the walls the game
+ * tests a tank against. Only the wall bits are read, so this works on a
+ * maze that has cell_walls and its bounds but no wall bodies.
+ *
+ * @param maze the maze
+ * @param center the center of the square
+ * @param size the length of its sides
+ * @param angle its orientation
+ * @return whether it overlaps a wall, or lies outside the maze
+ */
+bool maze_box_hits_wall(maze_t *maze, vector_t center, double size, double angle);
+
+/**
+ * Returns the cell beyond one side of a cell, reading only the wall bits.
+ *
+ * @param maze the maze
+ * @param cell the cell index, x + columns * y
+ * @param side WALL_LEFT, WALL_RIGHT, WALL_DOWN or WALL_UP
+ * @return the neighbouring cell, or SIZE_MAX if a wall or the edge of the maze is in the way
+ */
+size_t maze_neighbour(maze_t *maze, size_t cell, uint8_t side);
+
+/**
+ * Finds how many cells away every cell is from the nearest of some
+ * sources, moving only between neighbours no wall separates, with a
+ * breadth-first search of the wall bits.
+ *
+ * @param maze the maze, with fewer than UINT16_MAX cells
+ * @param sources the cells the distances are measured from
+ * @param source_count the number of sources
+ * @param distances receives the distance of each cell, UINT16_MAX where no source can be reached
+ * @param queue scratch space for one entry per cell
+ */
+void maze_distances(maze_t *maze, const size_t *sources, size_t source_count, uint16_t *distances,
+                    uint16_t *queue);
+
 #endif // #ifndef __MAZE_H__
@@ -0,0 +1,165 @@
+#ifndef __NET_H__
+#define __NET_H__
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rng.h"
+
+// the largest datagram sent; loopback carries it whole, other links fragment it above their MTU
+#define NET_MAX_DATAGRAM 16384
+
+/**
+ * Simulated network conditions, applied to the datagrams a socket sends so
+ * a loopback session behaves like one over a real link. All zero sends
+ * every datagram at once.
+ */
+typedef struct net_shim {
+  double latency; // seconds added to every datagram
+  double jitter; // up to this many more seconds, drawn per datagram, so datagrams may arrive out of order
+  double loss; // the fraction of datagrams dropped
+} net_shim_t;
+
+/**
+ * A datagram held back by the shim until it is due.
+ */
+typedef struct net_datagram {
+  double due;
+  struct sockaddr_in to;
+  size_t length;
+  uint8_t *data;
+} net_datagram_t;
+
+/**
+ * A non-blocking UDP socket with a latency and loss shim on its sends.
+ * The counts are of what the shim let through, as a link would carry it.
+ */
+typedef struct net_socket {
+  int fd;
+  net_shim_t shim;
+  rng_t rng;
+  net_datagram_t *delayed;
+  size_t delayed_count;
+  size_t delayed_capacity;
+  size_t bytes_sent;
+  size_t datagrams_sent;
+  size_t datagrams_dropped;
+  size_t bytes_received;
+  size_t datagrams_received;
+} net_socket_t;
+
+/**
+ * Appends values to a datagram being built. Writing past the end sets
+ * overflow instead, so a caller checks once when the datagram is done.
+ */
+typedef struct net_writer {
+  uint8_t *data;
+  size_t capacity;
+  size_t length;
+  bool overflow;
+} net_writer_t;
+
+/**
+ * Reads values out of a received datagram. Reading past the end, or a
+ * varint that does not fit, sets error and returns zeros, so a malformed
+ * datagram is checked for once after it is read.
+ */
+typedef struct net_reader {
+  const uint8_t *data;
+  size_t length;
+  size_t offset;
+  bool error;
+} net_reader_t;
+
+/**
+ * Opens a socket bound to a port on every interface.
+ *
+ * @param port the port, or 0 for any free port
+ * @param shim the conditions to simulate on the socket's sends
+ * @param seed the seed of the shim's losses and jitter
+ * @return the socket, or NULL if it could not be opened
+ */
+net_socket_t *net_socket_init(uint16_t port, net_shim_t shim, uint64_t seed);
+
+/**
+ * Closes a socket, dropping the datagrams the shim still holds.
+ *
+ * @param sock a pointer returned from net_socket_init()
+ */
+void net_socket_free(net_socket_t *sock);
+
+/**
+ * Looks up the address of a host.
+ *
+ * @param host a host name or dotted address
+ * @param port the port
+ * @param address where the address is written
+ * @return false if the host is unknown
+ */
+bool net_resolve(const char *host, uint16_t port, struct sockaddr_in *address);
+
+/**
+ * Sends a datagram through the shim: it is dropped, sent at once, or held
+ * until net_flush() is called at or after the time it is due.
+ *
+ * @param sock the socket
+ * @param to the address to send to
+ * @param data the datagram
+ * @param length its length, at most NET_MAX_DATAGRAM
+ * @param now the current time, in seconds
+ */
+void net_send(net_socket_t *sock, const struct sockaddr_in *to, const uint8_t *data, size_t length, double now);
+
+/**
+ * Sends the datagrams held by the shim that are due.
+ *
+ * @param sock the socket
+ * @param now the current time, in seconds
+ */
+void net_flush(net_socket_t *sock, double now);
+
+/**
+ * Takes the next datagram that has arrived, without waiting.
+ *
+ * @param sock the socket
+ * @param data where the datagram is written, NET_MAX_DATAGRAM bytes
+ * @param from where the sender's address is written
+ * @return the length of the datagram, 0 if none is waiting
+ */
+size_t net_receive(net_socket_t *sock, uint8_t *data, struct sockaddr_in *from);
+
+/**
+ * Tells whether two addresses are the same host and port.
+ */
+bool net_same_address(const struct sockaddr_in *a, const struct sockaddr_in *b);
+
+net_writer_t net_writer_init(uint8_t *data, size_t capacity);
+
+void net_put_u8(net_writer_t *writer, uint8_t value);
+
+/**
+ * Writes an unsigned number in 7-bit groups, low first, so small numbers
+ * take one byte.
+ */
+void net_put_varint(net_writer_t *writer, uint64_t value);
+
+/**
+ * Writes a signed number as a zigzag varint, so small changes of either
+ * sign take one byte.
+ */
+void net_put_svarint(net_writer_t *writer, int64_t value);
+
+void net_put_bytes(net_writer_t *writer, const uint8_t *bytes, size_t count);
+
+net_reader_t net_reader_init(const uint8_t *data, size_t length);
+
+uint8_t net_get_u8(net_reader_t *reader);
+
+uint64_t net_get_varint(net_reader_t *reader);
+
+int64_t net_get_svarint(net_reader_t *reader);
+
+void net_get_bytes(net_reader_t *reader, uint8_t *bytes, size_t count);
+
+#endif // #ifndef __NET_H__
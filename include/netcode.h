@@ -0,0 +1,295 @@
+#ifndef __NETCODE_H__
+#define __NETCODE_H__
+
+#include "game.h"
+#include "net.h"
+
+#define NET_PROTOCOL_VERSION 1
+#define NET_DEFAULT_PORT 7117
+#define NET_SNAPSHOT_HISTORY 32 // snapshots each side keeps as delta baselines, half a second at 60 ticks/s
+#define NET_INPUT_HISTORY 64 // inputs a client remembers for prediction, and a server for reordering
+#define NET_INPUT_REDUNDANCY 8 // inputs repeated in every input datagram, so a lost one is carried by the next
+#define NET_POSITION_UNITS 8 // positions are sent in eighths of a pixel
+#define NET_ANGLE_UNITS 65536 // angles are sent in 65536ths of a turn
+#define NET_ID_SHIFT 24 // an entity id is its kind above this bit and its index below
+
+typedef enum {
+  NET_TANK, // index: the player, red, green, blue
+  NET_POWERUP, // index: the slot in the powerup registry
+  NET_PROJECTILE // index: the slot in the projectile registry
+} net_entity_kind_t;
+
+/**
+ * What the numbers of an entity mean. Every kind uses the same fields, so
+ * one delta coder covers all of them; a field a kind does not use is 0.
+ */
+typedef enum {
+  NET_FIELD_X, // in 1 / NET_POSITION_UNITS pixels
+  NET_FIELD_Y,
+  NET_FIELD_ANGLE, // in 1 / NET_ANGLE_UNITS turns
+  NET_FIELD_KIND, // tank: the shot it fires; projectile: its kind; powerup: its type
+  NET_FIELD_FLAGS, // tank: the movement flags, as input buttons; projectile: the owner
+  NET_FIELD_AMMO, // tank: bullets on screen, plus special shots left times 256
+  NET_ENTITY_FIELDS
+} net_field_t;
+
+/**
+ * The numbers of a match that are not entities.
+ */
+typedef enum {
+  NET_MATCH_CONTROLS, // which tank each set of controls drives
+  NET_MATCH_RED_WINS,
+  NET_MATCH_GREEN_WINS,
+  NET_MATCH_BLUE_WINS,
+  NET_MATCH_GAMES,
+  NET_MATCH_COUNTDOWN, // milliseconds until the next game, 0 during a game
+  NET_MATCH_GENERATION, // of the maze
+  NET_MATCH_REVISION, // of the maze's walls
+  NET_MATCH_FIELDS
+} net_match_field_t;
+
+typedef struct net_entity {
+  uint32_t id;
+  int32_t fields[NET_ENTITY_FIELDS];
+} net_entity_t;
+
+/**
+ * A match as the server sends it: quantised, with the entities sorted by
+ * id so two snapshots are compared in one pass.
+ */
+typedef struct net_snapshot {
+  uint32_t tick; // 0 while the slot holding it is empty
+  int32_t match[NET_MATCH_FIELDS];
+  size_t cell_count;
+  size_t cell_capacity;
+  uint8_t *cell_walls;
+  size_t entity_count;
+  size_t entity_capacity;
+  net_entity_t *entities;
+} net_snapshot_t;
+
+/**
+ * Where the client predicts its own tank to be.
+ */
+typedef struct net_pose {
+  vector_t position;
+  double angle;
+  vector_t velocity; // the velocity the next tick moves the tank by
+  vector_t last_move; // how far the last tick moved it, which the next one undoes if the tank ended in a wall
+  uint8_t held; // the buttons of the last input; the server only changes a tank's flags when one changes
+  uint8_t flags; // the tank's movement flags, as buttons
+} net_pose_t;
+
+/**
+ * A client as the server sees it. The server applies one input of the
+ * client per tick, in order, more when they pile up, and keeps the
+ * snapshots it sent so the next one can be coded against the newest one
+ * the client confirmed.
+ */
+typedef struct net_peer {
+  bool connected;
+  struct sockaddr_in address;
+  double last_heard;
+  uint32_t newest_input; // the highest input sequence number received
+  uint32_t applied_input; // the highest one applied to the match
+  uint8_t buttons; // the controls held as of applied_input
+  uint8_t inputs[NET_INPUT_HISTORY]; // received inputs, by sequence number
+  uint32_t input_sequences[NET_INPUT_HISTORY];
+  uint32_t acked_tick; // the newest snapshot the client has, 0 for none
+  net_snapshot_t *sent[NET_SNAPSHOT_HISTORY]; // by tick
+  size_t snapshots_sent;
+  size_t full_snapshots;
+  size_t snapshot_bytes;
+} net_peer_t;
+
+/**
+ * Runs a match for up to INPUT_PLAYERS clients, one per set of controls.
+ * The match only changes in net_server_tick(), so the server is the one
+ * authority on it; clients send the controls they hold and get back
+ * snapshots of the match, coded as changes from one they already have.
+ */
+typedef struct net_server {
+  state_t *state;
+  net_socket_t *socket;
+  double dt;
+  size_t snapshot_interval; // ticks between snapshots
+  net_peer_t peers[INPUT_PLAYERS]; // by set of controls
+  net_snapshot_t *current;
+  size_t ticks;
+  double game_seconds; // spent in game_tick()
+  double snapshot_seconds; // spent capturing, coding and sending snapshots
+  double max_tick_seconds;
+  size_t oversized_snapshots; // not sent, larger than NET_MAX_DATAGRAM
+} net_server_t;
+
+/**
+ * Plays a match on a server: sends the controls held each tick, decodes
+ * the snapshots and predicts the tank its controls drive, so the tank
+ * answers at once instead of a round trip later.
+ */
+typedef struct net_client {
+  net_socket_t *socket;
+  struct sockaddr_in server;
+  bool connected;
+  uint8_t player; // the set of controls the server gave
+  game_config_t config;
+  double dt; // the server's tick
+  maze_t walls; // the bounds of the server's maze, and the wall bits of the latest snapshot when predicting
+  double last_connect;
+  uint32_t input_sequence; // of the newest input sent, 0 before the first
+  uint8_t inputs[NET_INPUT_HISTORY]; // by sequence number
+  double input_times[NET_INPUT_HISTORY];
+  vector_t predictions[NET_INPUT_HISTORY]; // the predicted position after each input
+  uint32_t prediction_sequences[NET_INPUT_HISTORY];
+  net_snapshot_t *snapshots[NET_SNAPSHOT_HISTORY]; // by tick
+  net_snapshot_t *latest; // NULL before the first snapshot
+  uint32_t acked_input; // the newest input applied in the latest snapshot
+  bool predicting; // whether the tank is alive in the latest snapshot
+  net_pose_t predicted;
+  size_t snapshots_received;
+  size_t full_snapshots;
+  size_t stale_snapshots; // older than the latest, or coded against one no longer kept
+  double round_trip_total; // from sending an input to a snapshot that applied it
+  size_t round_trips;
+  double prediction_error_total; // between the predicted and the confirmed position, in pixels
+  double prediction_error_max;
+  size_t prediction_errors;
+} net_client_t;
+
+/**
+ * Allocates an empty snapshot.
+ *
+ * @return the new snapshot
+ */
+net_snapshot_t *net_snapshot_init();
+
+/**
+ * Releases a snapshot.
+ *
+ * @param snapshot a pointer returned from net_snapshot_init()
+ */
+void net_snapshot_free(net_snapshot_t *snapshot);
+
+/**
+ * Copies a snapshot into another, reusing its arrays.
+ *
+ * @param to the snapshot to overwrite
+ * @param from the snapshot to copy
+ */
+void net_snapshot_copy(net_snapshot_t *to, const net_snapshot_t *from);
+
+/**
+ * Quantises a match into a snapshot.
+ *
+ * @param snapshot the snapshot to fill
+ * @param state the match
+ */
+void net_snapshot_capture(net_snapshot_t *snapshot, state_t *state);
+
+/**
+ * Returns an entity of a snapshot.
+ *
+ * @param snapshot the snapshot
+ * @param id the id of the entity
+ * @return the entity, NULL if the snapshot has none with that id
+ */
+const net_entity_t *net_snapshot_find(const net_snapshot_t *snapshot, uint32_t id);
+
+/**
+ * Writes a snapshot as its changes from a baseline: a bit mask and deltas
+ * of the match numbers, the walls if the maze changed, the ids of the
+ * entities gone, and for each entity new or changed its id, a bit mask of
+ * the fields that changed and their deltas, all as varints.
+ *
+ * @param writer where the snapshot is written
+ * @param snapshot the snapshot
+ * @param baseline a snapshot the receiver has, NULL to write the whole snapshot
+ */
+void net_snapshot_encode(net_writer_t *writer, const net_snapshot_t *snapshot, const net_snapshot_t *baseline);
+
+/**
+ * Reads a snapshot written by net_snapshot_encode().
+ *
+ * @param reader where the snapshot is read from
+ * @param snapshot the snapshot to fill, other than the baseline
+ * @param baseline the baseline it was written against, NULL if none
+ * @return false if the data is malformed, leaving the snapshot unusable
+ */
+bool net_snapshot_decode(net_reader_t *reader, net_snapshot_t *snapshot, const net_snapshot_t *baseline);
+
+/**
+ * Creates a server for a match.
+ *
+ * @param state the match, which the server ticks from now on
+ * @param sock the socket clients reach the server on
+ * @param dt the length of a tick, in seconds
+ * @param snapshot_interval ticks between snapshots
+ * @return the new server
+ */
+net_server_t *net_server_init(state_t *state, net_socket_t *sock, double dt, size_t snapshot_interval);
+
+/**
+ * Handles every datagram that has arrived: connections, inputs and
+ * acknowledged snapshots.
+ *
+ * @param server the server
+ * @param now the current time, in seconds
+ */
+void net_server_receive(net_server_t *server, double now);
+
+/**
+ * Applies the clients' inputs, advances the match by one tick, and sends
+ * each client a snapshot when one is due. Drops clients not heard from in
+ * a while.
+ *
+ * @param server the server
+ * @param now the current time, in seconds
+ */
+void net_server_tick(net_server_t *server, double now);
+
+/**
+ * Releases a server, but not its match or socket.
+ *
+ * @param server a pointer returned from net_server_init()
+ */
+void net_server_free(net_server_t *server);
+
+/**
+ * Creates a client of a server. It asks to join when it first receives.
+ *
+ * @param sock the socket to talk to the server on
+ * @param server the address of the server
+ * @return the new client
+ */
+net_client_t *net_client_init(net_socket_t *sock, const struct sockaddr_in *server);
+
+/**
+ * Asks to join until the server answers, and handles every datagram that
+ * has arrived: a newer snapshot replaces the latest one and the local tank
+ * is predicted again from it.
+ *
+ * @param client the client
+ * @param now the current time, in seconds
+ */
+void net_client_receive(net_client_t *client, double now);
+
+/**
+ * Sends the controls held for the next tick, with the ones before it in
+ * case those were lost, and moves the predicted tank by them.
+ *
+ * @param client a connected client
+ * @param buttons a bit (1 << action) for each input_action_t held down
+ * @param now the current time, in seconds
+ */
+void net_client_send_input(net_client_t *client, uint8_t buttons, double now);
+
+/**
+ * Tells the server the client is leaving and releases the client, but not
+ * its socket.
+ *
+ * @param client a pointer returned from net_client_init()
+ * @param now the current time, in seconds
+ */
+void net_client_free(net_client_t *client, double now);
+
+#endif // #ifndef __NETCODE_H__
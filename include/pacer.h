@@ -0,0 +1,89 @@
+#ifndef __PACER_H__
+#define __PACER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACER_BUCKETS 1000 // 0.1 ms each, so the histogram covers 0 to 100 ms
+
+/**
+ * Paces a loop to a target rate and measures it.
+ * Waiting sleeps until shortly before the deadline and spins the rest of
+ * the way, which keeps the CPU idle without inheriting the sleep's jitter.
+ * Every frame's length goes into a histogram, and the dt handed to the
+ * simulation is smoothed so scheduling noise does not reach the physics.
+ */
+typedef struct frame_pacer {
+  const char *name;
+  double period; // seconds per frame, 0 when something else paces the loop
+  uint64_t frequency;
+  uint64_t deadline;
+  uint64_t last_frame;
+  double smoothed_dt;
+  size_t histogram[PACER_BUCKETS + 1]; // the last bucket counts frames over 100 ms
+  size_t frames;
+  double max_frame;
+} frame_pacer_t;
+
+/**
+ * Frame time percentiles since the last report.
+ */
+typedef struct pacer_stats {
+  size_t frames;
+  double p50;
+  double p99;
+  double max;
+} pacer_stats_t;
+
+/**
+ * Allocates a pacer.
+ *
+ * @param name the name printed with its reports
+ * @param target_rate frames per second, or 0 to only measure (when vsync or
+ *   the browser already paces the loop)
+ * @return the new pacer
+ */
+frame_pacer_t *pacer_init(const char *name, double target_rate);
+
+/**
+ * Releases a pacer.
+ *
+ * @param pacer a pointer returned from pacer_init()
+ */
+void pacer_free(frame_pacer_t *pacer);
+
+/**
+ * Waits until the next frame is due. Returns at once if the pacer only
+ * measures, or if the loop has fallen behind; missed frames are dropped
+ * rather than run back to back.
+ *
+ * @param pacer the pacer
+ */
+void pacer_wait(frame_pacer_t *pacer);
+
+/**
+ * Marks the start of a frame and records the time since the previous one.
+ *
+ * @param pacer the pacer
+ * @return the smoothed time since the previous frame, in seconds
+ */
+double pacer_tick(frame_pacer_t *pacer);
+
+/**
+ * Returns the frame time percentiles since the last report.
+ *
+ * @param pacer the pacer
+ * @return the percentiles, in seconds
+ */
+pacer_stats_t pacer_get_stats(frame_pacer_t *pacer);
+
+/**
+ * Prints the frame time percentiles since the last report and starts a new
+ * histogram. Call it from the thread that ticks the pacer.
+ *
+ * @param pacer the pacer
+ */
+void pacer_report(frame_pacer_t *pacer);
+
+#endif // #ifndef __PACER_H__
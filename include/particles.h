@@ -0,0 +1,83 @@
+#ifndef __PARTICLES_H__
+#define __PARTICLES_H__
+
+#include <stddef.h>
+#include "color.h"
+#include "vector.h"
+
+/**
+ * A fixed-capacity pool of purely visual particles (debris, sparks, ...).
+ * Particles are stored structure-of-arrays so that the whole pool is
+ * integrated in a single loop, and they never enter the scene, so they
+ * cost nothing in the scene's body or force creator lists.
+ */
+typedef struct particle_system {
+  size_t capacity;
+  size_t count;
+  double drag;
+  float hue_shift; // degrees per second every particle's hue turns by
+  float *x;
+  float *y;
+  float *vx;
+  float *vy;
+  float *angle;
+  float *spin;
+  float *life;
+  float *size;
+  float *r;
+  float *g;
+  float *b;
+  // the color as hsv, converted to r, g, b in one batch each tick when hue_shift is set
+  float *hue;
+  float *saturation;
+  float *value;
+} particle_system_t;
+
+/**
+ * Allocates a particle system that holds at most capacity particles.
+ *
+ * @param capacity the maximum number of live particles
+ * @param drag the linear drag coefficient (drag force / mass) applied to every particle
+ * @param hue_shift how many degrees per second the particles' hue turns by, 0 for none
+ * @return the new particle system
+ */
+particle_system_t *particles_init(size_t capacity, double drag, double hue_shift);
+
+/**
+ * Releases the memory allocated for a particle system.
+ *
+ * @param particles a pointer returned from particles_init()
+ */
+void particles_free(particle_system_t *particles);
+
+/**
+ * Removes every live particle.
+ *
+ * @param particles the particle system
+ */
+void particles_clear(particle_system_t *particles);
+
+/**
+ * Spawns one particle. The particle is dropped if the system is full.
+ *
+ * @param particles the particle system
+ * @param center the starting position
+ * @param velocity the starting velocity
+ * @param color the color of the particle
+ * @param size the size of the particle
+ * @param spin the angular velocity of the particle
+ * @param life how many seconds the particle lives
+ */
+void particles_emit(particle_system_t *particles, vector_t center, vector_t velocity,
+                    rgb_color_t color, double size, double spin, double life);
+
+/**
+ * Advances every particle by dt, applying drag and lifetime in one pass.
+ * Dead particles are swapped out so the live ones stay packed.
+ *
+ * @param particles the particle system
+ * @param dt the elapsed time
+ */
+void particles_tick(particle_system_t *particles, double dt);
+
+#endif // #ifndef __PARTICLES_H__
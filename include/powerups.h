@@ -5,13 +5,60 @@
 #include "state.h"
 #include <stdio.h>
 #include "tank.h"
+#include "particles.h"
+#include "projectiles.h"
+#include "audio.h"
+#include "camera.h"
+#include "input.h"
+#include "rng.h"
+#include "snapshot.h"
+
+typedef struct powerup_pulse powerup_pulse_t;
+
+/**
+ * A registry of the powerups lying in the maze. Each slot is released by
+ * the powerup's pulse aux when the scene frees it, so like the projectile
+ * registry it never holds a freed body. It grows as powerups pile up.
+ */
+typedef struct powerup_pool {
+  size_t capacity;
+  body_t **bodies;
+  powerup_pulse_t **pulses;
+  size_t *free_slots;
+  size_t free_count;
+  size_t next_serial;
+} powerup_pool_t;
+
+/**
+ * What makes one match differ from another, fixed when it is created.
+ */
+typedef struct game_config {
+  size_t maze_columns; // per window; the arena holds ARENA_SCALE times as many
+  size_t maze_rows;
+  uint64_t seed;
+  bool keep_score; // load the win tallies at startup and save them after every game
+} game_config_t;
 
 typedef struct state {
+  game_config_t config;
+  rng_streams_t rng;
+  rng_t maze_rng; // the maze stream as it was before the current maze was drawn
   scene_t *scene;
   tank_t *red_player;
   tank_t *green_player;
   tank_t *blue_player;
+  body_t *dying_bodies[INPUT_PLAYERS]; // red, green, blue: bodies of tanks removed by the last tick, freed by the next
+  size_t dying_serial; // the next projectile serial when they were removed; later moons never pulled on them
   maze_t *maze;
+  vector_t arena; // the area the maze spans, larger than the window when the camera follows the tanks
+  camera_t camera;
+  particle_system_t *particles;
+  projectile_pool_t *projectiles;
+  powerup_pool_t *powerups;
+  audio_t audio; // silent when the game runs headless
+  broadphase_t *tank_broadphase;
+  bool bullet_annihilation; // opposing projectiles destroy each other on contact
+  bool destructible_walls; // railgun and moon hits destroy inner walls
   size_t red_wins;
   size_t green_wins;
   size_t blue_wins;
@@ -19,7 +66,16 @@ typedef struct state {
   double dt;
   double count_down_until_next_game_start;
   double count_down_until_next_powerup;
+  double count_down_controls_hint;
+  char banner[HUD_BANNER_LENGTH]; // the result of the last game, shown until the next one starts
   size_t tank_controls; // 0: red_player uses awsd, 1: red_player uses ijkl, 2: red_player uses arrows
+  size_t tick;
+  size_t maze_generation; // incremented whenever a new maze is generated
+  size_t captured_revision; // maze revision at the last snapshot
+  input_event_t *inputs; // the inputs applied before tick inputs_tick, for game_record_tick()
+  size_t input_count;
+  size_t input_capacity;
+  size_t inputs_tick;
 } state_t;
 
 typedef enum {
@@ -29,6 +85,100 @@ typedef enum {
   MOON
 } powerup_type_t;
 
+/**
+ * The aux of a powerup's pulse, which also releases its registry slot.
+ */
+typedef struct powerup_pulse {
+  state_t *state;
+  body_t *body;
+  powerup_type_t type;
+  double phase; // 0~1 through the pulse
+  size_t slot; // in state->powerups
+  size_t serial; // the order the powerups were added in
+} powerup_pulse_t;
+
+/**
+ * Allocates an empty powerup registry.
+ *
+ * @param capacity the number of slots to start with
+ * @return the new registry
+ */
+powerup_pool_t *powerups_init(size_t capacity);
+
+/**
+ * Releases the memory allocated for a registry.
+ * The scene the powerups were added to must be freed first.
+ *
+ * @param powerups a pointer returned from powerups_init()
+ */
+void powerups_free(powerup_pool_t *powerups);
+
+/**
+ * Returns the tank of a player.
+ *
+ * @param state the state
+ * @param player 0 red, 1 green, 2 blue
+ * @return the tank, or NULL if it is dead
+ */
+tank_t *player_tank(state_t *state, size_t player);
+
+/**
+ * Returns the player a live tank belongs to.
+ *
+ * @param state the state
+ * @param tank the tank
+ * @return 0 red, 1 green, 2 blue
+ */
+size_t tank_player(state_t *state, tank_t *tank);
+
+/**
+ * Returns the shot a tank fires while it holds a kind of projectile.
+ *
+ * @param kind the kind of projectile
+ * @return the shot handler
+ */
+shot_handler_t shot_handler(projectile_kind_t kind);
+
+/**
+ * Returns the kind of projectile a shot handler fires.
+ *
+ * @param handler one of the shot handlers
+ * @return the kind of projectile
+ */
+projectile_kind_t shot_kind(shot_handler_t handler);
+
+/**
+ * Creates the body of a projectile, with the mass and color of its kind.
+ *
+ * @param kind the kind of projectile
+ * @param shape the shape of the body, owned by the body from now on
+ * @return the body
+ */
+body_t *projectile_body(projectile_kind_t kind, list_t *shape);
+
+/**
+ * Adds a projectile body to the scene with every force its kind needs
+ * (walls, tanks, decay, gravity) and registers it. Does not count it
+ * against the owner's bullets.
+ *
+ * @param state the state
+ * @param body a body from projectile_body()
+ * @param kind the kind of projectile
+ * @param owner the player that fired it: 0 red, 1 green, 2 blue
+ */
+void projectile_attach(state_t *state, body_t *body, projectile_kind_t kind, size_t owner);
+
+/**
+ * Adds a powerup at a given place, with its pulse and a pickup for every
+ * live tank, and registers it.
+ *
+ * @param state the state
+ * @param powerup_type the type of powerup
+ * @param center the center of the powerup
+ * @return the pulse of the powerup, owned by the scene
+ */
+powerup_pulse_t *powerup_spawn(state_t *state, powerup_type_t powerup_type, vector_t center);
+
 /**
  * Shoot normally from a tank
  *
@@ -0,0 +1,104 @@
+#ifndef __PROJECTILES_H__
+#define __PROJECTILES_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "broadphase.h"
+#include "scene.h"
+#include "body.h"
+
+typedef struct decay decay_t;
+typedef struct body_maze_bool body_maze_bool_t;
+
+typedef enum {
+  PROJECTILE_NORMAL,
+  PROJECTILE_RAILGUN,
+  PROJECTILE_LASER,
+  PROJECTILE_SHOTGUN,
+  PROJECTILE_MOON,
+  PROJECTILE_KINDS
+} projectile_kind_t;
+
+/**
+ * What the game knows about a projectile besides its body: what fired it
+ * and the auxes holding its state between ticks, which the scene owns and
+ * frees together with the body.
+ */
+typedef struct projectile_info {
+  projectile_kind_t kind;
+  size_t owner; // the player that fired it: 0 red, 1 green, 2 blue
+  decay_t *decay; // NULL if it never decays
+  body_maze_bool_t *contact; // NULL if it passes through walls
+} projectile_info_t;
+
+/**
+ * A registry of the live projectiles in a scene.
+ * Every registered body is tied to a force creator, so the scene releases
+ * its slot at the same moment it frees the body. The registry therefore
+ * never holds a dangling pointer and needs no scanning of the scene.
+ */
+typedef struct projectile_pool {
+  size_t capacity;
+  body_t **bodies;
+  projectile_info_t *infos;
+  size_t *serials; // the order the projectiles were added in
+  size_t next_serial;
+  double *radii;
+  size_t *free_slots; // a stack; the next projectile takes the slot on top
+  size_t free_count;
+  broadphase_t *broadphase;
+  size_t *pairs_first;
+  size_t *pairs_second;
+} projectile_pool_t;
+
+/**
+ * Allocates a projectile registry for a maze-sized area.
+ *
+ * @param lower_left the lower left corner of the play area
+ * @param upper_right the upper right corner of the play area
+ * @param cell_size the edge length of a broadphase cell
+ * @param capacity the maximum number of registered projectiles
+ * @return the new registry
+ */
+projectile_pool_t *projectiles_init(vector_t lower_left, vector_t upper_right, double cell_size, size_t capacity);
+
+/**
+ * Releases the memory allocated for a registry.
+ * The scene the projectiles were added to must be freed first.
+ *
+ * @param projectiles a pointer returned from projectiles_init()
+ */
+void projectiles_free(projectile_pool_t *projectiles);
+
+/**
+ * Registers a projectile. Nothing happens if the registry is full.
+ *
+ * @param projectiles the registry
+ * @param scene the scene the projectile body belongs to
+ * @param body the projectile body
+ * @param info what fired the projectile and its auxes
+ */
+void projectiles_add(projectile_pool_t *projectiles, scene_t *scene, body_t *body, projectile_info_t info);
+
+/**
+ * Replaces the stack of free slots, so the projectiles added next take
+ * the given slots in order. Used to put projectiles back in the slots
+ * they were saved from.
+ *
+ * @param projectiles the registry, with no projectile in any of the slots
+ * @param slots the free slots, the last one on top
+ * @param count the number of slots
+ */
+void projectiles_set_free_slots(projectile_pool_t *projectiles, const size_t *slots, size_t count);
+
+/**
+ * Removes every pair of touching projectiles fired by different tanks.
+ * Railgun blasts stay out of it, as they are not solid.
+ * Must be called between scene ticks, when every registered body is alive.
+ *
+ * @param projectiles the registry
+ * @return the number of pairs that annihilated
+ */
+size_t projectiles_annihilate(projectile_pool_t *projectiles);
+
+#endif // #ifndef __PROJECTILES_H__
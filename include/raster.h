@@ -0,0 +1,139 @@
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "game.h"
+
+/**
+ * The planes of a rasterized observation, in the order they are written.
+ */
+typedef enum {
+  RASTER_WALLS, // 1 where a wall is; with one pixel per cell, the cell's WALL_* bits
+  RASTER_RED, // 1 under the red tank's hitbox
+  RASTER_GREEN,
+  RASTER_BLUE,
+  RASTER_PROJECTILES, // the number of projectiles centered in each pixel, up to 255
+  RASTER_POWERUPS, // the number of powerups centered in each pixel
+  RASTER_CHANNELS
+} raster_channel_t;
+
+/**
+ * The size of the grid a match is rasterized on: the maze's cell grid,
+ * each cell split into pixels_per_cell by pixels_per_cell pixels. Row 0 is
+ * the bottom of the maze and column 0 its left, as in maze_t.
+ */
+typedef struct raster_shape {
+  size_t width;
+  size_t height;
+  size_t pixels_per_cell;
+} raster_shape_t;
+
+/**
+ * A block of pixels drawn into one plane of an observation, so the next
+ * observation of the match clears just the block.
+ */
+typedef struct raster_rect {
+  uint32_t plane; // offset of the plane in the observation
+  uint16_t left;
+  uint16_t right; // inclusive
+  uint16_t bottom;
+  uint16_t top; // inclusive
+} raster_rect_t;
+
+/**
+ * What one match's observation in a batch holds now.
+ */
+typedef struct raster_match {
+  state_t *state; // the match last drawn, NULL before the first observation
+  maze_t *maze; // the maze whose walls were drawn
+  size_t maze_generation;
+  size_t maze_revision;
+  raster_rect_t *drawn;
+  size_t drawn_count;
+  size_t drawn_capacity;
+} raster_match_t;
+
+/**
+ * Observations of a batch of matches, updated in place every tick: the
+ * wall plane is drawn again only when the maze changes, and of the other
+ * planes only the blocks the bodies covered are cleared, so an update
+ * costs little more than the bodies there are.
+ */
+typedef struct raster {
+  raster_shape_t shape;
+  size_t matches;
+  size_t size; // bytes of one observation, raster_size(shape)
+  uint8_t *observations; // matches * size bytes; match i starts at i * size
+  raster_match_t *slots;
+} raster_t;
+
+/**
+ * Returns the grid a maze is rasterized on.
+ *
+ * @param maze the maze
+ * @param pixels_per_cell the pixels along each side of a cell, at least 1
+ * @return the shape of the grid
+ */
+raster_shape_t raster_shape(maze_t *maze, size_t pixels_per_cell);
+
+/**
+ * Returns the bytes one rasterized observation takes:
+ * RASTER_CHANNELS * height * width.
+ *
+ * @param shape the grid
+ * @return the size of one observation
+ */
+size_t raster_size(raster_shape_t shape);
+
+/**
+ * Rasterizes a match into an observation laid out channel, row, column,
+ * reading the maze's wall bits and the bodies of the tanks, projectiles
+ * and powerups directly.
+ *
+ * @param state the match
+ * @param shape the grid, which must be the shape of the match's maze
+ * @param out raster_size(shape) bytes
+ */
+void raster_observe(state_t *state, raster_shape_t shape, uint8_t *out);
+
+/**
+ * Rasterizes many matches in one call, such as every match of a batch
+ * stepped together, into consecutive observations.
+ *
+ * @param states the matches, all with mazes of the shape's size
+ * @param count the number of matches
+ * @param shape the grid
+ * @param out count * raster_size(shape) bytes; match i starts at i * raster_size(shape)
+ */
+void raster_observe_batch(state_t **states, size_t count, raster_shape_t shape, uint8_t *out);
+
+/**
+ * Allocates the observations of a batch, all zeros.
+ *
+ * @param shape the grid every match of the batch is rasterized on, at most
+ *   UINT16_MAX pixels a side and UINT32_MAX bytes an observation
+ * @param matches the number of matches in the batch
+ * @return the new batch
+ */
+raster_t *raster_init(raster_shape_t shape, size_t matches);
+
+/**
+ * Releases the memory allocated for a batch.
+ *
+ * @param raster a pointer returned from raster_init()
+ */
+void raster_free(raster_t *raster);
+
+/**
+ * Brings every observation of a batch up to date with its match. The
+ * observations are the same, byte for byte, as raster_observe_batch()
+ * writes.
+ *
+ * @param raster the batch
+ * @param states the matches, states[i] in observation i; a slot may be
+ *   given a different match, which is then drawn in full
+ */
+void raster_update(raster_t *raster, state_t **states);
+
+#endif // #ifndef __RASTER_H__
@@ -0,0 +1,54 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include <stddef.h>
+#include "snapshot.h"
+
+/**
+ * Counters describing the last frame drawn.
+ */
+typedef struct render_stats {
+  size_t draw_calls;
+  size_t triangles;
+  size_t polygons; // bodies drawn after culling
+} render_stats_t;
+
+/**
+ * Sets up the renderer for a scene spanning min to max.
+ * Must be called after sdl_init(), with the same bounds.
+ *
+ * @param min the lower left corner of the scene
+ * @param max the upper right corner of the scene
+ */
+void render_init(vector_t min, vector_t max);
+
+/**
+ * Draws one frame from a snapshot: the static maze layer, the bodies, then
+ * the particles, as seen through the snapshot's view. Replaces sdl_render_scene() for the game and only reads
+ * the snapshot, so it may run on another thread than the simulation.
+ * The walls are kept in a cached texture that is redrawn when a new maze
+ * appears and patched cell by cell when walls are destroyed. Bodies and
+ * particles are triangulated into one shared vertex/index buffer and
+ * submitted with a single geometry call. Only the bodies bucketed in the
+ * cells under the view are visited.
+ *
+ * @param snapshot the snapshot to draw
+ */
+void render_snapshot(const frame_snapshot_t *snapshot);
+
+/**
+ * Tells whether presenting a frame waits for the display's vertical blank,
+ * in which case the render loop needs no pacing of its own.
+ *
+ * @return true if the renderer was created with vsync
+ */
+bool render_has_vsync();
+
+/**
+ * Returns the counters of the last frame drawn by render_snapshot().
+ *
+ * @return the draw calls and triangles of the last frame
+ */
+render_stats_t render_get_stats();
+
+#endif // #ifndef __RENDER_H__
@@ -0,0 +1,124 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "input.h"
+
+// a replay stores each tick's dt as an integer count of these, and the game steps by exactly that
+#define REPLAY_DT_UNITS 1000000
+
+/**
+ * What a replay needs to recreate a match: the game_config_t fields that
+ * change the simulation.
+ */
+typedef struct replay_header {
+  size_t maze_columns;
+  size_t maze_rows;
+  uint64_t seed;
+} replay_header_t;
+
+/**
+ * One tick of a replay: the inputs applied before it, its dt and the hash
+ * of the state after it.
+ */
+typedef struct replay_tick {
+  input_event_t *inputs; // owned by the reader, valid until the next read
+  size_t input_count;
+  int64_t dt; // in 1 / REPLAY_DT_UNITS seconds
+  uint32_t hash;
+} replay_tick_t;
+
+/**
+ * Records a match into a file as it is played. The file holds a header,
+ * then one record per tick: a varint of the input count and whether the dt
+ * changed, the change in dt as a zigzag varint when it did, one byte per
+ * input, and the 32-bit state hash. A steady match costs 5 bytes per tick.
+ * Records are buffered and written in large blocks.
+ */
+typedef struct replay_writer {
+  FILE *file;
+  uint8_t *buffer;
+  size_t length;
+  size_t capacity;
+  uint8_t *inputs; // the encoded inputs of the tick being recorded
+  size_t input_count;
+  size_t input_capacity;
+  int64_t dt;
+  size_t ticks;
+} replay_writer_t;
+
+/**
+ * Reads a replay file back one tick at a time.
+ */
+typedef struct replay_reader {
+  uint8_t *data;
+  size_t size;
+  size_t offset;
+  replay_header_t header;
+  input_event_t *inputs;
+  size_t input_capacity;
+  int64_t dt;
+  size_t ticks;
+} replay_reader_t;
+
+/**
+ * Creates a replay file and writes its header.
+ *
+ * @param path the file to create
+ * @param header the configuration of the recorded match
+ * @return the writer, or NULL if the file could not be created
+ */
+replay_writer_t *replay_writer_init(const char *path, replay_header_t header);
+
+/**
+ * Records an input applied before the next tick.
+ *
+ * @param writer the writer
+ * @param event the input
+ */
+void replay_record_input(replay_writer_t *writer, input_event_t event);
+
+/**
+ * Ends the record of a tick.
+ *
+ * @param writer the writer
+ * @param dt the length of the tick, in 1 / REPLAY_DT_UNITS seconds
+ * @param hash the hash of the state after the tick
+ */
+void replay_record_tick(replay_writer_t *writer, int64_t dt, uint32_t hash);
+
+/**
+ * Writes out what is buffered, closes the file and releases the writer.
+ *
+ * @param writer a pointer returned from replay_writer_init()
+ */
+void replay_writer_free(replay_writer_t *writer);
+
+/**
+ * Opens a replay file and reads its header.
+ *
+ * @param path the file
+ * @return the reader, or NULL if the file is missing or is not a replay
+ */
+replay_reader_t *replay_reader_init(const char *path);
+
+/**
+ * Reads the next tick.
+ *
+ * @param reader the reader
+ * @param tick where the tick is stored
+ * @return false at the end of the replay, or if the rest of it is cut short
+ */
+bool replay_read_tick(replay_reader_t *reader, replay_tick_t *tick);
+
+/**
+ * Releases a reader.
+ *
+ * @param reader a pointer returned from replay_reader_init()
+ */
+void replay_reader_free(replay_reader_t *reader);
+
+#endif // #ifndef __REPLAY_H__
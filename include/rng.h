@@ -0,0 +1,76 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A xoshiro256** generator owned by one match, so matches on different
+ * threads neither share nor disturb each other's sequence, and a match
+ * replays the same sequence from the same seed.
+ */
+typedef struct rng {
+  uint64_t s[4];
+} rng_t;
+
+/**
+ * The independent streams of one match. Each part of the game draws from
+ * its own stream, so e.g. a powerup spawning does not change the next maze.
+ */
+typedef struct rng_streams {
+  rng_t maze; // wall layout
+  rng_t spawns; // tank spawn cells
+  rng_t powerups; // powerup type and cell
+  rng_t events; // the cannon event
+} rng_streams_t;
+
+/**
+ * Creates a generator from a seed.
+ *
+ * @param seed any value; equal seeds give equal sequences
+ * @return the generator
+ */
+rng_t rng_init(uint64_t seed);
+
+/**
+ * Advances a generator by 2^128 steps. Generators jumped apart from one
+ * seed never overlap, however long they run.
+ *
+ * @param rng the generator
+ */
+void rng_jump(rng_t *rng);
+
+/**
+ * Creates the streams of a match from its seed, one jump apart.
+ *
+ * @param seed any value; equal seeds give equal streams
+ * @return the streams
+ */
+rng_streams_t rng_streams_init(uint64_t seed);
+
+/**
+ * Returns the next 64 random bits of a generator.
+ *
+ * @param rng the generator
+ * @return the bits
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * Returns the next number of a generator.
+ *
+ * @param rng the generator
+ * @return a number in [0, 1), with 53 random bits
+ */
+double rng_double(rng_t *rng);
+
+/**
+ * Returns a random index.
+ *
+ * @param rng the generator
+ * @param n the number of indices, above 0
+ * @return a number in [0, n)
+ */
+size_t rng_below(rng_t *rng, size_t n);
+
+#endif // #ifndef __RNG_H__
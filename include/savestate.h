@@ -0,0 +1,71 @@
+#ifndef __SAVESTATE_H__
+#define __SAVESTATE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "powerups.h"
+
+/**
+ * A whole match copied into one flat buffer with no pointers in it: the
+ * random streams, counters and camera, every tank, projectile and powerup
+ * with the state their force creators keep between ticks, the maze's walls
+ * and the particles. The buffer can be kept for rollback, copied with
+ * memcpy or written to a file, and is reused between captures.
+ *
+ * Capturing only copies values and takes a few microseconds. Restoring
+ * cannot patch the scene's heap objects in place, so it frees the scene and
+ * builds the bodies and force creators again before writing the saved
+ * values back; it costs about as much as spawning the same objects. The
+ * maze is only regenerated when its walls differ from the saved ones.
+ * The inputs logged for game_record_tick() are dropped.
+ */
+typedef struct savestate {
+  uint8_t *data;
+  size_t length;
+  size_t capacity;
+} savestate_t;
+
+/**
+ * Allocates an empty savestate.
+ *
+ * @return the new savestate
+ */
+savestate_t *savestate_init();
+
+/**
+ * Saves a match, replacing what the savestate held.
+ * Must be called between ticks, on the thread that runs game_tick().
+ *
+ * @param savestate the savestate
+ * @param state the match
+ */
+void savestate_capture(savestate_t *savestate, state_t *state);
+
+/**
+ * Puts a match back the way it was when it was saved. Ticking it from
+ * there gives the same states, hash for hash, as the original did.
+ *
+ * @param savestate a savestate filled by savestate_capture()
+ * @param state a match with the same maze size as the saved one
+ * @return false, leaving the match untouched, if the maze sizes differ
+ */
+bool savestate_restore(const savestate_t *savestate, state_t *state);
+
+/**
+ * Returns the configuration of the saved match, to create a match the
+ * savestate can be restored into.
+ *
+ * @param savestate a savestate filled by savestate_capture()
+ * @return the configuration
+ */
+game_config_t savestate_config(const savestate_t *savestate);
+
+/**
+ * Releases a savestate.
+ *
+ * @param savestate a pointer returned from savestate_init()
+ */
+void savestate_free(savestate_t *savestate);
+
+#endif // #ifndef __SAVESTATE_H__
@@ -0,0 +1,83 @@
+#ifndef __SCRIPT_H__
+#define __SCRIPT_H__
+
+#include <stddef.h>
+#include "game.h"
+
+typedef struct scripted_input {
+  size_t tick;
+  input_event_t event;
+} scripted_input_t;
+
+/**
+ * Inputs read from a file, one per line: a tick, a player (0 to 2), an
+ * action (forward, backward, left, right or shoot) and down or up, e.g.
+ * "120 1 shoot down". Lines starting with # are skipped. Ticks must not
+ * decrease. The script repeats once its last tick has passed.
+ * A loaded script is only read, so many matches may share it.
+ */
+typedef struct script {
+  scripted_input_t *inputs;
+  size_t count;
+  size_t capacity;
+  size_t period;
+} script_t;
+
+/**
+ * Reads a script file.
+ *
+ * @param path the file
+ * @return the script, or NULL if the file is missing or malformed (the
+ *   reason is printed to stderr)
+ */
+script_t *script_load(const char *path);
+
+/**
+ * Releases a script.
+ *
+ * @param script a pointer returned from script_load()
+ */
+void script_free(script_t *script);
+
+/**
+ * Applies the inputs of a script due at a tick. Must be called for every
+ * tick in order, starting from 0.
+ *
+ * @param script the script
+ * @param state the match
+ * @param tick the tick about to run
+ * @param next the match's position in the script, 0 before the first call
+ */
+void script_apply(script_t *script, state_t *state, size_t tick, size_t *next);
+
+/**
+ * Applies the built-in script used when none is given: every player drives
+ * forward, turns for a while and fires at a steady rate, so a run covers
+ * movement, wall collisions, bullets and deaths.
+ *
+ * @param state the match
+ * @param tick the tick about to run
+ */
+void script_apply_pattern(state_t *state, size_t tick);
+
+/**
+ * Plays ticks of a match with the built-in script, from the match's
+ * current tick.
+ *
+ * @param state the match
+ * @param ticks the number of ticks to play
+ * @param dt the length of each tick, in seconds
+ */
+void script_play(state_t *state, size_t ticks, double dt);
+
+/**
+ * Returns the controls the built-in script holds down for one player, for
+ * front ends that send the state of the controls rather than presses.
+ *
+ * @param player the set of controls
+ * @param tick the tick about to run
+ * @return a bit (1 << action) for each input_action_t held down
+ */
+uint8_t script_pattern_buttons(size_t player, size_t tick);
+
+#endif // #ifndef __SCRIPT_H__
@@ -0,0 +1,164 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "color.h"
+#include "vector.h"
+
+typedef struct state state_t;
+
+#define HUD_PLAYERS 3
+#define SNAPSHOT_MAX_TREADS 64
+#define HUD_BANNER_LENGTH 48
+
+/**
+ * The numbers shown on the HUD.
+ */
+typedef struct hud_snapshot {
+  rgb_color_t colors[HUD_PLAYERS];
+  size_t wins[HUD_PLAYERS];
+  bool alive[HUD_PLAYERS];
+  size_t bullets[HUD_PLAYERS];
+  size_t special_shots[HUD_PLAYERS]; // shots left of the powerup held, 0 if none
+  size_t bullet_limit;
+  double countdown; // seconds until the next game, 0 during a game
+  bool show_controls;
+  char banner[HUD_BANNER_LENGTH];
+} hud_snapshot_t;
+
+/**
+ * Everything the renderer needs to draw one simulation step, copied out of
+ * the scene into flat arrays. A snapshot holds no pointer into the
+ * simulation, so it can be drawn on another thread while the next step runs.
+ */
+typedef struct frame_snapshot {
+  size_t tick;
+  double sim_frame_time; // filled in by the front end, which times the tick
+
+  // the static maze layer, redrawn when the generation or revision changes
+  vector_t lower_left;
+  vector_t upper_right;
+  size_t columns;
+  size_t rows;
+  size_t maze_generation;
+  size_t revision_before;
+  size_t revision;
+  size_t wall_count;
+  size_t wall_capacity;
+  float *wall_xy; // 4 corners per wall
+  rgb_color_t *wall_colors;
+  size_t dirty_count;
+  size_t dirty_capacity;
+  size_t *dirty_cells; // cells whose walls changed between revision_before and revision
+
+  // the part of the arena the camera shows
+  vector_t view_lower_left;
+  vector_t view_upper_right;
+
+  // the visible bodies as polygons
+  size_t polygon_count;
+  size_t polygon_capacity;
+  uint32_t *polygon_sizes;
+  uint32_t *polygon_offsets; // index of each polygon's first vertex
+  uint32_t *polygon_cells;
+  rgb_color_t *polygon_colors;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  float *xy;
+
+  // the polygons bucketed by the maze cell holding their center, so a view
+  // only visits the cells it overlaps. The polygons of bucket i are
+  // cell_polygons[cell_start[i]] to cell_polygons[cell_start[i + 1] - 1].
+  // The last bucket holds polygons larger than a cell, which are always tested.
+  size_t cell_count;
+  size_t cell_capacity;
+  uint32_t *cell_start;
+  uint32_t *cell_polygons;
+
+  // the particles
+  size_t particle_count;
+  size_t particle_capacity;
+  float *particle_x;
+  float *particle_y;
+  float *particle_angle;
+  float *particle_size;
+  rgb_color_t *particle_colors;
+
+  // the pose of each live tank, for the tread marks; a tank keeps its id for its whole life
+  size_t tread_count;
+  uint32_t tread_ids[SNAPSHOT_MAX_TREADS]; // below SNAPSHOT_MAX_TREADS
+  float tread_x[SNAPSHOT_MAX_TREADS];
+  float tread_y[SNAPSHOT_MAX_TREADS];
+  float tread_angle[SNAPSHOT_MAX_TREADS];
+
+  // filled by the game, since only it knows which bodies are tanks and what the numbers mean
+  hud_snapshot_t hud;
+} frame_snapshot_t;
+
+/**
+ * A lock-free triple buffer of snapshots with one writer and one reader.
+ * The writer always has a slot of its own to fill, and publishing swaps it
+ * with the middle slot, so the simulation never waits for the renderer.
+ * The reader takes the most recent published snapshot; older ones it did
+ * not get to are skipped.
+ */
+typedef struct snapshot_buffer {
+  frame_snapshot_t slots[3];
+  size_t back;
+  size_t front;
+  atomic_size_t middle;
+  bool has_front;
+} snapshot_buffer_t;
+
+/**
+ * Allocates an empty triple buffer.
+ *
+ * @return the new buffer
+ */
+snapshot_buffer_t *snapshot_buffer_init();
+
+/**
+ * Releases a triple buffer and its snapshots.
+ *
+ * @param buffer a pointer returned from snapshot_buffer_init()
+ */
+void snapshot_buffer_free(snapshot_buffer_t *buffer);
+
+/**
+ * Returns the snapshot the writer may fill. Writer thread only.
+ *
+ * @param buffer the buffer
+ * @return the writer's snapshot
+ */
+frame_snapshot_t *snapshot_begin_write(snapshot_buffer_t *buffer);
+
+/**
+ * Makes the snapshot returned by snapshot_begin_write() visible to the reader.
+ * Writer thread only.
+ *
+ * @param buffer the buffer
+ */
+void snapshot_publish(snapshot_buffer_t *buffer);
+
+/**
+ * Returns the most recent published snapshot. Reader thread only.
+ * The snapshot stays valid until the next call.
+ *
+ * @param buffer the buffer
+ * @return the latest snapshot, or NULL if none has been published yet
+ */
+frame_snapshot_t *snapshot_acquire(snapshot_buffer_t *buffer);
+
+/**
+ * Copies the drawable state of a match into a snapshot and marks the
+ * maze's dirty cells as consumed.
+ *
+ * @param state the state
+ * @param snapshot the snapshot to fill
+ */
+void snapshot_capture(state_t *state, frame_snapshot_t *snapshot);
+
+#endif // #ifndef __SNAPSHOT_H__
@@ -0,0 +1,90 @@
+#ifndef __SOUND_H__
+#define __SOUND_H__
+
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include "assets.h"
+#include "audio.h"
+
+// the most voices a single sound may use at once
+#define SOUND_MAX_VOICES 4
+// the most threads decoding sounds at startup
+#define SOUND_MAX_WORKERS 4
+
+/**
+ * Every sound effect of the game, decoded once at startup.
+ * Each sound owns a small ring of voices (mixer channels); playing a sound
+ * whose voices are all busy restarts its oldest voice instead of piling
+ * up more copies of the same effect.
+ */
+typedef struct sound_bank {
+  Mix_Chunk *chunks[SOUND_COUNT];
+  size_t voice_limit[SOUND_COUNT];
+  int voices[SOUND_COUNT][SOUND_MAX_VOICES];
+  size_t next_voice[SOUND_COUNT];
+  Mix_Music *music;
+  asset_archive_t *archive;
+  SDL_Thread *workers[SOUND_MAX_WORKERS];
+  size_t worker_count;
+} sound_bank_t;
+
+/**
+ * Starts decoding every sound effect on worker threads and returns at once,
+ * so other startup work can run while the sounds decode.
+ * Sounds are read from the archive when it holds them and from the
+ * assets directory otherwise. Must be called after Mix_OpenAudio().
+ *
+ * @param archive the asset archive, may be NULL; it must outlive the bank
+ * @return the new sound bank
+ */
+sound_bank_t *sound_bank_init(asset_archive_t *archive);
+
+/**
+ * Waits for the sound effects to finish decoding and loads the music.
+ * Must be called before any other use of the bank.
+ *
+ * @param bank the sound bank
+ */
+void sound_bank_wait(sound_bank_t *bank);
+
+/**
+ * Releases every sound of the bank and the bank itself.
+ *
+ * @param bank a pointer returned from sound_bank_init()
+ */
+void sound_bank_free(sound_bank_t *bank);
+
+/**
+ * Plays a sound effect, respecting its voice limit.
+ * Does nothing if the bank is NULL or the sound failed to load.
+ *
+ * @param bank the sound bank
+ * @param id the sound to play
+ */
+void sound_play(sound_bank_t *bank, sound_id_t id);
+
+/**
+ * Returns an audio sink that plays the game's sound effects from the bank.
+ *
+ * @param bank the sound bank; it must outlive the sink
+ * @return the sink
+ */
+audio_t sound_bank_audio(sound_bank_t *bank);
+
+/**
+ * Starts looping the background music.
+ *
+ * @param bank the sound bank
+ */
+void sound_play_music(sound_bank_t *bank);
+
+/**
+ * Returns the number of bytes of decoded audio held by the bank.
+ *
+ * @param bank the sound bank
+ * @return the memory used by the decoded sound effects
+ */
+size_t sound_bank_memory(sound_bank_t *bank);
+
+#endif // #ifndef __SOUND_H__
@@ -1,5 +1,4 @@
 #include "math.h"
-#include "sdl_wrapper.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -24,6 +23,13 @@ state_t *emscripten_init();
  */
 void emscripten_main(state_t *state);
 
+/**
+ * Draws the most recent state published by emscripten_main()
+ * May run on another thread than emscripten_main, but must run on the
+ * thread that called emscripten_init
+ */
+void emscripten_render(state_t *state);
+
 /**
  * Frees anything allocated in the demo
  * Should free everything in state as well as state itself.
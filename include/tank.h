@@ -2,12 +2,15 @@
 #define __TANK_H__
 
 #include <math.h>
-#include "sdl_wrapper.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include "body.h"
 #include "state.h"
 #include "maze.h"
+#include "broadphase.h"
+
+// the side of a tank's square hitbox, which the maze tests tanks against
+#define TANK_SIZE 50
 
 typedef struct tank tank_t;
 
@@ -28,6 +31,10 @@ typedef struct tank {
   shot_handler_t bang;
   size_t powerup_shots_left;
   size_t exists;
+  // the motion of the last step, undone by tank_maze_force() if it ended in a wall
+  vector_t last_velocity;
+  double last_rotation;
+  double last_dt;
 } tank_t;
 
 typedef struct body_tank {
@@ -50,8 +57,9 @@ typedef struct decay {
  * @param tank
  * @param body
  * @param time
+ * @return the aux, owned by the scene, whose time is what is left of the bullet's life
 */
-void create_decay_force(state_t *state, tank_t *tank, body_t *body, double time);
+decay_t *create_decay_force(state_t *state, tank_t *tank, body_t *body, double time);
 
 /** 
  * Adds a destructive collision on the given bullet and the given tank in the scene.
@@ -92,6 +100,15 @@ list_t *tank_hitbox_shape(vector_t center, size_t size);
 */
 tank_t *tank_init(vector_t center, size_t size, rgb_color_t color);
 
+/**
+ * Creates a body with the mass of a tank
+ *
+ * @param shape the outline of the body
+ * @param color the color of the body
+ * @return the new body
+*/
+body_t *tank_body_init(list_t *shape, rgb_color_t color);
+
 /**
  * Returns the body of a tank
  * 
@@ -160,6 +177,24 @@ list_t* tank_get_flags(tank_t *tank);
  */
 void tank_execute_flags(tank_t *tank);
 
+/**
+ * Returns the speed tank_execute_flags() gives a tank with these flags,
+ * negative when it backs up.
+ *
+ * @param flags the movement flags
+ * @return the speed, in pixels per second
+ */
+double tank_flags_speed(mov_flags_t flags);
+
+/**
+ * Returns the angle tank_execute_flags() turns a tank with these flags by
+ * in one tick, counterclockwise.
+ *
+ * @param flags the movement flags
+ * @return the angle, in radians
+ */
+double tank_flags_turn(mov_flags_t flags);
+
 /** 
  * Removes the tank from the state.
  * Calls tank_debris to plays the debris effect.
@@ -208,4 +243,18 @@ void add_tank_maze_force(state_t *state, maze_t *maze, tank_t *tank, size_t tank
  */
 void create_tank_killbox(scene_t *scene, tank_t *tank, body_t *body);
 
+/** 
+ * Pushes apart every pair of overlapping tanks along their axis of
+ * least penetration. Candidate pairs come from the given grid, which
+ * is rebuilt from the tank hitboxes on every call. Each tank takes half
+ * the push. A tank the push would put into a wall stays put, and the
+ * other takes the whole push if it can.
+ *
+ * @param broadphase a grid covering the maze, with room for count tanks
+ * @param maze the maze the tanks drive in
+ * @param tanks the live tanks
+ * @param count the number of tanks
+ */
+void tanks_separate(broadphase_t *broadphase, maze_t *maze, tank_t **tanks, size_t count);
+
 #endif // #ifndef __TANK_H__
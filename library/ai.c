@@ -0,0 +1,386 @@
+#include "ai.h"
+#include "clock.h"
+#include "tank.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define TAU (6.28318530717958)
+
+// budget constants
+const double AI_BUDGET = 50e-6; // seconds of thinking per player per tick
+const size_t AI_SCANS_PER_TICK = 4;
+
+// shot constants, for the normal bullet every tank fires without a powerup
+const size_t AI_SHOT_BOUNCES = 3;
+const double AI_SHOT_RANGE = 1000.; // 200 px/s for the 5 s a bullet lasts
+const double AI_SHOT_RADIUS = 6.;
+const double AI_MUZZLE = 35.; // how far ahead of the tank's center normal_shot() places the bullet
+const double AI_HIT_RADIUS = 28.; // a bullet this close to a tank's center hits it
+const double AI_SELF_RADIUS = 60.; // a shot coming back this close is refused, as the shooter may not get away
+const size_t AI_FIRE_INTERVAL = 15; // ticks
+
+// threat constants
+const double AI_THREAT_HORIZON = .6; // seconds of projectile flight looked ahead
+const double AI_THREAT_RADIUS = 45.;
+const size_t AI_THREAT_BOUNCES = 2;
+#define AI_MAX_THREATS 12 // projectiles followed per tick, nearest first
+
+// driving constants
+const double AI_FACING = .5; // radians off the heading it wants within which it drives forward
+const double AI_DEADBAND = TAU / 220.; // half the angle a tank turns in one tick
+const double AI_ALIGN = 12.; // how far off the middle of its cell a tank may be when it turns a corner
+const double AI_STUCK_DISTANCE = 1.;
+const size_t AI_STUCK_TICKS = 20;
+const size_t AI_REVERSE_TICKS = 15;
+
+ai_t *ai_init(uint8_t tanks) {
+  ai_t *ai = malloc(sizeof(ai_t));
+  assert(ai != NULL);
+  ai->budget = AI_BUDGET;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    ai->players[i] = (ai_player_t){.enabled = (tanks >> i & 1) != 0, .aim_age = SIZE_MAX};
+  }
+  return ai;
+}
+
+void ai_free(ai_t *ai) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    free(ai->players[i].distances);
+    if (ai->players[i].lookahead != NULL) {
+      lookahead_free(ai->players[i].lookahead);
+    }
+  }
+  free(ai);
+}
+
+bool ai_use_lookahead(ai_t *ai, state_t *state, size_t player, size_t workers, size_t min_rollouts) {
+  ai_player_t *cpu = &ai->players[player];
+  assert(cpu->lookahead == NULL);
+  cpu->lookahead = lookahead_init(player, workers, min_rollouts, state->maze->columns * state->maze->rows);
+  if (cpu->lookahead == NULL) {
+    return false;
+  }
+  cpu->enabled = true;
+  return true;
+}
+
+/**
+ * Returns the cell index a point lies in, clamped to the maze.
+ */
+size_t ai_cell(maze_t *maze, vector_t point) {
+  double width = (maze->upper_right.x - maze->lower_left.x) / maze->columns;
+  double height = (maze->upper_right.y - maze->lower_left.y) / maze->rows;
+  double column = floor((point.x - maze->lower_left.x) / width);
+  double row = floor((point.y - maze->lower_left.y) / height);
+  column = fmin(fmax(column, 0), maze->columns - 1);
+  row = fmin(fmax(row, 0), maze->rows - 1);
+  return (size_t)column + maze->columns * (size_t)row;
+}
+
+vector_t ai_cell_center(maze_t *maze, size_t cell) {
+  double width = (maze->upper_right.x - maze->lower_left.x) / maze->columns;
+  double height = (maze->upper_right.y - maze->lower_left.y) / maze->rows;
+  return (vector_t){
+    maze->lower_left.x + (cell % maze->columns + .5) * width,
+    maze->lower_left.y + (cell / maze->columns + .5) * height,
+  };
+}
+
+/**
+ * Finds the distance from every cell to the target's with a breadth-first
+ * search of the cell graph, unless the one found last is still good: the
+ * same maze, unchanged, and the target in the same cell.
+ */
+void ai_update_paths(ai_player_t *player, state_t *state, size_t target_cell) {
+  maze_t *maze = state->maze;
+  if (player->maze == maze && player->maze_generation == state->maze_generation
+      && player->maze_revision == maze->revision && player->target_cell == target_cell) {
+    return;
+  }
+  size_t cells = maze->columns * maze->rows;
+  if (cells != player->cells) {
+    // the search queue lives after the distances
+    player->distances = realloc(player->distances, sizeof(uint16_t) * cells * 2);
+    assert(player->distances != NULL);
+    player->cells = cells;
+  }
+  maze_distances(maze, &target_cell, 1, player->distances, &player->distances[cells]);
+  player->maze = maze;
+  player->maze_generation = state->maze_generation;
+  player->maze_revision = maze->revision;
+  player->target_cell = target_cell;
+  player->path_builds = player->path_builds + 1;
+}
+
+/**
+ * Returns how far a point is from a segment, and how far along the segment
+ * (0 to 1) the nearest point is.
+ */
+double ai_segment_distance(vector_t start, vector_t end, vector_t point, double *along) {
+  vector_t segment = vec_subtract(end, start);
+  double length_squared = vec_dot(segment, segment);
+  double t = length_squared > 0 ? vec_dot(vec_subtract(point, start), segment) / length_squared : 0;
+  t = fmin(fmax(t, 0), 1);
+  *along = t;
+  vector_t offset = vec_subtract(point, vec_add(start, vec_multiply(t, segment)));
+  return sqrt(vec_dot(offset, offset));
+}
+
+bool ai_in_maze(maze_t *maze, vector_t point) {
+  return point.x > maze->lower_left.x && point.x < maze->upper_right.x && point.y > maze->lower_left.y
+         && point.y < maze->upper_right.y;
+}
+
+/**
+ * Follows the bullet a tank would fire at a heading, off the walls, and
+ * returns whether it passes the target before it passes the tank itself.
+ */
+bool ai_shot_hits(maze_t *maze, vector_t center, double heading, vector_t target) {
+  vector_t direction = {cos(heading), sin(heading)};
+  vector_t start = vec_add(center, vec_multiply(AI_MUZZLE, direction));
+  if (!ai_in_maze(maze, start)) {
+    return false;
+  }
+  vector_t hits[AI_SHOT_BOUNCES + 1];
+  size_t count = maze_raycast(maze, start, direction, AI_SHOT_RADIUS, AI_SHOT_BOUNCES, AI_SHOT_RANGE, hits);
+  for (size_t i = 0; i < count; i++) {
+    double target_along;
+    double target_distance = ai_segment_distance(start, hits[i], target, &target_along);
+    // the first leg leaves the muzzle, away from the tank
+    double self_along = 1;
+    double self_distance = i > 0 ? ai_segment_distance(start, hits[i], center, &self_along) : INFINITY;
+    if (self_distance < AI_SELF_RADIUS && (target_distance >= AI_HIT_RADIUS || self_along < target_along)) {
+      return false;
+    }
+    if (target_distance < AI_HIT_RADIUS) {
+      return true;
+    }
+    start = hits[i];
+  }
+  return false;
+}
+
+/**
+ * Finds the projectile that would come nearest to reaching the tank soonest,
+ * following the nearest few along their bounces.
+ *
+ * @return false if none comes within AI_THREAT_RADIUS; otherwise away is
+ *   the direction to move out of its path
+ */
+bool ai_threat(state_t *state, vector_t center, vector_t *away) {
+  projectile_pool_t *projectiles = state->projectiles;
+  size_t nearest[AI_MAX_THREATS];
+  double nearest_distance[AI_MAX_THREATS];
+  size_t count = 0;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body == NULL || body_is_removed(body)) {
+      continue;
+    }
+    vector_t velocity = body_get_velocity(body);
+    double speed = sqrt(vec_dot(velocity, velocity));
+    vector_t offset = vec_subtract(body->center, center);
+    double distance = sqrt(vec_dot(offset, offset));
+    if (speed == 0 || distance - speed * AI_THREAT_HORIZON > AI_THREAT_RADIUS) {
+      continue;
+    }
+    // keep the nearest few, in order
+    size_t j = count < AI_MAX_THREATS ? count : AI_MAX_THREATS - 1;
+    if (count == AI_MAX_THREATS && distance >= nearest_distance[j]) {
+      continue;
+    }
+    for (; j > 0 && nearest_distance[j - 1] > distance; j--) {
+      nearest[j] = nearest[j - 1];
+      nearest_distance[j] = nearest_distance[j - 1];
+    }
+    nearest[j] = i;
+    nearest_distance[j] = distance;
+    count = count < AI_MAX_THREATS ? count + 1 : count;
+  }
+
+  double soonest = INFINITY;
+  for (size_t k = 0; k < count; k++) {
+    body_t *body = projectiles->bodies[nearest[k]];
+    vector_t start = body->center;
+    if (!ai_in_maze(state->maze, start)) {
+      continue;
+    }
+    vector_t velocity = body_get_velocity(body);
+    double speed = sqrt(vec_dot(velocity, velocity));
+    vector_t hits[AI_THREAT_BOUNCES + 1];
+    size_t points = maze_raycast(state->maze, start, velocity, projectiles->radii[nearest[k]], AI_THREAT_BOUNCES,
+                                 speed * AI_THREAT_HORIZON, hits);
+    double travelled = 0;
+    for (size_t i = 0; i < points; i++) {
+      vector_t segment = vec_subtract(hits[i], start);
+      double length = sqrt(vec_dot(segment, segment));
+      double along;
+      double distance = ai_segment_distance(start, hits[i], center, &along);
+      // a projectile already past the tank on its first leg is no danger until it bounces
+      bool receding = i == 0 && vec_dot(velocity, vec_subtract(center, start)) <= 0;
+      if (!receding && distance < AI_THREAT_RADIUS) {
+        double time = (travelled + along * length) / speed;
+        if (time < soonest) {
+          soonest = time;
+          vector_t nearest_point = vec_add(start, vec_multiply(along, segment));
+          vector_t out = vec_subtract(center, nearest_point);
+          // dead on: step to the side of the projectile's path
+          *away = vec_dot(out, out) > 1e-6 ? out : (vector_t){-segment.y, segment.x};
+        }
+        break;
+      }
+      travelled = travelled + length;
+      start = hits[i];
+    }
+  }
+  return soonest < INFINITY;
+}
+
+/**
+ * Returns the buttons that turn a tank toward a heading, driving forward
+ * once it roughly faces it.
+ */
+uint8_t ai_steer(double orientation, double heading, bool drive) {
+  double off = remainder(heading - orientation, TAU);
+  uint8_t buttons = 0;
+  if (off > AI_DEADBAND) {
+    buttons = buttons | 1 << INPUT_LEFT;
+  } else if (off < -AI_DEADBAND) {
+    buttons = buttons | 1 << INPUT_RIGHT;
+  }
+  if (drive && fabs(off) < AI_FACING) {
+    buttons = buttons | 1 << INPUT_FORWARD;
+  }
+  return buttons;
+}
+
+/**
+ * Returns where a tank should drive next on the way to its target: the
+ * middle of the next cell along the shortest path, or first the middle of
+ * its own cell if it is too far off it to turn the corner without
+ * catching a wall.
+ */
+vector_t ai_waypoint(ai_player_t *player, maze_t *maze, vector_t center, vector_t target) {
+  size_t cell = ai_cell(maze, center);
+  uint16_t distance = player->distances[cell];
+  if (distance == 0 || distance == UINT16_MAX) {
+    return target;
+  }
+  for (uint8_t side = WALL_LEFT; side <= WALL_UP; side = side << 1) {
+    size_t next = maze_neighbour(maze, cell, side);
+    if (next == SIZE_MAX || player->distances[next] != distance - 1) {
+      continue;
+    }
+    vector_t middle = ai_cell_center(maze, cell);
+    bool across = side == WALL_LEFT || side == WALL_RIGHT;
+    double off = across ? fabs(center.y - middle.y) : fabs(center.x - middle.x);
+    return off > AI_ALIGN ? middle : ai_cell_center(maze, next);
+  }
+  return target;
+}
+
+/**
+ * Chooses the buttons of one CPU player for this tick.
+ */
+uint8_t ai_think(ai_t *ai, ai_player_t *player, state_t *state, size_t self, double start) {
+  tank_t *tank = player_tank(state, self);
+  if (tank == NULL) {
+    return 0;
+  }
+  body_t *body = get_tank_body(tank);
+  vector_t center = body->center;
+  double orientation = body->orientation;
+  maze_t *maze = state->maze;
+
+  tank_t *target = NULL;
+  double best = INFINITY;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    tank_t *other = player_tank(state, i);
+    if (i == self || other == NULL) {
+      continue;
+    }
+    vector_t offset = vec_subtract(get_tank_body(other)->center, center);
+    if (vec_dot(offset, offset) < best) {
+      best = vec_dot(offset, offset);
+      target = other;
+    }
+  }
+
+  uint8_t buttons = 0;
+  bool drove = (player->held >> INPUT_FORWARD & 1) != 0;
+  vector_t moved = vec_subtract(center, player->last_center);
+  player->last_center = center;
+  player->stuck_ticks = drove && vec_dot(moved, moved) < AI_STUCK_DISTANCE * AI_STUCK_DISTANCE
+                        ? player->stuck_ticks + 1 : 0;
+  if (player->stuck_ticks > AI_STUCK_TICKS) {
+    player->stuck_ticks = 0;
+    player->reverse_ticks = AI_REVERSE_TICKS;
+  }
+  player->fire_cooldown = player->fire_cooldown > 0 ? player->fire_cooldown - 1 : 0;
+  player->aim_age = player->aim_age < SIZE_MAX ? player->aim_age + 1 : SIZE_MAX;
+
+  vector_t away;
+  if (ai_threat(state, center, &away)) {
+    // out of the way forwards, or backwards if the tank faces the other way
+    double heading = atan2(away.y, away.x);
+    double forward_off = remainder(heading - orientation, TAU);
+    if (fabs(forward_off) <= TAU / 4) {
+      buttons = ai_steer(orientation, heading, true);
+    } else {
+      buttons = ai_steer(orientation, heading + TAU / 2, false) | 1 << INPUT_BACKWARD;
+    }
+  } else if (player->reverse_ticks > 0) {
+    player->reverse_ticks = player->reverse_ticks - 1;
+    buttons = 1 << INPUT_BACKWARD | 1 << INPUT_LEFT;
+  } else if (target != NULL) {
+    vector_t target_center = get_tank_body(target)->center;
+    ai_update_paths(player, state, ai_cell(maze, target_center));
+    // the sweep is what a tick can go without when the rest ran long
+    if (clock_now() - start < ai->budget / 2) {
+      for (size_t i = 0; i < AI_SCANS_PER_TICK; i++) {
+        double heading = player->scan_next * TAU / AI_SCAN_ANGLES;
+        player->scan_next = (player->scan_next + 1) % AI_SCAN_ANGLES;
+        bool nearer = fabs(remainder(heading - orientation, TAU))
+                      < fabs(remainder(player->aim_angle - orientation, TAU));
+        if ((player->aim_age > AI_SCAN_ANGLES / AI_SCANS_PER_TICK || nearer)
+            && ai_shot_hits(maze, center, heading, target_center)) {
+          player->aim_angle = heading;
+          player->aim_age = 0;
+        }
+      }
+    } else {
+      player->over_budget = player->over_budget + 1;
+    }
+    if (player->aim_age <= AI_SCAN_ANGLES / AI_SCANS_PER_TICK) {
+      buttons = ai_steer(orientation, player->aim_angle, false);
+    } else {
+      vector_t waypoint = ai_waypoint(player, maze, center, target_center);
+      buttons = ai_steer(orientation, atan2(waypoint.y - center.y, waypoint.x - center.x), true);
+    }
+    if (player->fire_cooldown == 0 && ai_shot_hits(maze, center, orientation, target_center)) {
+      buttons = buttons | 1 << INPUT_SHOOT;
+      player->fire_cooldown = AI_FIRE_INTERVAL;
+    }
+  }
+  return buttons;
+}
+
+void ai_tick(ai_t *ai, state_t *state) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    ai_player_t *player = &ai->players[i];
+    if (!player->enabled) {
+      continue;
+    }
+    double start = clock_now();
+    uint8_t buttons = player->lookahead != NULL ? lookahead_tick(player->lookahead, state)
+                                                : ai_think(ai, player, state, i, start);
+    double elapsed = clock_now() - start;
+    player->think_time = player->think_time + elapsed;
+    player->worst_time = fmax(player->worst_time, elapsed);
+    player->late = player->late + (elapsed > ai->budget);
+    player->thinks = player->thinks + 1;
+    game_apply_buttons(state, i, buttons, player->held);
+    player->held = buttons;
+  }
+}
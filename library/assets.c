@@ -0,0 +1,187 @@
+#include "assets.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// archive constants
+const char ASSET_MAGIC[4] = {'T', 'T', 'P', 'K'};
+const uint32_t ASSET_VERSION = 1;
+
+typedef struct asset_header {
+  char magic[4];
+  uint32_t version;
+  uint64_t count;
+} asset_header_t;
+
+/**
+ * Reads a whole file into memory, for platforms without mmap.
+ */
+uint8_t *assets_read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  *size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *data = malloc(*size);
+  assert(data != NULL);
+  if (fread(data, 1, *size, file) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(file);
+  return data;
+}
+
+asset_archive_t *assets_open(const char *path) {
+  const uint8_t *data;
+  size_t size;
+  bool mapped;
+#ifdef __EMSCRIPTEN__
+  data = assets_read_file(path, &size);
+  mapped = false;
+  if (data == NULL) {
+    return NULL;
+  }
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  size = info.st_size;
+  data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  mapped = true;
+#endif
+
+  asset_archive_t *archive = malloc(sizeof(asset_archive_t));
+  assert(archive != NULL);
+  *archive = (asset_archive_t){.data = data, .size = size, .mapped = mapped};
+
+  const asset_header_t *header = (const asset_header_t *)data;
+  bool valid = size >= sizeof(asset_header_t)
+    && memcmp(header->magic, ASSET_MAGIC, sizeof(ASSET_MAGIC)) == 0
+    && header->version == ASSET_VERSION
+    && header->count <= (size - sizeof(asset_header_t)) / sizeof(asset_entry_t);
+  if (valid) {
+    archive->entries = (const asset_entry_t *)(data + sizeof(asset_header_t));
+    archive->count = header->count;
+    for (size_t i = 0; i < archive->count; i++) {
+      const asset_entry_t *entry = &archive->entries[i];
+      if (entry->offset > size || entry->size > size - entry->offset
+          || entry->name[ASSET_NAME_LENGTH - 1] != '\0') {
+        valid = false;
+        break;
+      }
+    }
+  }
+  if (!valid) {
+    fprintf(stderr, "%s is not a valid asset archive\n", path);
+    assets_close(archive);
+    return NULL;
+  }
+  return archive;
+}
+
+void assets_close(asset_archive_t *archive) {
+#ifndef __EMSCRIPTEN__
+  if (archive->mapped) {
+    munmap((void *)archive->data, archive->size);
+  } else {
+    free((void *)archive->data);
+  }
+#else
+  free((void *)archive->data);
+#endif
+  free(archive);
+}
+
+int assets_compare(const void *name, const void *entry) {
+  return strcmp((const char *)name, ((const asset_entry_t *)entry)->name);
+}
+
+const void *assets_find(asset_archive_t *archive, const char *name, size_t *size) {
+  if (archive == NULL) {
+    return NULL;
+  }
+  const asset_entry_t *entry = bsearch(name, archive->entries, archive->count,
+                                       sizeof(asset_entry_t), assets_compare);
+  if (entry == NULL) {
+    return NULL;
+  }
+  *size = entry->size;
+  return archive->data + entry->offset;
+}
+
+int assets_compare_entries(const void *entry1, const void *entry2) {
+  return strcmp(((const asset_entry_t *)entry1)->name, ((const asset_entry_t *)entry2)->name);
+}
+
+bool assets_pack(const char *archive_path, const char **paths, size_t count) {
+  asset_entry_t *entries = calloc(count, sizeof(asset_entry_t));
+  uint8_t **contents = calloc(count, sizeof(uint8_t *));
+  assert(entries != NULL && contents != NULL);
+  bool ok = true;
+  uint64_t offset = sizeof(asset_header_t) + count * sizeof(asset_entry_t);
+  for (size_t i = 0; i < count && ok; i++) {
+    size_t size;
+    if (strlen(paths[i]) >= ASSET_NAME_LENGTH) {
+      fprintf(stderr, "Asset name too long: %s\n", paths[i]);
+      ok = false;
+      break;
+    }
+    contents[i] = assets_read_file(paths[i], &size);
+    if (contents[i] == NULL) {
+      fprintf(stderr, "Could not read %s\n", paths[i]);
+      ok = false;
+      break;
+    }
+    strcpy(entries[i].name, paths[i]);
+    entries[i].offset = offset;
+    entries[i].size = size;
+    offset += size;
+  }
+
+  FILE *file = ok ? fopen(archive_path, "wb") : NULL;
+  if (file != NULL) {
+    // the data is written in the original order, the index is sorted for bsearch
+    asset_entry_t *index = malloc(sizeof(asset_entry_t) * count);
+    assert(index != NULL);
+    memcpy(index, entries, sizeof(asset_entry_t) * count);
+    qsort(index, count, sizeof(asset_entry_t), assets_compare_entries);
+    asset_header_t header = {.version = ASSET_VERSION, .count = count};
+    memcpy(header.magic, ASSET_MAGIC, sizeof(ASSET_MAGIC));
+    ok = fwrite(&header, sizeof(header), 1, file) == 1
+      && fwrite(index, sizeof(asset_entry_t), count, file) == count;
+    for (size_t i = 0; i < count && ok; i++) {
+      ok = fwrite(contents[i], 1, entries[i].size, file) == entries[i].size;
+    }
+    free(index);
+    ok = fclose(file) == 0 && ok;
+  } else {
+    ok = false;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    free(contents[i]);
+  }
+  free(contents);
+  free(entries);
+  return ok;
+}
@@ -0,0 +1,11 @@
+#include "audio.h"
+
+audio_t audio_silent() {
+  return (audio_t){.play = NULL, .aux = NULL};
+}
+
+void audio_play(const audio_t *audio, sound_id_t id) {
+  if (audio->play != NULL) {
+    audio->play(audio->aux, id);
+  }
+}
@@ -0,0 +1,211 @@
+#include "game.h"
+#include "clock.h"
+#include "script.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// batch constants
+const double BATCH_DT = 1. / 60.;
+const size_t BATCH_DEFAULT_MATCHES = 1000;
+const uint64_t BATCH_DEFAULT_SEED = 1;
+const size_t BATCH_MAX_TICKS = 60 * 60 * 3; // a match still undecided after three minutes of game time times out
+#define BATCH_MAX_THREADS 256
+
+typedef enum {
+  OUTCOME_RED,
+  OUTCOME_GREEN,
+  OUTCOME_BLUE,
+  OUTCOME_DRAW,
+  OUTCOME_TIMEOUT,
+  OUTCOME_COUNT
+} outcome_t;
+
+const char *OUTCOME_NAMES[OUTCOME_COUNT] = {
+  [OUTCOME_RED] = "red wins",
+  [OUTCOME_GREEN] = "green wins",
+  [OUTCOME_BLUE] = "blue wins",
+  [OUTCOME_DRAW] = "draws",
+  [OUTCOME_TIMEOUT] = "timeouts",
+};
+
+/**
+ * What one worker thread saw. Each worker only writes its own stats, which
+ * are aligned to separate cache lines so the workers never contend.
+ */
+typedef struct batch_stats {
+  _Alignas(64) size_t matches;
+  size_t outcomes[OUTCOME_COUNT];
+  size_t ticks;
+  double busy_seconds;
+} batch_stats_t;
+
+typedef struct batch {
+  size_t matches;
+  uint64_t seed;
+  atomic_size_t next_match;
+  size_t *durations; // ticks each match lasted, by match index
+  outcome_t *outcomes;
+} batch_t;
+
+typedef struct batch_worker {
+  batch_t *batch;
+  batch_stats_t stats;
+  pthread_t thread;
+} batch_worker_t;
+
+/**
+ * Plays one game of a match to its end and tells who won.
+ */
+outcome_t run_match(game_config_t config, size_t *ticks) {
+  state_t *state = game_init(config, audio_silent());
+  size_t tick = 0;
+  while (state->games_played == 0 && tick < BATCH_MAX_TICKS) {
+    script_play(state, 1, BATCH_DT);
+    tick = tick + 1;
+  }
+  outcome_t outcome = OUTCOME_TIMEOUT;
+  if (state->red_wins > 0) {
+    outcome = OUTCOME_RED;
+  } else if (state->green_wins > 0) {
+    outcome = OUTCOME_GREEN;
+  } else if (state->blue_wins > 0) {
+    outcome = OUTCOME_BLUE;
+  } else if (state->games_played > 0) {
+    outcome = OUTCOME_DRAW;
+  }
+  game_free(state);
+  *ticks = tick;
+  return outcome;
+}
+
+void *batch_work(void *aux) {
+  batch_worker_t *worker = aux;
+  batch_t *batch = worker->batch;
+  double start = clock_now();
+  while (true) {
+    size_t match = atomic_fetch_add_explicit(&batch->next_match, 1, memory_order_relaxed);
+    if (match >= batch->matches) {
+      break;
+    }
+    game_config_t config = game_default_config(batch->seed + match);
+    size_t ticks;
+    outcome_t outcome = run_match(config, &ticks);
+    batch->durations[match] = ticks;
+    batch->outcomes[match] = outcome;
+    worker->stats.matches = worker->stats.matches + 1;
+    worker->stats.outcomes[outcome] = worker->stats.outcomes[outcome] + 1;
+    worker->stats.ticks = worker->stats.ticks + ticks;
+  }
+  worker->stats.busy_seconds = clock_now() - start;
+  return NULL;
+}
+
+int compare_sizes(const void *a, const void *b) {
+  size_t x = *(const size_t *)a;
+  size_t y = *(const size_t *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Prints the length of the decided matches, in seconds of game time.
+ */
+void report_durations(batch_t *batch) {
+  size_t *decided = malloc(sizeof(size_t) * (batch->matches + 1));
+  assert(decided != NULL);
+  size_t count = 0;
+  size_t total = 0;
+  for (size_t i = 0; i < batch->matches; i++) {
+    if (batch->outcomes[i] != OUTCOME_TIMEOUT) {
+      decided[count] = batch->durations[i];
+      total = total + decided[count];
+      count = count + 1;
+    }
+  }
+  if (count == 0) {
+    printf("no match was decided\n");
+    free(decided);
+    return;
+  }
+  qsort(decided, count, sizeof(size_t), compare_sizes);
+  printf("match length: mean %.1f s, p50 %.1f s, p90 %.1f s, max %.1f s\n",
+         total * BATCH_DT / count, decided[count / 2] * BATCH_DT, decided[count * 9 / 10] * BATCH_DT,
+         decided[count - 1] * BATCH_DT);
+  free(decided);
+}
+
+/**
+ * Plays many independent headless matches across a pool of threads, each
+ * from its own seed, and reports who won, how long the matches lasted and
+ * how well the work spread over the threads. Matches share nothing but the
+ * counter handing them out.
+ *
+ * Usage: batch [matches] [threads] [seed]
+ * Match i is seeded with seed + i, so any match can be replayed on its own.
+ * The threads default to one per online CPU.
+ */
+int main(int argc, char *argv[]) {
+  batch_t batch = {
+    .matches = argc > 1 ? strtoull(argv[1], NULL, 10) : BATCH_DEFAULT_MATCHES,
+    .seed = argc > 3 ? strtoull(argv[3], NULL, 10) : BATCH_DEFAULT_SEED,
+  };
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t threads = argc > 2 ? strtoull(argv[2], NULL, 10) : (size_t)(cpus > 0 ? cpus : 1);
+  if (threads == 0 || threads > BATCH_MAX_THREADS) {
+    fprintf(stderr, "threads must be between 1 and %d\n", BATCH_MAX_THREADS);
+    exit(1);
+  }
+  atomic_init(&batch.next_match, 0);
+  batch.durations = calloc(batch.matches + 1, sizeof(size_t));
+  batch.outcomes = calloc(batch.matches + 1, sizeof(outcome_t));
+  // calloc only promises max_align_t, too little for the stats' cache lines
+  batch_worker_t *workers =
+      aligned_alloc(_Alignof(batch_worker_t), threads * sizeof(batch_worker_t));
+  assert(batch.durations != NULL && batch.outcomes != NULL && workers != NULL);
+  memset(workers, 0, threads * sizeof(batch_worker_t));
+
+  double start = clock_now();
+  for (size_t i = 0; i < threads; i++) {
+    workers[i].batch = &batch;
+    if (pthread_create(&workers[i].thread, NULL, batch_work, &workers[i]) != 0) {
+      fprintf(stderr, "Could not start worker %zu\n", i);
+      exit(1);
+    }
+  }
+  for (size_t i = 0; i < threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  double elapsed = clock_now() - start;
+
+  batch_stats_t total = {0};
+  for (size_t i = 0; i < threads; i++) {
+    batch_stats_t *stats = &workers[i].stats;
+    printf("thread %3zu: %6zu matches, %9.0f ticks/s\n", i, stats->matches,
+           stats->busy_seconds > 0 ? stats->ticks / stats->busy_seconds : 0);
+    total.matches = total.matches + stats->matches;
+    total.ticks = total.ticks + stats->ticks;
+    total.busy_seconds = total.busy_seconds + stats->busy_seconds;
+    for (size_t k = 0; k < OUTCOME_COUNT; k++) {
+      total.outcomes[k] = total.outcomes[k] + stats->outcomes[k];
+    }
+  }
+  printf("%zu matches on %zu threads in %.2f s: %.1f matches/s, %.0f ticks/s\n", total.matches, threads,
+         elapsed, total.matches / elapsed, total.ticks / elapsed);
+  for (size_t k = 0; k < OUTCOME_COUNT; k++) {
+    printf("  %-10s %6zu (%5.1f%%)\n", OUTCOME_NAMES[k], total.outcomes[k],
+           total.matches > 0 ? 100. * total.outcomes[k] / total.matches : 0);
+  }
+  report_durations(&batch);
+  // the busy time of all threads over the time they were given; below 1 when
+  // threads sat idle at the end
+  printf("load balance: %.2f\n", total.busy_seconds / (elapsed * threads));
+
+  free(workers);
+  free(batch.durations);
+  free(batch.outcomes);
+  return 0;
+}
@@ -0,0 +1,260 @@
+#include "botlink.h"
+#include "clock.h"
+#include "tank.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// link constants
+const size_t BOTLINK_SPINS = 4096; // polls before waiting yields the processor
+const uint8_t BOTLINK_TANK_MASK = 0x7f;
+
+botlink_t *botlink_map(const char *name, int fd, bool owner) {
+  botlink_shared_t *shared = mmap(NULL, sizeof(botlink_shared_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (shared == MAP_FAILED) {
+    return NULL;
+  }
+  botlink_t *link = malloc(sizeof(botlink_t));
+  assert(link != NULL);
+  *link = (botlink_t){.shared = shared, .owner = owner};
+  snprintf(link->name, sizeof(link->name), "%s", name);
+  return link;
+}
+
+botlink_t *botlink_create(const char *name, bool lockstep, size_t cells) {
+  if (cells > BOTLINK_MAX_CELLS) {
+    return NULL;
+  }
+  shm_unlink(name);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (ftruncate(fd, sizeof(botlink_shared_t)) != 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  botlink_t *link = botlink_map(name, fd, true);
+  if (link == NULL) {
+    shm_unlink(name);
+    return NULL;
+  }
+  // a fresh segment is zeros, so the counters and controls start cleared
+  botlink_shared_t *shared = link->shared;
+  shared->version = BOTLINK_VERSION;
+  shared->shared_size = sizeof(botlink_shared_t);
+  shared->observation_size = sizeof(botlink_observation_t);
+  shared->ring_capacity = BOTLINK_RING_CAPACITY;
+  shared->lockstep = lockstep;
+  // the magic goes last, so a bot never sees a half-written header as valid
+  atomic_store_explicit(&shared->magic, BOTLINK_MAGIC, memory_order_release);
+  return link;
+}
+
+botlink_t *botlink_attach(const char *name) {
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+  botlink_t *link = botlink_map(name, fd, false);
+  if (link == NULL) {
+    return NULL;
+  }
+  botlink_shared_t *shared = link->shared;
+  if (atomic_load_explicit(&shared->magic, memory_order_acquire) != BOTLINK_MAGIC
+      || shared->version != BOTLINK_VERSION
+      || shared->shared_size != sizeof(botlink_shared_t)
+      || shared->observation_size != sizeof(botlink_observation_t)) {
+    munmap(shared, sizeof(botlink_shared_t));
+    free(link);
+    return NULL;
+  }
+  atomic_store_explicit(&shared->attached, 1, memory_order_release);
+  return link;
+}
+
+void botlink_free(botlink_t *link) {
+  if (link->owner) {
+    atomic_store_explicit(&link->shared->closed, 1, memory_order_release);
+    shm_unlink(link->name);
+  } else {
+    atomic_store_explicit(&link->shared->attached, 0, memory_order_release);
+  }
+  munmap(link->shared, sizeof(botlink_shared_t));
+  free(link);
+}
+
+void botlink_observe(botlink_observation_t *observation, state_t *state) {
+  maze_t *maze = state->maze;
+  observation->tick = state->tick;
+  observation->maze_generation = state->maze_generation;
+  observation->maze_revision = maze->revision;
+  observation->tank_controls = state->tank_controls;
+  observation->countdown = fmax(state->count_down_until_next_game_start, 0);
+  size_t cells = maze->columns * maze->rows;
+  // botlink_create() refused larger mazes, and a match keeps its maze size
+  assert(cells <= BOTLINK_MAX_CELLS);
+  observation->columns = maze->columns;
+  observation->rows = maze->rows;
+  observation->lower_left_x = maze->lower_left.x;
+  observation->lower_left_y = maze->lower_left.y;
+  observation->upper_right_x = maze->upper_right.x;
+  observation->upper_right_y = maze->upper_right.y;
+  memcpy(observation->cell_walls, maze->cell_walls, cells);
+
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    tank_t *tank = player_tank(state, i);
+    botlink_tank_t *out = &observation->tanks[i];
+    if (tank == NULL) {
+      *out = (botlink_tank_t){.alive = 0};
+      continue;
+    }
+    body_t *body = get_tank_body(tank);
+    vector_t velocity = body_get_velocity(body);
+    *out = (botlink_tank_t){
+      .x = body->center.x,
+      .y = body->center.y,
+      .angle = body->orientation,
+      .vx = velocity.x,
+      .vy = velocity.y,
+      .alive = 1,
+      .flags = game_tank_buttons(tank),
+      .shot_kind = shot_kind(tank->bang),
+      .special_shots = tank->powerup_shots_left,
+      .bullets = tank->bullets_onscreen,
+    };
+  }
+
+  projectile_pool_t *projectiles = state->projectiles;
+  size_t count = 0;
+  size_t left_out = 0;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body == NULL || body_is_removed(body)) {
+      continue;
+    }
+    if (count == BOTLINK_MAX_PROJECTILES) {
+      left_out = left_out + 1;
+      continue;
+    }
+    vector_t velocity = body_get_velocity(body);
+    observation->projectiles[count] = (botlink_projectile_t){
+      .x = body->center.x,
+      .y = body->center.y,
+      .vx = velocity.x,
+      .vy = velocity.y,
+      .kind = projectiles->infos[i].kind,
+      .owner = projectiles->infos[i].owner,
+    };
+    count = count + 1;
+  }
+  observation->projectile_count = count;
+  observation->projectiles_left_out = left_out;
+
+  powerup_pool_t *powerups = state->powerups;
+  count = 0;
+  for (size_t i = 0; i < powerups->capacity && count < BOTLINK_MAX_POWERUPS; i++) {
+    powerup_pulse_t *pulse = powerups->pulses[i];
+    if (pulse != NULL) {
+      observation->powerups[count] = (botlink_powerup_t){
+        .x = pulse->body->center.x,
+        .y = pulse->body->center.y,
+        .type = pulse->type,
+      };
+      count = count + 1;
+    }
+  }
+  observation->powerup_count = count;
+}
+
+uint64_t botlink_publish(botlink_t *link, state_t *state) {
+  botlink_shared_t *shared = link->shared;
+  uint64_t head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+  uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_acquire);
+  if (head - tail >= BOTLINK_RING_CAPACITY) {
+    link->dropped = link->dropped + 1;
+    return 0;
+  }
+  botlink_observation_t *observation = &shared->ring[head % BOTLINK_RING_CAPACITY];
+  observation->sequence = head + 1;
+  botlink_observe(observation, state);
+  atomic_store_explicit(&shared->head, head + 1, memory_order_release);
+  return head + 1;
+}
+
+bool botlink_wait_controls(botlink_t *link, uint64_t sequence, double timeout) {
+  botlink_shared_t *shared = link->shared;
+  if (atomic_load_explicit(&shared->attached, memory_order_acquire)) {
+    link->bot_seen = true;
+  }
+  double deadline = 0;
+  for (size_t spins = 0;; spins++) {
+    if (atomic_load_explicit(&shared->answered, memory_order_acquire) >= sequence) {
+      return true;
+    }
+    if (spins < BOTLINK_SPINS) {
+      continue;
+    }
+    sched_yield();
+    if (!atomic_load_explicit(&shared->attached, memory_order_acquire)) {
+      // before the first bot, the game waits for one for as long as it takes
+      if (link->bot_seen) {
+        return false;
+      }
+      continue;
+    }
+    link->bot_seen = true;
+    double now = clock_now();
+    if (deadline == 0) {
+      deadline = now + timeout;
+    } else if (now > deadline) {
+      return false;
+    }
+  }
+}
+
+void botlink_apply_controls(botlink_t *link, state_t *state) {
+  uint32_t controls = atomic_load_explicit(&link->shared->controls, memory_order_acquire);
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    uint8_t buttons = controls >> (8 * i) & BOTLINK_TANK_MASK;
+    game_apply_buttons(state, i, buttons, link->held[i]);
+    link->held[i] = buttons;
+  }
+}
+
+bool botlink_next_observation(botlink_t *link, botlink_observation_t *observation) {
+  botlink_shared_t *shared = link->shared;
+  uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+  if (tail == atomic_load_explicit(&shared->head, memory_order_acquire)) {
+    return false;
+  }
+  // only the used part of each array, which is most of the cost of a handoff between cores
+  const botlink_observation_t *slot = &shared->ring[tail % BOTLINK_RING_CAPACITY];
+  memcpy(observation, slot, offsetof(botlink_observation_t, projectiles));
+  size_t projectiles = observation->projectile_count <= BOTLINK_MAX_PROJECTILES ? observation->projectile_count : 0;
+  size_t powerups = observation->powerup_count <= BOTLINK_MAX_POWERUPS ? observation->powerup_count : 0;
+  size_t cells = observation->columns * observation->rows <= BOTLINK_MAX_CELLS
+                 ? observation->columns * observation->rows : 0;
+  memcpy(observation->projectiles, slot->projectiles, sizeof(botlink_projectile_t) * projectiles);
+  memcpy(observation->powerups, slot->powerups, sizeof(botlink_powerup_t) * powerups);
+  memcpy(observation->cell_walls, slot->cell_walls, cells);
+  atomic_store_explicit(&shared->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+void botlink_send_controls(botlink_t *link, const uint8_t buttons[INPUT_PLAYERS], uint64_t sequence) {
+  uint32_t controls = 0;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    controls = controls | (uint32_t)(buttons[i] & BOTLINK_TANK_MASK) << (8 * i);
+  }
+  atomic_store_explicit(&link->shared->controls, controls, memory_order_relaxed);
+  atomic_store_explicit(&link->shared->answered, sequence, memory_order_release);
+}
@@ -0,0 +1,151 @@
+#include "broadphase.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+broadphase_t *broadphase_init(vector_t lower_left, vector_t upper_right, double cell_size, size_t capacity) {
+  broadphase_t *broadphase = malloc(sizeof(broadphase_t));
+  assert(broadphase != NULL);
+  broadphase->lower_left = lower_left;
+  broadphase->cell_size = cell_size;
+  broadphase->columns = (size_t) ceil((upper_right.x - lower_left.x) / cell_size);
+  broadphase->rows = (size_t) ceil((upper_right.y - lower_left.y) / cell_size);
+  broadphase->capacity = capacity;
+  broadphase->count = 0;
+  broadphase->ids = malloc(sizeof(size_t) * capacity);
+  broadphase->groups = malloc(sizeof(size_t) * capacity);
+  broadphase->x = malloc(sizeof(float) * capacity);
+  broadphase->y = malloc(sizeof(float) * capacity);
+  broadphase->radius = malloc(sizeof(float) * capacity);
+  broadphase->cells = malloc(sizeof(size_t) * capacity);
+  broadphase->sorted = malloc(sizeof(size_t) * capacity);
+  broadphase->cell_start = malloc(sizeof(size_t) * (broadphase->columns * broadphase->rows + 1));
+  assert(broadphase->ids != NULL && broadphase->groups != NULL);
+  assert(broadphase->x != NULL && broadphase->y != NULL);
+  assert(broadphase->radius != NULL && broadphase->cells != NULL);
+  assert(broadphase->sorted != NULL && broadphase->cell_start != NULL);
+  return broadphase;
+}
+
+void broadphase_free(broadphase_t *broadphase) {
+  free(broadphase->ids);
+  free(broadphase->groups);
+  free(broadphase->x);
+  free(broadphase->y);
+  free(broadphase->radius);
+  free(broadphase->cells);
+  free(broadphase->sorted);
+  free(broadphase->cell_start);
+  free(broadphase);
+}
+
+void broadphase_clear(broadphase_t *broadphase) {
+  broadphase->count = 0;
+}
+
+size_t broadphase_clamp(double value, size_t size) {
+  if (value < 0) {
+    return 0;
+  }
+  if (value >= size) {
+    return size - 1;
+  }
+  return (size_t) value;
+}
+
+void broadphase_insert(broadphase_t *broadphase, size_t id, size_t group, vector_t center, double radius) {
+  if (broadphase->count == broadphase->capacity) {
+    return;
+  }
+  size_t i = broadphase->count;
+  size_t column = broadphase_clamp((center.x - broadphase->lower_left.x) / broadphase->cell_size, broadphase->columns);
+  size_t row = broadphase_clamp((center.y - broadphase->lower_left.y) / broadphase->cell_size, broadphase->rows);
+  broadphase->ids[i] = id;
+  broadphase->groups[i] = group;
+  broadphase->x[i] = center.x;
+  broadphase->y[i] = center.y;
+  broadphase->radius[i] = radius;
+  broadphase->cells[i] = column + row * broadphase->columns;
+  broadphase->count = i + 1;
+}
+
+void broadphase_build(broadphase_t *broadphase) {
+  size_t cell_count = broadphase->columns * broadphase->rows;
+  size_t *cell_start = broadphase->cell_start;
+  memset(cell_start, 0, sizeof(size_t) * (cell_count + 1));
+  for (size_t i = 0; i < broadphase->count; i++) {
+    cell_start[broadphase->cells[i] + 1]++;
+  }
+  for (size_t c = 0; c < cell_count; c++) {
+    cell_start[c + 1] += cell_start[c];
+  }
+  // cell_start[c] is used as a write cursor and ends up at the start of cell c + 1
+  for (size_t i = 0; i < broadphase->count; i++) {
+    broadphase->sorted[cell_start[broadphase->cells[i]]++] = i;
+  }
+  for (size_t c = cell_count; c > 0; c--) {
+    cell_start[c] = cell_start[c - 1];
+  }
+  cell_start[0] = 0;
+}
+
+bool broadphase_overlap(broadphase_t *broadphase, size_t a, size_t b) {
+  if (broadphase->groups[a] == broadphase->groups[b]) {
+    return false;
+  }
+  float dx = broadphase->x[a] - broadphase->x[b];
+  float dy = broadphase->y[a] - broadphase->y[b];
+  float reach = broadphase->radius[a] + broadphase->radius[b];
+  return dx * dx + dy * dy <= reach * reach;
+}
+
+size_t broadphase_pairs(broadphase_t *broadphase, size_t *first, size_t *second, size_t max_pairs) {
+  // each cell is paired with itself and the 4 neighbours after it,
+  // so every pair of neighbouring cells is visited exactly once
+  const int NEIGHBORS[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+  size_t *cell_start = broadphase->cell_start;
+  size_t *sorted = broadphase->sorted;
+  size_t found = 0;
+  for (size_t row = 0; row < broadphase->rows; row++) {
+    for (size_t column = 0; column < broadphase->columns; column++) {
+      size_t cell = column + row * broadphase->columns;
+      for (size_t i = cell_start[cell]; i < cell_start[cell + 1]; i++) {
+        size_t a = sorted[i];
+        for (size_t j = i + 1; j < cell_start[cell + 1]; j++) {
+          size_t b = sorted[j];
+          if (broadphase_overlap(broadphase, a, b)) {
+            if (found == max_pairs) {
+              return found;
+            }
+            first[found] = broadphase->ids[a];
+            second[found] = broadphase->ids[b];
+            found++;
+          }
+        }
+        for (size_t n = 0; n < 4; n++) {
+          long neighbor_column = (long) column + NEIGHBORS[n][0];
+          size_t neighbor_row = row + NEIGHBORS[n][1];
+          if (neighbor_column < 0 || neighbor_column >= (long) broadphase->columns
+              || neighbor_row >= broadphase->rows) {
+            continue;
+          }
+          size_t neighbor = neighbor_column + neighbor_row * broadphase->columns;
+          for (size_t j = cell_start[neighbor]; j < cell_start[neighbor + 1]; j++) {
+            size_t b = sorted[j];
+            if (broadphase_overlap(broadphase, a, b)) {
+              if (found == max_pairs) {
+                return found;
+              }
+              first[found] = broadphase->ids[a];
+              second[found] = broadphase->ids[b];
+              found++;
+            }
+          }
+        }
+      }
+    }
+  }
+  return found;
+}
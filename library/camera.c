@@ -0,0 +1,68 @@
+#include "camera.h"
+#include <math.h>
+
+// how quickly the camera closes the distance to its target, per second
+const double CAMERA_RATE = 4.;
+
+camera_t camera_init(vector_t lower_left, vector_t upper_right, vector_t window) {
+  camera_t camera = {
+    .arena_lower_left = lower_left,
+    .arena_upper_right = upper_right,
+    .window = window,
+    .center = vec_multiply(0.5, vec_add(lower_left, upper_right)),
+    .half_extent = vec_multiply(0.5, window)
+  };
+  return camera;
+}
+
+/**
+ * Moves a view center along one axis so the view stays inside the arena.
+ */
+double camera_clamp_axis(double center, double half_extent, double low, double high) {
+  if (high - low <= 2 * half_extent) {
+    return (low + high) / 2;
+  }
+  return fmin(fmax(center, low + half_extent), high - half_extent);
+}
+
+void camera_follow(camera_t *camera, const vector_t *points, size_t count, double margin, double dt) {
+  vector_t arena_size = vec_subtract(camera->arena_upper_right, camera->arena_lower_left);
+  double aspect = camera->window.x / camera->window.y;
+  // the widest view that still shows all of the arena along its longer side
+  double max_half_height = fmax(arena_size.y, arena_size.x / aspect) / 2;
+  double min_half_height = camera->window.y / 2;
+  max_half_height = fmax(max_half_height, min_half_height);
+
+  vector_t target_center = camera->center;
+  double target_half_height = min_half_height;
+  if (count > 0) {
+    vector_t low = points[0];
+    vector_t high = points[0];
+    for (size_t i = 1; i < count; i++) {
+      low = (vector_t){.x = fmin(low.x, points[i].x), .y = fmin(low.y, points[i].y)};
+      high = (vector_t){.x = fmax(high.x, points[i].x), .y = fmax(high.y, points[i].y)};
+    }
+    target_center = vec_multiply(0.5, vec_add(low, high));
+    double half_width = (high.x - low.x) / 2 + margin;
+    double half_height = (high.y - low.y) / 2 + margin;
+    target_half_height = fmax(half_height, half_width / aspect);
+  }
+  target_half_height = fmin(fmax(target_half_height, min_half_height), max_half_height);
+
+  double blend = dt > 0 ? 1 - exp(-CAMERA_RATE * dt) : 1;
+  double half_height = camera->half_extent.y + (target_half_height - camera->half_extent.y) * blend;
+  camera->half_extent = (vector_t){.x = half_height * aspect, .y = half_height};
+  vector_t center = vec_add(camera->center, vec_multiply(blend, vec_subtract(target_center, camera->center)));
+  camera->center = (vector_t){
+    .x = camera_clamp_axis(center.x, camera->half_extent.x, camera->arena_lower_left.x, camera->arena_upper_right.x),
+    .y = camera_clamp_axis(center.y, camera->half_extent.y, camera->arena_lower_left.y, camera->arena_upper_right.y)
+  };
+}
+
+vector_t camera_lower_left(const camera_t *camera) {
+  return vec_subtract(camera->center, camera->half_extent);
+}
+
+vector_t camera_upper_right(const camera_t *camera) {
+  return vec_add(camera->center, camera->half_extent);
+}
@@ -0,0 +1,8 @@
+#include "clock.h"
+#include <time.h>
+
+double clock_now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
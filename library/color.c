@@ -66,4 +66,36 @@ hsv_color_t rgb_to_hsv(rgb_color_t rgb) {
   s = chroma / max;
   v = max;
   return (hsv_color_t) {.h = h, .s = s, .v = v};
-}
\ No newline at end of file
+}
+
+/**
+ * The branchless form of hsv_to_rgb() for one component:
+ * v - v s clamp(min(k, 4 - k), 0, 1) with k = (n + h / 60) mod 6,
+ * where n is 5 for red, 3 for green and 1 for blue.
+ * Conditionals, floorf and fminf/fmaxf (which must handle NaN) all keep the
+ * compiler from vectorizing the caller, so the modulo uses an integer
+ * truncation and min/max are written with fabsf.
+ */
+static inline float hsv_component(float sector, float n, float s, float v) {
+  float k = sector + n;
+  float turns = k * (1.f / 6);
+  int whole = (int) turns;
+  whole -= turns < whole; // truncation rounds negative hues up
+  k = k - 6 * whole;
+  float ramp = 0.5f * (4 - fabsf(2 * k - 4)); // min(k, 4 - k)
+  ramp = 0.5f * (ramp + fabsf(ramp)); // max(ramp, 0)
+  ramp = 0.5f * (ramp + 1 - fabsf(ramp - 1)); // min(ramp, 1)
+  return v - v * s * ramp;
+}
+
+void hsv_to_rgb_batch(const float *restrict h, const float *restrict s, const float *restrict v,
+                      float *restrict r, float *restrict g, float *restrict b, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    float sector = h[i] * (1.f / 60);
+    float saturation = s[i];
+    float value = v[i];
+    r[i] = hsv_component(sector, 5, saturation, value);
+    g[i] = hsv_component(sector, 3, saturation, value);
+    b[i] = hsv_component(sector, 1, saturation, value);
+  }
+}
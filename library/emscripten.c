@@ -1,41 +1,64 @@
 #include "math.h"
 #include "sdl_wrapper.h"
 #include "state.h"
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <SDL2/SDL.h>
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-state_t *state;
-
-void loop() {
-  // If needed, generate a pointer to our initial state
-  if (!state) {
-    state = emscripten_init();
-  }
-
+#ifdef __EMSCRIPTEN__
+void loop(void *aux) {
+  state_t *state = aux;
   emscripten_main(state);
+  emscripten_render(state);
 
   if (sdl_is_done(state)) { // Once our demo exits...
     emscripten_free(state); // Free any state variables we've been using
-#ifdef __EMSCRIPTEN__ // Clean up emscripten environment (if we're using it)
+    // Clean up emscripten environment
     emscripten_cancel_main_loop();
     emscripten_force_exit(0);
-#else
-    exit(0);
-#endif
     return;
   }
 }
+#else
+atomic_bool simulation_running = true;
+
+/**
+ * Steps the simulation on its own thread, so a slow frame (or a blocking
+ * window operation) on the main thread never delays the game.
+ * The main thread only polls events and draws the published snapshots.
+ * Both emscripten_main and emscripten_render wait for their own frame pacer.
+ */
+int simulation_loop(void *aux) {
+  state_t *state = aux;
+  while (atomic_load(&simulation_running)) {
+    emscripten_main(state);
+  }
+  return 0;
+}
+#endif
 
 int main() {
 #ifdef __EMSCRIPTEN__
   // Set loop as the function emscripten calls to request a new frame
-  emscripten_set_main_loop_arg(loop, NULL, 0, 1);
+  emscripten_set_main_loop_arg(loop, emscripten_init(), 0, 1);
 #else
-  while (1) {
-    loop();
+  state_t *state = emscripten_init();
+  SDL_Thread *simulation = SDL_CreateThread(simulation_loop, "simulation", state);
+  if (simulation == NULL) {
+    fprintf(stderr, "Could not start the simulation thread: %s\n", SDL_GetError());
+    exit(1);
+  }
+  while (!sdl_is_done(state)) {
+    emscripten_render(state);
   }
+  atomic_store(&simulation_running, false);
+  SDL_WaitThread(simulation, NULL);
+  emscripten_free(state);
+  exit(0);
 #endif
 }
@@ -0,0 +1,520 @@
+#include "game.h"
+#include "body.h"
+#include "collision.h"
+#include "forces.h"
+#include "scene.h"
+#include "tank.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// game constants
+const double COUNT_DOWN_NEXT_GAME = 5.;
+const double CONTROLS_HINT_TIME = 10.;
+const double CANNON_EVENT_2099 = 0.0001;
+
+// maze constants
+const size_t DEFAULT_MAZE_COLUMNS = 10;
+const size_t DEFAULT_MAZE_ROWS = 5;
+
+// arena constants
+const size_t ARENA_SCALE = 1; // the arena is this many windows wide and high; above 1 the camera follows the tanks
+const double CAMERA_MARGIN = 150.;
+
+// score constants
+const char *SCORE_LOAD_PATH = "/savedat.txt";
+const char *SCORE_SAVE_PATH = "/tmp/savedat.txt";
+
+// tank constants
+const rgb_color_t RED_PLAYER_COLOR = {.r = 1., .g = 0., .b = 0.};
+const rgb_color_t GREEN_PLAYER_COLOR = {.r = 0., .g = 1., .b = 0.};
+const rgb_color_t BLUE_PLAYER_COLOR = {.r = 0., .g = 0., .b = 1.};
+const size_t BULLET_LIMIT = 5;
+const size_t MAX_TANKS = 64;
+
+// particle constants
+const size_t PARTICLE_CAPACITY = 1024;
+const double PARTICLE_DRAG = 2.5; // drag / mass of the debris bodies this replaced (250 / 100)
+const double PARTICLE_HUE_SHIFT = 120.; // degrees per second
+
+// projectile constants
+const size_t PROJECTILE_CAPACITY = 512;
+const bool BULLET_ANNIHILATION = false;
+const bool DESTRUCTIBLE_WALLS = false;
+
+// powerup constants
+const size_t POWERUP_CAPACITY = 16; // the registry grows past this if powerups pile up
+const double POWERUP_SPAWN_INTERVAL = 5;
+const double POWERUP_SPAWN_PROB = .25;
+
+// input constants
+const size_t INPUT_LOG_CAPACITY = 16; // the log grows past this if a tick has more inputs
+
+void tank_shoot(state_t *state, tank_t *tank) {
+  if (tank->powerup_shots_left <= 0) {
+    tank->bang = normal_shot;
+  }
+  tank->bang(state, tank, TANK_SIZE);
+}
+
+size_t game_input_tank(state_t *state, size_t controls) {
+  // after a cannon event each set of controls drives another player's tank
+  return (controls + INPUT_PLAYERS - state->tank_controls) % INPUT_PLAYERS;
+}
+
+void game_apply_input(state_t *state, input_event_t event) {
+  if (event.player >= INPUT_PLAYERS) {
+    return;
+  }
+  if (state->inputs_tick != state->tick) {
+    state->input_count = 0;
+    state->inputs_tick = state->tick;
+  }
+  if (state->input_count == state->input_capacity) {
+    state->input_capacity = state->input_capacity * 2;
+    state->inputs = realloc(state->inputs, sizeof(input_event_t) * state->input_capacity);
+    assert(state->inputs != NULL);
+  }
+  state->inputs[state->input_count] = event;
+  state->input_count++;
+  tank_t *tank = player_tank(state, game_input_tank(state, event.player));
+  if (tank == NULL) {
+    return;
+  }
+  size_t flag = event.pressed ? 1 : 0;
+  switch (event.action) {
+    case INPUT_FORWARD:
+      tank_set_flags(tank, flag, 2, 2, 2);
+      break;
+    case INPUT_BACKWARD:
+      tank_set_flags(tank, 2, flag, 2, 2);
+      break;
+    case INPUT_LEFT:
+      tank_set_flags(tank, 2, 2, flag, 2);
+      break;
+    case INPUT_RIGHT:
+      tank_set_flags(tank, 2, 2, 2, flag);
+      break;
+    case INPUT_SHOOT:
+      if (!event.pressed) {
+        break;
+      }
+      if (tank->bullets_onscreen < BULLET_LIMIT) {
+        tank_shoot(state, tank);
+      }
+      else {
+        audio_play(&state->audio, SOUND_EMPTY_SHOT);
+      }
+      break;
+  }
+}
+
+uint8_t game_tank_buttons(tank_t *tank) {
+  mov_flags_t *flags = tank->mov_flags;
+  return (flags->flag_forwards == 1) << INPUT_FORWARD | (flags->flag_backwards == 1) << INPUT_BACKWARD
+         | (flags->flag_left == 1) << INPUT_LEFT | (flags->flag_right == 1) << INPUT_RIGHT;
+}
+
+void game_apply_buttons(state_t *state, size_t player, uint8_t buttons, uint8_t held) {
+  tank_t *tank = player_tank(state, player);
+  if (tank == NULL) {
+    return;
+  }
+  // the set of controls that drives this tank since the last cannon event
+  uint8_t controls = (player + state->tank_controls) % INPUT_PLAYERS;
+  uint8_t flags = game_tank_buttons(tank);
+  for (size_t action = 0; action < INPUT_SHOOT; action++) {
+    bool pressed = buttons >> action & 1;
+    if (pressed != (flags >> action & 1)) {
+      game_apply_input(state, (input_event_t){.player = controls, .action = action, .pressed = pressed});
+    }
+  }
+  if ((buttons & ~held) >> INPUT_SHOOT & 1) {
+    game_apply_input(state, (input_event_t){.player = controls, .action = INPUT_SHOOT, .pressed = true});
+  }
+}
+
+tank_t *tank_player_init_force(state_t *state, vector_t init_pos, rgb_color_t color) {
+  tank_t *tank_body = tank_init(init_pos, TANK_SIZE, color);
+  scene_add_body(state->scene, get_tank_body(tank_body));
+  scene_add_body(state->scene, get_tank_hitbox(tank_body));
+  add_tank_maze_force(state, state->maze, tank_body, TANK_SIZE);
+  return tank_body;
+}
+
+/**
+ * Moves the camera towards a view of every live tank; a dt of 0 snaps it there.
+ */
+void follow_tanks(state_t *state, double dt) {
+  vector_t centers[MAX_TANKS];
+  size_t count = 0;
+  tank_t *players[] = {state->red_player, state->green_player, state->blue_player};
+  for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+    if (players[i] != NULL && players[i]->exists) {
+      centers[count] = body_get_center(get_tank_body(players[i]));
+      count = count + 1;
+    }
+  }
+  camera_follow(&state->camera, centers, count, CAMERA_MARGIN, dt);
+}
+
+maze_t *match_maze_init(state_t *state) {
+  state->maze_rng = state->rng.maze;
+  return maze_init(state->config.maze_columns * ARENA_SCALE, state->config.maze_rows * ARENA_SCALE, VEC_ZERO,
+                   state->arena, &state->rng.maze);
+}
+
+void spawn_players(state_t *state) {
+  list_t *random_vectors = get_random_cell_centers(state->maze, 3, &state->rng.spawns);
+  state->red_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 0), RED_PLAYER_COLOR);
+  state->blue_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 1), BLUE_PLAYER_COLOR);
+  state->green_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 2), GREEN_PLAYER_COLOR);
+  list_free(random_vectors);
+  follow_tanks(state, 0);
+}
+
+void reset_state(state_t *state) {
+  scene_free(state->scene);
+  scene_t *scene = scene_init();
+  state->scene = scene;
+
+  state->count_down_until_next_game_start = 0;
+  state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
+  state->tank_controls = 0;
+  state->banner[0] = '\0';
+
+  particles_clear(state->particles);
+
+  maze_free(state->maze);
+  state->maze = match_maze_init(state);
+  state->maze_generation = state->maze_generation + 1;
+
+  spawn_players(state);
+
+  if (state->config.keep_score) {
+    FILE *fptr = fopen(SCORE_SAVE_PATH, "w");
+    fprintf(fptr, "%zu %zu %zu %zu", state->red_wins, state->blue_wins, state->green_wins, state->games_played);
+    fclose(fptr);
+  }
+}
+
+void check_game_over(state_t *state) {
+  bool red_null = state->red_player == NULL;
+  bool blue_null = state->blue_player == NULL;
+  bool green_null = state->green_player == NULL;
+
+  bool red_win = !red_null && blue_null && green_null;
+  bool blue_win = red_null && !blue_null && green_null;
+  bool green_win = red_null && blue_null && !green_null;
+  bool draw = red_null && blue_null && green_null;
+
+  if (red_win || blue_win || green_win || draw) {
+    state->games_played = state->games_played + 1;
+    state->count_down_until_next_game_start = COUNT_DOWN_NEXT_GAME;
+    if (red_win) {
+      snprintf(state->banner, HUD_BANNER_LENGTH, "RED PLAYER WINS!");
+      state->red_wins = state->red_wins + 1;
+    }
+    if (blue_win) {
+      snprintf(state->banner, HUD_BANNER_LENGTH, "BLUE PLAYER WINS!");
+      state->blue_wins = state->blue_wins + 1;
+    }
+    if (green_win) {
+      snprintf(state->banner, HUD_BANNER_LENGTH, "GREEN PLAYER WINS!");
+      state->green_wins = state->green_wins + 1;
+    }
+    if (draw) {
+      snprintf(state->banner, HUD_BANNER_LENGTH, "IT'S A DRAW!");
+    }
+  }
+}
+
+void add_random_powerup(state_t *state) {
+  double r = rng_double(&state->rng.powerups);
+  if (r < POWERUP_SPAWN_PROB) {
+    add_powerup(state, RAILGUN);
+  } else if (r < 2*POWERUP_SPAWN_PROB) {
+    add_powerup(state, LASER);
+  } else if (r < 3*POWERUP_SPAWN_PROB) {
+    add_powerup(state, SHOTGUN);
+  } else {
+    add_powerup(state, MOON);
+  }
+}
+
+void run_cannon_event(state_t *state) {
+  double r = rng_double(&state->rng.events);
+  if (r < CANNON_EVENT_2099) {
+    audio_play(&state->audio, SOUND_CANNON_EVENT);
+    state->tank_controls = (state->tank_controls + 1) % 2;
+    if (state->red_player != NULL) {
+      tank_set_flags(state->red_player, 0, 0, 0, 0);
+    }
+    if (state->green_player != NULL) {
+      tank_set_flags(state->green_player, 0, 0, 0, 0);
+    }
+    if (state->blue_player != NULL) {
+      tank_set_flags(state->blue_player, 0, 0, 0, 0);
+    }
+  }
+}
+
+void separate_tanks(state_t *state) {
+  tank_t *tanks[MAX_TANKS];
+  size_t count = 0;
+  tank_t *players[] = {state->red_player, state->green_player, state->blue_player};
+  for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+    if (players[i] != NULL && players[i]->exists) {
+      tanks[count] = players[i];
+      count = count + 1;
+    }
+  }
+  tanks_separate(state->tank_broadphase, state->maze, tanks, count);
+}
+
+game_config_t game_default_config(uint64_t seed) {
+  return (game_config_t){
+    .maze_columns = DEFAULT_MAZE_COLUMNS,
+    .maze_rows = DEFAULT_MAZE_ROWS,
+    .seed = seed,
+    .keep_score = false,
+  };
+}
+
+/**
+ * Forgets the bodies of the tanks removed by the last tick, which the scene
+ * frees at its next tick.
+ */
+void forget_dying_bodies(state_t *state) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    state->dying_bodies[i] = NULL;
+  }
+}
+
+state_t *game_init(game_config_t config, audio_t audio) {
+  state_t *state = malloc(sizeof(state_t));
+  assert(state != NULL);
+  state->config = config;
+  state->rng = rng_streams_init(config.seed);
+  state->scene = scene_init();
+  state->audio = audio;
+  state->particles = particles_init(PARTICLE_CAPACITY, PARTICLE_DRAG, PARTICLE_HUE_SHIFT);
+  state->count_down_until_next_game_start = 0;
+  state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
+  state->count_down_controls_hint = CONTROLS_HINT_TIME;
+  state->banner[0] = '\0';
+  state->arena = vec_multiply(ARENA_SCALE, GAME_WINDOW);
+  state->camera = camera_init(VEC_ZERO, state->arena, GAME_WINDOW);
+  state->maze = match_maze_init(state);
+  state->red_wins = 0;
+  state->blue_wins = 0;
+  state->green_wins = 0;
+  state->games_played = 0;
+  FILE *fptr = config.keep_score ? fopen(SCORE_LOAD_PATH, "r") : NULL;
+  if (fptr != NULL) {
+    fscanf(fptr, "%zu %zu %zu %zu", &(state->red_wins), &(state->blue_wins), &(state->green_wins), &(state->games_played));
+    fclose(fptr);
+  }
+  state->projectiles = projectiles_init(VEC_ZERO, state->arena, GAME_WINDOW.x / config.maze_columns, PROJECTILE_CAPACITY);
+  state->powerups = powerups_init(POWERUP_CAPACITY);
+  state->tank_broadphase = broadphase_init(VEC_ZERO, state->arena, GAME_WINDOW.x / config.maze_columns, MAX_TANKS);
+  state->bullet_annihilation = BULLET_ANNIHILATION;
+  state->destructible_walls = DESTRUCTIBLE_WALLS;
+  state->tank_controls = 0;
+  state->dt = 0;
+  state->tick = 0;
+  state->maze_generation = 0;
+  state->captured_revision = state->maze->revision;
+  state->inputs = malloc(sizeof(input_event_t) * INPUT_LOG_CAPACITY);
+  assert(state->inputs != NULL);
+  state->input_count = 0;
+  state->input_capacity = INPUT_LOG_CAPACITY;
+  state->inputs_tick = 0;
+  forget_dying_bodies(state);
+  state->dying_serial = 0;
+  spawn_players(state);
+  return state;
+}
+
+void game_tick(state_t *state, double dt) {
+  dt = (double)llround(dt * REPLAY_DT_UNITS) / REPLAY_DT_UNITS;
+  state->dt = dt;
+  forget_dying_bodies(state);
+  if (state->count_down_until_next_game_start == 0) {
+    check_game_over(state);
+  } else if (state->count_down_until_next_game_start > 0) {
+    state->count_down_until_next_game_start = state->count_down_until_next_game_start - dt;
+    if (state->count_down_until_next_game_start <= 0) {
+      reset_state(state);
+    }
+  }
+  run_cannon_event(state);
+  scene_tick(state->scene, dt);
+  particles_tick(state->particles, dt);
+  if (state->bullet_annihilation) {
+    projectiles_annihilate(state->projectiles);
+  }
+  separate_tanks(state);
+  state->count_down_until_next_powerup = state->count_down_until_next_powerup - dt;
+  if (state->count_down_until_next_powerup < 0) {
+    add_random_powerup(state);
+    state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
+  }
+  state->dying_serial = state->projectiles->next_serial;
+  if (state->red_player != NULL && state->red_player->exists == 0) {
+    state->dying_bodies[0] = get_tank_body(state->red_player);
+    tank_remove(state->red_player, state);
+    state->red_player = NULL;
+  }
+  if (state->green_player != NULL && state->green_player->exists == 0) {
+    state->dying_bodies[1] = get_tank_body(state->green_player);
+    tank_remove(state->green_player, state);
+    state->green_player = NULL;
+  }
+  if (state->blue_player != NULL && state->blue_player->exists == 0) {
+    state->dying_bodies[2] = get_tank_body(state->blue_player);
+    tank_remove(state->blue_player, state);
+    state->blue_player = NULL;
+  }
+  if (state->red_player != NULL) {
+    tank_execute_flags(state->red_player);
+  }
+  if (state->blue_player != NULL) {
+    tank_execute_flags(state->blue_player);
+  }
+  if (state->green_player != NULL) {
+    tank_execute_flags(state->green_player);
+  }
+  follow_tanks(state, dt);
+  state->count_down_controls_hint = fmax(state->count_down_controls_hint - dt, 0);
+  state->tick = state->tick + 1;
+}
+
+void game_record_tick(state_t *state, replay_writer_t *recorder) {
+  if (state->inputs_tick + 1 == state->tick) {
+    for (size_t i = 0; i < state->input_count; i++) {
+      replay_record_input(recorder, state->inputs[i]);
+    }
+  }
+  replay_record_tick(recorder, llround(state->dt * REPLAY_DT_UNITS), game_hash(state));
+}
+
+uint64_t hash_mix(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0x100000001b3;
+  return hash ^ (hash >> 29);
+}
+
+uint64_t hash_double(uint64_t hash, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return hash_mix(hash, bits);
+}
+
+uint64_t hash_vector(uint64_t hash, vector_t vector) {
+  return hash_double(hash_double(hash, vector.x), vector.y);
+}
+
+uint32_t game_hash(state_t *state) {
+  uint64_t hash = 0xcbf29ce484222325;
+  hash = hash_mix(hash, state->tick);
+  tank_t *players[] = {state->red_player, state->green_player, state->blue_player};
+  for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+    tank_t *tank = players[i];
+    if (tank == NULL) {
+      hash = hash_mix(hash, 0);
+      continue;
+    }
+    body_t *body = get_tank_body(tank);
+    hash = hash_mix(hash, 1 + tank->exists);
+    hash = hash_vector(hash, body_get_center(body));
+    hash = hash_double(hash, body_get_orientation(body));
+    hash = hash_mix(hash, tank->bullets_onscreen);
+    hash = hash_mix(hash, tank->powerup_shots_left);
+  }
+  projectile_pool_t *projectiles = state->projectiles;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body != NULL) {
+      hash = hash_mix(hash, i);
+      hash = hash_vector(hash, body_get_center(body));
+      hash = hash_vector(hash, body_get_velocity(body));
+    }
+  }
+  hash = hash_mix(hash, state->maze_generation);
+  hash = hash_mix(hash, state->maze->revision);
+  hash = hash_mix(hash, state->rng.maze.s[0]);
+  hash = hash_mix(hash, state->rng.spawns.s[0]);
+  hash = hash_mix(hash, state->rng.powerups.s[0]);
+  hash = hash_mix(hash, state->rng.events.s[0]);
+  return hash ^ (hash >> 32);
+}
+
+replay_header_t game_replay_header(state_t *state) {
+  return (replay_header_t){
+    .maze_columns = state->config.maze_columns,
+    .maze_rows = state->config.maze_rows,
+    .seed = state->config.seed,
+  };
+}
+
+game_config_t game_replay_config(replay_header_t header) {
+  game_config_t config = game_default_config(header.seed);
+  config.maze_columns = header.maze_columns;
+  config.maze_rows = header.maze_rows;
+  return config;
+}
+
+void capture_treads(state_t *state, frame_snapshot_t *snapshot) {
+  tank_t *players[HUD_PLAYERS] = {state->red_player, state->green_player, state->blue_player};
+  snapshot->tread_count = 0;
+  for (size_t i = 0; i < HUD_PLAYERS; i++) {
+    if (players[i] == NULL || !players[i]->exists) {
+      continue;
+    }
+    body_t *body = get_tank_body(players[i]);
+    vector_t center = body_get_center(body);
+    size_t k = snapshot->tread_count;
+    snapshot->tread_ids[k] = i;
+    snapshot->tread_x[k] = center.x;
+    snapshot->tread_y[k] = center.y;
+    snapshot->tread_angle[k] = body_get_orientation(body);
+    snapshot->tread_count = k + 1;
+  }
+}
+
+void capture_hud(state_t *state, hud_snapshot_t *hud) {
+  tank_t *players[HUD_PLAYERS] = {state->red_player, state->green_player, state->blue_player};
+  rgb_color_t colors[HUD_PLAYERS] = {RED_PLAYER_COLOR, GREEN_PLAYER_COLOR, BLUE_PLAYER_COLOR};
+  size_t wins[HUD_PLAYERS] = {state->red_wins, state->green_wins, state->blue_wins};
+  for (size_t i = 0; i < HUD_PLAYERS; i++) {
+    tank_t *tank = players[i];
+    hud->colors[i] = colors[i];
+    hud->wins[i] = wins[i];
+    hud->alive[i] = tank != NULL;
+    hud->bullets[i] = tank != NULL ? tank->bullets_onscreen : 0;
+    hud->special_shots[i] = tank != NULL && tank->bang != normal_shot ? tank->powerup_shots_left : 0;
+  }
+  hud->bullet_limit = BULLET_LIMIT;
+  hud->countdown = fmax(state->count_down_until_next_game_start, 0);
+  hud->show_controls = state->count_down_controls_hint > 0 || hud->countdown > 0;
+  memcpy(hud->banner, state->banner, HUD_BANNER_LENGTH);
+}
+
+void game_capture(state_t *state, frame_snapshot_t *snapshot) {
+  snapshot_capture(state, snapshot);
+  capture_treads(state, snapshot);
+  capture_hud(state, &snapshot->hud);
+}
+
+void game_free(state_t *state) {
+  scene_free(state->scene);
+  maze_free(state->maze);
+  particles_free(state->particles);
+  projectiles_free(state->projectiles);
+  powerups_free(state->powerups);
+  broadphase_free(state->tank_broadphase);
+  free(state->inputs);
+  free(state);
+}
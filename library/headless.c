@@ -0,0 +1,421 @@
+#include "ai.h"
+#include "botlink.h"
+#include "clock.h"
+#include "game.h"
+#include "raster.h"
+#include "lookahead.h"
+#include "savestate.h"
+#include "script.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// headless constants
+const double HEADLESS_DT = 1. / 60.; // the step the windowed game runs at
+const size_t HEADLESS_DEFAULT_TICKS = 36000; // ten minutes of game time
+const double HEADLESS_REPORT_INTERVAL = 1.;
+const uint64_t HEADLESS_DEFAULT_SEED = 1;
+#define HEADLESS_ROLLBACK_WINDOW 8 // ticks played again after each restore, as a rollback netcode would
+const double HEADLESS_BOT_TIMEOUT = 5.; // seconds a bot may take to answer one tick
+const size_t HEADLESS_RASTER_MATCHES = 64;
+const size_t HEADLESS_RASTER_TICKS = 3600;
+const size_t HEADLESS_PIXELS_PER_CELL = 10; // the 1000 by 500 arena as a 100 by 50 grid
+const size_t HEADLESS_LOOKAHEAD_TICKS = 7200;
+const size_t HEADLESS_LOOKAHEAD_WORKERS = 2;
+const size_t HEADLESS_LOOKAHEAD_ROLLOUTS = 1800; // futures per decision, about what 2 workers play in a 60 Hz frame
+const size_t HEADLESS_CLONES = 100000;
+
+/**
+ * Plays a replay back as fast as possible and checks the state hash after
+ * every tick.
+ *
+ * @return 0 if the replay matched to the end, 2 at the first desync
+ */
+int play_replay(const char *path) {
+  replay_reader_t *reader = replay_reader_init(path);
+  if (reader == NULL) {
+    fprintf(stderr, "%s is not a replay\n", path);
+    return 1;
+  }
+  state_t *state = game_init(game_replay_config(reader->header), audio_silent());
+  int status = 0;
+  double start = clock_now();
+  replay_tick_t tick;
+  while (replay_read_tick(reader, &tick)) {
+    for (size_t i = 0; i < tick.input_count; i++) {
+      game_apply_input(state, tick.inputs[i]);
+    }
+    game_tick(state, (double)tick.dt / REPLAY_DT_UNITS);
+    uint32_t hash = game_hash(state);
+    if (hash != tick.hash) {
+      printf("desync at tick %zu: recorded %08x, replayed %08x\n", state->tick - 1, tick.hash, hash);
+      status = 2;
+      break;
+    }
+  }
+  double elapsed = clock_now() - start;
+  if (status == 0) {
+    printf("replay matched: %zu ticks in %.2f s, %.0f ticks/s, %zu games played\n", state->tick, elapsed,
+           state->tick / elapsed, state->games_played);
+  }
+  game_free(state);
+  replay_reader_free(reader);
+  return status;
+}
+
+/**
+ * Checks that savestates round-trip. The match is saved, played for a few
+ * ticks, restored and played again with the same inputs, and the state hash
+ * must agree after every tick of both runs. Bullet annihilation and
+ * destructible walls are turned on so every kind of saved state is used.
+ *
+ * @return 0 if every rollback matched, 2 at the first mismatch
+ */
+int check_rollback(size_t ticks, uint64_t seed) {
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  state->bullet_annihilation = true;
+  state->destructible_walls = true;
+  savestate_t *savestate = savestate_init();
+  uint32_t hashes[HEADLESS_ROLLBACK_WINDOW];
+  double capture_time = 0;
+  double restore_time = 0;
+  size_t rollbacks = 0;
+  size_t largest = 0;
+  int status = 0;
+  while (status == 0 && state->tick < ticks) {
+    double start = clock_now();
+    savestate_capture(savestate, state);
+    capture_time = capture_time + clock_now() - start;
+    largest = savestate->length > largest ? savestate->length : largest;
+    for (size_t i = 0; i < HEADLESS_ROLLBACK_WINDOW; i++) {
+      script_play(state, 1, HEADLESS_DT);
+      hashes[i] = game_hash(state);
+    }
+    start = clock_now();
+    savestate_restore(savestate, state);
+    restore_time = restore_time + clock_now() - start;
+    for (size_t i = 0; i < HEADLESS_ROLLBACK_WINDOW; i++) {
+      script_play(state, 1, HEADLESS_DT);
+      if (game_hash(state) != hashes[i]) {
+        printf("rollback diverged at tick %zu\n", state->tick - 1);
+        status = 2;
+        break;
+      }
+    }
+    rollbacks = rollbacks + 1;
+  }
+  if (status == 0) {
+    printf("%zu rollbacks matched over %zu ticks, %zu games played\n", rollbacks, state->tick, state->games_played);
+  }
+  printf("capture %.2f us, restore %.2f us on average, largest savestate %zu bytes\n",
+         capture_time * 1e6 / rollbacks, restore_time * 1e6 / rollbacks, largest);
+  savestate_free(savestate);
+  game_free(state);
+  return status;
+}
+
+/**
+ * Lets a bot in another process drive every tank through shared memory,
+ * in lockstep: each tick the match is published, the bot's answer awaited
+ * and applied, so the match runs as fast as the bot and the simulation
+ * together allow.
+ *
+ * @return 0 if every tick was answered, 2 if the bot stopped answering
+ */
+int run_bots(const char *name, size_t ticks, uint64_t seed) {
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  size_t cells = state->maze->columns * state->maze->rows;
+  botlink_t *link = botlink_create(name, true, cells);
+  if (link == NULL) {
+    fprintf(stderr, "Could not create shared memory %s for a maze of %zu cells, at most %d\n", name, cells,
+            BOTLINK_MAX_CELLS);
+    game_free(state);
+    return 1;
+  }
+  printf("waiting for a bot on %s\n", name);
+  fflush(stdout);
+
+  int status = 0;
+  double start = 0;
+  double wait_time = 0;
+  for (size_t tick = 0; ticks == 0 || tick < ticks; tick++) {
+    uint64_t sequence = botlink_publish(link, state);
+    double waited = clock_now();
+    if (!botlink_wait_controls(link, sequence, HEADLESS_BOT_TIMEOUT)) {
+      printf("the bot stopped answering at tick %zu\n", state->tick);
+      status = 2;
+      break;
+    }
+    // the wait for the bot to attach is not counted
+    if (tick == 0) {
+      start = clock_now();
+    } else {
+      wait_time = wait_time + clock_now() - waited;
+    }
+    botlink_apply_controls(link, state);
+    game_tick(state, HEADLESS_DT);
+  }
+  double elapsed = clock_now() - start;
+  size_t waits = state->tick > 1 ? state->tick - 1 : 1;
+  printf("%zu ticks in %.2f s: %.0f ticks/s, %.2f us per tick waiting for the bot, %zu games played\n", state->tick,
+         elapsed, state->tick / elapsed, wait_time * 1e6 / waits, state->games_played);
+  game_free(state);
+  botlink_free(link);
+  return status;
+}
+
+/**
+ * Lets the computer drive all three tanks and prints how the games went
+ * and what each player's thinking cost per tick.
+ *
+ * @return 0
+ */
+int run_ai(size_t ticks, uint64_t seed) {
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  ai_t *ai = ai_init((1 << INPUT_PLAYERS) - 1);
+  double start = clock_now();
+  for (size_t tick = 0; ticks == 0 || tick < ticks; tick++) {
+    ai_tick(ai, state);
+    game_tick(state, HEADLESS_DT);
+  }
+  double elapsed = clock_now() - start;
+  printf("%zu ticks in %.2f s: %.0f ticks/s, %zu games played, wins red %zu green %zu blue %zu\n", state->tick,
+         elapsed, state->tick / elapsed, state->games_played, state->red_wins, state->green_wins, state->blue_wins);
+  const char *names[INPUT_PLAYERS] = {"red", "green", "blue"};
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    ai_player_t *player = &ai->players[i];
+    printf("%-5s %.2f us per tick, worst %.2f us, %zu of %zu ticks over the %.0f us budget, %zu sweeps skipped, "
+           "%zu paths found\n", names[i], player->think_time * 1e6 / player->thinks, player->worst_time * 1e6,
+           player->late, player->thinks, ai->budget * 1e6, player->over_budget, player->path_builds);
+  }
+  ai_free(ai);
+  game_free(state);
+  return 0;
+}
+
+/**
+ * Pits a tank that searches futures of the match on worker threads,
+ * blue, against two reacting CPU players, and prints how the games went,
+ * how many futures the search played per second and what cloning a world
+ * costs next to restoring a savestate. Each decision waits for a number
+ * of futures, as a frame's worth of searching would give it.
+ *
+ * @return 0, or 1 if the maze is too large to search
+ */
+int run_lookahead(size_t ticks, size_t workers, size_t rollouts, uint64_t seed) {
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  ai_t *ai = ai_init((1 << INPUT_PLAYERS) - 1);
+  if (!ai_use_lookahead(ai, state, 2, workers, rollouts)) {
+    fprintf(stderr, "The maze has more than %d cells, too many to search\n", LOOKAHEAD_MAX_CELLS);
+    ai_free(ai);
+    game_free(state);
+    return 1;
+  }
+  lookahead_t *lookahead = ai->players[2].lookahead;
+  double start = clock_now();
+  for (size_t tick = 0; tick < ticks; tick++) {
+    ai_tick(ai, state);
+    game_tick(state, HEADLESS_DT);
+  }
+  double elapsed = clock_now() - start;
+  printf("%zu ticks in %.2f s, %zu games played, wins red %zu green %zu blue (searching) %zu\n", state->tick,
+         elapsed, state->games_played, state->red_wins, state->green_wins, state->blue_wins);
+  pthread_mutex_lock(&lookahead->lock);
+  printf("%zu workers: %zu futures, %.0f per second of wall time, %.0f per busy worker second, "
+         "%.2f us per simulated tick, %.0f futures per decision\n",
+         workers, lookahead->rollouts, lookahead->rollouts / elapsed, lookahead->rollouts / lookahead->busy_time,
+         lookahead->busy_time * 1e6 / lookahead->rollout_ticks,
+         (double)lookahead->decided_rollouts / (lookahead->decisions > 0 ? lookahead->decisions : 1));
+  pthread_mutex_unlock(&lookahead->lock);
+  printf("searching player's tick on the game thread: %.2f us, worst %.2f us\n",
+         ai->players[2].think_time * 1e6 / ai->players[2].thinks, ai->players[2].worst_time * 1e6);
+
+  lookahead_world_t *world = malloc(sizeof(lookahead_world_t));
+  lookahead_world_t *clone = malloc(sizeof(lookahead_world_t));
+  savestate_t *savestate = savestate_init();
+  assert(world != NULL && clone != NULL);
+  lookahead_observe(world, state);
+  double clone_start = clock_now();
+  for (size_t i = 0; i < HEADLESS_CLONES; i++) {
+    lookahead_clone(clone, world);
+  }
+  double clone_time = (clock_now() - clone_start) / HEADLESS_CLONES;
+  savestate_capture(savestate, state);
+  double restore_start = clock_now();
+  for (size_t i = 0; i < HEADLESS_CLONES / 100; i++) {
+    savestate_restore(savestate, state);
+  }
+  double restore_time = (clock_now() - restore_start) / (HEADLESS_CLONES / 100);
+  printf("clone %.0f ns with %zu projectiles, savestate restore %.2f us\n", clone_time * 1e9, world->shot_count,
+         restore_time * 1e6);
+  free(world);
+  free(clone);
+  savestate_free(savestate);
+  ai_free(ai);
+  game_free(state);
+  return 0;
+}
+
+/**
+ * Steps a batch of matches together, as a vectorized learning environment
+ * would, rasterizing all of them in one call after every tick, and prints
+ * what encoding the observations costs next to simulating the tick. Each
+ * tick the batch is drawn both from scratch and in place, and the two
+ * must agree.
+ *
+ * @return 0 if they agreed every tick, 2 at the first difference
+ */
+int run_raster(size_t matches, size_t ticks, size_t pixels_per_cell, uint64_t seed) {
+  state_t **states = malloc(sizeof(state_t *) * matches);
+  assert(states != NULL);
+  for (size_t i = 0; i < matches; i++) {
+    states[i] = game_init(game_default_config(seed + i), audio_silent());
+  }
+  raster_shape_t shape = raster_shape(states[0]->maze, pixels_per_cell);
+  raster_t *raster = raster_init(shape, matches);
+  uint8_t *observations = malloc(raster->size * matches);
+  assert(observations != NULL);
+
+  int status = 0;
+  double tick_time = 0;
+  double full_time = 0;
+  double update_time = 0;
+  for (size_t tick = 0; tick < ticks; tick++) {
+    double start = clock_now();
+    for (size_t i = 0; i < matches; i++) {
+      script_play(states[i], 1, HEADLESS_DT);
+    }
+    double ticked = clock_now();
+    raster_observe_batch(states, matches, shape, observations);
+    double full = clock_now();
+    raster_update(raster, states);
+    double updated = clock_now();
+    tick_time = tick_time + ticked - start;
+    full_time = full_time + full - ticked;
+    update_time = update_time + updated - full;
+    if (memcmp(observations, raster->observations, raster->size * matches) != 0) {
+      printf("the observations updated in place differ at tick %zu\n", tick);
+      status = 2;
+      break;
+    }
+  }
+  size_t steps = matches * ticks;
+  printf("%zu matches, %zux%zu grid with %d channels, %zu bytes per observation\n", matches, shape.width,
+         shape.height, RASTER_CHANNELS, raster->size);
+  printf("per match: tick %.2f us, rasterize %.2f us from scratch, %.2f us in place (%.0f observations/s)\n",
+         tick_time * 1e6 / steps, full_time * 1e6 / steps, update_time * 1e6 / steps, steps / update_time);
+  for (size_t i = 0; i < matches; i++) {
+    game_free(states[i]);
+  }
+  free(states);
+  free(observations);
+  raster_free(raster);
+  return status;
+}
+
+/**
+ * Runs the game without a window, audio device or frame pacing, as fast as
+ * the simulation allows, and prints how many ticks it gets through per second.
+ *
+ * Usage: headless [ticks] [script] [seed]
+ *        headless --record <replay> [ticks] [script] [seed]
+ *        headless --play <replay>
+ *        headless --rollback [ticks] [seed]
+ *        headless --bots <shared memory name> [ticks] [seed]
+ *        headless --ai [ticks] [seed]
+ *        headless --lookahead [ticks] [workers] [futures per decision] [seed]
+ *        headless --raster [matches] [ticks] [pixels per cell] [seed]
+ * A tick count of 0 runs until killed, for soak tests. A script of "-"
+ * runs the built-in pattern.
+ */
+int main(int argc, char *argv[]) {
+  if (argc > 2 && strcmp(argv[1], "--play") == 0) {
+    return play_replay(argv[2]);
+  }
+  if (argc > 1 && strcmp(argv[1], "--rollback") == 0) {
+    return check_rollback(argc > 2 ? strtoull(argv[2], NULL, 10) : HEADLESS_DEFAULT_TICKS,
+                          argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_DEFAULT_SEED);
+  }
+  if (argc > 2 && strcmp(argv[1], "--bots") == 0) {
+    return run_bots(argv[2], argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_DEFAULT_TICKS,
+                    argc > 4 ? strtoull(argv[4], NULL, 10) : HEADLESS_DEFAULT_SEED);
+  }
+  if (argc > 1 && strcmp(argv[1], "--ai") == 0) {
+    return run_ai(argc > 2 ? strtoull(argv[2], NULL, 10) : HEADLESS_DEFAULT_TICKS,
+                  argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_DEFAULT_SEED);
+  }
+  if (argc > 1 && strcmp(argv[1], "--lookahead") == 0) {
+    return run_lookahead(argc > 2 ? strtoull(argv[2], NULL, 10) : HEADLESS_LOOKAHEAD_TICKS,
+                         argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_LOOKAHEAD_WORKERS,
+                         argc > 4 ? strtoull(argv[4], NULL, 10) : HEADLESS_LOOKAHEAD_ROLLOUTS,
+                         argc > 5 ? strtoull(argv[5], NULL, 10) : HEADLESS_DEFAULT_SEED);
+  }
+  if (argc > 1 && strcmp(argv[1], "--raster") == 0) {
+    return run_raster(argc > 2 ? strtoull(argv[2], NULL, 10) : HEADLESS_RASTER_MATCHES,
+                      argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_RASTER_TICKS,
+                      argc > 4 ? strtoull(argv[4], NULL, 10) : HEADLESS_PIXELS_PER_CELL,
+                      argc > 5 ? strtoull(argv[5], NULL, 10) : HEADLESS_DEFAULT_SEED);
+  }
+  const char *record_path = NULL;
+  if (argc > 2 && strcmp(argv[1], "--record") == 0) {
+    record_path = argv[2];
+    argc = argc - 2;
+    argv = argv + 2;
+  }
+  size_t ticks = argc > 1 ? strtoull(argv[1], NULL, 10) : HEADLESS_DEFAULT_TICKS;
+  script_t *script = NULL;
+  if (argc > 2 && strcmp(argv[2], "-") != 0) {
+    script = script_load(argv[2]);
+    if (script == NULL) {
+      exit(1);
+    }
+  }
+  uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : HEADLESS_DEFAULT_SEED;
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  replay_writer_t *recorder = NULL;
+  if (record_path != NULL) {
+    recorder = replay_writer_init(record_path, game_replay_header(state));
+    if (recorder == NULL) {
+      fprintf(stderr, "Could not create %s\n", record_path);
+      exit(1);
+    }
+  }
+
+  size_t next_input = 0;
+  double start = clock_now();
+  double report_start = start;
+  size_t report_tick = 0;
+  for (size_t tick = 0; ticks == 0 || tick < ticks; tick++) {
+    if (script != NULL) {
+      script_apply(script, state, tick, &next_input);
+      game_tick(state, HEADLESS_DT);
+    } else {
+      script_play(state, 1, HEADLESS_DT);
+    }
+    if (recorder != NULL) {
+      game_record_tick(state, recorder);
+    }
+
+    double now = clock_now();
+    if (now - report_start >= HEADLESS_REPORT_INTERVAL) {
+      printf("%.0f ticks/s, %zu games played\n", (tick + 1 - report_tick) / (now - report_start),
+             state->games_played);
+      fflush(stdout);
+      report_start = now;
+      report_tick = tick + 1;
+    }
+  }
+  double elapsed = clock_now() - start;
+  printf("%zu ticks in %.2f s: %.0f ticks/s, %.1fx real time, %zu games played\n", state->tick, elapsed,
+         state->tick / elapsed, state->tick * HEADLESS_DT / elapsed, state->games_played);
+
+  if (recorder != NULL) {
+    replay_writer_free(recorder);
+  }
+  game_free(state);
+  if (script != NULL) {
+    script_free(script);
+  }
+  return 0;
+}
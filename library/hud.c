@@ -0,0 +1,223 @@
+#include "hud.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// glyph atlas constants
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define GLYPH_CELL_WIDTH (GLYPH_WIDTH + 1)
+#define GLYPH_CELL_HEIGHT (GLYPH_HEIGHT + 1)
+const char GLYPH_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789:/!-.'+";
+#define GLYPH_COUNT (sizeof(GLYPH_CHARS) - 1)
+// one row of 5 bits per line of the glyph, leftmost pixel in the highest bit
+const unsigned char GLYPH_ROWS[GLYPH_COUNT][GLYPH_HEIGHT] = {
+  {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}, // A
+  {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+  {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+  {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+  {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+  {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+  {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+  {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+  {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+  {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+  {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+  {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+  {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+  {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+  {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+  {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+  {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+  {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+  {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+  {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // Y
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+  {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+  {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+  {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+  {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+  {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+  {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+  {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+  {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+  {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+  {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+  {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+  {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // !
+  {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+  {0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, // '
+  {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // +
+};
+
+// layout constants
+#define HUD_LINE_LENGTH 64
+const float HUD_GLYPH_SCALE = 2;
+const float HUD_MARGIN = 8;
+const float HUD_LINE_SPACING = 4;
+const SDL_Color HUD_TEXT_COLOR = {.r = 40, .g = 40, .b = 40, .a = 255};
+const char *HUD_PLAYER_NAMES[HUD_PLAYERS] = {"RED", "GREEN", "BLUE"};
+const char *HUD_CONTROLS = "RED: AWSD + Q   GREEN: IJKL + U   BLUE: ARROWS + SPACE";
+
+typedef enum {
+  LINE_PLAYER, // one per player
+  LINE_BANNER = HUD_PLAYERS,
+  LINE_COUNTDOWN,
+  LINE_CONTROLS,
+  LINE_COUNT
+} hud_line_id_t;
+
+/**
+ * A line of text and the quads drawing it, kept until the text changes.
+ */
+typedef struct hud_line {
+  char text[HUD_LINE_LENGTH];
+  SDL_Color color;
+  float x;
+  float y;
+  bool centered;
+  SDL_Vertex vertices[4 * HUD_LINE_LENGTH];
+  int indices[6 * HUD_LINE_LENGTH];
+  size_t quads;
+} hud_line_t;
+
+SDL_Texture *glyph_atlas = NULL;
+int glyph_index[128];
+hud_line_t hud_lines[LINE_COUNT];
+
+void hud_init(SDL_Renderer *renderer) {
+  for (size_t c = 0; c < 128; c++) {
+    glyph_index[c] = -1;
+  }
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    glyph_index[(unsigned char) GLYPH_CHARS[i]] = i;
+  }
+
+  const int width = GLYPH_COUNT * GLYPH_CELL_WIDTH;
+  const int height = GLYPH_CELL_HEIGHT;
+  Uint32 pixels[GLYPH_COUNT * GLYPH_CELL_WIDTH * GLYPH_CELL_HEIGHT] = {0};
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    for (size_t row = 0; row < GLYPH_HEIGHT; row++) {
+      for (size_t column = 0; column < GLYPH_WIDTH; column++) {
+        if (GLYPH_ROWS[i][row] & (1 << (GLYPH_WIDTH - 1 - column))) {
+          // opaque white in any 32-bit format; the vertex color tints it
+          pixels[row * width + i * GLYPH_CELL_WIDTH + column] = 0xFFFFFFFF;
+        }
+      }
+    }
+  }
+  glyph_atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+  if (glyph_atlas == NULL) {
+    return;
+  }
+  SDL_UpdateTexture(glyph_atlas, NULL, pixels, width * sizeof(Uint32));
+  SDL_SetTextureBlendMode(glyph_atlas, SDL_BLENDMODE_BLEND);
+  for (size_t i = 0; i < LINE_COUNT; i++) {
+    hud_lines[i].text[0] = '\0';
+    hud_lines[i].quads = 0;
+  }
+}
+
+void hud_build_line(hud_line_t *line) {
+  const float atlas_width = GLYPH_COUNT * GLYPH_CELL_WIDTH;
+  const float atlas_height = GLYPH_CELL_HEIGHT;
+  const float advance = GLYPH_CELL_WIDTH * HUD_GLYPH_SCALE;
+  size_t length = strlen(line->text);
+  float x = line->centered ? line->x - length * advance / 2 : line->x;
+  line->quads = 0;
+  for (size_t i = 0; i < length; i++, x += advance) {
+    unsigned char c = line->text[i];
+    if (c >= 'a' && c <= 'z') {
+      c = c - 'a' + 'A';
+    }
+    int glyph = c < 128 ? glyph_index[c] : -1;
+    if (glyph < 0) {
+      continue;
+    }
+    float u0 = glyph * GLYPH_CELL_WIDTH / atlas_width;
+    float u1 = (glyph * GLYPH_CELL_WIDTH + GLYPH_WIDTH) / atlas_width;
+    float v1 = GLYPH_HEIGHT / atlas_height;
+    float w = GLYPH_WIDTH * HUD_GLYPH_SCALE;
+    float h = GLYPH_HEIGHT * HUD_GLYPH_SCALE;
+    SDL_Vertex *quad = &line->vertices[4 * line->quads];
+    quad[0] = (SDL_Vertex){.position = {.x = x, .y = line->y}, .color = line->color, .tex_coord = {.x = u0, .y = 0}};
+    quad[1] = (SDL_Vertex){.position = {.x = x + w, .y = line->y}, .color = line->color, .tex_coord = {.x = u1, .y = 0}};
+    quad[2] = (SDL_Vertex){.position = {.x = x + w, .y = line->y + h}, .color = line->color, .tex_coord = {.x = u1, .y = v1}};
+    quad[3] = (SDL_Vertex){.position = {.x = x, .y = line->y + h}, .color = line->color, .tex_coord = {.x = u0, .y = v1}};
+    int base = 4 * line->quads;
+    int *indices = &line->indices[6 * line->quads];
+    indices[0] = base;
+    indices[1] = base + 1;
+    indices[2] = base + 2;
+    indices[3] = base;
+    indices[4] = base + 2;
+    indices[5] = base + 3;
+    line->quads++;
+  }
+}
+
+/**
+ * Sets the text of a line, rebuilding its quads only if anything changed.
+ */
+void hud_set_line(hud_line_t *line, const char *text, SDL_Color color, float x, float y, bool centered) {
+  bool same_color = line->color.r == color.r && line->color.g == color.g && line->color.b == color.b;
+  if (strcmp(line->text, text) == 0 && same_color && line->x == x && line->y == y && line->centered == centered) {
+    return;
+  }
+  strncpy(line->text, text, HUD_LINE_LENGTH - 1);
+  line->text[HUD_LINE_LENGTH - 1] = '\0';
+  line->color = color;
+  line->x = x;
+  line->y = y;
+  line->centered = centered;
+  hud_build_line(line);
+}
+
+size_t hud_draw(SDL_Renderer *renderer, const hud_snapshot_t *hud, int width, int height) {
+  if (glyph_atlas == NULL) {
+    return 0;
+  }
+  const float line_height = GLYPH_HEIGHT * HUD_GLYPH_SCALE + HUD_LINE_SPACING;
+  char text[HUD_LINE_LENGTH];
+  for (size_t i = 0; i < HUD_PLAYERS; i++) {
+    size_t ammo = hud->bullets[i] < hud->bullet_limit ? hud->bullet_limit - hud->bullets[i] : 0;
+    size_t length = snprintf(text, sizeof(text), "%-5s WINS %zu", HUD_PLAYER_NAMES[i], hud->wins[i]);
+    if (!hud->alive[i]) {
+      snprintf(text + length, sizeof(text) - length, "  DESTROYED");
+    } else if (hud->special_shots[i] > 0) {
+      snprintf(text + length, sizeof(text) - length, "  AMMO %zu/%zu  SPECIAL %zu",
+               ammo, hud->bullet_limit, hud->special_shots[i]);
+    } else {
+      snprintf(text + length, sizeof(text) - length, "  AMMO %zu/%zu", ammo, hud->bullet_limit);
+    }
+    rgb_color_t color = hud->colors[i];
+    SDL_Color tint = {.r = color.r * 255, .g = color.g * 255, .b = color.b * 255, .a = 255};
+    hud_set_line(&hud_lines[LINE_PLAYER + i], text, tint, HUD_MARGIN, HUD_MARGIN + i * line_height, false);
+  }
+  hud_set_line(&hud_lines[LINE_BANNER], hud->banner, HUD_TEXT_COLOR, width / 2., height / 2. - line_height, true);
+  if (hud->countdown > 0) {
+    snprintf(text, sizeof(text), "NEXT GAME IN %d", (int) ceil(hud->countdown));
+  } else {
+    text[0] = '\0';
+  }
+  hud_set_line(&hud_lines[LINE_COUNTDOWN], text, HUD_TEXT_COLOR, width / 2., height / 2., true);
+  hud_set_line(&hud_lines[LINE_CONTROLS], hud->show_controls ? HUD_CONTROLS : "", HUD_TEXT_COLOR,
+               width / 2., height - HUD_MARGIN - line_height, true);
+
+  size_t draw_calls = 0;
+  for (size_t i = 0; i < LINE_COUNT; i++) {
+    hud_line_t *line = &hud_lines[i];
+    if (line->quads > 0) {
+      SDL_RenderGeometry(renderer, glyph_atlas, line->vertices, 4 * line->quads, line->indices, 6 * line->quads);
+      draw_calls++;
+    }
+  }
+  return draw_calls;
+}
@@ -0,0 +1,37 @@
+#include "key_queue.h"
+#include <assert.h>
+#include <stdlib.h>
+
+key_queue_t *key_queue_init() {
+  key_queue_t *queue = malloc(sizeof(key_queue_t));
+  assert(queue != NULL);
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  return queue;
+}
+
+void key_queue_free(key_queue_t *queue) {
+  free(queue);
+}
+
+bool key_queue_push(key_queue_t *queue, input_event_t event) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  if (tail - head == KEY_QUEUE_CAPACITY) {
+    return false;
+  }
+  queue->events[tail % KEY_QUEUE_CAPACITY] = event;
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+bool key_queue_pop(key_queue_t *queue, input_event_t *event) {
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  if (head == tail) {
+    return false;
+  }
+  *event = queue->events[head % KEY_QUEUE_CAPACITY];
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
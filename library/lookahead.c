@@ -0,0 +1,473 @@
+#include "lookahead.h"
+#include "clock.h"
+#include "tank.h"
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// search constants
+const double LOOKAHEAD_DT = 1. / 60.; // ticks of the windowed game, since tanks turn a fixed angle per tick
+const size_t LOOKAHEAD_HORIZON = 30; // ticks in a future, half a second
+const size_t LOOKAHEAD_ROOT_ROLLOUTS = LOOKAHEAD_CANDIDATES * 256; // futures of one root before the workers rest
+const size_t LOOKAHEAD_POLICY_TICKS = 10; // ticks an opponent holds a random choice of buttons
+const size_t LOOKAHEAD_OPPONENT_FIRE = 40; // an opponent playing randomly fires once in this many ticks
+const uint64_t LOOKAHEAD_SEED = 0x6c6f6f6b;
+
+// scoring constants
+const double LOOKAHEAD_DEATH = -1.;
+const double LOOKAHEAD_KILL = .5;
+const double LOOKAHEAD_AIMED = .25; // a shot of its own still flying toward an enemy at the end
+const double LOOKAHEAD_APPROACH = .1; // for ending the future next to an enemy rather than far away
+
+// world constants, for the normal bullet; every shot fired in a future is one
+const size_t LOOKAHEAD_BULLET_LIMIT = 5;
+const double LOOKAHEAD_MUZZLE = 35.; // how far ahead of the tank's center normal_shot() places the bullet
+const double LOOKAHEAD_BULLET_SPEED = 200.;
+const double LOOKAHEAD_BULLET_RADIUS = 6.;
+const double LOOKAHEAD_BULLET_TIME = 5.;
+#define LOOKAHEAD_BOUNCES 3 // per tick when moving a shot, and when following one at the end of a future
+
+// the movement buttons of the candidates; candidates past the first nine also fire at the start
+const uint8_t LOOKAHEAD_MOVES[LOOKAHEAD_CANDIDATES / 2] = {
+  0,
+  1 << INPUT_FORWARD,
+  1 << INPUT_FORWARD | 1 << INPUT_LEFT,
+  1 << INPUT_FORWARD | 1 << INPUT_RIGHT,
+  1 << INPUT_LEFT,
+  1 << INPUT_RIGHT,
+  1 << INPUT_BACKWARD,
+  1 << INPUT_BACKWARD | 1 << INPUT_LEFT,
+  1 << INPUT_BACKWARD | 1 << INPUT_RIGHT,
+};
+
+struct lookahead_worker {
+  lookahead_t *lookahead;
+  pthread_t thread;
+  rng_t rng;
+  lookahead_root_t root; // a copy of the newest root, read without the lock
+  lookahead_world_t future;
+};
+
+mov_flags_t lookahead_flags(uint8_t buttons) {
+  return (mov_flags_t){
+    .flag_forwards = buttons >> INPUT_FORWARD & 1,
+    .flag_backwards = buttons >> INPUT_BACKWARD & 1,
+    .flag_left = buttons >> INPUT_LEFT & 1,
+    .flag_right = buttons >> INPUT_RIGHT & 1,
+  };
+}
+
+bool lookahead_in_maze(maze_t *walls, vector_t point) {
+  return point.x > walls->lower_left.x && point.x < walls->upper_right.x && point.y > walls->lower_left.y
+         && point.y < walls->upper_right.y;
+}
+
+void lookahead_observe(lookahead_world_t *world, state_t *state) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    tank_t *tank = player_tank(state, i);
+    if (tank == NULL) {
+      world->tanks[i] = (lookahead_tank_t){.alive = false};
+      continue;
+    }
+    body_t *body = get_tank_body(tank);
+    world->tanks[i] = (lookahead_tank_t){
+      .center = body->center,
+      .velocity = body_get_velocity(body),
+      .last_move = vec_multiply(tank->last_dt, tank->last_velocity),
+      .angle = body->orientation,
+      .held = game_tank_buttons(tank),
+      .alive = true,
+      .bullets = tank->bullets_onscreen,
+    };
+  }
+  projectile_pool_t *projectiles = state->projectiles;
+  size_t count = 0;
+  for (size_t i = 0; i < projectiles->capacity && count < LOOKAHEAD_MAX_SHOTS; i++) {
+    body_t *body = projectiles->bodies[i];
+    projectile_info_t *info = &projectiles->infos[i];
+    if (body == NULL || body_is_removed(body) || info->kind == PROJECTILE_RAILGUN) {
+      continue;
+    }
+    world->shots[count] = (lookahead_shot_t){
+      .position = body->center,
+      .velocity = body_get_velocity(body),
+      .radius = projectiles->radii[i],
+      .time_left = info->decay != NULL ? info->decay->time : INFINITY,
+      .owner = info->owner,
+    };
+    count = count + 1;
+  }
+  world->shot_count = count;
+}
+
+void lookahead_clone(lookahead_world_t *clone, const lookahead_world_t *world) {
+  memcpy(clone, world, offsetof(lookahead_world_t, shots) + sizeof(lookahead_shot_t) * world->shot_count);
+}
+
+/**
+ * Tells whether a round shot overlaps a tank's square hitbox.
+ */
+bool lookahead_shot_hits(const lookahead_tank_t *tank, vector_t position, double radius) {
+  vector_t offset = vec_subtract(position, tank->center);
+  double c = cos(tank->angle);
+  double s = sin(tank->angle);
+  double half = TANK_SIZE / 2.;
+  double along = fabs(offset.x * c + offset.y * s);
+  double across = fabs(offset.y * c - offset.x * s);
+  along = fmax(along - half, 0);
+  across = fmax(across - half, 0);
+  return along * along + across * across < radius * radius;
+}
+
+void lookahead_remove_shot(lookahead_world_t *world, size_t i) {
+  lookahead_tank_t *owner = &world->tanks[world->shots[i].owner];
+  owner->bullets = owner->bullets > 0 ? owner->bullets - 1 : 0;
+  world->shot_count = world->shot_count - 1;
+  world->shots[i] = world->shots[world->shot_count];
+}
+
+void lookahead_step(lookahead_world_t *world, maze_t *walls, const uint8_t buttons[INPUT_PLAYERS], double dt) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    lookahead_tank_t *tank = &world->tanks[i];
+    if (!tank->alive) {
+      continue;
+    }
+    // inputs come before the tick, so a shot leaves from where the tank stands
+    if ((buttons[i] & ~tank->held) >> INPUT_SHOOT & 1 && tank->bullets < LOOKAHEAD_BULLET_LIMIT
+        && world->shot_count < LOOKAHEAD_MAX_SHOTS) {
+      vector_t direction = {cos(tank->angle), sin(tank->angle)};
+      vector_t muzzle = vec_add(tank->center, vec_multiply(LOOKAHEAD_MUZZLE, direction));
+      if (lookahead_in_maze(walls, muzzle)) {
+        world->shots[world->shot_count] = (lookahead_shot_t){
+          .position = muzzle,
+          .velocity = vec_multiply(LOOKAHEAD_BULLET_SPEED, direction),
+          .radius = LOOKAHEAD_BULLET_RADIUS,
+          .time_left = LOOKAHEAD_BULLET_TIME,
+          .owner = i,
+        };
+        world->shot_count = world->shot_count + 1;
+        tank->bullets = tank->bullets + 1;
+      }
+    }
+    tank->held = buttons[i];
+    // the maze force, the scene's move and then tank_execute_flags(), as net_predict() models them
+    mov_flags_t flags = lookahead_flags(buttons[i]);
+    if (maze_box_hits_wall(walls, tank->center, TANK_SIZE, tank->angle)) {
+      tank->center = vec_subtract(tank->center, tank->last_move);
+    }
+    tank->last_move = vec_multiply(dt, tank->velocity);
+    tank->center = vec_add(tank->center, tank->last_move);
+    tank->velocity = vec_rotate((vector_t){.x = tank_flags_speed(flags), .y = 0}, tank->angle);
+    tank->angle = tank->angle + tank_flags_turn(flags);
+  }
+
+  for (size_t i = 0; i < world->shot_count;) {
+    lookahead_shot_t *shot = &world->shots[i];
+    shot->time_left = shot->time_left - dt;
+    if (shot->time_left <= 0 || !lookahead_in_maze(walls, shot->position)) {
+      lookahead_remove_shot(world, i);
+      continue;
+    }
+    double speed = sqrt(vec_dot(shot->velocity, shot->velocity));
+    if (speed > 0) {
+      vector_t hits[LOOKAHEAD_BOUNCES + 1];
+      size_t count = maze_raycast(walls, shot->position, shot->velocity, shot->radius, LOOKAHEAD_BOUNCES,
+                                  speed * dt, hits);
+      // after a bounce the shot leaves along the last leg of its path
+      if (count >= 2) {
+        vector_t leg = vec_subtract(hits[count - 1], hits[count - 2]);
+        double length = sqrt(vec_dot(leg, leg));
+        if (length > 1e-9) {
+          shot->velocity = vec_multiply(speed / length, leg);
+        }
+      }
+      shot->position = hits[count - 1];
+    }
+    bool hit = false;
+    for (size_t j = 0; j < INPUT_PLAYERS && !hit; j++) {
+      lookahead_tank_t *tank = &world->tanks[j];
+      if (tank->alive && lookahead_shot_hits(tank, shot->position, shot->radius)) {
+        tank->alive = false;
+        hit = true;
+      }
+    }
+    if (hit) {
+      lookahead_remove_shot(world, i);
+      continue;
+    }
+    i = i + 1;
+  }
+}
+
+/**
+ * Tells whether a shot, flying on as it is, passes a point before it runs out.
+ */
+bool lookahead_shot_reaches(maze_t *walls, const lookahead_shot_t *shot, vector_t point) {
+  double speed = sqrt(vec_dot(shot->velocity, shot->velocity));
+  if (speed == 0 || !lookahead_in_maze(walls, shot->position)) {
+    return false;
+  }
+  vector_t hits[LOOKAHEAD_BOUNCES + 1];
+  size_t count = maze_raycast(walls, shot->position, shot->velocity, shot->radius, LOOKAHEAD_BOUNCES,
+                              speed * fmin(shot->time_left, LOOKAHEAD_BULLET_TIME), hits);
+  vector_t start = shot->position;
+  double reach = TANK_SIZE / 2. + shot->radius;
+  for (size_t i = 0; i < count; i++) {
+    vector_t leg = vec_subtract(hits[i], start);
+    double length_squared = vec_dot(leg, leg);
+    double t = length_squared > 0 ? fmin(fmax(vec_dot(vec_subtract(point, start), leg) / length_squared, 0), 1) : 0;
+    vector_t nearest = vec_add(start, vec_multiply(t, leg));
+    vector_t offset = vec_subtract(point, nearest);
+    if (vec_dot(offset, offset) < reach * reach) {
+      return true;
+    }
+    start = hits[i];
+  }
+  return false;
+}
+
+size_t lookahead_cell(maze_t *walls, vector_t point) {
+  double width = (walls->upper_right.x - walls->lower_left.x) / walls->columns;
+  double height = (walls->upper_right.y - walls->lower_left.y) / walls->rows;
+  double column = fmin(fmax(floor((point.x - walls->lower_left.x) / width), 0), walls->columns - 1);
+  double row = fmin(fmax(floor((point.y - walls->lower_left.y) / height), 0), walls->rows - 1);
+  return (size_t)column + walls->columns * (size_t)row;
+}
+
+/**
+ * Plays out one future of a candidate from the worker's root: the
+ * searched tank holds the candidate's buttons throughout, and each
+ * opponent either keeps the buttons it holds now or plays randomly.
+ *
+ * @return the score of the future
+ */
+double lookahead_rollout(lookahead_worker_t *worker, size_t candidate, size_t *ticks) {
+  lookahead_root_t *root = &worker->root;
+  lookahead_world_t *future = &worker->future;
+  size_t self = worker->lookahead->player;
+  lookahead_clone(future, &root->world);
+
+  uint8_t buttons[INPUT_PLAYERS];
+  bool random[INPUT_PLAYERS];
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    buttons[i] = future->tanks[i].held & ~(1 << INPUT_SHOOT);
+    random[i] = i != self && rng_below(&worker->rng, 2) == 0;
+  }
+  uint8_t moves = LOOKAHEAD_MOVES[candidate % (LOOKAHEAD_CANDIDATES / 2)];
+  bool fires = candidate >= LOOKAHEAD_CANDIDATES / 2;
+
+  size_t tick = 0;
+  for (; tick < LOOKAHEAD_HORIZON && future->tanks[self].alive; tick++) {
+    for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+      if (i == self) {
+        buttons[i] = moves | (fires && tick == 0) << INPUT_SHOOT;
+      } else if (random[i]) {
+        if (tick % LOOKAHEAD_POLICY_TICKS == 0) {
+          buttons[i] = LOOKAHEAD_MOVES[rng_below(&worker->rng, LOOKAHEAD_CANDIDATES / 2)];
+        }
+        buttons[i] = (buttons[i] & ~(1 << INPUT_SHOOT))
+                     | (rng_below(&worker->rng, LOOKAHEAD_OPPONENT_FIRE) == 0) << INPUT_SHOOT;
+      }
+    }
+    lookahead_step(future, &root->walls, buttons, LOOKAHEAD_DT);
+  }
+  *ticks = tick;
+
+  lookahead_tank_t *tank = &future->tanks[self];
+  if (!tank->alive) {
+    return LOOKAHEAD_DEATH;
+  }
+  double score = 0;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    if (i != self && root->world.tanks[i].alive && !future->tanks[i].alive) {
+      score = score + LOOKAHEAD_KILL;
+    }
+  }
+  uint16_t distance = root->distances[lookahead_cell(&root->walls, tank->center)];
+  if (distance != UINT16_MAX) {
+    score = score + LOOKAHEAD_APPROACH * (1. - (double)distance / (root->walls.columns * root->walls.rows));
+  }
+  if (!fires) {
+    return score;
+  }
+  // the shot fired at the start, if it is still flying: the only one with that much time left
+  double fired_left = LOOKAHEAD_BULLET_TIME - tick * LOOKAHEAD_DT;
+  for (size_t s = 0; s < future->shot_count; s++) {
+    lookahead_shot_t *shot = &future->shots[s];
+    if (shot->owner != self || fabs(shot->time_left - fired_left) > 1e-6) {
+      continue;
+    }
+    for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+      if (i != self && future->tanks[i].alive && lookahead_shot_reaches(&root->walls, shot, future->tanks[i].center)) {
+        return score + LOOKAHEAD_AIMED;
+      }
+    }
+    break;
+  }
+  return score;
+}
+
+void *lookahead_work(void *aux) {
+  lookahead_worker_t *worker = aux;
+  lookahead_t *lookahead = worker->lookahead;
+  double scores[LOOKAHEAD_CANDIDATES];
+  pthread_mutex_lock(&lookahead->lock);
+  while (!lookahead->stopping) {
+    if (lookahead->root.serial == 0 || lookahead->root_rollouts >= lookahead->max_rollouts) {
+      pthread_cond_wait(&lookahead->root_ready, &lookahead->lock);
+      continue;
+    }
+    if (worker->root.serial != lookahead->root.serial) {
+      memcpy(&worker->root, &lookahead->root, offsetof(lookahead_root_t, world));
+      lookahead_clone(&worker->root.world, &lookahead->root.world);
+      worker->root.walls.cell_walls = worker->root.cell_walls;
+    }
+    pthread_mutex_unlock(&lookahead->lock);
+
+    // a round plays one future of every candidate, so they are compared under the same luck
+    double start = clock_now();
+    size_t ticks = 0;
+    for (size_t c = 0; c < LOOKAHEAD_CANDIDATES; c++) {
+      size_t played;
+      scores[c] = lookahead_rollout(worker, c, &played);
+      ticks = ticks + played;
+    }
+    double elapsed = clock_now() - start;
+
+    pthread_mutex_lock(&lookahead->lock);
+    lookahead->rollouts = lookahead->rollouts + LOOKAHEAD_CANDIDATES;
+    lookahead->rollout_ticks = lookahead->rollout_ticks + ticks;
+    lookahead->busy_time = lookahead->busy_time + elapsed;
+    if (worker->root.serial == lookahead->root.serial) {
+      for (size_t c = 0; c < LOOKAHEAD_CANDIDATES; c++) {
+        lookahead->scores[c] = lookahead->scores[c] + scores[c];
+        lookahead->counts[c] = lookahead->counts[c] + 1;
+      }
+      lookahead->root_rollouts = lookahead->root_rollouts + LOOKAHEAD_CANDIDATES;
+      pthread_cond_signal(&lookahead->progress);
+    }
+  }
+  pthread_mutex_unlock(&lookahead->lock);
+  return NULL;
+}
+
+lookahead_t *lookahead_init(size_t player, size_t workers, size_t min_rollouts, size_t cells) {
+  assert(player < INPUT_PLAYERS && workers > 0);
+  if (cells > LOOKAHEAD_MAX_CELLS) {
+    return NULL;
+  }
+  lookahead_t *lookahead = malloc(sizeof(lookahead_t));
+  assert(lookahead != NULL);
+  *lookahead = (lookahead_t){
+    .player = player,
+    .min_rollouts = min_rollouts,
+    .max_rollouts = min_rollouts > LOOKAHEAD_ROOT_ROLLOUTS ? min_rollouts : LOOKAHEAD_ROOT_ROLLOUTS,
+    .staging = malloc(sizeof(lookahead_root_t)),
+    .worker_count = workers,
+    .workers = malloc(sizeof(lookahead_worker_t *) * workers),
+  };
+  assert(lookahead->staging != NULL && lookahead->workers != NULL);
+  pthread_mutex_init(&lookahead->lock, NULL);
+  pthread_cond_init(&lookahead->root_ready, NULL);
+  pthread_cond_init(&lookahead->progress, NULL);
+  rng_t rng = rng_init(LOOKAHEAD_SEED + player);
+  for (size_t i = 0; i < workers; i++) {
+    lookahead_worker_t *worker = malloc(sizeof(lookahead_worker_t));
+    assert(worker != NULL);
+    worker->lookahead = lookahead;
+    worker->rng = rng;
+    worker->root.serial = 0;
+    rng_jump(&rng);
+    int created = pthread_create(&worker->thread, NULL, lookahead_work, worker);
+    assert(created == 0);
+    lookahead->workers[i] = worker;
+  }
+  return lookahead;
+}
+
+void lookahead_free(lookahead_t *lookahead) {
+  pthread_mutex_lock(&lookahead->lock);
+  lookahead->stopping = true;
+  pthread_cond_broadcast(&lookahead->root_ready);
+  pthread_mutex_unlock(&lookahead->lock);
+  for (size_t i = 0; i < lookahead->worker_count; i++) {
+    lookahead_worker_t *worker = lookahead->workers[i];
+    pthread_join(worker->thread, NULL);
+    free(worker);
+  }
+  pthread_mutex_destroy(&lookahead->lock);
+  pthread_cond_destroy(&lookahead->root_ready);
+  pthread_cond_destroy(&lookahead->progress);
+  free(lookahead->workers);
+  free(lookahead->staging);
+  free(lookahead);
+}
+
+/**
+ * Fills the staging root from the match: its world, a copy of its walls
+ * and the distance field toward the searched tank's enemies.
+ */
+void lookahead_stage(lookahead_t *lookahead, state_t *state) {
+  lookahead_root_t *root = lookahead->staging;
+  maze_t *maze = state->maze;
+  size_t cells = maze->columns * maze->rows;
+  // lookahead_init() refused larger mazes, and a match keeps its maze size
+  assert(cells <= LOOKAHEAD_MAX_CELLS);
+  memcpy(root->cell_walls, maze->cell_walls, cells);
+  root->walls = (maze_t){
+    .columns = maze->columns,
+    .rows = maze->rows,
+    .lower_left = maze->lower_left,
+    .upper_right = maze->upper_right,
+    .cell_walls = root->cell_walls,
+    .revision = maze->revision,
+  };
+  lookahead_observe(&root->world, state);
+  size_t enemies[INPUT_PLAYERS];
+  size_t count = 0;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    if (i != lookahead->player && root->world.tanks[i].alive) {
+      enemies[count] = lookahead_cell(&root->walls, root->world.tanks[i].center);
+      count = count + 1;
+    }
+  }
+  maze_distances(&root->walls, enemies, count, root->distances, root->queue);
+}
+
+uint8_t lookahead_tick(lookahead_t *lookahead, state_t *state) {
+  // the world is built before the lock is taken, so the workers wait only for the copy
+  lookahead_stage(lookahead, state);
+  pthread_mutex_lock(&lookahead->lock);
+  if (lookahead->root.serial != 0) {
+    while (lookahead->root_rollouts < lookahead->min_rollouts) {
+      pthread_cond_wait(&lookahead->progress, &lookahead->lock);
+    }
+  }
+  uint8_t buttons = 0;
+  double best = -INFINITY;
+  for (size_t c = 0; c < LOOKAHEAD_CANDIDATES; c++) {
+    if (lookahead->counts[c] > 0 && lookahead->scores[c] / lookahead->counts[c] > best) {
+      best = lookahead->scores[c] / lookahead->counts[c];
+      buttons = LOOKAHEAD_MOVES[c % (LOOKAHEAD_CANDIDATES / 2)] | (c >= LOOKAHEAD_CANDIDATES / 2) << INPUT_SHOOT;
+    }
+  }
+  if (best > -INFINITY) {
+    lookahead->decisions = lookahead->decisions + 1;
+    lookahead->decided_rollouts = lookahead->decided_rollouts + lookahead->root_rollouts;
+  }
+  uint64_t serial = lookahead->root.serial + 1;
+  memcpy(&lookahead->root, lookahead->staging, offsetof(lookahead_root_t, world));
+  lookahead_clone(&lookahead->root.world, &lookahead->staging->world);
+  lookahead->root.serial = serial;
+  lookahead->root.walls.cell_walls = lookahead->root.cell_walls;
+  for (size_t c = 0; c < LOOKAHEAD_CANDIDATES; c++) {
+    lookahead->scores[c] = 0;
+    lookahead->counts[c] = 0;
+  }
+  lookahead->root_rollouts = 0;
+  pthread_cond_broadcast(&lookahead->root_ready);
+  pthread_mutex_unlock(&lookahead->lock);
+  return buttons;
+}
@@ -4,8 +4,6 @@
 #include <math.h>
 #include "maze.h"
 #include "collision.h"
-#include <time.h>
-#include <sys/time.h>
 
 #define TRUE 1
 #define FALSE 0
@@ -19,13 +17,6 @@ typedef struct wall {
 const double WALL_THICKNESS = 6;
 const size_t MINUS_ONE = -1;
 
-void rand_seed_init() {
-  srand((unsigned int)time(NULL));
-}
-double rand_num() { 
-  return ((double)rand()) / RAND_MAX; 
-}
-
 size_t list_find_size(list_t *list, size_t* n) {
   for (size_t i = 0; i < list_size(list); i++) {
     if (*(size_t *)list_get(list, i) == *n) {
@@ -252,19 +243,20 @@ list_t *get_neighbors_vertex_index(size_t columns, size_t rows, size_t index) {
   return neighbors_index;
 }
 
-list_t *random_walls_index(size_t columns, size_t rows) {
+list_t *random_walls_index(size_t columns, size_t rows, rng_t *rng) {
   list_t *walls = walls_index_init(columns, rows);
   list_t *nodes = nodes_index_init(columns, rows);
   list_t *path = list_init((columns + 1) * (rows + 1), NULL);
   
   while (list_size(nodes) > 0) {
-    list_add(path, list_remove(nodes, floor(rand_num() * list_size(nodes))));  
+    list_add(path, list_remove(nodes, rng_below(rng, list_size(nodes))));  
     size_t wall_neighbor_index = MINUS_ONE;
-    size_t valid_neighbor_index = MINUS_ONE;
     while (wall_neighbor_index == MINUS_ONE) {
+      // found afresh at every step, or a dead end would step to a node it found earlier
+      size_t valid_neighbor_index = MINUS_ONE;
       list_t *neighbors_index = get_neighbors_vertex_index(columns, rows, *(size_t *)list_get(path, list_size(path) - 1));
       while (list_size(neighbors_index) > 0) {
-        size_t *neighbor_index = (size_t *)list_remove(neighbors_index, floor(rand_num() * list_size(neighbors_index)));
+        size_t *neighbor_index = (size_t *)list_remove(neighbors_index, rng_below(rng, list_size(neighbors_index)));
         size_t nodes_index_neighbor = list_find_size(nodes, neighbor_index);
         size_t path_index_neighbor = list_find_size(path, neighbor_index);
         bool neighbor_in_nodes = (nodes_index_neighbor != MINUS_ONE);
@@ -283,7 +275,13 @@ list_t *random_walls_index(size_t columns, size_t rows) {
           size_t *valid_neighbor = list_remove(nodes, list_find_size(nodes, &valid_neighbor_index));
           list_add(path, valid_neighbor);
         } else {
-          list_add(nodes, list_remove(path, list_size(path) - 1));
+          // a dead end: every neighbor is on the path, so erase the loop back to one of them and walk on from there
+          list_t *around = get_neighbors_vertex_index(columns, rows, *(size_t *)list_get(path, list_size(path) - 1));
+          size_t loop_start = list_find_size(path, list_get(around, rng_below(rng, list_size(around))));
+          while (list_size(path) > loop_start + 1) {
+            list_add(nodes, list_remove(path, list_size(path) - 1));
+          }
+          list_free(around);
         }
       } else {
         size_t *wall_neighbor = malloc(sizeof(size_t));
@@ -361,7 +359,7 @@ body_t *null_wall_init() {
         
 list_t *vertical_walls_init(
   size_t columns, size_t rows, vector_t lower_left, vector_t upper_right, list_t *walls_indices) {
-  list_t *vertical_walls = list_init(rows * (columns + 1), NULL); // should this be free?
+  list_t *vertical_walls = list_init(rows * (columns + 1), (free_func_t) body_free);
   wall_vertices_t *wall1 = malloc(sizeof(wall_vertices_t));
   wall_vertices_t *wall2 = malloc(sizeof(wall_vertices_t));
   for (size_t i = 0; i < rows; i++) {
@@ -384,7 +382,7 @@ list_t *vertical_walls_init(
 
 list_t *horizontal_walls_init(
   size_t columns, size_t rows, vector_t lower_left, vector_t upper_right, list_t *walls_index) {
-  list_t *horizontal_walls = list_init((rows + 1) * columns, NULL); // should this be free?
+  list_t *horizontal_walls = list_init((rows + 1) * columns, (free_func_t) body_free);
   wall_vertices_t *wall1 = malloc(sizeof(wall_vertices_t));
   wall_vertices_t *wall2 = malloc(sizeof(wall_vertices_t));
   for (size_t j = 0; j < columns; j++) {
@@ -405,30 +403,175 @@ list_t *horizontal_walls_init(
   return horizontal_walls;
 }
 
-maze_t *maze_init(size_t columns, size_t rows, vector_t lower_left, vector_t upper_right) {
+void cell_walls_init(maze_t *maze) {
+  size_t cells = maze->columns * maze->rows;
+  maze->cell_walls = malloc(sizeof(uint8_t) * cells);
+  maze->dirty_cells = malloc(sizeof(size_t) * cells);
+  assert(maze->cell_walls != NULL && maze->dirty_cells != NULL);
+  maze->dirty_count = 0;
+  maze->revision = 0;
+  for (size_t index = 0; index < cells; index++) {
+    list_t *walls_around = get_walls_around(maze, index_to_cell(maze, index));
+    const uint8_t bits[] = {WALL_LEFT, WALL_RIGHT, WALL_DOWN, WALL_UP};
+    uint8_t walls = 0;
+    for (size_t i = 0; i < list_size(walls_around); i++) {
+      if (((body_t *)list_get(walls_around, i))->info != NULL) {
+        walls |= bits[i];
+      }
+    }
+    maze->cell_walls[index] = walls;
+    list_free(walls_around);
+  }
+}
+
+maze_t *maze_init(size_t columns, size_t rows, vector_t lower_left, vector_t upper_right, rng_t *rng) {
   maze_t *maze = malloc(sizeof(maze_t));
   maze->columns = columns;
   maze->rows = rows;
   maze->lower_left = lower_left;
   maze->upper_right = upper_right;
-  rand_seed_init();
-  list_t *walls_index = random_walls_index(columns, rows);
+  list_t *walls_index = random_walls_index(columns, rows, rng);
   maze->vertical_walls = vertical_walls_init(columns, rows, lower_left, upper_right, walls_index);
   maze->horizontal_walls = horizontal_walls_init(columns, rows, lower_left, upper_right, walls_index);
+  cell_walls_init(maze);
   return maze;
 }
 
 void maze_free(maze_t *maze) {
   list_free(maze->vertical_walls);
   list_free(maze->horizontal_walls);
+  free(maze->cell_walls);
+  free(maze->dirty_cells);
   free(maze);
 }
 
-typedef struct body_maze_bool {
-  body_t *body;
-  maze_t *maze;
-  bool bol;
-} body_maze_bool_t;
+void maze_mark_dirty(maze_t *maze, cell_t cell, uint8_t wall) {
+  size_t index = cell_to_index(maze, cell);
+  maze->cell_walls[index] &= ~wall;
+  for (size_t i = 0; i < maze->dirty_count; i++) {
+    if (maze->dirty_cells[i] == index) {
+      return;
+    }
+  }
+  maze->dirty_cells[maze->dirty_count] = index;
+  maze->dirty_count = maze->dirty_count + 1;
+}
+
+bool maze_destroy_wall(maze_t *maze, bool vertical, size_t index) {
+  list_t *walls = vertical ? maze->vertical_walls : maze->horizontal_walls;
+  body_t *wall = list_get(walls, index);
+  if (wall->info == NULL) {
+    return FALSE;
+  }
+  if (vertical) {
+    // vertical_walls holds columns + 1 walls per row
+    size_t j = index % (maze->columns + 1);
+    size_t i = index / (maze->columns + 1);
+    if (j == 0 || j == maze->columns) {
+      return FALSE;
+    }
+    maze_mark_dirty(maze, (cell_t) {.x = j - 1, .y = i}, WALL_RIGHT);
+    maze_mark_dirty(maze, (cell_t) {.x = j, .y = i}, WALL_LEFT);
+  } else {
+    // horizontal_walls holds rows + 1 walls per column
+    size_t i = index % (maze->rows + 1);
+    size_t j = index / (maze->rows + 1);
+    if (i == 0 || i == maze->rows) {
+      return FALSE;
+    }
+    maze_mark_dirty(maze, (cell_t) {.x = j, .y = i - 1}, WALL_UP);
+    maze_mark_dirty(maze, (cell_t) {.x = j, .y = i}, WALL_DOWN);
+  }
+
+  // same shape as null_wall_init()
+  const vector_t null_shape[] = {{.x = 0, .y = 0}, {.x = 1, .y = 0}, {.x = 1, .y = 1}, {.x = 0, .y = 1}};
+  for (size_t k = 0; k < list_size(wall->shape); k++) {
+    *(vector_t *)list_get(wall->shape, k) = null_shape[k];
+  }
+  wall->center = (vector_t) {.x = 0.5, .y = 0.5};
+  wall->info = (void *)0;
+  wall->visible = FALSE;
+  maze->revision = maze->revision + 1;
+  return TRUE;
+}
+
+size_t maze_destroy_walls(maze_t *maze, cell_t cell, list_t *shape) {
+  size_t first_wall_index_horizontal = (maze->rows + 1) * cell.x + cell.y;
+  size_t first_wall_index_vertical = (maze->columns + 1) * cell.y + cell.x;
+  const bool vertical[] = {TRUE, TRUE, FALSE, FALSE};
+  const size_t indices[] = {
+    first_wall_index_vertical, first_wall_index_vertical + 1,
+    first_wall_index_horizontal, first_wall_index_horizontal + 1
+  };
+  size_t destroyed = 0;
+  for (size_t i = 0; i < 4; i++) {
+    list_t *walls = vertical[i] ? maze->vertical_walls : maze->horizontal_walls;
+    body_t *wall = list_get(walls, indices[i]);
+    if (wall->info != NULL && find_collision(shape, wall->shape).collided
+        && maze_destroy_wall(maze, vertical[i], indices[i])) {
+      destroyed++;
+    }
+  }
+  return destroyed;
+}
+
+/**
+ * Widens [*low, *high] to the x coordinates a convex shape reaches
+ * between two heights.
+ */
+void maze_shape_span(list_t *shape, double bottom, double top, double *low, double *high) {
+  size_t n = list_size(shape);
+  const double heights[] = {bottom, top};
+  for (size_t i = 0; i < n; i++) {
+    vector_t a = *(vector_t *)list_get(shape, i);
+    vector_t b = *(vector_t *)list_get(shape, (i + 1) % n);
+    if (bottom <= a.y && a.y <= top) {
+      *low = fmin(*low, a.x);
+      *high = fmax(*high, a.x);
+    }
+    for (size_t k = 0; k < 2; k++) {
+      if (a.y != b.y && (a.y - heights[k]) * (b.y - heights[k]) <= 0) {
+        double x = a.x + (heights[k] - a.y) * (b.x - a.x) / (b.y - a.y);
+        *low = fmin(*low, x);
+        *high = fmax(*high, x);
+      }
+    }
+  }
+}
+
+size_t maze_destroy_walls_under(maze_t *maze, list_t *shape) {
+  double edge_horizontal = (maze->upper_right.x - maze->lower_left.x) / maze->columns;
+  double edge_vertical = (maze->upper_right.y - maze->lower_left.y) / maze->rows;
+  // a wall reaches half its thickness into the cells on either side of its edge
+  double pad = WALL_THICKNESS / 2;
+  double bottom = INFINITY;
+  double top = -INFINITY;
+  for (size_t i = 0; i < list_size(shape); i++) {
+    vector_t *vertex = list_get(shape, i);
+    bottom = fmin(bottom, vertex->y);
+    top = fmax(top, vertex->y);
+  }
+  double first_row = fmax(0, floor((bottom - pad - maze->lower_left.y) / edge_vertical));
+  double last_row = fmin(maze->rows - 1, floor((top + pad - maze->lower_left.y) / edge_vertical));
+  size_t destroyed = 0;
+  // row by row, the cells between where the shape enters and leaves the row
+  for (double row = first_row; row <= last_row; row++) {
+    double row_bottom = maze->lower_left.y + row * edge_vertical;
+    double low = INFINITY;
+    double high = -INFINITY;
+    maze_shape_span(shape, row_bottom - pad, row_bottom + edge_vertical + pad, &low, &high);
+    double first_column = fmax(0, floor((low - pad - maze->lower_left.x) / edge_horizontal));
+    double last_column = fmin(maze->columns - 1, floor((high + pad - maze->lower_left.x) / edge_horizontal));
+    for (double column = first_column; column <= last_column; column++) {
+      destroyed += maze_destroy_walls(maze, (cell_t) {.x = (size_t) column, .y = (size_t) row}, shape);
+    }
+  }
+  return destroyed;
+}
+
+void maze_clear_dirty(maze_t *maze) {
+  maze->dirty_count = 0;
+}
 
 void amazing_force(void *aux) {
   body_t *body = ((body_maze_bool_t *)aux)->body;
@@ -477,7 +620,7 @@ void amazing_force(void *aux) {
   list_free(collision_info_list);
 }
 
-void add_maze_collision(scene_t *scene, maze_t *maze, body_t *body) {
+body_maze_bool_t *add_maze_collision(scene_t *scene, maze_t *maze, body_t *body) {
   body_maze_bool_t *aux = malloc(sizeof(body_maze_bool_t));
   aux->body = body;
   aux->maze = maze;
@@ -485,10 +628,11 @@ void add_maze_collision(scene_t *scene, maze_t *maze, body_t *body) {
   list_t *bodies = list_init(1, NULL);
   list_add(bodies, body);
   scene_add_bodies_force_creator(scene, amazing_force, aux, bodies, free);
+  return aux;
 }
 
-vector_t get_random_cell_center(maze_t *maze) {
-  size_t index = (maze->rows * maze->columns) * rand_num();
+vector_t get_random_cell_center(maze_t *maze, rng_t *rng) {
+  size_t index = rng_below(rng, maze->rows * maze->columns);
   return cell_to_vector(maze, index_to_cell(maze, index));
 }
 
@@ -501,10 +645,10 @@ size_t list_find_vector(list_t *list, vector_t* v) {
   }
   return MINUS_ONE;
 }
-list_t *get_random_cell_centers(maze_t *maze, size_t num) {
+list_t *get_random_cell_centers(maze_t *maze, size_t num, rng_t *rng) {
   list_t *random_vectors = list_init(num, free);
   while (list_size(random_vectors) < num) {
-    size_t index = (maze->rows * maze->columns) * rand_num();
+    size_t index = rng_below(rng, maze->rows * maze->columns);
     vector_t *center = malloc(sizeof(vector_t));
     *center = cell_to_vector(maze, index_to_cell(maze, index));
     if (list_find_vector(random_vectors, center) == MINUS_ONE) {
@@ -515,3 +659,314 @@ list_t *get_random_cell_centers(maze_t *maze, size_t num) {
   }
   return random_vectors;
 }
+
+/**
+ * Tells whether the wall on the vertical grid line x = line between rows
+ * row and row + 1 stands. Rows off the grid have no wall.
+ */
+bool maze_vertical_wall(maze_t *maze, size_t line, size_t row) {
+  if (row >= maze->rows) {
+    return FALSE;
+  }
+  if (line < maze->columns) {
+    return (maze->cell_walls[line + maze->columns * row] & WALL_LEFT) != 0;
+  }
+  return (maze->cell_walls[line - 1 + maze->columns * row] & WALL_RIGHT) != 0;
+}
+
+/**
+ * Tells whether the wall on the horizontal grid line y = line between
+ * columns column and column + 1 stands. Columns off the grid have no wall.
+ */
+bool maze_horizontal_wall(maze_t *maze, size_t column, size_t line) {
+  if (column >= maze->columns) {
+    return FALSE;
+  }
+  if (line < maze->rows) {
+    return (maze->cell_walls[column + maze->columns * line] & WALL_DOWN) != 0;
+  }
+  return (maze->cell_walls[column + maze->columns * (line - 1)] & WALL_UP) != 0;
+}
+
+/**
+ * Finds the stretch of the ray (px, py) + t (dx, dy) inside the box
+ * [low, high]. The ray enters the box's x range at *near_x and its y
+ * range at *near_y, and leaves the box at *far; it misses the box if the
+ * later entry comes after *far.
+ */
+void maze_ray_box_span(double px, double py, double dx, double dy, vector_t low, vector_t high,
+                       double *near_x, double *near_y, double *far) {
+  *near_x = -INFINITY;
+  *near_y = -INFINITY;
+  *far = INFINITY;
+  if (dx != 0) {
+    double a = (low.x - px) / dx;
+    double b = (high.x - px) / dx;
+    *near_x = a < b ? a : b;
+    *far = a < b ? b : a;
+  } else if (px < low.x || px > high.x) {
+    *far = -INFINITY;
+  }
+  if (dy != 0) {
+    double a = (low.y - py) / dy;
+    double b = (high.y - py) / dy;
+    *near_y = a < b ? a : b;
+    double far_y = a < b ? b : a;
+    *far = far_y < *far ? far_y : *far;
+  } else if (py < low.y || py > high.y) {
+    *far = -INFINITY;
+  }
+}
+
+/**
+ * Moves *t to where the ray enters the box [low, high] if that comes
+ * before *t, and records in *along_x whether it entered through a vertical
+ * side. A ray starting inside the box never enters it.
+ */
+void maze_raycast_box(double px, double py, double dx, double dy, vector_t low, vector_t high,
+                      double *t, bool *along_x) {
+  double near_x;
+  double near_y;
+  double far;
+  maze_ray_box_span(px, py, dx, dy, low, high, &near_x, &near_y, &far);
+  double near = near_x > near_y ? near_x : near_y;
+  if (near < 0 || near > far || near >= *t) {
+    return;
+  }
+  *t = near;
+  *along_x = near_x >= near_y;
+}
+
+size_t maze_raycast(maze_t *maze, vector_t origin, vector_t direction, double radius,
+                    size_t max_bounces, double max_distance, vector_t *hits) {
+  if (check_outside(maze, origin)) {
+    return 0;
+  }
+  size_t columns = maze->columns;
+  size_t rows = maze->rows;
+  double edge_horizontal = (maze->upper_right.x - maze->lower_left.x) / columns;
+  double edge_vertical = (maze->upper_right.y - maze->lower_left.y) / rows;
+  double pad = WALL_THICKNESS / 2 + radius;
+  double length = sqrt(direction.x * direction.x + direction.y * direction.y);
+  assert(length > 0);
+  double dx = direction.x / length;
+  double dy = direction.y / length;
+  double px = origin.x - maze->lower_left.x;
+  double py = origin.y - maze->lower_left.y;
+  size_t cx = (size_t) fmin(floor(px / edge_horizontal), columns - 1);
+  size_t cy = (size_t) fmin(floor(py / edge_vertical), rows - 1);
+  double remaining = max_distance;
+  size_t count = 0;
+
+  while (TRUE) {
+    uint8_t walls = maze->cell_walls[cx + columns * cy];
+
+    // time until the ray reaches the next vertical line or the wall on it
+    double t_x = INFINITY;
+    bool wall_x = FALSE;
+    if (dx != 0) {
+      bool right = dx > 0;
+      double plane = (cx + right) * edge_horizontal;
+      wall_x = (walls & (right ? WALL_RIGHT : WALL_LEFT)) != 0;
+      if (wall_x) {
+        plane = plane + (right ? -pad : pad);
+      }
+      t_x = (plane - px) / dx;
+      t_x = t_x > 0 ? t_x : 0;
+    }
+    double t_y = INFINITY;
+    bool wall_y = FALSE;
+    if (dy != 0) {
+      bool up = dy > 0;
+      double plane = (cy + up) * edge_vertical;
+      wall_y = (walls & (up ? WALL_UP : WALL_DOWN)) != 0;
+      if (wall_y) {
+        plane = plane + (up ? -pad : pad);
+      }
+      t_y = (plane - py) / dy;
+      t_y = t_y > 0 ? t_y : 0;
+    }
+
+    bool along_x = t_x < t_y;
+    double t = along_x ? t_x : t_y;
+    bool wall = along_x ? wall_x : wall_y;
+    // the ends of the walls meeting at this cell's corners reach pad into
+    // it, so they are only tested when the step passes within pad of a corner
+    // (comparisons rather than fmin and fmax, which are library calls on this hot path)
+    double step = t < remaining ? t : remaining;
+    double end_x = px + dx * step;
+    double end_y = py + dy * step;
+    bool near_side[2] = {(dx < 0 ? end_x : px) < cx * edge_horizontal + pad,
+                         (dx < 0 ? px : end_x) > (cx + 1) * edge_horizontal - pad};
+    bool near_end[2] = {(dy < 0 ? end_y : py) < cy * edge_vertical + pad,
+                        (dy < 0 ? py : end_y) > (cy + 1) * edge_vertical - pad};
+    for (size_t corner_y = 0; corner_y < 2; corner_y++) {
+      for (size_t corner_x = 0; corner_x < 2; corner_x++) {
+        if (!near_side[corner_x] || !near_end[corner_y]) {
+          continue;
+        }
+        // the wall along the cell's side line past the corner, and the one along its top or bottom line
+        size_t row = cy + 2 * corner_y - 1;
+        size_t column = cx + 2 * corner_x - 1;
+        bool side_wall = maze_vertical_wall(maze, cx + corner_x, row);
+        bool end_wall = maze_horizontal_wall(maze, column, cy + corner_y);
+        if (!side_wall && !end_wall) {
+          continue;
+        }
+        double x = (cx + corner_x) * edge_horizontal;
+        double y = (cy + corner_y) * edge_vertical;
+        double near_x;
+        double near_y;
+        double far;
+        maze_ray_box_span(px, py, dx, dy, (vector_t) {.x = x - pad, .y = y - pad},
+                          (vector_t) {.x = x + pad, .y = y + pad}, &near_x, &near_y, &far);
+        double near = near_x > near_y ? near_x : near_y;
+        if (near > far || far < 0 || near > step) {
+          continue;
+        }
+        double before = t;
+        if (side_wall) {
+          maze_raycast_box(px, py, dx, dy, (vector_t) {.x = x - pad, .y = row * edge_vertical - pad},
+                           (vector_t) {.x = x + pad, .y = (row + 1) * edge_vertical + pad}, &t, &along_x);
+        }
+        if (end_wall) {
+          maze_raycast_box(px, py, dx, dy, (vector_t) {.x = column * edge_horizontal - pad, .y = y - pad},
+                           (vector_t) {.x = (column + 1) * edge_horizontal + pad, .y = y + pad}, &t, &along_x);
+        }
+        wall = wall || t < before;
+      }
+    }
+    if (t >= remaining) {
+      hits[count] = (vector_t) {.x = px + dx * remaining + maze->lower_left.x,
+                                .y = py + dy * remaining + maze->lower_left.y};
+      return count + 1;
+    }
+    px = px + dx * t;
+    py = py + dy * t;
+    remaining = remaining - t;
+
+    if (wall) {
+      hits[count] = (vector_t) {.x = px + maze->lower_left.x, .y = py + maze->lower_left.y};
+      count++;
+      if (count > max_bounces) {
+        return count;
+      }
+      if (along_x) {
+        dx = -dx;
+      } else {
+        dy = -dy;
+      }
+    } else if (along_x) {
+      // the border walls are never destroyed, so the ray cannot leave the grid
+      cx = dx > 0 ? cx + 1 : cx - 1;
+    } else {
+      cy = dy > 0 ? cy + 1 : cy - 1;
+    }
+  }
+}
+
+void maze_raycast_batch(maze_t *maze, const vector_t *origins, const vector_t *directions,
+                        size_t count, double radius, size_t max_bounces, double max_distance,
+                        vector_t *hits, size_t *hit_counts) {
+  size_t stride = max_bounces + 1;
+  for (size_t i = 0; i < count; i++) {
+    hit_counts[i] = maze_raycast(maze, origins[i], directions[i], radius, max_bounces,
+                                 max_distance, &hits[i * stride]);
+  }
+}
+
+/**
+ * Tells whether a square overlaps an axis-aligned rectangle, by separating
+ * axes: the two of the rectangle and the two of the square.
+ */
+bool maze_box_overlaps_rect(vector_t center, double half, vector_t axis, vector_t rect_center, vector_t rect_half) {
+  double dx = rect_center.x - center.x;
+  double dy = rect_center.y - center.y;
+  double reach = half * (fabs(axis.x) + fabs(axis.y));
+  if (fabs(dx) >= rect_half.x + reach || fabs(dy) >= rect_half.y + reach) {
+    return FALSE;
+  }
+  double along = dx * axis.x + dy * axis.y;
+  double across = dy * axis.x - dx * axis.y;
+  return fabs(along) < half + rect_half.x * fabs(axis.x) + rect_half.y * fabs(axis.y)
+         && fabs(across) < half + rect_half.x * fabs(axis.y) + rect_half.y * fabs(axis.x);
+}
+
+bool maze_box_hits_wall(maze_t *maze, vector_t center, double size, double angle) {
+  if (check_outside(maze, center)) {
+    return TRUE;
+  }
+  double edge_horizontal = (maze->upper_right.x - maze->lower_left.x) / maze->columns;
+  double edge_vertical = (maze->upper_right.y - maze->lower_left.y) / maze->rows;
+  double pad = WALL_THICKNESS / 2;
+  size_t cx = (size_t) fmin(floor((center.x - maze->lower_left.x) / edge_horizontal), maze->columns - 1);
+  size_t cy = (size_t) fmin(floor((center.y - maze->lower_left.y) / edge_vertical), maze->rows - 1);
+  uint8_t walls = maze->cell_walls[cx + maze->columns * cy];
+  double left = maze->lower_left.x + cx * edge_horizontal;
+  double bottom = maze->lower_left.y + cy * edge_vertical;
+  vector_t axis = {.x = cos(angle), .y = sin(angle)};
+  double half = size / 2;
+  // each wall spans its edge and half its thickness past either end, as wall_init() builds it
+  vector_t vertical_half = {.x = pad, .y = edge_vertical / 2 + pad};
+  vector_t horizontal_half = {.x = edge_horizontal / 2 + pad, .y = pad};
+  double middle_x = left + edge_horizontal / 2;
+  double middle_y = bottom + edge_vertical / 2;
+  return ((walls & WALL_LEFT)
+          && maze_box_overlaps_rect(center, half, axis, (vector_t) {.x = left, .y = middle_y}, vertical_half))
+         || ((walls & WALL_RIGHT)
+             && maze_box_overlaps_rect(center, half, axis, (vector_t) {.x = left + edge_horizontal, .y = middle_y},
+                                       vertical_half))
+         || ((walls & WALL_DOWN)
+             && maze_box_overlaps_rect(center, half, axis, (vector_t) {.x = middle_x, .y = bottom}, horizontal_half))
+         || ((walls & WALL_UP)
+             && maze_box_overlaps_rect(center, half, axis, (vector_t) {.x = middle_x, .y = bottom + edge_vertical},
+                                       horizontal_half));
+}
+
+size_t maze_neighbour(maze_t *maze, size_t cell, uint8_t side) {
+  if (maze->cell_walls[cell] & side) {
+    return SIZE_MAX;
+  }
+  size_t column = cell % maze->columns;
+  size_t row = cell / maze->columns;
+  switch (side) {
+    case WALL_LEFT:
+      return column > 0 ? cell - 1 : SIZE_MAX;
+    case WALL_RIGHT:
+      return column + 1 < maze->columns ? cell + 1 : SIZE_MAX;
+    case WALL_DOWN:
+      return row > 0 ? cell - maze->columns : SIZE_MAX;
+    default:
+      return row + 1 < maze->rows ? cell + maze->columns : SIZE_MAX;
+  }
+}
+
+void maze_distances(maze_t *maze, const size_t *sources, size_t source_count, uint16_t *distances,
+                    uint16_t *queue) {
+  size_t cells = maze->columns * maze->rows;
+  assert(cells < UINT16_MAX);
+  for (size_t i = 0; i < cells; i++) {
+    distances[i] = UINT16_MAX;
+  }
+  size_t head = 0;
+  size_t tail = 0;
+  for (size_t i = 0; i < source_count; i++) {
+    if (distances[sources[i]] != 0) {
+      distances[sources[i]] = 0;
+      queue[tail] = sources[i];
+      tail = tail + 1;
+    }
+  }
+  while (head < tail) {
+    size_t cell = queue[head];
+    head = head + 1;
+    for (uint8_t side = WALL_LEFT; side <= WALL_UP; side = side << 1) {
+      size_t next = maze_neighbour(maze, cell, side);
+      if (next != SIZE_MAX && distances[next] == UINT16_MAX) {
+        distances[next] = distances[cell] + 1;
+        queue[tail] = next;
+        tail = tail + 1;
+      }
+    }
+  }
+}
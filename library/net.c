@@ -0,0 +1,201 @@
+#include "net.h"
+#include "clock.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// socket constants
+const size_t NET_INITIAL_DELAYED = 64;
+const int NET_RECEIVE_BUFFER = 1 << 20; // room for a burst of snapshots from a stalled loop
+
+net_socket_t *net_socket_init(uint16_t port, net_shim_t shim, uint64_t seed) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0
+      || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+    close(fd);
+    return NULL;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &NET_RECEIVE_BUFFER, sizeof(NET_RECEIVE_BUFFER));
+  net_socket_t *sock = malloc(sizeof(net_socket_t));
+  assert(sock != NULL);
+  *sock = (net_socket_t){.fd = fd, .shim = shim, .rng = rng_init(seed)};
+  sock->delayed_capacity = NET_INITIAL_DELAYED;
+  sock->delayed = malloc(sizeof(net_datagram_t) * sock->delayed_capacity);
+  assert(sock->delayed != NULL);
+  return sock;
+}
+
+void net_socket_free(net_socket_t *sock) {
+  for (size_t i = 0; i < sock->delayed_count; i++) {
+    free(sock->delayed[i].data);
+  }
+  free(sock->delayed);
+  close(sock->fd);
+  free(sock);
+}
+
+bool net_resolve(const char *host, uint16_t port, struct sockaddr_in *address) {
+  struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+  struct addrinfo *found;
+  if (getaddrinfo(host, NULL, &hints, &found) != 0) {
+    return false;
+  }
+  *address = *(struct sockaddr_in *)found->ai_addr;
+  address->sin_port = htons(port);
+  freeaddrinfo(found);
+  return true;
+}
+
+void net_send_now(net_socket_t *sock, const struct sockaddr_in *to, const uint8_t *data, size_t length) {
+  sendto(sock->fd, data, length, 0, (const struct sockaddr *)to, sizeof(*to));
+  sock->bytes_sent = sock->bytes_sent + length;
+  sock->datagrams_sent = sock->datagrams_sent + 1;
+}
+
+void net_send(net_socket_t *sock, const struct sockaddr_in *to, const uint8_t *data, size_t length, double now) {
+  assert(length <= NET_MAX_DATAGRAM);
+  net_shim_t shim = sock->shim;
+  if (shim.loss > 0 && rng_double(&sock->rng) < shim.loss) {
+    sock->datagrams_dropped = sock->datagrams_dropped + 1;
+    return;
+  }
+  if (shim.latency <= 0 && shim.jitter <= 0) {
+    net_send_now(sock, to, data, length);
+    return;
+  }
+  if (sock->delayed_count == sock->delayed_capacity) {
+    sock->delayed_capacity = sock->delayed_capacity * 2;
+    sock->delayed = realloc(sock->delayed, sizeof(net_datagram_t) * sock->delayed_capacity);
+    assert(sock->delayed != NULL);
+  }
+  net_datagram_t *datagram = &sock->delayed[sock->delayed_count];
+  datagram->due = now + shim.latency + shim.jitter * rng_double(&sock->rng);
+  datagram->to = *to;
+  datagram->length = length;
+  datagram->data = malloc(length);
+  assert(datagram->data != NULL);
+  memcpy(datagram->data, data, length);
+  sock->delayed_count = sock->delayed_count + 1;
+}
+
+void net_flush(net_socket_t *sock, double now) {
+  // the datagrams still held keep their order, so without jitter none overtakes another
+  size_t kept = 0;
+  for (size_t i = 0; i < sock->delayed_count; i++) {
+    net_datagram_t *datagram = &sock->delayed[i];
+    if (datagram->due <= now) {
+      net_send_now(sock, &datagram->to, datagram->data, datagram->length);
+      free(datagram->data);
+    } else {
+      sock->delayed[kept] = *datagram;
+      kept = kept + 1;
+    }
+  }
+  sock->delayed_count = kept;
+}
+
+size_t net_receive(net_socket_t *sock, uint8_t *data, struct sockaddr_in *from) {
+  while (true) {
+    socklen_t from_length = sizeof(*from);
+    ssize_t length = recvfrom(sock->fd, data, NET_MAX_DATAGRAM, 0, (struct sockaddr *)from, &from_length);
+    if (length > 0) {
+      sock->bytes_received = sock->bytes_received + length;
+      sock->datagrams_received = sock->datagrams_received + 1;
+      return length;
+    }
+    // empty datagrams are skipped; errors other than an interruption mean nothing is waiting
+    if (length < 0 && errno != EINTR) {
+      return 0;
+    }
+  }
+}
+
+bool net_same_address(const struct sockaddr_in *a, const struct sockaddr_in *b) {
+  return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+net_writer_t net_writer_init(uint8_t *data, size_t capacity) {
+  return (net_writer_t){.data = data, .capacity = capacity, .length = 0, .overflow = false};
+}
+
+void net_put_u8(net_writer_t *writer, uint8_t value) {
+  if (writer->length >= writer->capacity) {
+    writer->overflow = true;
+    return;
+  }
+  writer->data[writer->length] = value;
+  writer->length = writer->length + 1;
+}
+
+void net_put_varint(net_writer_t *writer, uint64_t value) {
+  while (value >= 0x80) {
+    net_put_u8(writer, (value & 0x7f) | 0x80);
+    value = value >> 7;
+  }
+  net_put_u8(writer, value);
+}
+
+void net_put_svarint(net_writer_t *writer, int64_t value) {
+  net_put_varint(writer, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void net_put_bytes(net_writer_t *writer, const uint8_t *bytes, size_t count) {
+  if (writer->length + count > writer->capacity) {
+    writer->overflow = true;
+    return;
+  }
+  memcpy(writer->data + writer->length, bytes, count);
+  writer->length = writer->length + count;
+}
+
+net_reader_t net_reader_init(const uint8_t *data, size_t length) {
+  return (net_reader_t){.data = data, .length = length, .offset = 0, .error = false};
+}
+
+uint8_t net_get_u8(net_reader_t *reader) {
+  if (reader->offset >= reader->length) {
+    reader->error = true;
+    return 0;
+  }
+  uint8_t value = reader->data[reader->offset];
+  reader->offset = reader->offset + 1;
+  return value;
+}
+
+uint64_t net_get_varint(net_reader_t *reader) {
+  uint64_t value = 0;
+  for (size_t shift = 0; shift < 64; shift += 7) {
+    uint8_t byte = net_get_u8(reader);
+    value = value | (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+  reader->error = true;
+  return 0;
+}
+
+int64_t net_get_svarint(net_reader_t *reader) {
+  uint64_t value = net_get_varint(reader);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void net_get_bytes(net_reader_t *reader, uint8_t *bytes, size_t count) {
+  if (reader->offset + count > reader->length) {
+    reader->error = true;
+    memset(bytes, 0, count);
+    return;
+  }
+  memcpy(bytes, reader->data + reader->offset, count);
+  reader->offset = reader->offset + count;
+}
@@ -0,0 +1,839 @@
+#include "netcode.h"
+#include "clock.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAU (6.28318530717958)
+
+// protocol constants
+const uint8_t NET_MAGIC = 0x54;
+const size_t NET_INITIAL_ENTITIES = 64;
+const size_t NET_MAX_ENTITIES = 1 << 16; // more than a decoded snapshot could be meant to hold
+const size_t NET_MAX_CELLS = 1 << 16;
+const size_t NET_INPUT_BACKLOG = 2; // inputs waiting before the server applies two a tick to catch up
+const double NET_TIMEOUT = 3.; // seconds without a datagram before a client is dropped
+const double NET_CONNECT_INTERVAL = .25; // seconds between requests to join
+
+typedef enum {
+  NET_CONNECT, // client: the protocol version
+  NET_WELCOME, // server: the set of controls, the maze size, the seed, the tick and the maze's bounds
+  NET_FULL, // server: every set of controls is taken
+  NET_INPUT, // client: the newest snapshot it has, then its newest inputs, newest first
+  NET_SNAPSHOT, // server: the tick, the baseline, the newest input applied, then the coded snapshot
+  NET_LEAVE // client: it is going away
+} net_message_t;
+
+net_snapshot_t *net_snapshot_init() {
+  net_snapshot_t *snapshot = malloc(sizeof(net_snapshot_t));
+  assert(snapshot != NULL);
+  *snapshot = (net_snapshot_t){.tick = 0};
+  snapshot->entity_capacity = NET_INITIAL_ENTITIES;
+  snapshot->entities = malloc(sizeof(net_entity_t) * snapshot->entity_capacity);
+  assert(snapshot->entities != NULL);
+  return snapshot;
+}
+
+void net_snapshot_free(net_snapshot_t *snapshot) {
+  free(snapshot->entities);
+  free(snapshot->cell_walls);
+  free(snapshot);
+}
+
+void net_snapshot_reserve(net_snapshot_t *snapshot, size_t entities, size_t cells) {
+  if (entities > snapshot->entity_capacity) {
+    while (entities > snapshot->entity_capacity) {
+      snapshot->entity_capacity = snapshot->entity_capacity * 2;
+    }
+    snapshot->entities = realloc(snapshot->entities, sizeof(net_entity_t) * snapshot->entity_capacity);
+    assert(snapshot->entities != NULL);
+  }
+  if (cells > snapshot->cell_capacity) {
+    snapshot->cell_capacity = cells;
+    snapshot->cell_walls = realloc(snapshot->cell_walls, cells);
+    assert(snapshot->cell_walls != NULL);
+  }
+}
+
+void net_snapshot_copy(net_snapshot_t *to, const net_snapshot_t *from) {
+  net_snapshot_reserve(to, from->entity_count, from->cell_count);
+  to->tick = from->tick;
+  memcpy(to->match, from->match, sizeof(from->match));
+  to->cell_count = from->cell_count;
+  memcpy(to->cell_walls, from->cell_walls, from->cell_count);
+  to->entity_count = from->entity_count;
+  memcpy(to->entities, from->entities, sizeof(net_entity_t) * from->entity_count);
+}
+
+int32_t net_position(double coordinate) {
+  return lround(coordinate * NET_POSITION_UNITS);
+}
+
+int32_t net_angle(double angle) {
+  int32_t units = lround(fmod(angle, TAU) / TAU * NET_ANGLE_UNITS);
+  return (units % NET_ANGLE_UNITS + NET_ANGLE_UNITS) % NET_ANGLE_UNITS;
+}
+
+net_entity_t *net_snapshot_add(net_snapshot_t *snapshot, net_entity_kind_t kind, size_t index, vector_t position,
+                               double angle) {
+  net_snapshot_reserve(snapshot, snapshot->entity_count + 1, 0);
+  net_entity_t *entity = &snapshot->entities[snapshot->entity_count];
+  *entity = (net_entity_t){.id = (uint32_t)kind << NET_ID_SHIFT | index};
+  entity->fields[NET_FIELD_X] = net_position(position.x);
+  entity->fields[NET_FIELD_Y] = net_position(position.y);
+  entity->fields[NET_FIELD_ANGLE] = net_angle(angle);
+  snapshot->entity_count = snapshot->entity_count + 1;
+  return entity;
+}
+
+uint8_t net_flags_buttons(const mov_flags_t *flags) {
+  return (flags->flag_forwards == 1) << INPUT_FORWARD | (flags->flag_backwards == 1) << INPUT_BACKWARD
+         | (flags->flag_left == 1) << INPUT_LEFT | (flags->flag_right == 1) << INPUT_RIGHT;
+}
+
+mov_flags_t net_buttons_flags(uint8_t buttons) {
+  return (mov_flags_t){
+    .flag_forwards = buttons >> INPUT_FORWARD & 1,
+    .flag_backwards = buttons >> INPUT_BACKWARD & 1,
+    .flag_left = buttons >> INPUT_LEFT & 1,
+    .flag_right = buttons >> INPUT_RIGHT & 1,
+  };
+}
+
+void net_snapshot_capture(net_snapshot_t *snapshot, state_t *state) {
+  maze_t *maze = state->maze;
+  size_t cell_count = maze->columns * maze->rows;
+  net_snapshot_reserve(snapshot, 0, cell_count);
+  snapshot->tick = state->tick;
+  snapshot->match[NET_MATCH_CONTROLS] = state->tank_controls;
+  snapshot->match[NET_MATCH_RED_WINS] = state->red_wins;
+  snapshot->match[NET_MATCH_GREEN_WINS] = state->green_wins;
+  snapshot->match[NET_MATCH_BLUE_WINS] = state->blue_wins;
+  snapshot->match[NET_MATCH_GAMES] = state->games_played;
+  snapshot->match[NET_MATCH_COUNTDOWN] = lround(fmax(state->count_down_until_next_game_start, 0) * 1000);
+  snapshot->match[NET_MATCH_GENERATION] = state->maze_generation;
+  snapshot->match[NET_MATCH_REVISION] = maze->revision;
+  snapshot->cell_count = cell_count;
+  memcpy(snapshot->cell_walls, maze->cell_walls, cell_count);
+
+  snapshot->entity_count = 0;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    tank_t *tank = player_tank(state, i);
+    if (tank == NULL) {
+      continue;
+    }
+    body_t *body = get_tank_body(tank);
+    net_entity_t *entity = net_snapshot_add(snapshot, NET_TANK, i, body->center, body->orientation);
+    entity->fields[NET_FIELD_KIND] = shot_kind(tank->bang);
+    entity->fields[NET_FIELD_FLAGS] = net_flags_buttons(tank->mov_flags);
+    entity->fields[NET_FIELD_AMMO] = tank->bullets_onscreen + tank->powerup_shots_left * 256;
+  }
+  powerup_pool_t *powerups = state->powerups;
+  for (size_t i = 0; i < powerups->capacity; i++) {
+    powerup_pulse_t *pulse = powerups->pulses[i];
+    if (pulse != NULL) {
+      net_entity_t *entity = net_snapshot_add(snapshot, NET_POWERUP, i, pulse->body->center, 0);
+      entity->fields[NET_FIELD_KIND] = pulse->type;
+    }
+  }
+  projectile_pool_t *projectiles = state->projectiles;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body != NULL && !body_is_removed(body)) {
+      net_entity_t *entity = net_snapshot_add(snapshot, NET_PROJECTILE, i, body->center, body->orientation);
+      entity->fields[NET_FIELD_KIND] = projectiles->infos[i].kind;
+      entity->fields[NET_FIELD_FLAGS] = projectiles->infos[i].owner;
+    }
+  }
+}
+
+const net_entity_t *net_snapshot_find(const net_snapshot_t *snapshot, uint32_t id) {
+  size_t low = 0;
+  size_t high = snapshot->entity_count;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (snapshot->entities[middle].id < id) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low < snapshot->entity_count && snapshot->entities[low].id == id ? &snapshot->entities[low] : NULL;
+}
+
+/**
+ * Walks the baseline alongside ids given in increasing order, returning
+ * its entity with each id, or NULL.
+ */
+const net_entity_t *net_baseline_entity(const net_snapshot_t *baseline, uint32_t id, size_t *cursor) {
+  if (baseline == NULL) {
+    return NULL;
+  }
+  while (*cursor < baseline->entity_count && baseline->entities[*cursor].id < id) {
+    *cursor = *cursor + 1;
+  }
+  return *cursor < baseline->entity_count && baseline->entities[*cursor].id == id ? &baseline->entities[*cursor] : NULL;
+}
+
+uint8_t net_changed_fields(const net_entity_t *entity, const net_entity_t *base) {
+  uint8_t mask = 0;
+  for (size_t f = 0; f < NET_ENTITY_FIELDS; f++) {
+    if (entity->fields[f] != (base != NULL ? base->fields[f] : 0)) {
+      mask = mask | 1 << f;
+    }
+  }
+  return mask;
+}
+
+bool net_walls_changed(uint8_t match_mask) {
+  return match_mask & (1 << NET_MATCH_GENERATION | 1 << NET_MATCH_REVISION);
+}
+
+void net_snapshot_encode(net_writer_t *writer, const net_snapshot_t *snapshot, const net_snapshot_t *baseline) {
+  uint8_t match_mask = 0;
+  for (size_t f = 0; f < NET_MATCH_FIELDS; f++) {
+    if (baseline == NULL || snapshot->match[f] != baseline->match[f]) {
+      match_mask = match_mask | 1 << f;
+    }
+  }
+  net_put_u8(writer, match_mask);
+  for (size_t f = 0; f < NET_MATCH_FIELDS; f++) {
+    if (match_mask & 1 << f) {
+      net_put_svarint(writer, (int64_t)snapshot->match[f] - (baseline != NULL ? baseline->match[f] : 0));
+    }
+  }
+  if (net_walls_changed(match_mask)) {
+    net_put_varint(writer, snapshot->cell_count);
+    net_put_bytes(writer, snapshot->cell_walls, snapshot->cell_count);
+  }
+
+  // the entities gone since the baseline
+  size_t removed = 0;
+  for (size_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      net_put_varint(writer, removed);
+    }
+    size_t cursor = 0;
+    uint32_t last_id = 0;
+    for (size_t i = 0; baseline != NULL && i < baseline->entity_count; i++) {
+      uint32_t id = baseline->entities[i].id;
+      if (net_baseline_entity(snapshot, id, &cursor) != NULL) {
+        continue;
+      }
+      if (pass == 0) {
+        removed = removed + 1;
+      } else {
+        net_put_varint(writer, id - last_id);
+        last_id = id;
+      }
+    }
+  }
+
+  // the entities new or changed since the baseline
+  size_t changed = 0;
+  for (size_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      net_put_varint(writer, changed);
+    }
+    size_t cursor = 0;
+    uint32_t last_id = 0;
+    for (size_t i = 0; i < snapshot->entity_count; i++) {
+      const net_entity_t *entity = &snapshot->entities[i];
+      const net_entity_t *base = net_baseline_entity(baseline, entity->id, &cursor);
+      uint8_t mask = net_changed_fields(entity, base);
+      if (base != NULL && mask == 0) {
+        continue;
+      }
+      if (pass == 0) {
+        changed = changed + 1;
+        continue;
+      }
+      net_put_varint(writer, entity->id - last_id);
+      last_id = entity->id;
+      net_put_u8(writer, mask);
+      for (size_t f = 0; f < NET_ENTITY_FIELDS; f++) {
+        if (mask & 1 << f) {
+          net_put_svarint(writer, (int64_t)entity->fields[f] - (base != NULL ? base->fields[f] : 0));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Reads a list of ids written as increasing gaps, at most max of them.
+ */
+uint32_t *net_get_ids(net_reader_t *reader, size_t count, size_t max) {
+  if (count > max) {
+    reader->error = true;
+    return NULL;
+  }
+  uint32_t *ids = malloc(sizeof(uint32_t) * (count + 1));
+  assert(ids != NULL);
+  uint64_t id = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t gap = net_get_varint(reader);
+    if ((i > 0 && gap == 0) || id + gap > UINT32_MAX) {
+      reader->error = true;
+    }
+    id = id + gap;
+    ids[i] = id;
+  }
+  return ids;
+}
+
+bool net_snapshot_decode(net_reader_t *reader, net_snapshot_t *snapshot, const net_snapshot_t *baseline) {
+  assert(snapshot != baseline);
+  snapshot->tick = 0;
+  uint8_t match_mask = net_get_u8(reader);
+  for (size_t f = 0; f < NET_MATCH_FIELDS; f++) {
+    int64_t value = baseline != NULL ? baseline->match[f] : 0;
+    if (match_mask & 1 << f) {
+      value = value + net_get_svarint(reader);
+    }
+    snapshot->match[f] = value;
+  }
+  if (net_walls_changed(match_mask) || baseline == NULL) {
+    size_t cell_count = net_get_varint(reader);
+    if (cell_count > NET_MAX_CELLS) {
+      return false;
+    }
+    net_snapshot_reserve(snapshot, 0, cell_count);
+    snapshot->cell_count = cell_count;
+    net_get_bytes(reader, snapshot->cell_walls, cell_count);
+  } else {
+    net_snapshot_reserve(snapshot, 0, baseline->cell_count);
+    snapshot->cell_count = baseline->cell_count;
+    memcpy(snapshot->cell_walls, baseline->cell_walls, baseline->cell_count);
+  }
+
+  size_t base_count = baseline != NULL ? baseline->entity_count : 0;
+  size_t removed_count = net_get_varint(reader);
+  uint32_t *removed = net_get_ids(reader, removed_count, base_count);
+  // each changed entity takes at least two bytes
+  size_t changed_count = net_get_varint(reader);
+  if (reader->error || changed_count > NET_MAX_ENTITIES || changed_count > (reader->length - reader->offset) / 2) {
+    free(removed);
+    return false;
+  }
+  net_entity_t *changed = malloc(sizeof(net_entity_t) * (changed_count + 1));
+  assert(changed != NULL);
+  size_t cursor = 0;
+  uint64_t id = 0;
+  for (size_t i = 0; i < changed_count && !reader->error; i++) {
+    uint64_t gap = net_get_varint(reader);
+    if ((i > 0 && gap == 0) || id + gap > UINT32_MAX) {
+      reader->error = true;
+    }
+    id = id + gap;
+    const net_entity_t *base = net_baseline_entity(baseline, id, &cursor);
+    changed[i] = (net_entity_t){.id = id};
+    uint8_t mask = net_get_u8(reader);
+    for (size_t f = 0; f < NET_ENTITY_FIELDS; f++) {
+      int64_t value = base != NULL ? base->fields[f] : 0;
+      if (mask & 1 << f) {
+        value = value + net_get_svarint(reader);
+      }
+      changed[i].fields[f] = value;
+    }
+  }
+
+  // the baseline's entities less the removed ones, merged with the changed ones
+  bool ok = !reader->error;
+  net_snapshot_reserve(snapshot, base_count + changed_count, 0);
+  size_t count = 0;
+  size_t r = 0;
+  size_t c = 0;
+  for (size_t b = 0; ok && (b < base_count || c < changed_count);) {
+    const net_entity_t *base = b < base_count ? &baseline->entities[b] : NULL;
+    if (c < changed_count && (base == NULL || changed[c].id <= base->id)) {
+      if (base != NULL && changed[c].id == base->id) {
+        b = b + 1;
+      }
+      snapshot->entities[count] = changed[c];
+      c = c + 1;
+    } else {
+      b = b + 1;
+      while (r < removed_count && removed[r] < base->id) {
+        r = r + 1;
+      }
+      if (r < removed_count && removed[r] == base->id) {
+        continue;
+      }
+      snapshot->entities[count] = *base;
+    }
+    count = count + 1;
+  }
+  snapshot->entity_count = count;
+  free(removed);
+  free(changed);
+  return ok;
+}
+
+void net_put_header(net_writer_t *writer, net_message_t message) {
+  net_put_u8(writer, NET_MAGIC);
+  net_put_u8(writer, message);
+}
+
+/**
+ * Presses and releases the controls that differ between two button masks.
+ */
+void net_apply_buttons(state_t *state, size_t player, uint8_t held, uint8_t buttons) {
+  for (size_t action = 0; action < INPUT_ACTION_COUNT; action++) {
+    bool pressed = buttons >> action & 1;
+    if (pressed != (held >> action & 1)) {
+      game_apply_input(state, (input_event_t){.player = player, .action = action, .pressed = pressed});
+    }
+  }
+}
+
+net_server_t *net_server_init(state_t *state, net_socket_t *sock, double dt, size_t snapshot_interval) {
+  net_server_t *server = malloc(sizeof(net_server_t));
+  assert(server != NULL);
+  *server = (net_server_t){.state = state, .socket = sock, .dt = dt, .snapshot_interval = snapshot_interval};
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    for (size_t j = 0; j < NET_SNAPSHOT_HISTORY; j++) {
+      server->peers[i].sent[j] = net_snapshot_init();
+    }
+  }
+  server->current = net_snapshot_init();
+  return server;
+}
+
+void net_server_free(net_server_t *server) {
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    for (size_t j = 0; j < NET_SNAPSHOT_HISTORY; j++) {
+      net_snapshot_free(server->peers[i].sent[j]);
+    }
+  }
+  net_snapshot_free(server->current);
+  free(server);
+}
+
+void net_server_welcome(net_server_t *server, size_t player, double now) {
+  uint8_t data[128];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_put_header(&writer, NET_WELCOME);
+  net_put_u8(&writer, player);
+  net_put_varint(&writer, server->state->config.maze_columns);
+  net_put_varint(&writer, server->state->config.maze_rows);
+  net_put_varint(&writer, server->state->config.seed);
+  net_put_varint(&writer, llround(server->dt * REPLAY_DT_UNITS));
+  maze_t *maze = server->state->maze;
+  net_put_varint(&writer, maze->columns);
+  net_put_varint(&writer, maze->rows);
+  net_put_svarint(&writer, net_position(maze->lower_left.x));
+  net_put_svarint(&writer, net_position(maze->lower_left.y));
+  net_put_svarint(&writer, net_position(maze->upper_right.x));
+  net_put_svarint(&writer, net_position(maze->upper_right.y));
+  net_send(server->socket, &server->peers[player].address, data, writer.length, now);
+}
+
+void net_server_connect(net_server_t *server, const struct sockaddr_in *from, net_reader_t *reader, double now) {
+  if (net_get_varint(reader) != NET_PROTOCOL_VERSION || reader->error) {
+    return;
+  }
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    if (server->peers[i].connected && net_same_address(&server->peers[i].address, from)) {
+      // the welcome was lost
+      net_server_welcome(server, i, now);
+      return;
+    }
+  }
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    net_peer_t *peer = &server->peers[i];
+    if (!peer->connected) {
+      peer->connected = true;
+      peer->address = *from;
+      peer->last_heard = now;
+      peer->newest_input = 0;
+      peer->applied_input = 0;
+      peer->buttons = 0;
+      memset(peer->input_sequences, 0, sizeof(peer->input_sequences));
+      peer->acked_tick = 0;
+      for (size_t j = 0; j < NET_SNAPSHOT_HISTORY; j++) {
+        peer->sent[j]->tick = 0;
+      }
+      net_server_welcome(server, i, now);
+      return;
+    }
+  }
+  uint8_t data[2];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_put_header(&writer, NET_FULL);
+  net_send(server->socket, from, data, writer.length, now);
+}
+
+void net_server_disconnect(net_server_t *server, size_t player) {
+  net_peer_t *peer = &server->peers[player];
+  net_apply_buttons(server->state, player, peer->buttons, 0);
+  peer->connected = false;
+}
+
+void net_server_input(net_server_t *server, net_peer_t *peer, net_reader_t *reader, double now) {
+  uint32_t acked_tick = net_get_varint(reader);
+  uint32_t newest = net_get_varint(reader);
+  size_t count = net_get_u8(reader);
+  uint8_t buttons[NET_INPUT_REDUNDANCY];
+  if (count > NET_INPUT_REDUNDANCY || count > newest) {
+    return;
+  }
+  net_get_bytes(reader, buttons, count);
+  if (reader->error) {
+    return;
+  }
+  peer->last_heard = now;
+  if (acked_tick > peer->acked_tick && acked_tick <= server->state->tick) {
+    peer->acked_tick = acked_tick;
+  }
+  for (size_t i = 0; i < count; i++) {
+    uint32_t sequence = newest - i;
+    // older than the history would overwrite inputs not applied yet
+    if (sequence <= peer->applied_input || sequence > peer->applied_input + NET_INPUT_HISTORY) {
+      continue;
+    }
+    peer->inputs[sequence % NET_INPUT_HISTORY] = buttons[i];
+    peer->input_sequences[sequence % NET_INPUT_HISTORY] = sequence;
+    if (sequence > peer->newest_input) {
+      peer->newest_input = sequence;
+    }
+  }
+}
+
+void net_server_receive(net_server_t *server, double now) {
+  uint8_t data[NET_MAX_DATAGRAM];
+  struct sockaddr_in from;
+  size_t length;
+  while ((length = net_receive(server->socket, data, &from)) > 0) {
+    net_reader_t reader = net_reader_init(data, length);
+    if (net_get_u8(&reader) != NET_MAGIC) {
+      continue;
+    }
+    net_message_t message = net_get_u8(&reader);
+    if (message == NET_CONNECT) {
+      net_server_connect(server, &from, &reader, now);
+      continue;
+    }
+    for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+      net_peer_t *peer = &server->peers[i];
+      if (!peer->connected || !net_same_address(&peer->address, &from)) {
+        continue;
+      }
+      if (message == NET_INPUT) {
+        net_server_input(server, peer, &reader, now);
+      } else if (message == NET_LEAVE) {
+        net_server_disconnect(server, i);
+      }
+    }
+  }
+}
+
+/**
+ * Applies the next input of a client, or a few when they have piled up.
+ * An input that never arrived leaves the controls as they were: by the
+ * time a later one is here, every datagram repeating it was lost.
+ */
+void net_server_apply_inputs(net_server_t *server, size_t player) {
+  net_peer_t *peer = &server->peers[player];
+  size_t budget = peer->newest_input - peer->applied_input > NET_INPUT_BACKLOG ? 2 : 1;
+  for (size_t i = 0; i < budget && peer->applied_input < peer->newest_input; i++) {
+    uint32_t next = peer->applied_input + 1;
+    size_t at = next % NET_INPUT_HISTORY;
+    if (peer->input_sequences[at] == next) {
+      net_apply_buttons(server->state, player, peer->buttons, peer->inputs[at]);
+      peer->buttons = peer->inputs[at];
+    }
+    peer->applied_input = next;
+  }
+}
+
+void net_server_send_snapshot(net_server_t *server, size_t player, double now) {
+  net_peer_t *peer = &server->peers[player];
+  net_snapshot_t *current = server->current;
+  net_snapshot_t *baseline = NULL;
+  if (peer->acked_tick != 0 && current->tick - peer->acked_tick < NET_SNAPSHOT_HISTORY) {
+    baseline = peer->sent[peer->acked_tick % NET_SNAPSHOT_HISTORY];
+    if (baseline->tick != peer->acked_tick) {
+      baseline = NULL;
+    }
+  }
+  uint8_t data[NET_MAX_DATAGRAM];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_put_header(&writer, NET_SNAPSHOT);
+  net_put_varint(&writer, current->tick);
+  net_put_varint(&writer, baseline != NULL ? current->tick - baseline->tick : 0);
+  net_put_varint(&writer, peer->applied_input);
+  net_snapshot_encode(&writer, current, baseline);
+  if (writer.overflow) {
+    server->oversized_snapshots = server->oversized_snapshots + 1;
+    return;
+  }
+  net_send(server->socket, &peer->address, data, writer.length, now);
+  net_snapshot_copy(peer->sent[current->tick % NET_SNAPSHOT_HISTORY], current);
+  peer->snapshots_sent = peer->snapshots_sent + 1;
+  peer->full_snapshots = peer->full_snapshots + (baseline == NULL);
+  peer->snapshot_bytes = peer->snapshot_bytes + writer.length;
+}
+
+void net_server_tick(net_server_t *server, double now) {
+  double start = clock_now();
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    net_peer_t *peer = &server->peers[i];
+    if (peer->connected && now - peer->last_heard > NET_TIMEOUT) {
+      net_server_disconnect(server, i);
+    }
+    if (peer->connected) {
+      net_server_apply_inputs(server, i);
+    }
+  }
+  game_tick(server->state, server->dt);
+  double ticked = clock_now();
+  if (server->state->tick % server->snapshot_interval == 0) {
+    net_snapshot_capture(server->current, server->state);
+    for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+      if (server->peers[i].connected) {
+        net_server_send_snapshot(server, i, now);
+      }
+    }
+  }
+  double end = clock_now();
+  server->ticks = server->ticks + 1;
+  server->game_seconds = server->game_seconds + ticked - start;
+  server->snapshot_seconds = server->snapshot_seconds + end - ticked;
+  server->max_tick_seconds = fmax(server->max_tick_seconds, end - start);
+}
+
+net_client_t *net_client_init(net_socket_t *sock, const struct sockaddr_in *server) {
+  net_client_t *client = malloc(sizeof(net_client_t));
+  assert(client != NULL);
+  *client = (net_client_t){.socket = sock, .server = *server, .last_connect = -INFINITY};
+  for (size_t i = 0; i < NET_SNAPSHOT_HISTORY; i++) {
+    client->snapshots[i] = net_snapshot_init();
+  }
+  return client;
+}
+
+void net_client_free(net_client_t *client, double now) {
+  if (client->connected) {
+    // if this is lost the server drops the client when it times out
+    uint8_t data[2];
+    net_writer_t writer = net_writer_init(data, sizeof(data));
+    net_put_header(&writer, NET_LEAVE);
+    net_send(client->socket, &client->server, data, writer.length, now);
+  }
+  for (size_t i = 0; i < NET_SNAPSHOT_HISTORY; i++) {
+    net_snapshot_free(client->snapshots[i]);
+  }
+  free(client);
+}
+
+/**
+ * Returns the walls of the latest snapshot as a maze that only has wall
+ * bits, or NULL if they do not fit the maze the server described.
+ */
+maze_t *net_client_walls(net_client_t *client) {
+  maze_t *walls = &client->walls;
+  if (client->latest == NULL || client->latest->cell_count != walls->columns * walls->rows) {
+    walls->cell_walls = NULL;
+    return NULL;
+  }
+  walls->cell_walls = client->latest->cell_walls;
+  return walls;
+}
+
+/**
+ * Moves a predicted tank by one tick the way game_tick() does: the tank's
+ * maze force undoes the last move if it left the hitbox in a wall, the
+ * scene moves it by the velocity set last tick, then its flags set a new
+ * velocity along its heading and turn it. The buttons pressed or released
+ * since the last input change the flags, as game_apply_input() does, so a
+ * tank spawned while a button is held ignores it. Other tanks and the turn
+ * the maze force undoes are not predicted; the next snapshot corrects them.
+ */
+void net_predict(net_pose_t *pose, uint8_t buttons, double dt, maze_t *walls) {
+  uint8_t changed = buttons ^ pose->held;
+  pose->flags = (pose->flags & ~changed) | (buttons & changed);
+  pose->held = buttons;
+  mov_flags_t flags = net_buttons_flags(pose->flags);
+  if (walls != NULL && maze_box_hits_wall(walls, pose->position, TANK_SIZE, pose->angle)) {
+    pose->position = vec_subtract(pose->position, pose->last_move);
+  }
+  pose->last_move = vec_multiply(dt, pose->velocity);
+  pose->position = vec_add(pose->position, pose->last_move);
+  pose->velocity = vec_rotate((vector_t){.x = tank_flags_speed(flags), .y = 0}, pose->angle);
+  pose->angle = pose->angle + tank_flags_turn(flags);
+}
+
+/**
+ * Starts the prediction again from the tank in the latest snapshot and
+ * replays the inputs the server had not applied yet.
+ */
+void net_client_reconcile(net_client_t *client, bool new_input) {
+  const net_snapshot_t *snapshot = client->latest;
+  // the tank this client's controls drive, after any cannon event
+  uint32_t controls = snapshot->match[NET_MATCH_CONTROLS] % INPUT_PLAYERS;
+  uint32_t tank = (client->player + INPUT_PLAYERS - controls) % INPUT_PLAYERS;
+  const net_entity_t *entity = net_snapshot_find(snapshot, (uint32_t)NET_TANK << NET_ID_SHIFT | tank);
+  client->predicting = entity != NULL;
+  if (entity == NULL) {
+    return;
+  }
+  net_pose_t pose;
+  pose.position = (vector_t){.x = (double)entity->fields[NET_FIELD_X] / NET_POSITION_UNITS,
+                             .y = (double)entity->fields[NET_FIELD_Y] / NET_POSITION_UNITS};
+  pose.angle = entity->fields[NET_FIELD_ANGLE] * TAU / NET_ANGLE_UNITS;
+  pose.flags = entity->fields[NET_FIELD_FLAGS];
+  mov_flags_t flags = net_buttons_flags(pose.flags);
+  // the flags of the tick before are not sent; the tank most likely held the same ones
+  double speed = tank_flags_speed(flags);
+  double turn = tank_flags_turn(flags);
+  pose.velocity = vec_rotate((vector_t){.x = speed, .y = 0}, pose.angle - turn);
+  pose.last_move = vec_multiply(client->dt, vec_rotate((vector_t){.x = speed, .y = 0}, pose.angle - 2 * turn));
+
+  uint32_t acked = client->acked_input;
+  bool acked_kept = acked > 0 && client->input_sequence - acked < NET_INPUT_HISTORY;
+  pose.held = acked_kept ? client->inputs[acked % NET_INPUT_HISTORY] : 0;
+  if (new_input && acked > 0 && client->prediction_sequences[acked % NET_INPUT_HISTORY] == acked) {
+    vector_t miss = vec_subtract(pose.position, client->predictions[acked % NET_INPUT_HISTORY]);
+    double error = sqrt(vec_dot(miss, miss));
+    client->prediction_error_total = client->prediction_error_total + error;
+    client->prediction_error_max = fmax(client->prediction_error_max, error);
+    client->prediction_errors = client->prediction_errors + 1;
+  }
+  uint32_t first = acked + 1;
+  if (client->input_sequence >= NET_INPUT_HISTORY && first <= client->input_sequence - NET_INPUT_HISTORY) {
+    first = client->input_sequence - NET_INPUT_HISTORY + 1;
+  }
+  maze_t *walls = net_client_walls(client);
+  for (uint32_t sequence = first; sequence <= client->input_sequence; sequence++) {
+    net_predict(&pose, client->inputs[sequence % NET_INPUT_HISTORY], client->dt, walls);
+  }
+  client->predicted = pose;
+}
+
+void net_client_snapshot(net_client_t *client, net_reader_t *reader, double now) {
+  uint32_t tick = net_get_varint(reader);
+  uint32_t gap = net_get_varint(reader);
+  uint32_t acked_input = net_get_varint(reader);
+  if (reader->error || tick == 0 || acked_input > client->input_sequence) {
+    return;
+  }
+  net_snapshot_t *baseline = NULL;
+  if (gap != 0) {
+    baseline = client->snapshots[(tick - gap) % NET_SNAPSHOT_HISTORY];
+    if (gap >= NET_SNAPSHOT_HISTORY || gap > tick || baseline->tick != tick - gap) {
+      baseline = NULL;
+    }
+  }
+  if ((client->latest != NULL && tick <= client->latest->tick) || (gap != 0 && baseline == NULL)) {
+    client->stale_snapshots = client->stale_snapshots + 1;
+    return;
+  }
+  // a new maze or a cannon event puts the controls on another tank, which the old predictions do not describe
+  bool same_tank = client->latest != NULL;
+  int32_t generation = same_tank ? client->latest->match[NET_MATCH_GENERATION] : 0;
+  int32_t controls = same_tank ? client->latest->match[NET_MATCH_CONTROLS] : 0;
+  net_snapshot_t *snapshot = client->snapshots[tick % NET_SNAPSHOT_HISTORY];
+  if (snapshot == client->latest) {
+    client->latest = NULL;
+  }
+  if (!net_snapshot_decode(reader, snapshot, baseline)) {
+    snapshot->tick = 0;
+    return;
+  }
+  snapshot->tick = tick;
+  client->latest = snapshot;
+  if (!same_tank || snapshot->match[NET_MATCH_GENERATION] != generation
+      || snapshot->match[NET_MATCH_CONTROLS] != controls) {
+    memset(client->prediction_sequences, 0, sizeof(client->prediction_sequences));
+  }
+  client->snapshots_received = client->snapshots_received + 1;
+  client->full_snapshots = client->full_snapshots + (baseline == NULL);
+  bool new_input = acked_input > client->acked_input;
+  if (new_input && client->input_sequence - acked_input < NET_INPUT_HISTORY) {
+    client->round_trip_total = client->round_trip_total + now - client->input_times[acked_input % NET_INPUT_HISTORY];
+    client->round_trips = client->round_trips + 1;
+  }
+  if (new_input) {
+    client->acked_input = acked_input;
+  }
+  net_client_reconcile(client, new_input);
+}
+
+void net_client_welcome(net_client_t *client, net_reader_t *reader) {
+  uint8_t player = net_get_u8(reader);
+  size_t columns = net_get_varint(reader);
+  size_t rows = net_get_varint(reader);
+  uint64_t seed = net_get_varint(reader);
+  uint64_t dt_units = net_get_varint(reader);
+  size_t maze_columns = net_get_varint(reader);
+  size_t maze_rows = net_get_varint(reader);
+  vector_t lower_left = {.x = (double)net_get_svarint(reader) / NET_POSITION_UNITS,
+                         .y = (double)net_get_svarint(reader) / NET_POSITION_UNITS};
+  vector_t upper_right = {.x = (double)net_get_svarint(reader) / NET_POSITION_UNITS,
+                          .y = (double)net_get_svarint(reader) / NET_POSITION_UNITS};
+  if (reader->error || player >= INPUT_PLAYERS || dt_units == 0 || maze_columns == 0 || maze_rows == 0
+      || maze_columns * maze_rows > NET_MAX_CELLS || upper_right.x <= lower_left.x || upper_right.y <= lower_left.y) {
+    return;
+  }
+  client->connected = true;
+  client->player = player;
+  client->config = (game_config_t){.maze_columns = columns, .maze_rows = rows, .seed = seed, .keep_score = false};
+  client->dt = (double)dt_units / REPLAY_DT_UNITS;
+  client->walls = (maze_t){.columns = maze_columns, .rows = maze_rows, .lower_left = lower_left,
+                           .upper_right = upper_right};
+}
+
+void net_client_receive(net_client_t *client, double now) {
+  if (!client->connected && now - client->last_connect >= NET_CONNECT_INTERVAL) {
+    uint8_t data[16];
+    net_writer_t writer = net_writer_init(data, sizeof(data));
+    net_put_header(&writer, NET_CONNECT);
+    net_put_varint(&writer, NET_PROTOCOL_VERSION);
+    net_send(client->socket, &client->server, data, writer.length, now);
+    client->last_connect = now;
+  }
+  uint8_t data[NET_MAX_DATAGRAM];
+  struct sockaddr_in from;
+  size_t length;
+  while ((length = net_receive(client->socket, data, &from)) > 0) {
+    net_reader_t reader = net_reader_init(data, length);
+    if (!net_same_address(&from, &client->server) || net_get_u8(&reader) != NET_MAGIC) {
+      continue;
+    }
+    net_message_t message = net_get_u8(&reader);
+    if (message == NET_WELCOME && !client->connected) {
+      net_client_welcome(client, &reader);
+    } else if (message == NET_SNAPSHOT && client->connected) {
+      net_client_snapshot(client, &reader, now);
+    }
+  }
+}
+
+void net_client_send_input(net_client_t *client, uint8_t buttons, double now) {
+  if (!client->connected) {
+    return;
+  }
+  client->input_sequence = client->input_sequence + 1;
+  uint32_t sequence = client->input_sequence;
+  size_t at = sequence % NET_INPUT_HISTORY;
+  client->inputs[at] = buttons;
+  client->input_times[at] = now;
+  if (client->predicting) {
+    net_predict(&client->predicted, buttons, client->dt, net_client_walls(client));
+    client->predictions[at] = client->predicted.position;
+    client->prediction_sequences[at] = sequence;
+  }
+  uint8_t data[32];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_put_header(&writer, NET_INPUT);
+  net_put_varint(&writer, client->latest != NULL ? client->latest->tick : 0);
+  net_put_varint(&writer, sequence);
+  size_t count = sequence < NET_INPUT_REDUNDANCY ? sequence : NET_INPUT_REDUNDANCY;
+  net_put_u8(&writer, count);
+  for (size_t i = 0; i < count; i++) {
+    net_put_u8(&writer, client->inputs[(sequence - i) % NET_INPUT_HISTORY]);
+  }
+  net_send(client->socket, &client->server, data, writer.length, now);
+}
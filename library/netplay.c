@@ -0,0 +1,256 @@
+#include "netcode.h"
+#include "clock.h"
+#include "script.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// netplay constants
+const double NETPLAY_DT = 1. / 60.;
+const size_t NETPLAY_SNAPSHOT_INTERVAL = 2; // 30 snapshots a second
+const size_t NETPLAY_DEFAULT_TICKS = 1800; // thirty seconds
+const size_t NETPLAY_DEFAULT_CLIENTS = INPUT_PLAYERS;
+const double NETPLAY_DEFAULT_LATENCY = 40; // milliseconds each way
+const double NETPLAY_DEFAULT_JITTER = 10;
+const double NETPLAY_DEFAULT_LOSS = 2; // percent
+const uint64_t NETPLAY_SEED = 1;
+const double NETPLAY_POLL = .0005; // the longest sleep between polls, so the shim releases datagrams on time
+const double NETPLAY_MAX_LAG = .25; // a loop further behind than this skips ahead instead of catching up
+const size_t NETPLAY_UDP_OVERHEAD = 28; // IPv4 and UDP headers per datagram
+
+typedef struct netplay_clients {
+  net_client_t *clients[INPUT_PLAYERS];
+  net_socket_t *sockets[INPUT_PLAYERS];
+  size_t ticks[INPUT_PLAYERS]; // inputs each has sent
+  size_t count;
+  size_t max_ticks; // per client; 0 plays until stopped
+  atomic_bool *stop;
+} netplay_clients_t;
+
+void sleep_until(double when) {
+  double wait = fmin(when - clock_now(), NETPLAY_POLL);
+  if (wait > 0) {
+    struct timespec duration = {.tv_sec = 0, .tv_nsec = wait * 1e9};
+    nanosleep(&duration, NULL);
+  }
+}
+
+/**
+ * Ticks a server in real time until it has run the given ticks, or until
+ * stopped when that is 0.
+ */
+void run_server(net_server_t *server, size_t ticks, atomic_bool *stop) {
+  double next_tick = clock_now();
+  while (!atomic_load(stop) && (ticks == 0 || server->ticks < ticks)) {
+    double now = clock_now();
+    net_server_receive(server, now);
+    if (now >= next_tick) {
+      net_server_tick(server, now);
+      next_tick = now - next_tick > NETPLAY_MAX_LAG ? now + server->dt : next_tick + server->dt;
+    }
+    net_flush(server->socket, clock_now());
+    sleep_until(next_tick);
+  }
+}
+
+/**
+ * Plays the built-in script on every client, each with its own set of
+ * controls, one input per server tick.
+ */
+void *run_clients(void *aux) {
+  netplay_clients_t *netplay = aux;
+  double next_tick = clock_now();
+  while (!atomic_load(netplay->stop)) {
+    double now = clock_now();
+    bool tick = now >= next_tick;
+    bool done = netplay->max_ticks != 0;
+    for (size_t i = 0; i < netplay->count; i++) {
+      net_client_t *client = netplay->clients[i];
+      net_client_receive(client, now);
+      if (tick && client->connected && (netplay->max_ticks == 0 || netplay->ticks[i] < netplay->max_ticks)) {
+        net_client_send_input(client, script_pattern_buttons(client->player, netplay->ticks[i]), now);
+        netplay->ticks[i] = netplay->ticks[i] + 1;
+      }
+      net_flush(netplay->sockets[i], now);
+      done = done && netplay->ticks[i] >= netplay->max_ticks;
+    }
+    if (done) {
+      break;
+    }
+    if (tick) {
+      next_tick = now - next_tick > NETPLAY_MAX_LAG ? now + NETPLAY_DT : next_tick + NETPLAY_DT;
+    }
+    sleep_until(next_tick);
+  }
+  return NULL;
+}
+
+void report_server(net_server_t *server, double seconds) {
+  size_t ticks = server->ticks > 0 ? server->ticks : 1;
+  printf("server: %zu ticks in %.1f s, game_tick %.1f us, snapshots %.1f us, worst tick %.1f us, %zu oversized\n",
+         server->ticks, seconds, server->game_seconds * 1e6 / ticks, server->snapshot_seconds * 1e6 / ticks,
+         server->max_tick_seconds * 1e6, server->oversized_snapshots);
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    net_peer_t *peer = &server->peers[i];
+    if (peer->snapshots_sent == 0) {
+      continue;
+    }
+    printf("  to player %zu: %zu snapshots (%zu whole), %.1f bytes each, %.2f KB/s with UDP/IP headers\n", i,
+           peer->snapshots_sent, peer->full_snapshots, (double)peer->snapshot_bytes / peer->snapshots_sent,
+           (peer->snapshot_bytes + peer->snapshots_sent * NETPLAY_UDP_OVERHEAD) / seconds / 1000);
+  }
+}
+
+void report_client(net_client_t *client, double seconds) {
+  net_socket_t *sock = client->socket;
+  printf("player %u: up %.2f KB/s, down %.2f KB/s with UDP/IP headers; %zu snapshots (%zu whole, %zu stale)\n",
+         client->player, (sock->bytes_sent + sock->datagrams_sent * NETPLAY_UDP_OVERHEAD) / seconds / 1000,
+         (sock->bytes_received + sock->datagrams_received * NETPLAY_UDP_OVERHEAD) / seconds / 1000,
+         client->snapshots_received, client->full_snapshots, client->stale_snapshots);
+  printf("  input to snapshot %.1f ms, prediction error %.2f px mean, %.2f px worst over %zu inputs\n",
+         client->round_trips > 0 ? client->round_trip_total * 1000 / client->round_trips : 0,
+         client->prediction_errors > 0 ? client->prediction_error_total / client->prediction_errors : 0,
+         client->prediction_error_max, client->prediction_errors);
+}
+
+net_shim_t shim_from_args(int argc, char *argv[], int first) {
+  return (net_shim_t){
+    .latency = (argc > first ? atof(argv[first]) : NETPLAY_DEFAULT_LATENCY) / 1000,
+    .jitter = (argc > first + 1 ? atof(argv[first + 1]) : NETPLAY_DEFAULT_JITTER) / 1000,
+    .loss = (argc > first + 2 ? atof(argv[first + 2]) : NETPLAY_DEFAULT_LOSS) / 100,
+  };
+}
+
+/**
+ * Runs a server for clients on other processes until killed.
+ */
+int serve(uint16_t port, uint64_t seed) {
+  net_socket_t *sock = net_socket_init(port, (net_shim_t){0}, seed);
+  if (sock == NULL) {
+    fprintf(stderr, "Could not listen on port %u\n", port);
+    return 1;
+  }
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  net_server_t *server = net_server_init(state, sock, NETPLAY_DT, NETPLAY_SNAPSHOT_INTERVAL);
+  printf("serving on port %u\n", port);
+  fflush(stdout);
+  atomic_bool stop = false;
+  run_server(server, 0, &stop);
+  net_server_free(server);
+  game_free(state);
+  net_socket_free(sock);
+  return 0;
+}
+
+/**
+ * Joins a server and plays the built-in script on the controls it gives.
+ */
+int join(const char *host, uint16_t port, size_t ticks, net_shim_t shim) {
+  struct sockaddr_in address;
+  if (!net_resolve(host, port, &address)) {
+    fprintf(stderr, "Unknown host %s\n", host);
+    return 1;
+  }
+  net_socket_t *sock = net_socket_init(0, shim, NETPLAY_SEED);
+  if (sock == NULL) {
+    fprintf(stderr, "Could not open a socket\n");
+    return 1;
+  }
+  atomic_bool stop = false;
+  netplay_clients_t netplay = {.count = 1, .max_ticks = ticks, .stop = &stop};
+  netplay.sockets[0] = sock;
+  netplay.clients[0] = net_client_init(sock, &address);
+  double start = clock_now();
+  run_clients(&netplay);
+  report_client(netplay.clients[0], clock_now() - start);
+  net_client_free(netplay.clients[0], clock_now());
+  net_socket_free(sock);
+  return 0;
+}
+
+/**
+ * Plays a session on this machine: a server and its clients talk over
+ * loopback, each socket delaying and dropping what it sends as the shim
+ * says, and the bandwidth, round trips, prediction error and server tick
+ * cost are printed at the end.
+ */
+int loopback(size_t ticks, size_t count, net_shim_t shim) {
+  net_socket_t *server_socket = net_socket_init(0, shim, NETPLAY_SEED);
+  if (server_socket == NULL) {
+    fprintf(stderr, "Could not open a socket\n");
+    return 1;
+  }
+  struct sockaddr_in bound;
+  socklen_t bound_length = sizeof(bound);
+  getsockname(server_socket->fd, (struct sockaddr *)&bound, &bound_length);
+  struct sockaddr_in address;
+  net_resolve("127.0.0.1", ntohs(bound.sin_port), &address);
+
+  state_t *state = game_init(game_default_config(NETPLAY_SEED), audio_silent());
+  net_server_t *server = net_server_init(state, server_socket, NETPLAY_DT, NETPLAY_SNAPSHOT_INTERVAL);
+  atomic_bool stop = false;
+  netplay_clients_t netplay = {.count = count, .max_ticks = 0, .stop = &stop};
+  for (size_t i = 0; i < count; i++) {
+    netplay.sockets[i] = net_socket_init(0, shim, NETPLAY_SEED + 1 + i);
+    if (netplay.sockets[i] == NULL) {
+      fprintf(stderr, "Could not open a socket\n");
+      return 1;
+    }
+    netplay.clients[i] = net_client_init(netplay.sockets[i], &address);
+  }
+  printf("%zu clients, %.0f ms latency, %.0f ms jitter, %.1f%% loss each way, %zu ticks\n", count,
+         shim.latency * 1000, shim.jitter * 1000, shim.loss * 100, ticks);
+  fflush(stdout);
+
+  pthread_t client_thread;
+  pthread_create(&client_thread, NULL, run_clients, &netplay);
+  double start = clock_now();
+  run_server(server, ticks, &stop);
+  double seconds = clock_now() - start;
+  atomic_store(&stop, true);
+  pthread_join(client_thread, NULL);
+
+  report_server(server, seconds);
+  for (size_t i = 0; i < count; i++) {
+    report_client(netplay.clients[i], seconds);
+    net_client_free(netplay.clients[i], clock_now());
+    net_socket_free(netplay.sockets[i]);
+  }
+  net_server_free(server);
+  game_free(state);
+  net_socket_free(server_socket);
+  return 0;
+}
+
+/**
+ * Runs the game as an authoritative server and its clients, without a
+ * window, to measure what the netcode costs.
+ *
+ * Usage: netplay [ticks] [clients] [latency ms] [jitter ms] [loss %]
+ *        netplay --server [port] [seed]
+ *        netplay --client <host> [port] [ticks] [latency ms] [jitter ms] [loss %]
+ * The first form plays a session over loopback with the shim on every
+ * socket, so the round trip is twice the latency; a client started on its
+ * own only delays what it sends. A tick count of 0 keeps a client playing
+ * until killed.
+ */
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--server") == 0) {
+    return serve(argc > 2 ? atoi(argv[2]) : NET_DEFAULT_PORT, argc > 3 ? strtoull(argv[3], NULL, 10) : NETPLAY_SEED);
+  }
+  if (argc > 2 && strcmp(argv[1], "--client") == 0) {
+    return join(argv[2], argc > 3 ? atoi(argv[3]) : NET_DEFAULT_PORT,
+                argc > 4 ? strtoull(argv[4], NULL, 10) : NETPLAY_DEFAULT_TICKS, shim_from_args(argc, argv, 5));
+  }
+  size_t ticks = argc > 1 ? strtoull(argv[1], NULL, 10) : NETPLAY_DEFAULT_TICKS;
+  size_t count = argc > 2 ? strtoull(argv[2], NULL, 10) : NETPLAY_DEFAULT_CLIENTS;
+  if (count < 1 || count > INPUT_PLAYERS) {
+    fprintf(stderr, "A session has 1 to %d clients\n", INPUT_PLAYERS);
+    return 1;
+  }
+  return loopback(ticks, count, shim_from_args(argc, argv, 3));
+}
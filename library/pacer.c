@@ -0,0 +1,96 @@
+#include "pacer.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+// waiting constants
+const double PACER_SPIN_MARGIN = 0.002; // seconds before the deadline that sleeping stops
+const double PACER_BUCKET_WIDTH = 0.0001;
+
+// dt constants
+const double PACER_SMOOTHING = 0.2; // weight of the newest frame in the smoothed dt
+const double PACER_MAX_DT = 0.1; // longer frames (a stall, a dragged window) are clamped
+
+frame_pacer_t *pacer_init(const char *name, double target_rate) {
+  frame_pacer_t *pacer = malloc(sizeof(frame_pacer_t));
+  assert(pacer != NULL);
+  memset(pacer, 0, sizeof(frame_pacer_t));
+  pacer->name = name;
+  pacer->period = target_rate > 0 ? 1 / target_rate : 0;
+  pacer->frequency = SDL_GetPerformanceFrequency();
+  uint64_t now = SDL_GetPerformanceCounter();
+  pacer->deadline = now;
+  pacer->last_frame = now;
+  pacer->smoothed_dt = pacer->period > 0 ? pacer->period : 1 / 60.;
+  return pacer;
+}
+
+void pacer_free(frame_pacer_t *pacer) {
+  free(pacer);
+}
+
+void pacer_wait(frame_pacer_t *pacer) {
+  if (pacer->period == 0) {
+    return;
+  }
+  uint64_t period = pacer->period * pacer->frequency;
+  uint64_t margin = PACER_SPIN_MARGIN * pacer->frequency;
+  pacer->deadline += period;
+  uint64_t now = SDL_GetPerformanceCounter();
+  if (now >= pacer->deadline) {
+    // behind: start the next frame now instead of catching up in a burst
+    pacer->deadline = now;
+    return;
+  }
+  if (pacer->deadline - now > margin) {
+    SDL_Delay((pacer->deadline - now - margin) * 1000 / pacer->frequency);
+  }
+  while (SDL_GetPerformanceCounter() < pacer->deadline) {
+  }
+}
+
+pacer_stats_t pacer_get_stats(frame_pacer_t *pacer) {
+  pacer_stats_t stats = {.frames = pacer->frames, .max = pacer->max_frame};
+  size_t p50_rank = (pacer->frames + 1) / 2;
+  size_t p99_rank = ceil(0.99 * pacer->frames);
+  size_t seen = 0;
+  bool p50_found = false;
+  for (size_t i = 0; i <= PACER_BUCKETS && seen < p99_rank; i++) {
+    seen += pacer->histogram[i];
+    double upper = fmin((i + 1) * PACER_BUCKET_WIDTH, pacer->max_frame);
+    if (!p50_found && seen >= p50_rank) {
+      stats.p50 = upper;
+      p50_found = true;
+    }
+    if (seen >= p99_rank) {
+      stats.p99 = upper;
+    }
+  }
+  return stats;
+}
+
+void pacer_report(frame_pacer_t *pacer) {
+  pacer_stats_t stats = pacer_get_stats(pacer);
+  printf("%s: %zu frames, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+         pacer->name, stats.frames, 1000 * stats.p50, 1000 * stats.p99, 1000 * stats.max);
+  memset(pacer->histogram, 0, sizeof(pacer->histogram));
+  pacer->frames = 0;
+  pacer->max_frame = 0;
+}
+
+double pacer_tick(frame_pacer_t *pacer) {
+  uint64_t now = SDL_GetPerformanceCounter();
+  double frame = (double) (now - pacer->last_frame) / pacer->frequency;
+  pacer->last_frame = now;
+
+  size_t bucket = frame / PACER_BUCKET_WIDTH;
+  pacer->histogram[bucket < PACER_BUCKETS ? bucket : PACER_BUCKETS]++;
+  pacer->frames++;
+  pacer->max_frame = fmax(pacer->max_frame, frame);
+
+  pacer->smoothed_dt += (fmin(frame, PACER_MAX_DT) - pacer->smoothed_dt) * PACER_SMOOTHING;
+  return pacer->smoothed_dt;
+}
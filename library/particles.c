@@ -0,0 +1,127 @@
+#include "particles.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+particle_system_t *particles_init(size_t capacity, double drag, double hue_shift) {
+  particle_system_t *particles = malloc(sizeof(particle_system_t));
+  assert(particles != NULL);
+  particles->capacity = capacity;
+  particles->count = 0;
+  particles->drag = drag;
+  particles->hue_shift = hue_shift;
+  particles->x = malloc(sizeof(float) * capacity);
+  particles->y = malloc(sizeof(float) * capacity);
+  particles->vx = malloc(sizeof(float) * capacity);
+  particles->vy = malloc(sizeof(float) * capacity);
+  particles->angle = malloc(sizeof(float) * capacity);
+  particles->spin = malloc(sizeof(float) * capacity);
+  particles->life = malloc(sizeof(float) * capacity);
+  particles->size = malloc(sizeof(float) * capacity);
+  particles->r = malloc(sizeof(float) * capacity);
+  particles->g = malloc(sizeof(float) * capacity);
+  particles->b = malloc(sizeof(float) * capacity);
+  particles->hue = malloc(sizeof(float) * capacity);
+  particles->saturation = malloc(sizeof(float) * capacity);
+  particles->value = malloc(sizeof(float) * capacity);
+  assert(particles->x != NULL && particles->y != NULL);
+  assert(particles->vx != NULL && particles->vy != NULL);
+  assert(particles->angle != NULL && particles->spin != NULL);
+  assert(particles->life != NULL && particles->size != NULL);
+  assert(particles->r != NULL && particles->g != NULL && particles->b != NULL);
+  assert(particles->hue != NULL && particles->saturation != NULL && particles->value != NULL);
+  return particles;
+}
+
+void particles_free(particle_system_t *particles) {
+  free(particles->x);
+  free(particles->y);
+  free(particles->vx);
+  free(particles->vy);
+  free(particles->angle);
+  free(particles->spin);
+  free(particles->life);
+  free(particles->size);
+  free(particles->r);
+  free(particles->g);
+  free(particles->b);
+  free(particles->hue);
+  free(particles->saturation);
+  free(particles->value);
+  free(particles);
+}
+
+void particles_clear(particle_system_t *particles) {
+  particles->count = 0;
+}
+
+void particles_emit(particle_system_t *particles, vector_t center, vector_t velocity,
+                    rgb_color_t color, double size, double spin, double life) {
+  if (particles->count == particles->capacity) {
+    return;
+  }
+  size_t i = particles->count;
+  particles->x[i] = center.x;
+  particles->y[i] = center.y;
+  particles->vx[i] = velocity.x;
+  particles->vy[i] = velocity.y;
+  particles->angle[i] = 0;
+  particles->spin[i] = spin;
+  particles->life[i] = life;
+  particles->size[i] = size;
+  particles->r[i] = color.r;
+  particles->g[i] = color.g;
+  particles->b[i] = color.b;
+  hsv_color_t hsv = rgb_to_hsv(color);
+  particles->hue[i] = hsv.h;
+  particles->saturation[i] = hsv.s;
+  particles->value[i] = hsv.v;
+  particles->count = i + 1;
+}
+
+void particles_move(particle_system_t *particles, size_t from, size_t to) {
+  particles->x[to] = particles->x[from];
+  particles->y[to] = particles->y[from];
+  particles->vx[to] = particles->vx[from];
+  particles->vy[to] = particles->vy[from];
+  particles->angle[to] = particles->angle[from];
+  particles->spin[to] = particles->spin[from];
+  particles->life[to] = particles->life[from];
+  particles->size[to] = particles->size[from];
+  particles->r[to] = particles->r[from];
+  particles->g[to] = particles->g[from];
+  particles->b[to] = particles->b[from];
+  particles->hue[to] = particles->hue[from];
+  particles->saturation[to] = particles->saturation[from];
+  particles->value[to] = particles->value[from];
+}
+
+void particles_tick(particle_system_t *particles, double dt) {
+  // exact solution of dv/dt = -drag * v over one step, so large dt stays stable
+  float damping = exp(-particles->drag * dt);
+  float fdt = dt;
+  size_t i = 0;
+  while (i < particles->count) {
+    particles->life[i] -= fdt;
+    if (particles->life[i] <= 0) {
+      particles->count = particles->count - 1;
+      particles_move(particles, particles->count, i);
+      continue;
+    }
+    particles->vx[i] *= damping;
+    particles->vy[i] *= damping;
+    particles->x[i] += particles->vx[i] * fdt;
+    particles->y[i] += particles->vy[i] * fdt;
+    particles->angle[i] += particles->spin[i] * fdt;
+    i++;
+  }
+  if (particles->hue_shift != 0) {
+    float turn = particles->hue_shift * fdt;
+    for (i = 0; i < particles->count; i++) {
+      float hue = particles->hue[i] + turn;
+      particles->hue[i] = hue >= 360 ? hue - 360 : hue;
+    }
+    hsv_to_rgb_batch(particles->hue, particles->saturation, particles->value,
+                     particles->r, particles->g, particles->b, particles->count);
+  }
+}
@@ -5,18 +5,13 @@
 #include "color.h"
 #include "maze.h"
 #include <assert.h>
+#include <pthread.h>
 #include "tank.h"
 #include "collision.h"
-#include <SDL2/SDL_mixer.h>
+#include "projectiles.h"
+#include "audio.h"
 #define TAU (2 * 3.14159265358979)
 
-// sound constants
-const char *NORMAL_SHOT_SOUND_PATH = "assets/normalshot.wav";
-const char *RAILGUN_SHOT_SOUND_PATH = "assets/railgunshot.wav";
-const char *LASER_SHOT_SOUND_PATH = "assets/lasershot.wav";
-const char *SHOTGUN_SHOT_SOUND_PATH = "assets/shotgunshot.wav";
-const char *MOON_SHOT_SOUND_PATH = "assets/moonshot.wav";
-
 // bullet constants
 const size_t BULLET_VERTICES = 6;
 const double BULLET_MASS = 100.;
@@ -56,6 +51,38 @@ const size_t MOON_G = 10;
 
 // powerup box constants
 const double POWERUP_BOX_LENGTH = 25;
+#define POWERUP_TYPES 4
+#define POWERUP_PULSE_STEPS 64
+const double POWERUP_PULSE_RATE = 1.5; // pulses per second
+const float POWERUP_PULSE_DEPTH = 0.35; // the fraction of the value lost at the darkest point
+const float POWERUP_PULSE_HUE_SWING = 20; // degrees
+
+// one pulse of every powerup type, built once with the batched hsv conversion
+rgb_color_t powerup_palette[POWERUP_TYPES][POWERUP_PULSE_STEPS];
+pthread_once_t powerup_palette_once = PTHREAD_ONCE_INIT; // matches may run on several threads
+
+typedef struct body_maze {
+  body_t *body;
+  maze_t *maze;
+} body_maze_t;
+
+void moon_wall_force(void *aux) {
+  body_t *moon = ((body_maze_t *)aux)->body;
+  maze_t *maze = ((body_maze_t *)aux)->maze;
+  vector_t center = body_get_center(moon);
+  if (!check_outside(maze, center)) {
+    maze_destroy_walls(maze, vector_to_cell(maze, center), moon->shape);
+  }
+}
+
+void add_moon_wall_force(scene_t *scene, maze_t *maze, body_t *moon) {
+  body_maze_t *aux = malloc(sizeof(body_maze_t));
+  assert(aux != NULL);
+  *aux = (body_maze_t){.body = moon, .maze = maze};
+  list_t *bodies = list_init(1, NULL);
+  list_add(bodies, moon);
+  scene_add_bodies_force_creator(scene, moon_wall_force, aux, bodies, free);
+}
 
 vector_t bullet_location(double orientation, vector_t center, size_t tank_size, size_t bullet_size, double forwards) {
   return vec_add(vec_rotate((vector_t) {.x = (tank_size/2+1.) + (bullet_size/2+1.) + forwards, .y = 0}, orientation), center);
@@ -80,34 +107,140 @@ list_t *normal_bullet(double size, vector_t center) {
   return bullet;
 }
 
+tank_t *player_tank(state_t *state, size_t player) {
+  tank_t *tanks[] = {state->red_player, state->green_player, state->blue_player};
+  assert(player < sizeof(tanks) / sizeof(tanks[0]));
+  return tanks[player];
+}
+
+size_t tank_player(state_t *state, tank_t *tank) {
+  if (tank == state->red_player) {
+    return 0;
+  }
+  if (tank == state->green_player) {
+    return 1;
+  }
+  assert(tank == state->blue_player);
+  return 2;
+}
+
+shot_handler_t shot_handler(projectile_kind_t kind) {
+  switch (kind) {
+    case PROJECTILE_RAILGUN:
+      return railgun_shot;
+    case PROJECTILE_LASER:
+      return laser_shot;
+    case PROJECTILE_SHOTGUN:
+      return shotgun_shot;
+    case PROJECTILE_MOON:
+      return moon_shot;
+    default:
+      return normal_shot;
+  }
+}
+
+projectile_kind_t shot_kind(shot_handler_t handler) {
+  for (projectile_kind_t kind = 0; kind < PROJECTILE_KINDS; kind++) {
+    if (shot_handler(kind) == handler) {
+      return kind;
+    }
+  }
+  assert(false);
+  return PROJECTILE_NORMAL;
+}
+
+body_t *projectile_body(projectile_kind_t kind, list_t *shape) {
+  switch (kind) {
+    case PROJECTILE_RAILGUN:
+      return body_init_with_info(shape, BULLET_MASS, RAILGUN_COLOR, NULL, NULL, 1);
+    case PROJECTILE_LASER:
+      return body_init_with_info(shape, BULLET_MASS, LASER_COLOR, NULL, NULL, 1);
+    case PROJECTILE_SHOTGUN:
+      return body_init_with_info(shape, BULLET_MASS, SHOTGUN_COLOR, NULL, NULL, 1);
+    case PROJECTILE_MOON:
+      return body_init_with_info(shape, MOON_MASS, NORMAL_COLOR, NULL, NULL, 1);
+    default:
+      return body_init_with_info(shape, BULLET_MASS, NORMAL_COLOR, NULL, NULL, 1);
+  }
+}
+
+void add_destructive_collisions(state_t *state, body_t *bullet) {
+  tank_t *players[] = {state->red_player, state->blue_player, state->green_player};
+  for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+    if (players[i] != NULL) {
+      create_tank_destructive_collision(state->scene, players[i], bullet);
+    }
+  }
+}
+
+/**
+ * The forces of every kind are added in the order the shots have always
+ * added them, so a restored projectile behaves exactly like the original.
+ */
+void projectile_attach(state_t *state, body_t *body, projectile_kind_t kind, size_t owner) {
+  scene_t *scene = state->scene;
+  tank_t *tonk = player_tank(state, owner);
+  projectile_info_t info = {.kind = kind, .owner = owner, .decay = NULL, .contact = NULL};
+  switch (kind) {
+    case PROJECTILE_NORMAL:
+      info.contact = add_maze_collision(scene, state->maze, body);
+      add_destructive_collisions(state, body);
+      info.decay = create_decay_force(state, tonk, body, NORMAL_DECAY);
+      break;
+    case PROJECTILE_LASER:
+      info.contact = add_maze_collision(scene, state->maze, body);
+      add_destructive_collisions(state, body);
+      info.decay = create_decay_force(state, tonk, body, LASER_DECAY);
+      break;
+    case PROJECTILE_SHOTGUN:
+      add_destructive_collisions(state, body);
+      info.decay = create_decay_force(state, tonk, body, SHOTGUN_DECAY);
+      info.contact = add_maze_collision(scene, state->maze, body);
+      break;
+    case PROJECTILE_RAILGUN: {
+      tank_t *players[] = {state->red_player, state->blue_player, state->green_player};
+      for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+        if (players[i] != NULL) {
+          create_tank_killbox(scene, players[i], body);
+        }
+      }
+      info.decay = create_decay_force(state, tonk, body, RAILGUN_DECAY);
+      break;
+    }
+    case PROJECTILE_MOON: {
+      tank_t *players[] = {state->red_player, state->green_player, state->blue_player};
+      for (size_t i = 0; i < sizeof(players) / sizeof(players[0]); i++) {
+        if (players[i] != NULL) {
+          create_tank_destructive_collision(scene, players[i], body);
+          create_newtonian_gravity(scene, MOON_G, body, players[i]->hitbox);
+          create_newtonian_gravity(scene, MOON_G, body, players[i]->body);
+        } else if (state->dying_bodies[i] != NULL && state->projectiles->next_serial < state->dying_serial) {
+          // a restored moon that was shot before the tank died still pulls on its body for one more tick
+          create_newtonian_gravity(scene, MOON_G, body, state->dying_bodies[i]);
+        }
+      }
+      if (state->destructible_walls) {
+        add_moon_wall_force(scene, state->maze, body);
+      }
+      break;
+    }
+    default:
+      assert(false);
+  }
+  scene_add_body(scene, body);
+  projectiles_add(state->projectiles, scene, body, info);
+}
+
 void normal_shot(state_t* state, tank_t *tonk, size_t tank_size) {
-  Mix_Chunk *shot_sound = Mix_LoadWAV(NORMAL_SHOT_SOUND_PATH);
-  Mix_PlayChannel(-1, shot_sound, 0);
+  audio_play(&state->audio, SOUND_NORMAL_SHOT);
   body_t *tank = get_tank_hitbox(tonk);
   double orientation = body_get_orientation(tank);
   vector_t bullet_loc = bullet_location(body_get_orientation(tank), body_get_center(tank), tank_size, NORMAL_SIZE, 5);
-  body_t *bullet = body_init_with_info(
-    normal_bullet(NORMAL_SIZE, bullet_loc), BULLET_MASS, NORMAL_COLOR, NULL, NULL, 1
-    );
-  scene_t *scene = state->scene;
+  body_t *bullet = projectile_body(PROJECTILE_NORMAL, normal_bullet(NORMAL_SIZE, bullet_loc));
   vector_t vel = vec_rotate(NORMAL_VELOCITY, orientation);
   body_set_velocity(bullet, vel);
-  add_maze_collision(scene, state->maze, bullet);
-  tank_t *red_player = state->red_player;
-  tank_t *blue_player = state->blue_player;
-  tank_t *green_player = state->green_player;
-  if (red_player != NULL) {
-    create_tank_destructive_collision(scene, red_player, bullet);
-  }
-  if (blue_player != NULL) {
-    create_tank_destructive_collision(scene, blue_player, bullet);
-  }
-  if (green_player != NULL) {
-    create_tank_destructive_collision(scene, green_player, bullet);
-  }
-  create_decay_force(state, tonk, bullet, NORMAL_DECAY);
+  projectile_attach(state, bullet, PROJECTILE_NORMAL, tank_player(state, tonk));
   tonk->bullets_onscreen = tonk->bullets_onscreen + 1;
-  scene_add_body(scene, bullet);
 }
 
 list_t *rectangle(double length, double width, double orientation, vector_t center) {
@@ -137,61 +270,33 @@ list_t *rectangle(double length, double width, double orientation, vector_t cent
 }
 
 void railgun_shot(state_t* state, tank_t *tonk, size_t tank_size) {
-  Mix_Chunk *shot_sound = Mix_LoadWAV(RAILGUN_SHOT_SOUND_PATH);
-  Mix_PlayChannel(-1, shot_sound, 0);
+  audio_play(&state->audio, SOUND_RAILGUN_SHOT);
   body_t *tank = get_tank_hitbox(tonk);
   double orientation = body_get_orientation(tank);
-  body_t *bullet = body_init_with_info(
+  body_t *bullet = projectile_body(PROJECTILE_RAILGUN,
     rectangle(RAILGUN_LENGTH, RAILGUN_BLAST_WIDTH, orientation, bullet_location(body_get_orientation(tank),
-              body_get_center(tank), tank_size, RAILGUN_LENGTH, 20)),
-    BULLET_MASS, RAILGUN_COLOR, NULL, NULL, 1);
-  scene_t *scene = state->scene;
-  tank_t *red_player = state->red_player;
-  tank_t *blue_player = state->blue_player;
-  tank_t *green_player = state->green_player;
-  if (red_player != NULL) { 
-    create_tank_killbox(scene, red_player, bullet);
-  }
-  if (blue_player != NULL) {
-    create_tank_killbox(scene, blue_player, bullet);
+              body_get_center(tank), tank_size, RAILGUN_LENGTH, 20)));
+  if (state->destructible_walls) {
+    maze_destroy_walls_under(state->maze, bullet->shape);
   }
-  if (green_player != NULL) {
-    create_tank_killbox(scene, green_player, bullet);
-  }
-  create_decay_force(state, tonk, bullet, RAILGUN_DECAY);
+  projectile_attach(state, bullet, PROJECTILE_RAILGUN, tank_player(state, tonk));
   tonk->bullets_onscreen = tonk->bullets_onscreen + 1;
   tonk->powerup_shots_left = tonk->powerup_shots_left - 1;
-  scene_add_body(scene, bullet);
 }
 
 void laser_shot(state_t* state, tank_t *tonk, size_t tank_size) {
-  Mix_Chunk *shot_sound = Mix_LoadWAV(LASER_SHOT_SOUND_PATH);
-  Mix_PlayChannel(-1, shot_sound, 0);
+  audio_play(&state->audio, SOUND_LASER_SHOT);
   body_t *tank = get_tank_hitbox(tonk);
   double orientation = body_get_orientation(tank);
-  scene_t *scene = state->scene;
   vector_t vel = vec_rotate(LASER_VELOCITY, orientation);
+  size_t owner = tank_player(state, tonk);
   for (size_t i = 0; i < 20; i++) {
-    body_t *bullet = body_init_with_info(  
+    body_t *bullet = projectile_body(PROJECTILE_LASER,
     rectangle(LASER_LENGTH, LASER_WIDTH, body_get_orientation(tank), 
-    bullet_location(body_get_orientation(tank), body_get_center(tank), tank_size, LASER_LENGTH, 5 + i*5)), BULLET_MASS, LASER_COLOR, NULL, NULL, 1);
+    bullet_location(body_get_orientation(tank), body_get_center(tank), tank_size, LASER_LENGTH, 5 + i*5)));
     body_set_velocity(bullet, vel);
-    add_maze_collision(scene, state->maze, bullet);
-    tank_t *red_player = state->red_player;
-    tank_t *blue_player = state->blue_player;
-    tank_t *green_player = state->green_player;
-    if (red_player != NULL) {
-      create_tank_destructive_collision(scene, red_player, bullet);
-    }
-    if (blue_player != NULL) {
-      create_tank_destructive_collision(scene, blue_player, bullet);
-    }
-    if (green_player != NULL) {
-      create_tank_destructive_collision(scene, green_player, bullet);
-    }
-    create_decay_force(state, tonk, bullet, LASER_DECAY);
+    projectile_attach(state, bullet, PROJECTILE_LASER, owner);
     tonk->bullets_onscreen = tonk->bullets_onscreen + 1;
-    scene_add_body(scene, bullet);
   }
   tonk->powerup_shots_left = tonk->powerup_shots_left - 1;
 }
@@ -199,67 +304,29 @@ void laser_shot(state_t* state, tank_t *tonk, size_t tank_size) {
 void shotgun_shot(state_t* state, tank_t *tonk, size_t tank_size) {
   body_t *tank = get_tank_hitbox(tonk);
   double tank_orientation = body_get_orientation(tank);
-  tank_t *red_player = state->red_player;
-  tank_t *green_player = state->green_player;
-  tank_t *blue_player = state->blue_player;
+  size_t owner = tank_player(state, tonk);
   for (size_t i = 0; i < SHOTGUN_BULLETS; i++) {
     double bullet_orientation = tank_orientation + ((double)i - (double)SHOTGUN_BULLETS/2.)*(SHOTGUN_SHOT_RANGE)/(SHOTGUN_BULLETS/2.);
-    body_t *bullet = body_init_with_info(
-      normal_bullet(SHOTGUN_SIZE, bullet_location(bullet_orientation, body_get_center(tank), tank_size, SHOTGUN_SIZE, 20)), 
-                BULLET_MASS, SHOTGUN_COLOR, NULL, NULL, 1);
-    scene_t *scene = state->scene;
+    body_t *bullet = projectile_body(PROJECTILE_SHOTGUN,
+      normal_bullet(SHOTGUN_SIZE, bullet_location(bullet_orientation, body_get_center(tank), tank_size, SHOTGUN_SIZE, 20)));
     body_set_velocity(bullet, vec_rotate(SHOTGUN_VELOCITY, bullet_orientation));
-    if (red_player != NULL) {
-      create_tank_destructive_collision(scene, red_player, bullet);
-    }
-    if (blue_player != NULL) {
-      create_tank_destructive_collision(scene, blue_player, bullet);
-    }
-    if (green_player != NULL) {
-      create_tank_destructive_collision(scene, green_player, bullet);
-    }
-    create_decay_force(state, tonk, bullet, SHOTGUN_DECAY);
+    projectile_attach(state, bullet, PROJECTILE_SHOTGUN, owner);
     tonk->bullets_onscreen = tonk->bullets_onscreen + 1;
-    add_maze_collision(scene, state->maze, bullet);
-    scene_add_body(scene, bullet);
   }
   tonk->powerup_shots_left = tonk->powerup_shots_left - 1;
-  Mix_Chunk *shot_sound = Mix_LoadWAV(SHOTGUN_SHOT_SOUND_PATH);
-  Mix_PlayChannel(-1, shot_sound, 0);
+  audio_play(&state->audio, SOUND_SHOTGUN_SHOT);
 }
 
 void moon_shot(state_t* state, tank_t *tonk, size_t tank_size) {
   body_t *tank = get_tank_hitbox(tonk);
   double orientation = body_get_orientation(tank);
   vector_t bullet_loc = bullet_location(body_get_orientation(tank), body_get_center(tank), tank_size, NORMAL_SIZE, 30);
-  body_t *bullet = body_init_with_info(
-    normal_bullet(MOON_SIZE, bullet_loc), MOON_MASS, NORMAL_COLOR, NULL, NULL, 1
-    );
-  scene_t *scene = state->scene;
+  body_t *bullet = projectile_body(PROJECTILE_MOON, normal_bullet(MOON_SIZE, bullet_loc));
   vector_t vel = vec_rotate(MOON_VELOCITY, orientation);
   body_set_velocity(bullet, vel);
-  tank_t *red_player = state->red_player;
-  tank_t *blue_player = state->blue_player;
-  tank_t *green_player = state->green_player;
-  if (red_player != NULL) {
-    create_tank_destructive_collision(scene, red_player, bullet);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, red_player->hitbox);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, red_player->body);
-  }
-  if (green_player != NULL) {
-    create_tank_destructive_collision(scene, green_player, bullet);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, green_player->hitbox);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, green_player->body);
-  }
-  if (blue_player != NULL) {
-    create_tank_destructive_collision(scene, blue_player, bullet);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, blue_player->hitbox);
-    create_newtonian_gravity(state->scene, MOON_G, bullet, blue_player->body);
-  }
-  scene_add_body(scene, bullet);
+  projectile_attach(state, bullet, PROJECTILE_MOON, tank_player(state, tonk));
   tonk->powerup_shots_left = tonk->powerup_shots_left - 1;
-  Mix_Chunk *shot_sound = Mix_LoadWAV(MOON_SHOT_SOUND_PATH);
-  Mix_PlayChannel(-1, shot_sound, 0);
+  audio_play(&state->audio, SOUND_MOON_SHOT);
 }
 
 list_t *powerup_shape(vector_t center) {
@@ -305,26 +372,139 @@ void create_powerup_destructive_collision(scene_t *scene, tank_t *tank, body_t *
   scene_add_bodies_force_creator(scene, powerup_force, aux, bodies, free);
 }
 
-void add_powerup(state_t *state, powerup_type_t powerup_type) {
-  rgb_color_t color;
+rgb_color_t powerup_color(powerup_type_t powerup_type) {
   if (powerup_type == RAILGUN) {
-    color = RAILGUN_COLOR;
+    return RAILGUN_COLOR;
   } else if (powerup_type == LASER) {
-    color = LASER_COLOR;
+    return LASER_COLOR;
   } else if (powerup_type == SHOTGUN) {
-    color = SHOTGUN_COLOR;
+    return SHOTGUN_COLOR;
   } else {
-    color = MOON_COLOR;
+    return MOON_COLOR;
+  }
+}
+
+/**
+ * Precomputes one pulse per powerup type: the value dips and the hue
+ * swings around the type's color.
+ */
+void powerup_palette_init() {
+  float h[POWERUP_PULSE_STEPS];
+  float s[POWERUP_PULSE_STEPS];
+  float v[POWERUP_PULSE_STEPS];
+  float r[POWERUP_PULSE_STEPS];
+  float g[POWERUP_PULSE_STEPS];
+  float b[POWERUP_PULSE_STEPS];
+  for (size_t type = 0; type < POWERUP_TYPES; type++) {
+    hsv_color_t base = rgb_to_hsv(powerup_color(type));
+    for (size_t i = 0; i < POWERUP_PULSE_STEPS; i++) {
+      double t = TAU * i / POWERUP_PULSE_STEPS;
+      h[i] = base.h + POWERUP_PULSE_HUE_SWING * sin(t);
+      s[i] = base.s;
+      v[i] = base.v * (1 - POWERUP_PULSE_DEPTH * (0.5 - 0.5 * cos(t)));
+    }
+    hsv_to_rgb_batch(h, s, v, r, g, b, POWERUP_PULSE_STEPS);
+    for (size_t i = 0; i < POWERUP_PULSE_STEPS; i++) {
+      powerup_palette[type][i] = (rgb_color_t) {.r = r[i], .g = g[i], .b = b[i]};
+    }
+  }
+}
+
+powerup_pool_t *powerups_init(size_t capacity) {
+  powerup_pool_t *powerups = malloc(sizeof(powerup_pool_t));
+  assert(powerups != NULL && capacity > 0);
+  powerups->capacity = capacity;
+  powerups->bodies = malloc(sizeof(body_t *) * capacity);
+  powerups->pulses = malloc(sizeof(powerup_pulse_t *) * capacity);
+  powerups->free_slots = malloc(sizeof(size_t) * capacity);
+  assert(powerups->bodies != NULL && powerups->pulses != NULL && powerups->free_slots != NULL);
+  for (size_t i = 0; i < capacity; i++) {
+    powerups->bodies[i] = NULL;
+    powerups->pulses[i] = NULL;
+    powerups->free_slots[i] = capacity - 1 - i;
+  }
+  powerups->free_count = capacity;
+  powerups->next_serial = 0;
+  return powerups;
+}
+
+void powerups_free(powerup_pool_t *powerups) {
+  free(powerups->bodies);
+  free(powerups->pulses);
+  free(powerups->free_slots);
+  free(powerups);
+}
+
+size_t powerups_take_slot(powerup_pool_t *powerups) {
+  if (powerups->free_count == 0) {
+    size_t old_capacity = powerups->capacity;
+    powerups->capacity = old_capacity * 2;
+    powerups->bodies = realloc(powerups->bodies, sizeof(body_t *) * powerups->capacity);
+    powerups->pulses = realloc(powerups->pulses, sizeof(powerup_pulse_t *) * powerups->capacity);
+    powerups->free_slots = realloc(powerups->free_slots, sizeof(size_t) * powerups->capacity);
+    assert(powerups->bodies != NULL && powerups->pulses != NULL && powerups->free_slots != NULL);
+    for (size_t i = old_capacity; i < powerups->capacity; i++) {
+      powerups->bodies[i] = NULL;
+      powerups->pulses[i] = NULL;
+      powerups->free_slots[powerups->free_count] = powerups->capacity - 1 - (i - old_capacity);
+      powerups->free_count = powerups->free_count + 1;
+    }
   }
-  body_t *powerup = powerup_init(get_random_cell_center(state->maze), color, powerup_type);
+  powerups->free_count = powerups->free_count - 1;
+  return powerups->free_slots[powerups->free_count];
+}
+
+void powerup_release(void *aux) {
+  powerup_pulse_t *pulse = aux;
+  powerup_pool_t *powerups = pulse->state->powerups;
+  powerups->bodies[pulse->slot] = NULL;
+  powerups->pulses[pulse->slot] = NULL;
+  powerups->free_slots[powerups->free_count] = pulse->slot;
+  powerups->free_count = powerups->free_count + 1;
+  free(pulse);
+}
+
+void powerup_pulse(void *aux) {
+  powerup_pulse_t *pulse = aux;
+  pulse->phase = fmod(pulse->phase + pulse->state->dt * POWERUP_PULSE_RATE, 1);
+  pulse->body->color = powerup_palette[pulse->type][(size_t) (pulse->phase * POWERUP_PULSE_STEPS)];
+}
+
+powerup_pulse_t *add_powerup_pulse(state_t *state, body_t *powerup, powerup_type_t powerup_type) {
+  pthread_once(&powerup_palette_once, powerup_palette_init);
+  powerup_pulse_t *aux = malloc(sizeof(powerup_pulse_t));
+  assert(aux != NULL);
+  size_t slot = powerups_take_slot(state->powerups);
+  *aux = (powerup_pulse_t){
+    .state = state, .body = powerup, .type = powerup_type, .phase = 0, .slot = slot,
+    .serial = state->powerups->next_serial,
+  };
+  state->powerups->next_serial = state->powerups->next_serial + 1;
+  state->powerups->bodies[slot] = powerup;
+  state->powerups->pulses[slot] = aux;
+  list_t *bodies = list_init(1, NULL);
+  list_add(bodies, powerup);
+  scene_add_bodies_force_creator(state->scene, powerup_pulse, aux, bodies, powerup_release);
+  return aux;
+}
+
+powerup_pulse_t *powerup_spawn(state_t *state, powerup_type_t powerup_type, vector_t center) {
+  body_t *powerup = powerup_init(center, powerup_color(powerup_type), powerup_type);
   scene_add_body(state->scene, powerup);
-  if (state->red_player != NULL) {
+  powerup_pulse_t *pulse = add_powerup_pulse(state, powerup, powerup_type);
+  // a tank shot earlier in the tick is freed at the end of it, before its removed hitbox lets go of the force
+  if (state->red_player != NULL && state->red_player->exists) {
     create_powerup_destructive_collision(state->scene, state->red_player, powerup);
   }
-  if (state->green_player != NULL) {
+  if (state->green_player != NULL && state->green_player->exists) {
     create_powerup_destructive_collision(state->scene, state->green_player, powerup);
   }
-  if (state->blue_player != NULL) {
+  if (state->blue_player != NULL && state->blue_player->exists) {
     create_powerup_destructive_collision(state->scene, state->blue_player, powerup);
   }
+  return pulse;
+}
+
+void add_powerup(state_t *state, powerup_type_t powerup_type) {
+  powerup_spawn(state, powerup_type, get_random_cell_center(state->maze, &state->rng.powerups));
 }
@@ -0,0 +1,135 @@
+#include "projectiles.h"
+#include "collision.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// pairs handed to the narrow phase per tick, bounding the worst-case cost
+const size_t PROJECTILE_PAIR_BUDGET = 256;
+
+typedef struct projectile_slot {
+  projectile_pool_t *projectiles;
+  size_t index;
+} projectile_slot_t;
+
+projectile_pool_t *projectiles_init(vector_t lower_left, vector_t upper_right, double cell_size, size_t capacity) {
+  projectile_pool_t *projectiles = malloc(sizeof(projectile_pool_t));
+  assert(projectiles != NULL);
+  projectiles->capacity = capacity;
+  projectiles->bodies = malloc(sizeof(body_t *) * capacity);
+  projectiles->infos = malloc(sizeof(projectile_info_t) * capacity);
+  projectiles->serials = malloc(sizeof(size_t) * capacity);
+  projectiles->radii = malloc(sizeof(double) * capacity);
+  projectiles->free_slots = malloc(sizeof(size_t) * capacity);
+  projectiles->pairs_first = malloc(sizeof(size_t) * PROJECTILE_PAIR_BUDGET);
+  projectiles->pairs_second = malloc(sizeof(size_t) * PROJECTILE_PAIR_BUDGET);
+  assert(projectiles->bodies != NULL && projectiles->infos != NULL && projectiles->serials != NULL);
+  assert(projectiles->radii != NULL && projectiles->free_slots != NULL);
+  assert(projectiles->pairs_first != NULL && projectiles->pairs_second != NULL);
+  for (size_t i = 0; i < capacity; i++) {
+    projectiles->bodies[i] = NULL;
+    projectiles->free_slots[i] = capacity - 1 - i;
+  }
+  projectiles->free_count = capacity;
+  projectiles->next_serial = 0;
+  projectiles->broadphase = broadphase_init(lower_left, upper_right, cell_size, capacity);
+  return projectiles;
+}
+
+void projectiles_free(projectile_pool_t *projectiles) {
+  broadphase_free(projectiles->broadphase);
+  free(projectiles->bodies);
+  free(projectiles->infos);
+  free(projectiles->serials);
+  free(projectiles->radii);
+  free(projectiles->free_slots);
+  free(projectiles->pairs_first);
+  free(projectiles->pairs_second);
+  free(projectiles);
+}
+
+double projectile_radius(body_t *body) {
+  vector_t center = body_get_center(body);
+  double radius = 0;
+  for (size_t i = 0; i < list_size(body->shape); i++) {
+    vector_t offset = vec_subtract(*(vector_t *)list_get(body->shape, i), center);
+    radius = fmax(radius, sqrt(vec_dot(offset, offset)));
+  }
+  return radius;
+}
+
+/**
+ * The projectile only needs the scene to tell it when the body is freed,
+ * so the force itself does nothing.
+ */
+void projectile_track(void *aux) {}
+
+void projectile_release(void *aux) {
+  projectile_slot_t *slot = aux;
+  projectile_pool_t *projectiles = slot->projectiles;
+  projectiles->bodies[slot->index] = NULL;
+  projectiles->free_slots[projectiles->free_count] = slot->index;
+  projectiles->free_count = projectiles->free_count + 1;
+  free(slot);
+}
+
+void projectiles_add(projectile_pool_t *projectiles, scene_t *scene, body_t *body, projectile_info_t info) {
+  if (projectiles->free_count == 0) {
+    return;
+  }
+  projectiles->free_count = projectiles->free_count - 1;
+  size_t index = projectiles->free_slots[projectiles->free_count];
+  projectiles->bodies[index] = body;
+  projectiles->infos[index] = info;
+  projectiles->serials[index] = projectiles->next_serial;
+  projectiles->next_serial = projectiles->next_serial + 1;
+  projectiles->radii[index] = projectile_radius(body);
+
+  projectile_slot_t *slot = malloc(sizeof(projectile_slot_t));
+  assert(slot != NULL);
+  *slot = (projectile_slot_t){.projectiles = projectiles, .index = index};
+  list_t *bodies = list_init(1, NULL);
+  list_add(bodies, body);
+  scene_add_bodies_force_creator(scene, projectile_track, slot, bodies, projectile_release);
+}
+
+void projectiles_set_free_slots(projectile_pool_t *projectiles, const size_t *slots, size_t count) {
+  assert(count <= projectiles->capacity);
+  for (size_t i = 0; i < count; i++) {
+    assert(slots[i] < projectiles->capacity && projectiles->bodies[slots[i]] == NULL);
+    projectiles->free_slots[i] = slots[i];
+  }
+  projectiles->free_count = count;
+}
+
+size_t projectiles_annihilate(projectile_pool_t *projectiles) {
+  broadphase_t *broadphase = projectiles->broadphase;
+  broadphase_clear(broadphase);
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body != NULL && !body_is_removed(body) && projectiles->infos[i].kind != PROJECTILE_RAILGUN) {
+      // a tank's own projectiles never annihilate, so they are never paired and cannot use up the budget
+      broadphase_insert(broadphase, i, projectiles->infos[i].owner, body_get_center(body), projectiles->radii[i]);
+    }
+  }
+  broadphase_build(broadphase);
+  size_t pairs = broadphase_pairs(broadphase, projectiles->pairs_first, projectiles->pairs_second,
+                                  PROJECTILE_PAIR_BUDGET);
+
+  size_t annihilated = 0;
+  for (size_t i = 0; i < pairs; i++) {
+    size_t a = projectiles->pairs_first[i];
+    size_t b = projectiles->pairs_second[i];
+    body_t *body_a = projectiles->bodies[a];
+    body_t *body_b = projectiles->bodies[b];
+    if (body_is_removed(body_a) || body_is_removed(body_b)) {
+      continue;
+    }
+    if (find_collision(body_a->shape, body_b->shape).collided) {
+      body_remove(body_a);
+      body_remove(body_b);
+      annihilated++;
+    }
+  }
+  return annihilated;
+}
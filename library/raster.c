@@ -0,0 +1,243 @@
+#include "raster.h"
+#include "tank.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// raster constants
+const uint8_t RASTER_SATURATED = 255;
+const size_t RASTER_INITIAL_DRAWN = 64;
+
+raster_shape_t raster_shape(maze_t *maze, size_t pixels_per_cell) {
+  assert(pixels_per_cell > 0);
+  return (raster_shape_t){
+    .width = maze->columns * pixels_per_cell,
+    .height = maze->rows * pixels_per_cell,
+    .pixels_per_cell = pixels_per_cell,
+  };
+}
+
+size_t raster_size(raster_shape_t shape) {
+  return RASTER_CHANNELS * shape.width * shape.height;
+}
+
+/**
+ * Draws every wall as the line of pixels along its side of the cell, one
+ * row of the grid at a time, so each row is a few short runs of stores.
+ * Both cells beside a wall mark it, as the wall is as thick on each side.
+ */
+void raster_walls(maze_t *maze, raster_shape_t shape, uint8_t *plane) {
+  size_t k = shape.pixels_per_cell;
+  if (k == 1) {
+    memcpy(plane, maze->cell_walls, maze->columns * maze->rows);
+    return;
+  }
+  for (size_t y = 0; y < maze->rows; y++) {
+    const uint8_t *walls = &maze->cell_walls[maze->columns * y];
+    for (size_t v = 0; v < k; v++) {
+      uint8_t *row = &plane[(y * k + v) * shape.width];
+      uint8_t across = v == 0 ? WALL_DOWN : v == k - 1 ? WALL_UP : 0;
+      for (size_t x = 0; x < maze->columns; x++) {
+        uint8_t *cell = &row[x * k];
+        if (walls[x] & across) {
+          memset(cell, 1, k);
+          continue;
+        }
+        memset(cell, 0, k);
+        cell[0] = (walls[x] & WALL_LEFT) != 0;
+        cell[k - 1] = (walls[x] & WALL_RIGHT) != 0;
+      }
+    }
+  }
+}
+
+/**
+ * Returns the pixel a coordinate falls in along one axis, clamped to the grid.
+ */
+size_t raster_pixel(double coordinate, double origin, double pixel, size_t pixels) {
+  double index = floor((coordinate - origin) / pixel);
+  if (!(index >= 0)) {
+    return 0;
+  }
+  return index >= pixels ? pixels - 1 : (size_t)index;
+}
+
+/**
+ * Remembers a block drawn into an observation, if the observation is kept
+ * up to date in place.
+ */
+void raster_remember(raster_match_t *match, raster_rect_t rect) {
+  if (match == NULL) {
+    return;
+  }
+  if (match->drawn_count == match->drawn_capacity) {
+    match->drawn_capacity = match->drawn_capacity * 2;
+    match->drawn = realloc(match->drawn, sizeof(raster_rect_t) * match->drawn_capacity);
+    assert(match->drawn != NULL);
+  }
+  match->drawn[match->drawn_count] = rect;
+  match->drawn_count = match->drawn_count + 1;
+}
+
+/**
+ * Marks the pixels whose centers lie in a tank's rotated hitbox, and the
+ * pixel under its center, so a tank smaller than a pixel still shows.
+ */
+void raster_tank(tank_t *tank, raster_shape_t shape, vector_t origin, vector_t pixel, uint8_t *observation,
+                 size_t plane, raster_match_t *match) {
+  body_t *body = get_tank_body(tank);
+  vector_t center = body->center;
+  double c = cos(body->orientation);
+  double s = sin(body->orientation);
+  double half = TANK_SIZE / 2.;
+  double reach = half * (fabs(c) + fabs(s));
+  size_t left = raster_pixel(center.x - reach, origin.x, pixel.x, shape.width);
+  size_t right = raster_pixel(center.x + reach, origin.x, pixel.x, shape.width);
+  size_t bottom = raster_pixel(center.y - reach, origin.y, pixel.y, shape.height);
+  size_t top = raster_pixel(center.y + reach, origin.y, pixel.y, shape.height);
+  uint8_t *samples = &observation[plane];
+  for (size_t y = bottom; y <= top; y++) {
+    uint8_t *row = &samples[y * shape.width];
+    double dy = origin.y + (y + .5) * pixel.y - center.y;
+    // the hitbox's own axes, as a branch-free test the compiler can vectorize along the row
+    for (size_t x = left; x <= right; x++) {
+      double dx = origin.x + (x + .5) * pixel.x - center.x;
+      double along = dx * c + dy * s;
+      double across = dy * c - dx * s;
+      row[x] = row[x] | (fabs(along) <= half && fabs(across) <= half);
+    }
+  }
+  size_t x = raster_pixel(center.x, origin.x, pixel.x, shape.width);
+  size_t y = raster_pixel(center.y, origin.y, pixel.y, shape.height);
+  samples[y * shape.width + x] = 1;
+  raster_remember(match, (raster_rect_t){.plane = plane, .left = left, .right = right, .bottom = bottom, .top = top});
+}
+
+void raster_count(raster_shape_t shape, vector_t origin, vector_t pixel, vector_t point, uint8_t *observation,
+                  size_t plane, raster_match_t *match) {
+  size_t x = raster_pixel(point.x, origin.x, pixel.x, shape.width);
+  size_t y = raster_pixel(point.y, origin.y, pixel.y, shape.height);
+  uint8_t *count = &observation[plane + y * shape.width + x];
+  if (*count == 0) {
+    raster_remember(match, (raster_rect_t){.plane = plane, .left = x, .right = x, .bottom = y, .top = y});
+  }
+  if (*count < RASTER_SATURATED) {
+    *count = *count + 1;
+  }
+}
+
+/**
+ * Stamps the tanks, projectiles and powerups onto planes that are clear.
+ */
+void raster_bodies(state_t *state, raster_shape_t shape, uint8_t *observation, raster_match_t *match) {
+  maze_t *maze = state->maze;
+  size_t plane = shape.width * shape.height;
+  vector_t origin = maze->lower_left;
+  vector_t pixel = {
+    (maze->upper_right.x - maze->lower_left.x) / shape.width,
+    (maze->upper_right.y - maze->lower_left.y) / shape.height,
+  };
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    tank_t *tank = player_tank(state, i);
+    if (tank != NULL) {
+      raster_tank(tank, shape, origin, pixel, observation, (RASTER_RED + i) * plane, match);
+    }
+  }
+
+  projectile_pool_t *projectiles = state->projectiles;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body != NULL && !body_is_removed(body)) {
+      raster_count(shape, origin, pixel, body->center, observation, RASTER_PROJECTILES * plane, match);
+    }
+  }
+
+  powerup_pool_t *powerups = state->powerups;
+  for (size_t i = 0; i < powerups->capacity; i++) {
+    if (powerups->pulses[i] != NULL) {
+      raster_count(shape, origin, pixel, powerups->pulses[i]->body->center, observation,
+                   RASTER_POWERUPS * plane, match);
+    }
+  }
+}
+
+void raster_observe(state_t *state, raster_shape_t shape, uint8_t *out) {
+  maze_t *maze = state->maze;
+  assert(shape.width == maze->columns * shape.pixels_per_cell);
+  assert(shape.height == maze->rows * shape.pixels_per_cell);
+  size_t plane = shape.width * shape.height;
+  raster_walls(maze, shape, out);
+  memset(&out[plane], 0, (RASTER_CHANNELS - 1) * plane);
+  raster_bodies(state, shape, out, NULL);
+}
+
+void raster_observe_batch(state_t **states, size_t count, raster_shape_t shape, uint8_t *out) {
+  size_t size = raster_size(shape);
+  for (size_t i = 0; i < count; i++) {
+    raster_observe(states[i], shape, &out[i * size]);
+  }
+}
+
+raster_t *raster_init(raster_shape_t shape, size_t matches) {
+  // the drawn blocks store pixel indices in 16 bits and plane offsets in 32
+  assert(shape.width <= UINT16_MAX && shape.height <= UINT16_MAX);
+  size_t size = raster_size(shape);
+  assert(size <= UINT32_MAX);
+  raster_t *raster = malloc(sizeof(raster_t));
+  assert(raster != NULL);
+  *raster = (raster_t){
+    .shape = shape,
+    .matches = matches,
+    .size = size,
+    .observations = calloc(matches, size),
+    .slots = malloc(sizeof(raster_match_t) * matches),
+  };
+  assert(raster->observations != NULL);
+  assert(raster->slots != NULL);
+  for (size_t i = 0; i < matches; i++) {
+    raster_rect_t *drawn = malloc(sizeof(raster_rect_t) * RASTER_INITIAL_DRAWN);
+    assert(drawn != NULL);
+    raster->slots[i] = (raster_match_t){.drawn = drawn, .drawn_capacity = RASTER_INITIAL_DRAWN};
+  }
+  return raster;
+}
+
+void raster_free(raster_t *raster) {
+  for (size_t i = 0; i < raster->matches; i++) {
+    free(raster->slots[i].drawn);
+  }
+  free(raster->slots);
+  free(raster->observations);
+  free(raster);
+}
+
+void raster_update(raster_t *raster, state_t **states) {
+  raster_shape_t shape = raster->shape;
+  for (size_t i = 0; i < raster->matches; i++) {
+    state_t *state = states[i];
+    maze_t *maze = state->maze;
+    assert(shape.width == maze->columns * shape.pixels_per_cell);
+    assert(shape.height == maze->rows * shape.pixels_per_cell);
+    raster_match_t *match = &raster->slots[i];
+    uint8_t *observation = &raster->observations[i * raster->size];
+
+    if (match->state != state || match->maze != maze || match->maze_generation != state->maze_generation
+        || match->maze_revision != maze->revision) {
+      raster_walls(maze, shape, observation);
+      match->state = state;
+      match->maze = maze;
+      match->maze_generation = state->maze_generation;
+      match->maze_revision = maze->revision;
+    }
+    for (size_t j = 0; j < match->drawn_count; j++) {
+      raster_rect_t rect = match->drawn[j];
+      size_t width = rect.right - rect.left + 1;
+      for (size_t y = rect.bottom; y <= rect.top; y++) {
+        memset(&observation[rect.plane + y * shape.width + rect.left], 0, width);
+      }
+    }
+    match->drawn_count = 0;
+    raster_bodies(state, shape, observation, match);
+  }
+}
@@ -0,0 +1,697 @@
+#include "render.h"
+#include "hud.h"
+#include "sdl_wrapper.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+// window constants; SDL numbers windows from 1 in the order they are created
+const Uint32 RENDER_MAX_WINDOW_ID = 16;
+
+// static layer constants
+const SDL_Color RENDER_BACKGROUND = {.r = 255, .g = 255, .b = 255, .a = 255};
+const double RENDER_WALL_THICKNESS = 6;
+
+// trail constants
+const SDL_Color TREAD_COLOR = {.r = 90, .g = 80, .b = 70, .a = 110};
+const double TREAD_OFFSET = 19; // from the tank's center to the middle of each tread, for 50 unit tanks
+const double TREAD_WIDTH = 10;
+const double TREAD_STEP = 4; // shortest movement stamped, so idle tanks add nothing
+const double TREAD_MAX_STEP = 60;
+const Uint32 TRAIL_FADE_INTERVAL = 500; // milliseconds
+const Uint8 TRAIL_FADE_ALPHA = 32;
+const Uint8 TRAIL_FADE_FLOOR = 2; // alpha subtracted after each fade, as rounding holds alpha 3 and below in place
+
+// batch constants
+const size_t BATCH_INITIAL_VERTICES = 4096;
+const size_t MAX_POLYGON_VERTICES = 64;
+
+// particle constants
+const size_t PARTICLE_VERTICES = 3;
+const vector_t PARTICLE_SHAPE[] = {{.x = 10, .y = -4}, {.x = -8, .y = -4}, {.x = 0, .y = 8}};
+const float PARTICLE_REACH = 11; // bounds the distance of PARTICLE_SHAPE's corners from its center
+
+/**
+ * Untextured triangles accumulated during a frame and submitted with a
+ * single SDL_RenderGeometry() call. The buffers are kept between frames.
+ */
+typedef struct render_batch {
+  SDL_Vertex *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  int *indices;
+  size_t index_count;
+  size_t index_capacity;
+} render_batch_t;
+
+SDL_Renderer *renderer = NULL;
+// the transform render_to_pixel() applies, set for the screen or for the static layer
+vector_t scene_center;
+double scene_scale;
+vector_t window_center;
+// pixels per scene unit when the whole window is shown, as sdl_wrapper draws it
+double base_scale;
+vector_t screen_center;
+
+// the static layer covers the whole arena, which may be larger than the view
+SDL_Texture *static_layer = NULL;
+int static_width = 0;
+int static_height = 0;
+double static_scale;
+bool static_valid = false;
+size_t static_generation = 0;
+size_t static_revision = 0;
+
+// the trail layer accumulates tread marks over the static layer
+SDL_Texture *trail_layer = NULL;
+SDL_BlendMode trail_fade_mode;
+SDL_BlendMode trail_floor_mode;
+size_t trail_generation = 0;
+Uint32 trail_last_fade = 0;
+bool tread_known[SNAPSHOT_MAX_TREADS];
+vector_t tread_center[SNAPSHOT_MAX_TREADS];
+vector_t tread_left[SNAPSHOT_MAX_TREADS];
+vector_t tread_right[SNAPSHOT_MAX_TREADS];
+
+render_batch_t batch = {0};
+render_stats_t stats = {0};
+render_stats_t frame_stats = {0};
+
+/**
+ * Returns the renderer of the window sdl_wrapper created. The wrapper keeps
+ * its window to itself, but it is the only one given a renderer, so it is
+ * the first window found with one.
+ */
+SDL_Renderer *render_find_renderer() {
+  for (Uint32 id = 1; id <= RENDER_MAX_WINDOW_ID; id++) {
+    SDL_Window *window = SDL_GetWindowFromID(id);
+    if (window != NULL && SDL_GetRenderer(window) != NULL) {
+      return SDL_GetRenderer(window);
+    }
+  }
+  return NULL;
+}
+
+void render_init(vector_t min, vector_t max) {
+  renderer = render_find_renderer();
+  assert(renderer != NULL);
+  int width;
+  int height;
+  SDL_GetRendererOutputSize(renderer, &width, &height);
+  screen_center = (vector_t){.x = width / 2., .y = height / 2.};
+  window_center = screen_center;
+  scene_center = vec_multiply(0.5, vec_add(min, max));
+  vector_t max_diff = vec_subtract(max, scene_center);
+  base_scale = fmin(window_center.x / max_diff.x, window_center.y / max_diff.y);
+  scene_scale = base_scale;
+  hud_init(renderer);
+}
+
+void render_set_transform(vector_t center, double scale, vector_t pixel_center) {
+  scene_center = center;
+  scene_scale = scale;
+  window_center = pixel_center;
+}
+
+/**
+ * Maps the snapshot's view onto the screen.
+ */
+void render_use_view(const frame_snapshot_t *snapshot) {
+  vector_t half_extent = vec_multiply(0.5, vec_subtract(snapshot->view_upper_right, snapshot->view_lower_left));
+  double scale = fmin(screen_center.x / half_extent.x, screen_center.y / half_extent.y);
+  render_set_transform(vec_add(snapshot->view_lower_left, half_extent), scale, screen_center);
+}
+
+/**
+ * Maps the snapshot's arena onto the static layer.
+ */
+void render_use_static(const frame_snapshot_t *snapshot) {
+  vector_t center = vec_multiply(0.5, vec_add(snapshot->lower_left, snapshot->upper_right));
+  render_set_transform(center, static_scale, (vector_t){.x = static_width / 2., .y = static_height / 2.});
+}
+
+bool render_overlaps(float min_x, float min_y, float max_x, float max_y, vector_t low, vector_t high) {
+  return max_x >= low.x && min_x <= high.x && max_y >= low.y && min_y <= high.y;
+}
+
+/**
+ * Maps a scene coordinate to a pixel coordinate the same way sdl_wrapper does.
+ */
+SDL_FPoint render_to_pixel(double x, double y) {
+  return (SDL_FPoint){
+    .x = window_center.x + (x - scene_center.x) * scene_scale,
+    .y = window_center.y - (y - scene_center.y) * scene_scale
+  };
+}
+
+SDL_Color render_color(float r, float g, float b) {
+  return (SDL_Color){.r = r * 255, .g = g * 255, .b = b * 255, .a = 255};
+}
+
+void batch_reserve(size_t vertices, size_t indices) {
+  if (batch.vertex_count + vertices > batch.vertex_capacity) {
+    size_t capacity = batch.vertex_capacity > 0 ? batch.vertex_capacity : BATCH_INITIAL_VERTICES;
+    while (capacity < batch.vertex_count + vertices) {
+      capacity *= 2;
+    }
+    batch.vertices = realloc(batch.vertices, sizeof(SDL_Vertex) * capacity);
+    assert(batch.vertices != NULL);
+    batch.vertex_capacity = capacity;
+  }
+  if (batch.index_count + indices > batch.index_capacity) {
+    size_t capacity = batch.index_capacity > 0 ? batch.index_capacity : 3 * BATCH_INITIAL_VERTICES;
+    while (capacity < batch.index_count + indices) {
+      capacity *= 2;
+    }
+    batch.indices = realloc(batch.indices, sizeof(int) * capacity);
+    assert(batch.indices != NULL);
+    batch.index_capacity = capacity;
+  }
+}
+
+void batch_flush() {
+  if (batch.index_count > 0) {
+    SDL_RenderGeometry(renderer, NULL, batch.vertices, batch.vertex_count, batch.indices, batch.index_count);
+    frame_stats.draw_calls++;
+    frame_stats.triangles += batch.index_count / 3;
+  }
+  batch.vertex_count = 0;
+  batch.index_count = 0;
+}
+
+double batch_cross(SDL_FPoint o, SDL_FPoint a, SDL_FPoint b) {
+  return (double)(a.x - o.x) * (b.y - o.y) - (double)(a.y - o.y) * (b.x - o.x);
+}
+
+bool batch_is_convex(SDL_Vertex *vertices, size_t count) {
+  bool positive = false;
+  bool negative = false;
+  for (size_t i = 0; i < count; i++) {
+    double cross = batch_cross(vertices[i].position, vertices[(i + 1) % count].position,
+                               vertices[(i + 2) % count].position);
+    positive = positive || cross > 0;
+    negative = negative || cross < 0;
+  }
+  return !(positive && negative);
+}
+
+bool batch_in_triangle(SDL_FPoint p, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c) {
+  return batch_cross(a, b, p) >= 0 && batch_cross(b, c, p) >= 0 && batch_cross(c, a, p) >= 0;
+}
+
+/**
+ * Triangulates a simple concave polygon by ear clipping.
+ * base is the index of the polygon's first vertex in the batch.
+ */
+void batch_ear_clip(size_t base, size_t count) {
+  size_t remaining[MAX_POLYGON_VERTICES];
+  double area = 0;
+  for (size_t i = 0; i < count; i++) {
+    remaining[i] = base + i;
+    SDL_FPoint a = batch.vertices[base + i].position;
+    SDL_FPoint b = batch.vertices[base + (i + 1) % count].position;
+    area += (double)a.x * b.y - (double)b.x * a.y;
+  }
+  // work in counter-clockwise order
+  double orientation = area > 0 ? 1 : -1;
+  size_t left = count;
+  size_t i = 0;
+  size_t attempts = 0;
+  while (left > 3 && attempts < left) {
+    size_t prev = remaining[(i + left - 1) % left];
+    size_t curr = remaining[i % left];
+    size_t next = remaining[(i + 1) % left];
+    SDL_FPoint a = batch.vertices[prev].position;
+    SDL_FPoint b = batch.vertices[curr].position;
+    SDL_FPoint c = batch.vertices[next].position;
+    bool ear = orientation * batch_cross(a, b, c) > 0;
+    for (size_t k = 0; k < left && ear; k++) {
+      size_t other = remaining[k];
+      if (other == prev || other == curr || other == next) {
+        continue;
+      }
+      SDL_FPoint p = batch.vertices[other].position;
+      ear = orientation > 0 ? !batch_in_triangle(p, a, b, c) : !batch_in_triangle(p, c, b, a);
+    }
+    if (ear) {
+      batch.indices[batch.index_count++] = prev;
+      batch.indices[batch.index_count++] = curr;
+      batch.indices[batch.index_count++] = next;
+      for (size_t k = i % left; k + 1 < left; k++) {
+        remaining[k] = remaining[k + 1];
+      }
+      left--;
+      attempts = 0;
+    } else {
+      i++;
+      attempts++;
+    }
+  }
+  // whatever is left (a triangle, or a degenerate remainder) is fanned
+  for (size_t k = 1; k + 1 < left; k++) {
+    batch.indices[batch.index_count++] = remaining[0];
+    batch.indices[batch.index_count++] = remaining[k];
+    batch.indices[batch.index_count++] = remaining[k + 1];
+  }
+}
+
+/**
+ * Adds a polygon given as count interleaved x, y scene coordinates to the batch.
+ */
+void batch_add_polygon(const float *xy, size_t count, SDL_Color color) {
+  if (count < 3) {
+    return;
+  }
+  assert(count <= MAX_POLYGON_VERTICES);
+  batch_reserve(count, 3 * (count - 2));
+  size_t base = batch.vertex_count;
+  for (size_t i = 0; i < count; i++) {
+    SDL_Vertex *vertex = &batch.vertices[base + i];
+    vertex->position = render_to_pixel(xy[2 * i], xy[2 * i + 1]);
+    vertex->color = color;
+    vertex->tex_coord = (SDL_FPoint){.x = 0, .y = 0};
+  }
+  batch.vertex_count = base + count;
+  if (batch_is_convex(&batch.vertices[base], count)) {
+    for (size_t i = 1; i + 1 < count; i++) {
+      batch.indices[batch.index_count++] = base;
+      batch.indices[batch.index_count++] = base + i;
+      batch.indices[batch.index_count++] = base + i + 1;
+    }
+  } else {
+    batch_ear_clip(base, count);
+  }
+}
+
+/**
+ * Draws the walls touching the area from low to high.
+ */
+void render_walls(const frame_snapshot_t *snapshot, vector_t low, vector_t high) {
+  for (size_t i = 0; i < snapshot->wall_count; i++) {
+    const float *xy = &snapshot->wall_xy[8 * i];
+    float min_x = fminf(fminf(xy[0], xy[2]), fminf(xy[4], xy[6]));
+    float max_x = fmaxf(fmaxf(xy[0], xy[2]), fmaxf(xy[4], xy[6]));
+    float min_y = fminf(fminf(xy[1], xy[3]), fminf(xy[5], xy[7]));
+    float max_y = fmaxf(fmaxf(xy[1], xy[3]), fmaxf(xy[5], xy[7]));
+    if (!render_overlaps(min_x, min_y, max_x, max_y, low, high)) {
+      continue;
+    }
+    rgb_color_t color = snapshot->wall_colors[i];
+    batch_add_polygon(&snapshot->wall_xy[8 * i], 4, render_color(color.r, color.g, color.b));
+  }
+}
+
+/**
+ * Creates the static layer at the on-screen resolution of the arena when
+ * fully zoomed in, or as close to it as the renderer's texture limit allows.
+ */
+bool render_create_static(const frame_snapshot_t *snapshot) {
+  vector_t arena = vec_subtract(snapshot->upper_right, snapshot->lower_left);
+  double scale = base_scale;
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0 && info.max_texture_height > 0) {
+    scale = fmin(scale, fmin(info.max_texture_width / arena.x, info.max_texture_height / arena.y));
+  }
+  int width = floor(arena.x * scale);
+  int height = floor(arena.y * scale);
+  if (static_layer != NULL && width == static_width && height == static_height) {
+    return true;
+  }
+  if (static_layer != NULL) {
+    SDL_DestroyTexture(static_layer);
+  }
+  static_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+  static_width = width;
+  static_height = height;
+  static_scale = scale;
+  // without render targets the walls are drawn every frame instead
+  return static_layer != NULL;
+}
+
+void render_rebuild_static(const frame_snapshot_t *snapshot) {
+  if (!render_create_static(snapshot)) {
+    return;
+  }
+  render_use_static(snapshot);
+  SDL_SetRenderTarget(renderer, static_layer);
+  SDL_SetRenderDrawColor(renderer, RENDER_BACKGROUND.r, RENDER_BACKGROUND.g, RENDER_BACKGROUND.b, RENDER_BACKGROUND.a);
+  SDL_RenderClear(renderer);
+  render_walls(snapshot, snapshot->lower_left, snapshot->upper_right);
+  batch_flush();
+  SDL_SetRenderTarget(renderer, NULL);
+  static_valid = true;
+}
+
+/**
+ * Redraws only the cells of the static layer whose walls were destroyed.
+ * Each cell is cleared (including the half walls on its border) and the
+ * walls are redrawn clipped to that area.
+ */
+void render_update_static(const frame_snapshot_t *snapshot) {
+  double edge_horizontal = (snapshot->upper_right.x - snapshot->lower_left.x) / snapshot->columns;
+  double edge_vertical = (snapshot->upper_right.y - snapshot->lower_left.y) / snapshot->rows;
+  render_use_static(snapshot);
+  SDL_SetRenderTarget(renderer, static_layer);
+  for (size_t i = 0; i < snapshot->dirty_count; i++) {
+    size_t column = snapshot->dirty_cells[i] % snapshot->columns;
+    size_t row = snapshot->dirty_cells[i] / snapshot->columns;
+    double left = snapshot->lower_left.x + column * edge_horizontal - RENDER_WALL_THICKNESS / 2;
+    double right = snapshot->lower_left.x + (column + 1) * edge_horizontal + RENDER_WALL_THICKNESS / 2;
+    double bottom = snapshot->lower_left.y + row * edge_vertical - RENDER_WALL_THICKNESS / 2;
+    double top = snapshot->lower_left.y + (row + 1) * edge_vertical + RENDER_WALL_THICKNESS / 2;
+    SDL_FPoint top_left = render_to_pixel(left, top);
+    SDL_FPoint bottom_right = render_to_pixel(right, bottom);
+    SDL_Rect area = {
+      .x = floor(top_left.x), .y = floor(top_left.y),
+      .w = ceil(bottom_right.x) - floor(top_left.x), .h = ceil(bottom_right.y) - floor(top_left.y)
+    };
+    SDL_RenderSetClipRect(renderer, &area);
+    SDL_SetRenderDrawColor(renderer, RENDER_BACKGROUND.r, RENDER_BACKGROUND.g, RENDER_BACKGROUND.b, RENDER_BACKGROUND.a);
+    SDL_RenderFillRect(renderer, &area);
+    render_walls(snapshot, (vector_t){.x = left, .y = bottom}, (vector_t){.x = right, .y = top});
+    batch_flush();
+  }
+  SDL_RenderSetClipRect(renderer, NULL);
+  SDL_SetRenderTarget(renderer, NULL);
+}
+
+/**
+ * Brings the static layer up to date with the snapshot's maze.
+ * Dirty cells only describe the changes since the previous snapshot, so
+ * the layer is rebuilt whole if a snapshot in between was skipped.
+ */
+void render_sync_static(const frame_snapshot_t *snapshot) {
+  if (static_valid && snapshot->maze_generation == static_generation && snapshot->revision == static_revision) {
+    // already up to date, e.g. the same snapshot drawn twice
+    return;
+  }
+  if (!static_valid || snapshot->maze_generation != static_generation
+      || snapshot->revision_before != static_revision) {
+    render_rebuild_static(snapshot);
+  } else if (snapshot->revision != static_revision) {
+    render_update_static(snapshot);
+  }
+  static_generation = snapshot->maze_generation;
+  static_revision = snapshot->revision;
+}
+
+void render_particles(const frame_snapshot_t *snapshot) {
+  size_t needed = snapshot->particle_count * PARTICLE_VERTICES;
+  batch_reserve(needed, needed);
+  vector_t low = snapshot->view_lower_left;
+  vector_t high = snapshot->view_upper_right;
+  for (size_t i = 0; i < snapshot->particle_count; i++) {
+    float x = snapshot->particle_x[i];
+    float y = snapshot->particle_y[i];
+    float reach = PARTICLE_REACH * snapshot->particle_size[i];
+    if (!render_overlaps(x - reach, y - reach, x + reach, y + reach, low, high)) {
+      continue;
+    }
+    double c = cos(snapshot->particle_angle[i]);
+    double s = sin(snapshot->particle_angle[i]);
+    double size = snapshot->particle_size[i];
+    rgb_color_t particle_color = snapshot->particle_colors[i];
+    SDL_Color color = render_color(particle_color.r, particle_color.g, particle_color.b);
+    for (size_t k = 0; k < PARTICLE_VERTICES; k++) {
+      double px = PARTICLE_SHAPE[k].x * size;
+      double py = PARTICLE_SHAPE[k].y * size;
+      SDL_Vertex *vertex = &batch.vertices[batch.vertex_count];
+      vertex->position = render_to_pixel(snapshot->particle_x[i] + c * px - s * py,
+                                         snapshot->particle_y[i] + s * px + c * py);
+      vertex->color = color;
+      vertex->tex_coord = (SDL_FPoint){.x = 0, .y = 0};
+      batch.indices[batch.index_count++] = batch.vertex_count;
+      batch.vertex_count++;
+    }
+  }
+}
+
+void render_polygon(const frame_snapshot_t *snapshot, size_t polygon) {
+  rgb_color_t color = snapshot->polygon_colors[polygon];
+  batch_add_polygon(&snapshot->xy[2 * snapshot->polygon_offsets[polygon]], snapshot->polygon_sizes[polygon],
+                    render_color(color.r, color.g, color.b));
+  frame_stats.polygons++;
+}
+
+/**
+ * Draws the bodies in the cells the view overlaps. A polygon is bucketed
+ * by its center and is at most a cell wide, so it can only reach into the
+ * neighbouring cells: one extra ring of cells around the view suffices.
+ */
+void render_bodies(const frame_snapshot_t *snapshot) {
+  vector_t low = snapshot->view_lower_left;
+  vector_t high = snapshot->view_upper_right;
+  double edge_horizontal = (snapshot->upper_right.x - snapshot->lower_left.x) / snapshot->columns;
+  double edge_vertical = (snapshot->upper_right.y - snapshot->lower_left.y) / snapshot->rows;
+  long first_column = floor((low.x - snapshot->lower_left.x) / edge_horizontal) - 1;
+  long last_column = floor((high.x - snapshot->lower_left.x) / edge_horizontal) + 1;
+  long first_row = floor((low.y - snapshot->lower_left.y) / edge_vertical) - 1;
+  long last_row = floor((high.y - snapshot->lower_left.y) / edge_vertical) + 1;
+  first_column = first_column < 0 ? 0 : first_column;
+  first_row = first_row < 0 ? 0 : first_row;
+  last_column = last_column >= (long) snapshot->columns ? (long) snapshot->columns - 1 : last_column;
+  last_row = last_row >= (long) snapshot->rows ? (long) snapshot->rows - 1 : last_row;
+  for (long row = first_row; row <= last_row; row++) {
+    for (long column = first_column; column <= last_column; column++) {
+      size_t cell = row * snapshot->columns + column;
+      for (size_t k = snapshot->cell_start[cell]; k < snapshot->cell_start[cell + 1]; k++) {
+        render_polygon(snapshot, snapshot->cell_polygons[k]);
+      }
+    }
+  }
+  size_t oversized = snapshot->cell_count - 1;
+  for (size_t k = snapshot->cell_start[oversized]; k < snapshot->cell_start[oversized + 1]; k++) {
+    size_t polygon = snapshot->cell_polygons[k];
+    const float *xy = &snapshot->xy[2 * snapshot->polygon_offsets[polygon]];
+    float min_x = xy[0];
+    float max_x = xy[0];
+    float min_y = xy[1];
+    float max_y = xy[1];
+    for (size_t v = 1; v < snapshot->polygon_sizes[polygon]; v++) {
+      min_x = fminf(min_x, xy[2 * v]);
+      max_x = fmaxf(max_x, xy[2 * v]);
+      min_y = fminf(min_y, xy[2 * v + 1]);
+      max_y = fmaxf(max_y, xy[2 * v + 1]);
+    }
+    if (render_overlaps(min_x, min_y, max_x, max_y, low, high)) {
+      render_polygon(snapshot, polygon);
+    }
+  }
+}
+
+/**
+ * Copies the part of an arena-sized layer inside the view to the screen.
+ * Clears the screen first if the view reaches past the arena.
+ */
+void render_blit_layer(const frame_snapshot_t *snapshot, SDL_Texture *layer) {
+  vector_t low = {
+    .x = fmax(snapshot->view_lower_left.x, snapshot->lower_left.x),
+    .y = fmax(snapshot->view_lower_left.y, snapshot->lower_left.y)
+  };
+  vector_t high = {
+    .x = fmin(snapshot->view_upper_right.x, snapshot->upper_right.x),
+    .y = fmin(snapshot->view_upper_right.y, snapshot->upper_right.y)
+  };
+  SDL_Rect source = {
+    .x = round((low.x - snapshot->lower_left.x) * static_scale),
+    .y = round((snapshot->upper_right.y - high.y) * static_scale),
+    .w = round((high.x - low.x) * static_scale),
+    .h = round((high.y - low.y) * static_scale)
+  };
+  SDL_FPoint top_left = render_to_pixel(low.x, high.y);
+  SDL_FPoint bottom_right = render_to_pixel(high.x, low.y);
+  SDL_Rect destination = {
+    .x = round(top_left.x), .y = round(top_left.y),
+    .w = round(bottom_right.x) - round(top_left.x), .h = round(bottom_right.y) - round(top_left.y)
+  };
+  SDL_RenderCopy(renderer, layer, &source, &destination);
+  frame_stats.draw_calls++;
+}
+
+bool render_view_inside_arena(const frame_snapshot_t *snapshot) {
+  return snapshot->view_lower_left.x >= snapshot->lower_left.x && snapshot->view_lower_left.y >= snapshot->lower_left.y
+         && snapshot->view_upper_right.x <= snapshot->upper_right.x
+         && snapshot->view_upper_right.y <= snapshot->upper_right.y;
+}
+
+/**
+ * Adds a quad of the given width along the segment from a to b to the batch.
+ */
+void batch_add_segment(vector_t a, vector_t b, double width, SDL_Color color) {
+  vector_t along = vec_subtract(b, a);
+  double length = sqrt(vec_dot(along, along));
+  if (length == 0) {
+    return;
+  }
+  vector_t side = vec_multiply(width / 2 / length, (vector_t){.x = -along.y, .y = along.x});
+  vector_t corners[4] = {vec_add(a, side), vec_add(b, side), vec_subtract(b, side), vec_subtract(a, side)};
+  batch_reserve(4, 6);
+  size_t base = batch.vertex_count;
+  for (size_t i = 0; i < 4; i++) {
+    SDL_Vertex *vertex = &batch.vertices[base + i];
+    vertex->position = render_to_pixel(corners[i].x, corners[i].y);
+    vertex->color = color;
+    vertex->tex_coord = (SDL_FPoint){.x = 0, .y = 0};
+  }
+  batch.vertex_count = base + 4;
+  const int QUAD[6] = {0, 1, 2, 0, 2, 3};
+  for (size_t i = 0; i < 6; i++) {
+    batch.indices[batch.index_count++] = base + QUAD[i];
+  }
+}
+
+/**
+ * Creates (or resizes) the trail layer to match the static layer and clears it.
+ */
+bool render_create_trails() {
+  int width = 0;
+  int height = 0;
+  if (trail_layer != NULL) {
+    SDL_QueryTexture(trail_layer, NULL, NULL, &width, &height);
+  }
+  if (trail_layer == NULL || width != static_width || height != static_height) {
+    if (trail_layer != NULL) {
+      SDL_DestroyTexture(trail_layer);
+    }
+    trail_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                    static_width, static_height);
+    if (trail_layer == NULL) {
+      return false;
+    }
+    SDL_SetTextureBlendMode(trail_layer, SDL_BLENDMODE_BLEND);
+    trail_fade_mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    trail_floor_mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_REV_SUBTRACT);
+  }
+  SDL_SetRenderTarget(renderer, trail_layer);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+  SDL_SetRenderTarget(renderer, NULL);
+  for (size_t i = 0; i < SNAPSHOT_MAX_TREADS; i++) {
+    tread_known[i] = false;
+  }
+  trail_last_fade = SDL_GetTicks();
+  return true;
+}
+
+/**
+ * Multiplies the alpha of the whole trail layer by 1 - TRAIL_FADE_ALPHA / 255,
+ * then subtracts TRAIL_FADE_FLOOR so the faintest marks reach 0 instead of
+ * rounding back to themselves. Renderers without custom blend modes clear
+ * the layer instead.
+ */
+void render_fade_trails() {
+  SDL_SetRenderTarget(renderer, trail_layer);
+  if (SDL_SetRenderDrawBlendMode(renderer, trail_fade_mode) == 0 &&
+      SDL_SetRenderDrawColor(renderer, 0, 0, 0, TRAIL_FADE_ALPHA) == 0 &&
+      SDL_RenderFillRect(renderer, NULL) == 0 &&
+      SDL_SetRenderDrawBlendMode(renderer, trail_floor_mode) == 0) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, TRAIL_FADE_FLOOR);
+    SDL_RenderFillRect(renderer, NULL);
+    frame_stats.draw_calls++;
+  } else {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+  }
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+  SDL_SetRenderTarget(renderer, NULL);
+  frame_stats.draw_calls++;
+}
+
+/**
+ * Stamps the tread marks left since the last snapshot drawn into the trail
+ * layer. Each tread is a quad from its previous stamped position to its
+ * current one, so skipped snapshots leave no gaps. The layer is faded as
+ * a whole on an interval, so the cost does not grow with the round's length.
+ */
+void render_update_trails(const frame_snapshot_t *snapshot) {
+  if (snapshot->maze_generation != trail_generation || trail_layer == NULL) {
+    trail_generation = snapshot->maze_generation;
+    if (!render_create_trails()) {
+      return;
+    }
+  }
+  render_use_static(snapshot);
+  bool seen[SNAPSHOT_MAX_TREADS] = {false};
+  for (size_t i = 0; i < snapshot->tread_count; i++) {
+    uint32_t id = snapshot->tread_ids[i];
+    vector_t center = {.x = snapshot->tread_x[i], .y = snapshot->tread_y[i]};
+    vector_t offset = vec_rotate((vector_t){.x = 0, .y = TREAD_OFFSET}, snapshot->tread_angle[i]);
+    vector_t left = vec_add(center, offset);
+    vector_t right = vec_subtract(center, offset);
+    seen[id] = true;
+    if (tread_known[id]) {
+      vector_t moved = vec_subtract(center, tread_center[id]);
+      double distance = sqrt(vec_dot(moved, moved));
+      if (distance < TREAD_STEP) {
+        continue;
+      }
+      // a longer jump is a respawn or a correction, not driving
+      if (distance <= TREAD_MAX_STEP) {
+        batch_add_segment(tread_left[id], left, TREAD_WIDTH, TREAD_COLOR);
+        batch_add_segment(tread_right[id], right, TREAD_WIDTH, TREAD_COLOR);
+      }
+    }
+    tread_known[id] = true;
+    tread_center[id] = center;
+    tread_left[id] = left;
+    tread_right[id] = right;
+  }
+  for (size_t i = 0; i < SNAPSHOT_MAX_TREADS; i++) {
+    tread_known[i] = tread_known[i] && seen[i];
+  }
+  Uint32 now = SDL_GetTicks();
+  bool fade = now - trail_last_fade >= TRAIL_FADE_INTERVAL;
+  if (batch.index_count == 0 && !fade) {
+    return;
+  }
+  if (fade) {
+    render_fade_trails();
+    trail_last_fade = now;
+  }
+  SDL_SetRenderTarget(renderer, trail_layer);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  batch_flush();
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+  SDL_SetRenderTarget(renderer, NULL);
+}
+
+void render_snapshot(const frame_snapshot_t *snapshot) {
+  frame_stats = (render_stats_t){0};
+  render_sync_static(snapshot);
+  if (static_layer != NULL) {
+    render_update_trails(snapshot);
+  }
+  render_use_view(snapshot);
+  if (static_layer != NULL) {
+    if (!render_view_inside_arena(snapshot)) {
+      sdl_clear();
+    }
+    render_blit_layer(snapshot, static_layer);
+    if (trail_layer != NULL) {
+      render_blit_layer(snapshot, trail_layer);
+    }
+  } else {
+    sdl_clear();
+    render_walls(snapshot, snapshot->view_lower_left, snapshot->view_upper_right);
+  }
+  render_bodies(snapshot);
+  render_particles(snapshot);
+  batch_flush();
+  frame_stats.draw_calls += hud_draw(renderer, &snapshot->hud, 2 * screen_center.x, 2 * screen_center.y);
+  sdl_show();
+  stats = frame_stats;
+}
+
+bool render_has_vsync() {
+  SDL_RendererInfo info;
+  return SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+}
+
+render_stats_t render_get_stats() {
+  return stats;
+}
@@ -0,0 +1,242 @@
+#include "replay.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// file constants
+const char REPLAY_MAGIC[4] = {'T', 'T', 'R', 'P'};
+const uint8_t REPLAY_VERSION = 3; // raised whenever the simulation changes, so an older replay is refused instead of desyncing
+const size_t REPLAY_FLUSH_BYTES = 1 << 16;
+#define REPLAY_MAX_VARINT 10
+
+// input byte layout
+const uint8_t REPLAY_PLAYER_MASK = 0x3;
+const uint8_t REPLAY_ACTION_SHIFT = 2;
+const uint8_t REPLAY_ACTION_MASK = 0x7;
+const uint8_t REPLAY_PRESSED_BIT = 0x20;
+
+size_t put_varint(uint8_t *out, uint64_t value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length] = (value & 0x7f) | 0x80;
+    value = value >> 7;
+    length++;
+  }
+  out[length] = value;
+  return length + 1;
+}
+
+bool get_varint(replay_reader_t *reader, uint64_t *value) {
+  *value = 0;
+  for (size_t shift = 0; shift < 7 * REPLAY_MAX_VARINT; shift += 7) {
+    if (reader->offset == reader->size) {
+      return false;
+    }
+    uint8_t byte = reader->data[reader->offset];
+    reader->offset++;
+    *value |= (uint64_t)(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void replay_reserve(replay_writer_t *writer, size_t bytes) {
+  if (writer->length + bytes > writer->capacity) {
+    while (writer->length + bytes > writer->capacity) {
+      writer->capacity = writer->capacity * 2;
+    }
+    writer->buffer = realloc(writer->buffer, writer->capacity);
+    assert(writer->buffer != NULL);
+  }
+}
+
+void replay_put_varint(replay_writer_t *writer, uint64_t value) {
+  replay_reserve(writer, REPLAY_MAX_VARINT);
+  writer->length += put_varint(writer->buffer + writer->length, value);
+}
+
+void replay_put_bytes(replay_writer_t *writer, const void *bytes, size_t count) {
+  replay_reserve(writer, count);
+  memcpy(writer->buffer + writer->length, bytes, count);
+  writer->length += count;
+}
+
+void replay_flush(replay_writer_t *writer) {
+  fwrite(writer->buffer, 1, writer->length, writer->file);
+  fflush(writer->file);
+  writer->length = 0;
+}
+
+replay_writer_t *replay_writer_init(const char *path, replay_header_t header) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return NULL;
+  }
+  replay_writer_t *writer = malloc(sizeof(replay_writer_t));
+  assert(writer != NULL);
+  writer->file = file;
+  writer->capacity = REPLAY_FLUSH_BYTES * 2;
+  writer->buffer = malloc(writer->capacity);
+  writer->length = 0;
+  writer->input_capacity = 16;
+  writer->inputs = malloc(writer->input_capacity);
+  writer->input_count = 0;
+  writer->dt = 0;
+  writer->ticks = 0;
+  assert(writer->buffer != NULL && writer->inputs != NULL);
+
+  replay_put_bytes(writer, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+  replay_put_bytes(writer, &REPLAY_VERSION, 1);
+  replay_put_varint(writer, header.maze_columns);
+  replay_put_varint(writer, header.maze_rows);
+  uint8_t seed[8];
+  for (size_t i = 0; i < 8; i++) {
+    seed[i] = header.seed >> (8 * i);
+  }
+  replay_put_bytes(writer, seed, 8);
+  return writer;
+}
+
+void replay_record_input(replay_writer_t *writer, input_event_t event) {
+  if (writer->input_count == writer->input_capacity) {
+    writer->input_capacity = writer->input_capacity * 2;
+    writer->inputs = realloc(writer->inputs, writer->input_capacity);
+    assert(writer->inputs != NULL);
+  }
+  uint8_t byte = (event.player & REPLAY_PLAYER_MASK) | (event.action & REPLAY_ACTION_MASK) << REPLAY_ACTION_SHIFT;
+  if (event.pressed) {
+    byte |= REPLAY_PRESSED_BIT;
+  }
+  writer->inputs[writer->input_count] = byte;
+  writer->input_count++;
+}
+
+void replay_record_tick(replay_writer_t *writer, int64_t dt, uint32_t hash) {
+  bool dt_changed = dt != writer->dt;
+  replay_put_varint(writer, (uint64_t)writer->input_count << 1 | dt_changed);
+  if (dt_changed) {
+    replay_put_varint(writer, zigzag(dt - writer->dt));
+    writer->dt = dt;
+  }
+  replay_put_bytes(writer, writer->inputs, writer->input_count);
+  uint8_t bytes[4] = {hash, hash >> 8, hash >> 16, hash >> 24};
+  replay_put_bytes(writer, bytes, 4);
+  writer->input_count = 0;
+  writer->ticks++;
+  if (writer->length >= REPLAY_FLUSH_BYTES) {
+    replay_flush(writer);
+  }
+}
+
+void replay_writer_free(replay_writer_t *writer) {
+  replay_flush(writer);
+  fclose(writer->file);
+  free(writer->buffer);
+  free(writer->inputs);
+  free(writer);
+}
+
+replay_reader_t *replay_reader_init(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  replay_reader_t *reader = malloc(sizeof(replay_reader_t));
+  assert(reader != NULL);
+  reader->size = size > 0 ? size : 0;
+  reader->data = malloc(reader->size + 1);
+  assert(reader->data != NULL);
+  size_t read = fread(reader->data, 1, reader->size, file);
+  fclose(file);
+  reader->offset = 0;
+  reader->input_capacity = 16;
+  reader->inputs = malloc(sizeof(input_event_t) * reader->input_capacity);
+  assert(reader->inputs != NULL);
+  reader->dt = 0;
+  reader->ticks = 0;
+
+  uint64_t columns;
+  uint64_t rows;
+  size_t seed_offset;
+  bool valid = read == reader->size && reader->size >= sizeof(REPLAY_MAGIC) + 1
+               && memcmp(reader->data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) == 0
+               && reader->data[sizeof(REPLAY_MAGIC)] == REPLAY_VERSION;
+  if (valid) {
+    reader->offset = sizeof(REPLAY_MAGIC) + 1;
+    valid = get_varint(reader, &columns) && get_varint(reader, &rows);
+    seed_offset = reader->offset;
+    valid = valid && reader->size - seed_offset >= 8;
+  }
+  if (!valid) {
+    replay_reader_free(reader);
+    return NULL;
+  }
+  uint64_t seed = 0;
+  for (size_t i = 0; i < 8; i++) {
+    seed |= (uint64_t)reader->data[seed_offset + i] << (8 * i);
+  }
+  reader->offset = seed_offset + 8;
+  reader->header = (replay_header_t){.maze_columns = columns, .maze_rows = rows, .seed = seed};
+  return reader;
+}
+
+bool replay_read_tick(replay_reader_t *reader, replay_tick_t *tick) {
+  uint64_t head;
+  if (!get_varint(reader, &head)) {
+    return false;
+  }
+  size_t count = head >> 1;
+  if (head & 1) {
+    uint64_t change;
+    if (!get_varint(reader, &change)) {
+      return false;
+    }
+    reader->dt = reader->dt + unzigzag(change);
+  }
+  if (reader->size - reader->offset < count + 4) {
+    return false;
+  }
+  if (count > reader->input_capacity) {
+    reader->input_capacity = count;
+    reader->inputs = realloc(reader->inputs, sizeof(input_event_t) * count);
+    assert(reader->inputs != NULL);
+  }
+  for (size_t i = 0; i < count; i++) {
+    uint8_t byte = reader->data[reader->offset + i];
+    reader->inputs[i] = (input_event_t){
+      .player = byte & REPLAY_PLAYER_MASK,
+      .action = (byte >> REPLAY_ACTION_SHIFT) & REPLAY_ACTION_MASK,
+      .pressed = (byte & REPLAY_PRESSED_BIT) != 0,
+    };
+  }
+  reader->offset += count;
+  const uint8_t *hash = reader->data + reader->offset;
+  reader->offset += 4;
+  *tick = (replay_tick_t){
+    .inputs = reader->inputs,
+    .input_count = count,
+    .dt = reader->dt,
+    .hash = hash[0] | hash[1] << 8 | hash[2] << 16 | (uint32_t)hash[3] << 24,
+  };
+  reader->ticks++;
+  return true;
+}
+
+void replay_reader_free(replay_reader_t *reader) {
+  free(reader->data);
+  free(reader->inputs);
+  free(reader);
+}
@@ -0,0 +1,79 @@
+#include "rng.h"
+#include <assert.h>
+
+const uint64_t RNG_JUMP[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+uint64_t rotate_left(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * The splitmix64 generator, which spreads a seed over the four words of
+ * the state; xoshiro must not start from all zeros.
+ */
+uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+rng_t rng_init(uint64_t seed) {
+  rng_t rng;
+  for (size_t i = 0; i < 4; i++) {
+    rng.s[i] = splitmix64(&seed);
+  }
+  return rng;
+}
+
+uint64_t rng_next(rng_t *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotate_left(s[3], 45);
+  return result;
+}
+
+void rng_jump(rng_t *rng) {
+  uint64_t jumped[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < 4; i++) {
+    for (int bit = 0; bit < 64; bit++) {
+      if (RNG_JUMP[i] & ((uint64_t)1 << bit)) {
+        for (size_t k = 0; k < 4; k++) {
+          jumped[k] ^= rng->s[k];
+        }
+      }
+      rng_next(rng);
+    }
+  }
+  for (size_t k = 0; k < 4; k++) {
+    rng->s[k] = jumped[k];
+  }
+}
+
+rng_streams_t rng_streams_init(uint64_t seed) {
+  rng_streams_t streams;
+  streams.maze = rng_init(seed);
+  streams.spawns = streams.maze;
+  rng_jump(&streams.spawns);
+  streams.powerups = streams.spawns;
+  rng_jump(&streams.powerups);
+  streams.events = streams.powerups;
+  rng_jump(&streams.events);
+  return streams;
+}
+
+double rng_double(rng_t *rng) {
+  return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+size_t rng_below(rng_t *rng, size_t n) {
+  assert(n > 0);
+  // the high word of a 64 x 64 bit product; its bias is at most n / 2^64
+  return ((unsigned __int128)rng_next(rng) * n) >> 64;
+}
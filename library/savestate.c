@@ -0,0 +1,552 @@
+#include "savestate.h"
+#include "game.h"
+#include "tank.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// layout constants
+#define SAVED_PLAYERS 3
+#define SAVED_TANK_VERTICES 16
+#define SAVED_HITBOX_VERTICES 4
+#define SAVED_PROJECTILE_VERTICES 6
+#define SAVED_PARTICLE_FIELDS 14
+const size_t SAVESTATE_ALIGNMENT = 8;
+const size_t SAVESTATE_INITIAL_CAPACITY = 1 << 14;
+
+typedef struct saved_body {
+  vector_t center;
+  vector_t velocity;
+  double orientation;
+  double rotation;
+} saved_body_t;
+
+typedef struct saved_tank {
+  bool alive;
+  bool dying; // removed by the last tick; only the body is saved, for the moons still pulling on it
+  rgb_color_t color;
+  saved_body_t body;
+  saved_body_t hitbox;
+  size_t body_vertices;
+  size_t hitbox_vertices;
+  vector_t body_shape[SAVED_TANK_VERTICES];
+  vector_t hitbox_shape[SAVED_HITBOX_VERTICES];
+  mov_flags_t flags;
+  size_t bullets_onscreen;
+  projectile_kind_t shot;
+  size_t powerup_shots_left;
+  vector_t last_velocity;
+  double last_rotation;
+  double last_dt;
+} saved_tank_t;
+
+typedef struct saved_projectile {
+  projectile_kind_t kind;
+  size_t owner;
+  size_t slot;
+  size_t serial;
+  bool removed; // annihilated after the last scene tick; its forces still run once more
+  bool contact;
+  double decay;
+  saved_body_t body;
+  size_t vertices;
+  vector_t shape[SAVED_PROJECTILE_VERTICES];
+} saved_projectile_t;
+
+typedef struct saved_powerup {
+  powerup_type_t type;
+  vector_t center;
+  double phase;
+  rgb_color_t color;
+  size_t serial;
+} saved_powerup_t;
+
+/**
+ * The start of the buffer. The arrays whose lengths it gives follow it,
+ * each aligned to SAVESTATE_ALIGNMENT.
+ */
+typedef struct saved_header {
+  game_config_t config;
+  rng_streams_t rng;
+  rng_t maze_rng;
+  camera_t camera;
+  bool bullet_annihilation;
+  bool destructible_walls;
+  size_t red_wins;
+  size_t green_wins;
+  size_t blue_wins;
+  size_t games_played;
+  double dt;
+  double count_down_until_next_game_start;
+  double count_down_until_next_powerup;
+  double count_down_controls_hint;
+  char banner[HUD_BANNER_LENGTH];
+  size_t tank_controls;
+  size_t tick;
+  size_t maze_generation;
+  size_t maze_revision;
+  size_t dying_serial;
+  saved_tank_t tanks[SAVED_PLAYERS]; // red, green, blue
+  size_t projectile_count;
+  size_t next_serial;
+  size_t free_slot_count;
+  size_t powerup_count;
+  size_t powerup_next_serial;
+  size_t cell_count;
+  size_t particle_count;
+} saved_header_t;
+
+/**
+ * Where each array starts in the buffer.
+ */
+typedef struct savestate_layout {
+  size_t projectiles;
+  size_t free_slots;
+  size_t powerups;
+  size_t cell_walls;
+  size_t particles;
+  size_t length;
+} savestate_layout_t;
+
+size_t savestate_align(size_t offset) {
+  return (offset + SAVESTATE_ALIGNMENT - 1) / SAVESTATE_ALIGNMENT * SAVESTATE_ALIGNMENT;
+}
+
+savestate_layout_t savestate_layout(const saved_header_t *header) {
+  savestate_layout_t layout;
+  layout.projectiles = savestate_align(sizeof(saved_header_t));
+  layout.free_slots = savestate_align(layout.projectiles + sizeof(saved_projectile_t) * header->projectile_count);
+  layout.powerups = savestate_align(layout.free_slots + sizeof(size_t) * header->free_slot_count);
+  layout.cell_walls = savestate_align(layout.powerups + sizeof(saved_powerup_t) * header->powerup_count);
+  layout.particles = savestate_align(layout.cell_walls + header->cell_count);
+  layout.length = layout.particles + sizeof(float) * SAVED_PARTICLE_FIELDS * header->particle_count;
+  return layout;
+}
+
+/**
+ * The particle arrays in the order they are saved in.
+ */
+void particle_fields(particle_system_t *particles, float **fields) {
+  float *all[SAVED_PARTICLE_FIELDS] = {
+    particles->x, particles->y, particles->vx, particles->vy, particles->angle, particles->spin,
+    particles->life, particles->size, particles->r, particles->g, particles->b,
+    particles->hue, particles->saturation, particles->value,
+  };
+  memcpy(fields, all, sizeof(all));
+}
+
+savestate_t *savestate_init() {
+  savestate_t *savestate = malloc(sizeof(savestate_t));
+  assert(savestate != NULL);
+  savestate->capacity = SAVESTATE_INITIAL_CAPACITY;
+  savestate->data = malloc(savestate->capacity);
+  assert(savestate->data != NULL);
+  savestate->length = 0;
+  return savestate;
+}
+
+void savestate_free(savestate_t *savestate) {
+  free(savestate->data);
+  free(savestate);
+}
+
+saved_body_t save_body(body_t *body) {
+  return (saved_body_t){
+    .center = body->center,
+    .velocity = body->velocity,
+    .orientation = body->orientation,
+    .rotation = body->rotation,
+  };
+}
+
+void load_body(body_t *body, const saved_body_t *saved) {
+  body->center = saved->center;
+  body->velocity = saved->velocity;
+  body->orientation = saved->orientation;
+  body->rotation = saved->rotation;
+}
+
+size_t save_shape(list_t *shape, vector_t *vertices, size_t capacity) {
+  size_t count = list_size(shape);
+  assert(count <= capacity);
+  for (size_t i = 0; i < count; i++) {
+    vertices[i] = *(vector_t *)list_get(shape, i);
+  }
+  return count;
+}
+
+void load_shape(list_t *shape, const vector_t *vertices, size_t count) {
+  assert(list_size(shape) == count);
+  for (size_t i = 0; i < count; i++) {
+    *(vector_t *)list_get(shape, i) = vertices[i];
+  }
+}
+
+list_t *new_shape(const vector_t *vertices, size_t count) {
+  list_t *shape = list_init(count, free);
+  for (size_t i = 0; i < count; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    *vertex = vertices[i];
+    list_add(shape, vertex);
+  }
+  return shape;
+}
+
+void save_tank(saved_tank_t *saved, tank_t *tank, body_t *dying_body) {
+  saved->alive = tank != NULL;
+  saved->dying = dying_body != NULL;
+  if (dying_body != NULL) {
+    saved->color = dying_body->color;
+    saved->body = save_body(dying_body);
+    saved->body_vertices = save_shape(dying_body->shape, saved->body_shape, SAVED_TANK_VERTICES);
+  }
+  if (tank == NULL) {
+    return;
+  }
+  saved->color = tank->body->color;
+  saved->body = save_body(tank->body);
+  saved->hitbox = save_body(tank->hitbox);
+  saved->body_vertices = save_shape(tank->body->shape, saved->body_shape, SAVED_TANK_VERTICES);
+  saved->hitbox_vertices = save_shape(tank->hitbox->shape, saved->hitbox_shape, SAVED_HITBOX_VERTICES);
+  saved->flags = *tank->mov_flags;
+  saved->bullets_onscreen = tank->bullets_onscreen;
+  saved->shot = shot_kind(tank->bang);
+  saved->powerup_shots_left = tank->powerup_shots_left;
+  saved->last_velocity = tank->last_velocity;
+  saved->last_rotation = tank->last_rotation;
+  saved->last_dt = tank->last_dt;
+}
+
+tank_t *load_tank(state_t *state, const saved_tank_t *saved) {
+  if (!saved->alive) {
+    return NULL;
+  }
+  tank_t *tank = tank_player_init_force(state, saved->body.center, saved->color);
+  load_body(tank->body, &saved->body);
+  load_body(tank->hitbox, &saved->hitbox);
+  load_shape(tank->body->shape, saved->body_shape, saved->body_vertices);
+  load_shape(tank->hitbox->shape, saved->hitbox_shape, saved->hitbox_vertices);
+  *tank->mov_flags = saved->flags;
+  tank->bullets_onscreen = saved->bullets_onscreen;
+  tank->bang = shot_handler(saved->shot);
+  tank->powerup_shots_left = saved->powerup_shots_left;
+  tank->last_velocity = saved->last_velocity;
+  tank->last_rotation = saved->last_rotation;
+  tank->last_dt = saved->last_dt;
+  return tank;
+}
+
+/**
+ * Puts back the body of a tank removed by the last tick, still in the
+ * scene until its next tick, so the moons shot before can pull on it.
+ */
+body_t *load_dying_body(state_t *state, const saved_tank_t *saved) {
+  if (!saved->dying) {
+    return NULL;
+  }
+  body_t *body = tank_body_init(new_shape(saved->body_shape, saved->body_vertices), saved->color);
+  load_body(body, &saved->body);
+  scene_add_body(state->scene, body);
+  return body;
+}
+
+void savestate_capture(savestate_t *savestate, state_t *state) {
+  projectile_pool_t *projectiles = state->projectiles;
+  powerup_pool_t *powerups = state->powerups;
+  maze_t *maze = state->maze;
+  saved_header_t counts = {
+    .projectile_count = projectiles->capacity - projectiles->free_count,
+    .next_serial = projectiles->next_serial,
+    .free_slot_count = projectiles->free_count,
+    .powerup_count = powerups->capacity - powerups->free_count,
+    .powerup_next_serial = powerups->next_serial,
+    .cell_count = maze->columns * maze->rows,
+    .particle_count = state->particles->count,
+  };
+  savestate_layout_t layout = savestate_layout(&counts);
+  if (layout.length > savestate->capacity) {
+    while (layout.length > savestate->capacity) {
+      savestate->capacity = savestate->capacity * 2;
+    }
+    savestate->data = realloc(savestate->data, savestate->capacity);
+    assert(savestate->data != NULL);
+  }
+  savestate->length = layout.length;
+  // no stale bytes in the padding, so two captures of the same match compare equal
+  memset(savestate->data, 0, layout.length);
+
+  saved_header_t *header = (saved_header_t *)savestate->data;
+  *header = counts;
+  header->config = state->config;
+  header->rng = state->rng;
+  header->maze_rng = state->maze_rng;
+  header->camera = state->camera;
+  header->bullet_annihilation = state->bullet_annihilation;
+  header->destructible_walls = state->destructible_walls;
+  header->red_wins = state->red_wins;
+  header->green_wins = state->green_wins;
+  header->blue_wins = state->blue_wins;
+  header->games_played = state->games_played;
+  header->dt = state->dt;
+  header->count_down_until_next_game_start = state->count_down_until_next_game_start;
+  header->count_down_until_next_powerup = state->count_down_until_next_powerup;
+  header->count_down_controls_hint = state->count_down_controls_hint;
+  memcpy(header->banner, state->banner, HUD_BANNER_LENGTH);
+  header->tank_controls = state->tank_controls;
+  header->tick = state->tick;
+  header->maze_generation = state->maze_generation;
+  header->maze_revision = maze->revision;
+  header->dying_serial = state->dying_serial;
+  for (size_t i = 0; i < SAVED_PLAYERS; i++) {
+    save_tank(&header->tanks[i], player_tank(state, i), state->dying_bodies[i]);
+  }
+
+  saved_projectile_t *saved = (saved_projectile_t *)(savestate->data + layout.projectiles);
+  size_t count = 0;
+  for (size_t i = 0; i < projectiles->capacity; i++) {
+    body_t *body = projectiles->bodies[i];
+    if (body == NULL) {
+      continue;
+    }
+    projectile_info_t *info = &projectiles->infos[i];
+    saved[count] = (saved_projectile_t){
+      .kind = info->kind,
+      .owner = info->owner,
+      .slot = i,
+      .serial = projectiles->serials[i],
+      .removed = body_is_removed(body),
+      .contact = info->contact != NULL && info->contact->bol,
+      .decay = info->decay != NULL ? info->decay->time : 0,
+      .body = save_body(body),
+    };
+    saved[count].vertices = save_shape(body->shape, saved[count].shape, SAVED_PROJECTILE_VERTICES);
+    count++;
+  }
+  assert(count == header->projectile_count);
+  memcpy(savestate->data + layout.free_slots, projectiles->free_slots, sizeof(size_t) * projectiles->free_count);
+
+  saved_powerup_t *saved_powerups = (saved_powerup_t *)(savestate->data + layout.powerups);
+  count = 0;
+  for (size_t i = 0; i < powerups->capacity; i++) {
+    powerup_pulse_t *pulse = powerups->pulses[i];
+    if (pulse == NULL) {
+      continue;
+    }
+    saved_powerups[count] = (saved_powerup_t){
+      .type = pulse->type,
+      .center = pulse->body->center,
+      .phase = pulse->phase,
+      .color = pulse->body->color,
+      .serial = pulse->serial,
+    };
+    count++;
+  }
+  assert(count == header->powerup_count);
+
+  memcpy(savestate->data + layout.cell_walls, maze->cell_walls, header->cell_count);
+  float *fields[SAVED_PARTICLE_FIELDS];
+  particle_fields(state->particles, fields);
+  float *particles = (float *)(savestate->data + layout.particles);
+  for (size_t i = 0; i < SAVED_PARTICLE_FIELDS; i++) {
+    memcpy(particles + i * header->particle_count, fields[i], sizeof(float) * header->particle_count);
+  }
+}
+
+/**
+ * Gives the maze the saved walls. The same walls need nothing; otherwise
+ * the maze is drawn again from the stream it came from and the walls
+ * destroyed since are knocked down again, and every cell is marked dirty
+ * so the renderer redraws the whole maze.
+ */
+void restore_maze(state_t *state, const saved_header_t *header, const uint8_t *cell_walls) {
+  maze_t *maze = state->maze;
+  if (memcmp(maze->cell_walls, cell_walls, header->cell_count) == 0) {
+    maze->revision = header->maze_revision;
+    return;
+  }
+  size_t columns = maze->columns;
+  size_t rows = maze->rows;
+  vector_t lower_left = maze->lower_left;
+  vector_t upper_right = maze->upper_right;
+  maze_free(maze);
+  rng_t rng = header->maze_rng;
+  maze = maze_init(columns, rows, lower_left, upper_right, &rng);
+  state->maze = maze;
+  for (size_t y = 0; y < rows; y++) {
+    for (size_t x = 0; x < columns; x++) {
+      size_t index = x + columns * y;
+      uint8_t destroyed = maze->cell_walls[index] & ~cell_walls[index];
+      if (destroyed & WALL_RIGHT) {
+        maze_destroy_wall(maze, true, (columns + 1) * y + x + 1);
+      }
+      if (destroyed & WALL_UP) {
+        maze_destroy_wall(maze, false, (rows + 1) * x + y + 1);
+      }
+    }
+  }
+  assert(memcmp(maze->cell_walls, cell_walls, header->cell_count) == 0);
+  maze->revision = header->maze_revision;
+  for (size_t i = 0; i < header->cell_count; i++) {
+    maze->dirty_cells[i] = i;
+  }
+  maze->dirty_count = header->cell_count;
+}
+
+/**
+ * Adds the saved projectiles in the order they were first added, so their
+ * force creators run in the same order, each into the slot it was saved
+ * from with the serial it had, and leaves the registry's free slots as
+ * they were.
+ */
+void restore_projectiles(state_t *state, const saved_projectile_t *saved, size_t count, size_t next_serial,
+                         const size_t *free_slots, size_t free_count) {
+  projectile_pool_t *projectiles = state->projectiles;
+  size_t *order = malloc(sizeof(size_t) * (count + 1));
+  size_t *slots = malloc(sizeof(size_t) * (free_count + count + 1));
+  assert(order != NULL && slots != NULL);
+  for (size_t i = 0; i < count; i++) {
+    size_t k = i;
+    while (k > 0 && saved[order[k - 1]].serial > saved[i].serial) {
+      order[k] = order[k - 1];
+      k--;
+    }
+    order[k] = i;
+  }
+  memcpy(slots, free_slots, sizeof(size_t) * free_count);
+  for (size_t i = 0; i < count; i++) {
+    slots[free_count + i] = saved[order[count - 1 - i]].slot;
+  }
+  projectiles_set_free_slots(projectiles, slots, free_count + count);
+
+  for (size_t i = 0; i < count; i++) {
+    const saved_projectile_t *projectile = &saved[order[i]];
+    body_t *body = projectile_body(projectile->kind, new_shape(projectile->shape, projectile->vertices));
+    load_body(body, &projectile->body);
+    projectiles->next_serial = projectile->serial;
+    projectile_attach(state, body, projectile->kind, projectile->owner);
+    assert(projectiles->bodies[projectile->slot] == body);
+    projectile_info_t *info = &projectiles->infos[projectile->slot];
+    if (info->decay != NULL) {
+      info->decay->time = projectile->decay;
+    }
+    if (info->contact != NULL) {
+      info->contact->bol = projectile->contact;
+    }
+    if (projectile->removed) {
+      body_remove(body);
+    }
+  }
+  projectiles_set_free_slots(projectiles, free_slots, free_count);
+  projectiles->next_serial = next_serial;
+  free(order);
+  free(slots);
+}
+
+/**
+ * Adds the saved powerups back in the order they were first added, which
+ * is the order the scene resolves a tank touching several of them in.
+ */
+void restore_powerups(state_t *state, const saved_powerup_t *saved, size_t count, size_t next_serial) {
+  size_t *order = malloc(sizeof(size_t) * (count + 1));
+  assert(order != NULL);
+  for (size_t i = 0; i < count; i++) {
+    size_t k = i;
+    while (k > 0 && saved[order[k - 1]].serial > saved[i].serial) {
+      order[k] = order[k - 1];
+      k--;
+    }
+    order[k] = i;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const saved_powerup_t *powerup = &saved[order[i]];
+    powerup_pulse_t *pulse = powerup_spawn(state, powerup->type, powerup->center);
+    pulse->phase = powerup->phase;
+    pulse->serial = powerup->serial;
+    pulse->body->color = powerup->color;
+  }
+  state->powerups->next_serial = next_serial;
+  free(order);
+}
+
+bool savestate_restore(const savestate_t *savestate, state_t *state) {
+  const saved_header_t *header = (const saved_header_t *)savestate->data;
+  if (header->config.maze_columns != state->config.maze_columns
+      || header->config.maze_rows != state->config.maze_rows
+      || header->cell_count != state->maze->columns * state->maze->rows) {
+    return false;
+  }
+  savestate_layout_t layout = savestate_layout(header);
+  assert(layout.length == savestate->length);
+  assert(header->particle_count <= state->particles->capacity);
+
+  // the scene frees the bodies and auxes, but the tanks themselves are the game's
+  for (size_t i = 0; i < SAVED_PLAYERS; i++) {
+    tank_t *tank = player_tank(state, i);
+    if (tank != NULL) {
+      free(tank->mov_flags);
+      free(tank);
+    }
+  }
+  state->red_player = NULL;
+  state->green_player = NULL;
+  state->blue_player = NULL;
+  scene_free(state->scene);
+  state->scene = scene_init();
+  restore_maze(state, header, savestate->data + layout.cell_walls);
+
+  state->config = header->config;
+  state->rng = header->rng;
+  state->maze_rng = header->maze_rng;
+  state->camera = header->camera;
+  state->bullet_annihilation = header->bullet_annihilation;
+  state->destructible_walls = header->destructible_walls;
+  state->red_wins = header->red_wins;
+  state->green_wins = header->green_wins;
+  state->blue_wins = header->blue_wins;
+  state->games_played = header->games_played;
+  state->dt = header->dt;
+  state->count_down_until_next_game_start = header->count_down_until_next_game_start;
+  state->count_down_until_next_powerup = header->count_down_until_next_powerup;
+  state->count_down_controls_hint = header->count_down_controls_hint;
+  memcpy(state->banner, header->banner, HUD_BANNER_LENGTH);
+  state->tank_controls = header->tank_controls;
+  state->tick = header->tick;
+  state->maze_generation = header->maze_generation;
+  // the logged inputs belong to a tick that has been undone
+  state->input_count = 0;
+
+  // in the order spawn_players() adds them
+  state->red_player = load_tank(state, &header->tanks[0]);
+  state->blue_player = load_tank(state, &header->tanks[2]);
+  state->green_player = load_tank(state, &header->tanks[1]);
+  state->dying_serial = header->dying_serial;
+  for (size_t i = 0; i < SAVED_PLAYERS; i++) {
+    state->dying_bodies[i] = load_dying_body(state, &header->tanks[i]);
+  }
+
+  restore_projectiles(state, (const saved_projectile_t *)(savestate->data + layout.projectiles),
+                      header->projectile_count, header->next_serial,
+                      (const size_t *)(savestate->data + layout.free_slots), header->free_slot_count);
+  for (size_t i = 0; i < SAVED_PLAYERS; i++) {
+    if (state->dying_bodies[i] != NULL) {
+      body_remove(state->dying_bodies[i]);
+    }
+  }
+
+  restore_powerups(state, (const saved_powerup_t *)(savestate->data + layout.powerups), header->powerup_count,
+                   header->powerup_next_serial);
+
+  float *fields[SAVED_PARTICLE_FIELDS];
+  particle_fields(state->particles, fields);
+  const float *particles = (const float *)(savestate->data + layout.particles);
+  for (size_t i = 0; i < SAVED_PARTICLE_FIELDS; i++) {
+    memcpy(fields[i], particles + i * header->particle_count, sizeof(float) * header->particle_count);
+  }
+  state->particles->count = header->particle_count;
+  return true;
+}
+
+game_config_t savestate_config(const savestate_t *savestate) {
+  return ((const saved_header_t *)savestate->data)->config;
+}
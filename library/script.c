@@ -0,0 +1,142 @@
+#include "script.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// built-in script constants, in ticks; each player is offset so the tanks do not move in lockstep
+const size_t PATTERN_PERIOD = 120;
+const size_t PATTERN_TURN_START = 60;
+const size_t PATTERN_TURN_LENGTH = 25;
+const size_t PATTERN_PLAYER_OFFSET = 10;
+const size_t PATTERN_SHOT_PERIOD = 40;
+
+#define SCRIPT_MAX_LINE 128
+
+const char *ACTION_NAMES[INPUT_ACTION_COUNT] = {
+  [INPUT_FORWARD] = "forward",
+  [INPUT_BACKWARD] = "backward",
+  [INPUT_LEFT] = "left",
+  [INPUT_RIGHT] = "right",
+  [INPUT_SHOOT] = "shoot",
+};
+
+void script_free(script_t *script) {
+  free(script->inputs);
+  free(script);
+}
+
+script_t *script_load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Could not open %s\n", path);
+    return NULL;
+  }
+  script_t *script = malloc(sizeof(script_t));
+  assert(script != NULL);
+  script->count = 0;
+  script->capacity = 64;
+  script->inputs = malloc(sizeof(scripted_input_t) * script->capacity);
+  assert(script->inputs != NULL);
+  char line[SCRIPT_MAX_LINE];
+  size_t line_number = 0;
+  while (fgets(line, SCRIPT_MAX_LINE, file) != NULL) {
+    line_number = line_number + 1;
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    size_t tick;
+    unsigned player;
+    char action[16];
+    char direction[8];
+    if (sscanf(line, "%zu %u %15s %7s", &tick, &player, action, direction) != 4) {
+      fprintf(stderr, "%s:%zu: expected <tick> <player> <action> <down|up>\n", path, line_number);
+      fclose(file);
+      script_free(script);
+      return NULL;
+    }
+    size_t id = 0;
+    while (id < INPUT_ACTION_COUNT && strcmp(action, ACTION_NAMES[id]) != 0) {
+      id++;
+    }
+    bool valid_tick = script->count == 0 || tick >= script->inputs[script->count - 1].tick;
+    if (id == INPUT_ACTION_COUNT || player >= INPUT_PLAYERS || !valid_tick) {
+      fprintf(stderr, "%s:%zu: invalid input\n", path, line_number);
+      fclose(file);
+      script_free(script);
+      return NULL;
+    }
+    if (script->count == script->capacity) {
+      script->capacity = script->capacity * 2;
+      script->inputs = realloc(script->inputs, sizeof(scripted_input_t) * script->capacity);
+      assert(script->inputs != NULL);
+    }
+    script->inputs[script->count] = (scripted_input_t){
+      .tick = tick,
+      .event = {.player = player, .action = id, .pressed = strcmp(direction, "down") == 0},
+    };
+    script->count = script->count + 1;
+  }
+  fclose(file);
+  script->period = script->count > 0 ? script->inputs[script->count - 1].tick + 1 : 1;
+  return script;
+}
+
+void script_apply(script_t *script, state_t *state, size_t tick, size_t *next) {
+  size_t local = tick % script->period;
+  if (local == 0) {
+    *next = 0;
+  }
+  while (*next < script->count && script->inputs[*next].tick <= local) {
+    game_apply_input(state, script->inputs[*next].event);
+    *next = *next + 1;
+  }
+}
+
+void press(state_t *state, size_t player, input_action_t action, bool pressed) {
+  game_apply_input(state, (input_event_t){.player = player, .action = action, .pressed = pressed});
+}
+
+void script_apply_pattern(state_t *state, size_t tick) {
+  for (size_t player = 0; player < INPUT_PLAYERS; player++) {
+    size_t local = (tick + player * PATTERN_PLAYER_OFFSET) % PATTERN_PERIOD;
+    input_action_t turn = player % 2 == 0 ? INPUT_LEFT : INPUT_RIGHT;
+    if (local == 0) {
+      press(state, player, INPUT_FORWARD, true);
+    } else if (local == PATTERN_TURN_START) {
+      press(state, player, INPUT_FORWARD, false);
+      press(state, player, turn, true);
+    } else if (local == PATTERN_TURN_START + PATTERN_TURN_LENGTH) {
+      press(state, player, turn, false);
+    }
+    size_t shot = (tick + player * PATTERN_PLAYER_OFFSET) % PATTERN_SHOT_PERIOD;
+    if (shot == 0) {
+      press(state, player, INPUT_SHOOT, true);
+    } else if (shot == 1) {
+      press(state, player, INPUT_SHOOT, false);
+    }
+  }
+}
+
+void script_play(state_t *state, size_t ticks, double dt) {
+  for (size_t i = 0; i < ticks; i++) {
+    script_apply_pattern(state, state->tick);
+    game_tick(state, dt);
+  }
+}
+
+uint8_t script_pattern_buttons(size_t player, size_t tick) {
+  size_t local = (tick + player * PATTERN_PLAYER_OFFSET) % PATTERN_PERIOD;
+  input_action_t turn = player % 2 == 0 ? INPUT_LEFT : INPUT_RIGHT;
+  uint8_t buttons = 0;
+  if (local < PATTERN_TURN_START) {
+    buttons = buttons | 1 << INPUT_FORWARD;
+  } else if (local < PATTERN_TURN_START + PATTERN_TURN_LENGTH) {
+    buttons = buttons | 1 << turn;
+  }
+  if ((tick + player * PATTERN_PLAYER_OFFSET) % PATTERN_SHOT_PERIOD == 0) {
+    buttons = buttons | 1 << INPUT_SHOOT;
+  }
+  return buttons;
+}
+
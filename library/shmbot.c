@@ -0,0 +1,96 @@
+#include "botlink.h"
+#include "clock.h"
+#include <assert.h>
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TAU (6.28318530717958)
+
+// bot constants
+const double SHMBOT_AIM = .08; // radians off target at which the bot fires
+const double SHMBOT_DRIVE = .6; // radians off target within which it drives forward
+const double SHMBOT_ATTACH_INTERVAL = .05; // seconds between attempts to find the game
+
+/**
+ * Turns a tank toward the nearest other tank, drives at it when roughly
+ * facing it and fires when lined up. It ignores walls; it only shows how
+ * an agent reads observations and answers them.
+ */
+uint8_t shmbot_buttons(const botlink_observation_t *observation, size_t self) {
+  const botlink_tank_t *tank = &observation->tanks[self];
+  if (!tank->alive) {
+    return 0;
+  }
+  double best = INFINITY;
+  double bearing = 0;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    const botlink_tank_t *other = &observation->tanks[i];
+    if (i == self || !other->alive) {
+      continue;
+    }
+    double dx = other->x - tank->x;
+    double dy = other->y - tank->y;
+    if (dx * dx + dy * dy < best) {
+      best = dx * dx + dy * dy;
+      bearing = atan2(dy, dx);
+    }
+  }
+  if (best == INFINITY) {
+    return 0;
+  }
+  double off = remainder(bearing - tank->angle, TAU);
+  uint8_t buttons = 1 << (off > 0 ? INPUT_LEFT : INPUT_RIGHT);
+  if (fabs(off) < SHMBOT_DRIVE) {
+    buttons = buttons | 1 << INPUT_FORWARD;
+  }
+  // shoot is an edge, so it is released every other tick
+  if (fabs(off) < SHMBOT_AIM && observation->tick % 2 == 0) {
+    buttons = buttons | 1 << INPUT_SHOOT;
+  }
+  return buttons;
+}
+
+/**
+ * An example bot process: attaches to a game started with
+ * `headless --bots <name>`, drives every tank, and stops when the game
+ * does.
+ *
+ * Usage: shmbot <shared memory name>
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: shmbot <shared memory name>\n");
+    return 1;
+  }
+  botlink_t *link;
+  while ((link = botlink_attach(argv[1])) == NULL) {
+    struct timespec interval = {.tv_sec = 0, .tv_nsec = SHMBOT_ATTACH_INTERVAL * 1e9};
+    nanosleep(&interval, NULL);
+  }
+  botlink_observation_t *observation = malloc(sizeof(botlink_observation_t));
+  assert(observation != NULL);
+  size_t answered = 0;
+  double think_time = 0;
+  while (!atomic_load_explicit(&link->shared->closed, memory_order_acquire)) {
+    if (!botlink_next_observation(link, observation)) {
+      sched_yield();
+      continue;
+    }
+    double start = clock_now();
+    uint8_t buttons[INPUT_PLAYERS];
+    for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+      buttons[i] = shmbot_buttons(observation, i);
+    }
+    think_time = think_time + clock_now() - start;
+    botlink_send_controls(link, buttons, observation->sequence);
+    answered = answered + 1;
+  }
+  printf("answered %zu observations, %.2f us thinking each\n", answered,
+         answered > 0 ? think_time * 1e6 / answered : 0);
+  free(observation);
+  botlink_free(link);
+  return 0;
+}
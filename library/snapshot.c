@@ -0,0 +1,264 @@
+#include "snapshot.h"
+#include "powerups.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// snapshot_buffer_t.middle holds a slot index, plus this bit when it is newer than front
+const size_t SNAPSHOT_FRESH = 4;
+
+snapshot_buffer_t *snapshot_buffer_init() {
+  snapshot_buffer_t *buffer = calloc(1, sizeof(snapshot_buffer_t));
+  assert(buffer != NULL);
+  buffer->back = 0;
+  atomic_init(&buffer->middle, 1);
+  buffer->front = 2;
+  buffer->has_front = false;
+  return buffer;
+}
+
+void snapshot_free_slot(frame_snapshot_t *snapshot) {
+  free(snapshot->wall_xy);
+  free(snapshot->wall_colors);
+  free(snapshot->dirty_cells);
+  free(snapshot->polygon_sizes);
+  free(snapshot->polygon_offsets);
+  free(snapshot->polygon_cells);
+  free(snapshot->polygon_colors);
+  free(snapshot->cell_start);
+  free(snapshot->cell_polygons);
+  free(snapshot->xy);
+  free(snapshot->particle_x);
+  free(snapshot->particle_y);
+  free(snapshot->particle_angle);
+  free(snapshot->particle_size);
+  free(snapshot->particle_colors);
+}
+
+void snapshot_buffer_free(snapshot_buffer_t *buffer) {
+  for (size_t i = 0; i < 3; i++) {
+    snapshot_free_slot(&buffer->slots[i]);
+  }
+  free(buffer);
+}
+
+frame_snapshot_t *snapshot_begin_write(snapshot_buffer_t *buffer) {
+  return &buffer->slots[buffer->back];
+}
+
+void snapshot_publish(snapshot_buffer_t *buffer) {
+  size_t previous = atomic_exchange(&buffer->middle, buffer->back | SNAPSHOT_FRESH);
+  buffer->back = previous & ~SNAPSHOT_FRESH;
+}
+
+frame_snapshot_t *snapshot_acquire(snapshot_buffer_t *buffer) {
+  if (atomic_load(&buffer->middle) & SNAPSHOT_FRESH) {
+    size_t previous = atomic_exchange(&buffer->middle, buffer->front);
+    buffer->front = previous & ~SNAPSHOT_FRESH;
+    buffer->has_front = true;
+  }
+  return buffer->has_front ? &buffer->slots[buffer->front] : NULL;
+}
+
+/**
+ * Grows an array so it holds at least needed elements, doubling its capacity.
+ */
+void *snapshot_reserve(void *array, size_t *capacity, size_t needed, size_t element_size) {
+  if (needed <= *capacity) {
+    return array;
+  }
+  size_t grown = *capacity > 0 ? *capacity : 64;
+  while (grown < needed) {
+    grown *= 2;
+  }
+  void *resized = realloc(array, grown * element_size);
+  assert(resized != NULL);
+  *capacity = grown;
+  return resized;
+}
+
+void snapshot_reserve_walls(frame_snapshot_t *snapshot, size_t walls) {
+  size_t capacity = snapshot->wall_capacity;
+  snapshot->wall_xy = snapshot_reserve(snapshot->wall_xy, &capacity, walls, 8 * sizeof(float));
+  capacity = snapshot->wall_capacity;
+  snapshot->wall_colors = snapshot_reserve(snapshot->wall_colors, &capacity, walls, sizeof(rgb_color_t));
+  snapshot->wall_capacity = capacity;
+}
+
+void snapshot_capture_walls(frame_snapshot_t *snapshot, list_t *walls) {
+  for (size_t i = 0; i < list_size(walls); i++) {
+    body_t *wall = list_get(walls, i);
+    if (wall->info == NULL) {
+      continue;
+    }
+    float *xy = &snapshot->wall_xy[8 * snapshot->wall_count];
+    for (size_t k = 0; k < 4; k++) {
+      vector_t *point = list_get(wall->shape, k);
+      xy[2 * k] = point->x;
+      xy[2 * k + 1] = point->y;
+    }
+    snapshot->wall_colors[snapshot->wall_count] = wall->color;
+    snapshot->wall_count++;
+  }
+}
+
+void snapshot_capture_maze(state_t *state, frame_snapshot_t *snapshot) {
+  maze_t *maze = state->maze;
+  snapshot->lower_left = maze->lower_left;
+  snapshot->upper_right = maze->upper_right;
+  snapshot->columns = maze->columns;
+  snapshot->rows = maze->rows;
+  snapshot->maze_generation = state->maze_generation;
+  snapshot->revision = maze->revision;
+  snapshot->revision_before = maze->revision;
+  snapshot->wall_count = 0;
+  snapshot_reserve_walls(snapshot, list_size(maze->vertical_walls) + list_size(maze->horizontal_walls));
+  snapshot_capture_walls(snapshot, maze->vertical_walls);
+  snapshot_capture_walls(snapshot, maze->horizontal_walls);
+
+  // each wall destroyed since the last capture dirtied two cells
+  snapshot->dirty_cells = snapshot_reserve(snapshot->dirty_cells, &snapshot->dirty_capacity,
+                                           maze->dirty_count, sizeof(size_t));
+  memcpy(snapshot->dirty_cells, maze->dirty_cells, sizeof(size_t) * maze->dirty_count);
+  snapshot->dirty_count = maze->dirty_count;
+  if (maze->dirty_count > 0) {
+    snapshot->revision_before = state->captured_revision;
+  }
+  state->captured_revision = maze->revision;
+  maze_clear_dirty(maze);
+}
+
+void snapshot_reserve_polygons(frame_snapshot_t *snapshot, size_t polygons) {
+  if (polygons <= snapshot->polygon_capacity) {
+    return;
+  }
+  size_t capacity = snapshot->polygon_capacity;
+  snapshot->polygon_sizes = snapshot_reserve(snapshot->polygon_sizes, &capacity, polygons, sizeof(uint32_t));
+  capacity = snapshot->polygon_capacity;
+  snapshot->polygon_offsets = snapshot_reserve(snapshot->polygon_offsets, &capacity, polygons, sizeof(uint32_t));
+  capacity = snapshot->polygon_capacity;
+  snapshot->polygon_cells = snapshot_reserve(snapshot->polygon_cells, &capacity, polygons, sizeof(uint32_t));
+  capacity = snapshot->polygon_capacity;
+  snapshot->cell_polygons = snapshot_reserve(snapshot->cell_polygons, &capacity, polygons, sizeof(uint32_t));
+  capacity = snapshot->polygon_capacity;
+  snapshot->polygon_colors = snapshot_reserve(snapshot->polygon_colors, &capacity, polygons, sizeof(rgb_color_t));
+  snapshot->polygon_capacity = capacity;
+}
+
+/**
+ * Returns the bucket of a polygon: the maze cell holding the center of its
+ * bounding box (clamped to the maze), or the last bucket if the polygon is
+ * larger than a cell and could reach past the neighbouring cells.
+ */
+uint32_t snapshot_polygon_cell(frame_snapshot_t *snapshot, const float *xy, size_t count) {
+  float min_x = xy[0];
+  float max_x = xy[0];
+  float min_y = xy[1];
+  float max_y = xy[1];
+  for (size_t k = 1; k < count; k++) {
+    min_x = fminf(min_x, xy[2 * k]);
+    max_x = fmaxf(max_x, xy[2 * k]);
+    min_y = fminf(min_y, xy[2 * k + 1]);
+    max_y = fmaxf(max_y, xy[2 * k + 1]);
+  }
+  double edge_horizontal = (snapshot->upper_right.x - snapshot->lower_left.x) / snapshot->columns;
+  double edge_vertical = (snapshot->upper_right.y - snapshot->lower_left.y) / snapshot->rows;
+  if (max_x - min_x > edge_horizontal || max_y - min_y > edge_vertical) {
+    return snapshot->columns * snapshot->rows;
+  }
+  double column = floor(((min_x + max_x) / 2 - snapshot->lower_left.x) / edge_horizontal);
+  double row = floor(((min_y + max_y) / 2 - snapshot->lower_left.y) / edge_vertical);
+  column = fmin(fmax(column, 0), snapshot->columns - 1);
+  row = fmin(fmax(row, 0), snapshot->rows - 1);
+  return (uint32_t) row * snapshot->columns + (uint32_t) column;
+}
+
+/**
+ * Counting-sorts the polygons into their cell buckets.
+ */
+void snapshot_bucket_polygons(frame_snapshot_t *snapshot) {
+  size_t buckets = snapshot->columns * snapshot->rows + 1;
+  snapshot->cell_start = snapshot_reserve(snapshot->cell_start, &snapshot->cell_capacity,
+                                          buckets + 1, sizeof(uint32_t));
+  snapshot->cell_count = buckets;
+  memset(snapshot->cell_start, 0, sizeof(uint32_t) * (buckets + 1));
+  for (size_t i = 0; i < snapshot->polygon_count; i++) {
+    snapshot->cell_start[snapshot->polygon_cells[i] + 1]++;
+  }
+  for (size_t i = 0; i < buckets; i++) {
+    snapshot->cell_start[i + 1] += snapshot->cell_start[i];
+  }
+  // cell_start[i] is used as the insertion cursor of bucket i, leaving it
+  // at the start of bucket i + 1; shifting back restores the starts
+  for (size_t i = 0; i < snapshot->polygon_count; i++) {
+    uint32_t cell = snapshot->polygon_cells[i];
+    snapshot->cell_polygons[snapshot->cell_start[cell]++] = i;
+  }
+  memmove(&snapshot->cell_start[1], &snapshot->cell_start[0], sizeof(uint32_t) * buckets);
+  snapshot->cell_start[0] = 0;
+}
+
+void snapshot_capture_bodies(state_t *state, frame_snapshot_t *snapshot) {
+  scene_t *scene = state->scene;
+  size_t bodies = scene_bodies(scene);
+  snapshot->polygon_count = 0;
+  snapshot->vertex_count = 0;
+  snapshot_reserve_polygons(snapshot, bodies);
+  for (size_t i = 0; i < bodies; i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!body->visible) {
+      continue;
+    }
+    size_t count = list_size(body->shape);
+    snapshot->xy = snapshot_reserve(snapshot->xy, &snapshot->vertex_capacity,
+                                    snapshot->vertex_count + count, 2 * sizeof(float));
+    float *xy = &snapshot->xy[2 * snapshot->vertex_count];
+    for (size_t k = 0; k < count; k++) {
+      vector_t *point = list_get(body->shape, k);
+      xy[2 * k] = point->x;
+      xy[2 * k + 1] = point->y;
+    }
+    size_t polygon = snapshot->polygon_count;
+    snapshot->polygon_sizes[polygon] = count;
+    snapshot->polygon_offsets[polygon] = snapshot->vertex_count;
+    snapshot->polygon_cells[polygon] = count > 0 ? snapshot_polygon_cell(snapshot, xy, count) : 0;
+    snapshot->polygon_colors[polygon] = body->color;
+    snapshot->polygon_count++;
+    snapshot->vertex_count += count;
+  }
+  snapshot_bucket_polygons(snapshot);
+}
+
+void snapshot_capture_particles(state_t *state, frame_snapshot_t *snapshot) {
+  particle_system_t *particles = state->particles;
+  size_t count = particles->count;
+  size_t capacity = snapshot->particle_capacity;
+  snapshot->particle_x = snapshot_reserve(snapshot->particle_x, &capacity, count, sizeof(float));
+  capacity = snapshot->particle_capacity;
+  snapshot->particle_y = snapshot_reserve(snapshot->particle_y, &capacity, count, sizeof(float));
+  capacity = snapshot->particle_capacity;
+  snapshot->particle_angle = snapshot_reserve(snapshot->particle_angle, &capacity, count, sizeof(float));
+  capacity = snapshot->particle_capacity;
+  snapshot->particle_size = snapshot_reserve(snapshot->particle_size, &capacity, count, sizeof(float));
+  capacity = snapshot->particle_capacity;
+  snapshot->particle_colors = snapshot_reserve(snapshot->particle_colors, &capacity, count, sizeof(rgb_color_t));
+  snapshot->particle_capacity = capacity;
+  memcpy(snapshot->particle_x, particles->x, sizeof(float) * count);
+  memcpy(snapshot->particle_y, particles->y, sizeof(float) * count);
+  memcpy(snapshot->particle_angle, particles->angle, sizeof(float) * count);
+  memcpy(snapshot->particle_size, particles->size, sizeof(float) * count);
+  for (size_t i = 0; i < count; i++) {
+    snapshot->particle_colors[i] = (rgb_color_t) {.r = particles->r[i], .g = particles->g[i], .b = particles->b[i]};
+  }
+  snapshot->particle_count = count;
+}
+
+void snapshot_capture(state_t *state, frame_snapshot_t *snapshot) {
+  snapshot->tick = state->tick;
+  snapshot->view_lower_left = camera_lower_left(&state->camera);
+  snapshot->view_upper_right = camera_upper_right(&state->camera);
+  snapshot_capture_maze(state, snapshot);
+  snapshot_capture_bodies(state, snapshot);
+  snapshot_capture_particles(state, snapshot);
+}
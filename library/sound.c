@@ -0,0 +1,175 @@
+#include "sound.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// sound constants
+const char *SOUND_PATHS[SOUND_COUNT] = {
+  [SOUND_NORMAL_SHOT] = "assets/normalshot.wav",
+  [SOUND_RAILGUN_SHOT] = "assets/railgunshot.wav",
+  [SOUND_LASER_SHOT] = "assets/lasershot.wav",
+  [SOUND_SHOTGUN_SHOT] = "assets/shotgunshot.wav",
+  [SOUND_MOON_SHOT] = "assets/moonshot.wav",
+  [SOUND_EMPTY_SHOT] = "assets/empty_shot.wav",
+  [SOUND_DEATH] = "assets/lego_death.wav",
+  [SOUND_CANNON_EVENT] = "assets/cannon_event.wav",
+};
+const size_t SOUND_VOICE_LIMITS[SOUND_COUNT] = {
+  [SOUND_NORMAL_SHOT] = 4,
+  [SOUND_RAILGUN_SHOT] = 2,
+  [SOUND_LASER_SHOT] = 2,
+  [SOUND_SHOTGUN_SHOT] = 2,
+  [SOUND_MOON_SHOT] = 2,
+  [SOUND_EMPTY_SHOT] = 2,
+  [SOUND_DEATH] = 3,
+  [SOUND_CANNON_EVENT] = 1,
+};
+const char *MUSIC_PATH = "assets/soul_sanctum.ogg";
+
+typedef struct sound_worker {
+  sound_bank_t *bank;
+  size_t first;
+  size_t stride;
+} sound_worker_t;
+
+Mix_Chunk *sound_load(asset_archive_t *archive, const char *path) {
+  size_t size;
+  const void *data = assets_find(archive, path, &size);
+  if (data != NULL) {
+    return Mix_LoadWAV_RW(SDL_RWFromConstMem(data, size), 1);
+  }
+  return Mix_LoadWAV(path);
+}
+
+int sound_decode(void *aux) {
+  sound_worker_t *worker = aux;
+  sound_bank_t *bank = worker->bank;
+  for (size_t id = worker->first; id < SOUND_COUNT; id += worker->stride) {
+    bank->chunks[id] = sound_load(bank->archive, SOUND_PATHS[id]);
+    if (bank->chunks[id] == NULL) {
+      fprintf(stderr, "Could not load %s\n", SOUND_PATHS[id]);
+    }
+  }
+  free(worker);
+  return 0;
+}
+
+sound_bank_t *sound_bank_init(asset_archive_t *archive) {
+  sound_bank_t *bank = malloc(sizeof(sound_bank_t));
+  assert(bank != NULL);
+  bank->archive = archive;
+  bank->music = NULL;
+  size_t channels = 0;
+  for (size_t id = 0; id < SOUND_COUNT; id++) {
+    bank->chunks[id] = NULL;
+    bank->voice_limit[id] = SOUND_VOICE_LIMITS[id];
+    assert(bank->voice_limit[id] <= SOUND_MAX_VOICES);
+    channels += bank->voice_limit[id];
+    for (size_t voice = 0; voice < SOUND_MAX_VOICES; voice++) {
+      bank->voices[id][voice] = -1;
+    }
+    bank->next_voice[id] = 0;
+  }
+  // enough mixer channels for every sound to use all of its voices at once
+  Mix_AllocateChannels(channels);
+
+#ifdef __EMSCRIPTEN__
+  size_t workers = 0;
+#else
+  int cpus = SDL_GetCPUCount();
+  size_t workers = cpus > SOUND_MAX_WORKERS ? SOUND_MAX_WORKERS : cpus;
+#endif
+  size_t stride = workers > 0 ? workers : 1;
+  bank->worker_count = 0;
+  for (size_t first = 0; first < stride; first++) {
+    sound_worker_t *worker = malloc(sizeof(sound_worker_t));
+    assert(worker != NULL);
+    *worker = (sound_worker_t){.bank = bank, .first = first, .stride = stride};
+    SDL_Thread *thread = workers > 0 ? SDL_CreateThread(sound_decode, "sound_decode", worker) : NULL;
+    if (thread == NULL) {
+      // no thread available: decode this share of the sounds here
+      sound_decode(worker);
+    } else {
+      bank->workers[bank->worker_count] = thread;
+      bank->worker_count = bank->worker_count + 1;
+    }
+  }
+  return bank;
+}
+
+void sound_bank_wait(sound_bank_t *bank) {
+  for (size_t i = 0; i < bank->worker_count; i++) {
+    SDL_WaitThread(bank->workers[i], NULL);
+  }
+  bank->worker_count = 0;
+  if (bank->music == NULL) {
+    size_t size;
+    const void *data = assets_find(bank->archive, MUSIC_PATH, &size);
+    // music is streamed while it plays, straight from the mapped archive
+    bank->music = data != NULL ? Mix_LoadMUS_RW(SDL_RWFromConstMem(data, size), 1)
+                               : Mix_LoadMUS(MUSIC_PATH);
+  }
+}
+
+void sound_bank_free(sound_bank_t *bank) {
+  for (size_t id = 0; id < SOUND_COUNT; id++) {
+    if (bank->chunks[id] != NULL) {
+      Mix_FreeChunk(bank->chunks[id]);
+    }
+  }
+  if (bank->music != NULL) {
+    Mix_FreeMusic(bank->music);
+  }
+  free(bank);
+}
+
+void sound_play(sound_bank_t *bank, sound_id_t id) {
+  if (bank == NULL || bank->chunks[id] == NULL) {
+    return;
+  }
+  Mix_Chunk *chunk = bank->chunks[id];
+  size_t limit = bank->voice_limit[id];
+  int *voices = bank->voices[id];
+
+  // reuse a voice of this sound that has finished, otherwise steal the oldest
+  size_t voice = bank->next_voice[id];
+  for (size_t i = 0; i < limit; i++) {
+    int channel = voices[i];
+    if (channel < 0 || !Mix_Playing(channel) || Mix_GetChunk(channel) != chunk) {
+      voice = i;
+      break;
+    }
+  }
+  int channel = voices[voice];
+  if (channel >= 0 && Mix_Playing(channel) && Mix_GetChunk(channel) == chunk) {
+    Mix_HaltChannel(channel);
+  } else {
+    channel = -1;
+  }
+  voices[voice] = Mix_PlayChannel(channel, chunk, 0);
+  bank->next_voice[id] = (voice + 1) % limit;
+}
+
+void sound_bank_play(void *aux, sound_id_t id) {
+  sound_play(aux, id);
+}
+
+audio_t sound_bank_audio(sound_bank_t *bank) {
+  return (audio_t){.play = sound_bank_play, .aux = bank};
+}
+
+void sound_play_music(sound_bank_t *bank) {
+  if (bank != NULL && bank->music != NULL) {
+    Mix_PlayMusic(bank->music, -1);
+  }
+}
+
+size_t sound_bank_memory(sound_bank_t *bank) {
+  size_t bytes = sizeof(sound_bank_t);
+  for (size_t id = 0; id < SOUND_COUNT; id++) {
+    if (bank->chunks[id] != NULL) {
+      bytes += sizeof(Mix_Chunk) + bank->chunks[id]->alen;
+    }
+  }
+  return bytes;
+}
@@ -6,12 +6,10 @@
 #include "powerups.h"
 #include "collision.h"
 #include "maze.h"
-#include <SDL2/SDL_mixer.h>
+#include "audio.h"
 
 #define TAU (6.28318530717958)
 
-const char *DEATH_SOUND_PATH = "assets/lego_death.wav";
-
 // tank constants
 const double TANK_MASS = 100000;
 const double TANK_SPEED = 300.;
@@ -19,10 +17,13 @@ const double TANK_ROTATION = TAU/110.;
 
 // debris constants
 const double DEBRIS_VELOCITY = 400.;
-const double DEBRIS_MASS = 100;
 const double DEBRIS_DECAY = 1.;
-const double DEBRIS_DRAG = 250;
+const double DEBRIS_SPIN = 5;
 const size_t DEBRIS_SIZE = 2.;
+const size_t DEBRIS_PIECES = 8;
+
+// tank-vs-tank constants
+const size_t TANK_PAIR_BUDGET = 64;
 
 bool tank_is_not_null(state_t *state, tank_t *tank) {
   if (tank != NULL && (tank == state->red_player || tank == state->green_player || tank == state->blue_player)) {
@@ -44,13 +45,14 @@ void decay_force(void *aux) {
   }
 }
 
-void create_decay_force(state_t *state, tank_t *tank, body_t *body, double time) {
+decay_t *create_decay_force(state_t *state, tank_t *tank, body_t *body, double time) {
   decay_t *aux = malloc(sizeof(decay_t));
   assert(aux != NULL);
   *aux = (decay_t){.state = state, .time = time, .tank = tank, .body = body};
   list_t *bodies = list_init(1, NULL);
   list_add(bodies, body);
   scene_add_bodies_force_creator(state->scene, decay_force, aux, bodies, free);
+  return aux;
 }
 
 void tank_force_of_nature(void *aux) {
@@ -178,10 +180,14 @@ list_t *tank_hitbox_shape(vector_t center, size_t size) {
   return shape;
 }
 
+body_t *tank_body_init(list_t *shape, rgb_color_t color) {
+  return body_init_with_info(shape, TANK_MASS, color, NULL, free, 1);
+}
+
 tank_t *tank_init(vector_t center, size_t size, rgb_color_t color) {
   tank_t *tank = malloc(sizeof(tank_t));
   assert(tank != NULL);
-  tank->body = body_init_with_info(tank_shape(center, size), TANK_MASS, color, NULL, free, 1);
+  tank->body = tank_body_init(tank_shape(center, size), color);
   body_set_center(tank->body, center);
   tank->body->orientation = TAU/4;
   tank->hitbox = body_init_with_info(tank_hitbox_shape(center, size), TANK_MASS, color, NULL, free, 0);
@@ -197,6 +203,9 @@ tank_t *tank_init(vector_t center, size_t size, rgb_color_t color) {
   tank->bang = normal_shot;
   tank->powerup_shots_left = 0;
   tank->exists = 1;
+  tank->last_velocity = VEC_ZERO;
+  tank->last_rotation = 0;
+  tank->last_dt = 0;
   return tank;
 }
 
@@ -244,73 +253,44 @@ list_t* tank_get_flags(tank_t *tank) {
 }
 
 void tank_execute_flags(tank_t *tank) {
-  if (tank->mov_flags->flag_forwards == 1) {
-    tank_move(tank, TANK_SPEED);
-  }
-  if (tank->mov_flags->flag_backwards == 1) {
-    tank_move(tank, -TANK_SPEED/3.);
-  }
-  if (tank->mov_flags->flag_backwards == 0 && tank->mov_flags->flag_forwards == 0) {
-    tank_move(tank, 0.0);
-  }
+  tank_move(tank, tank_flags_speed(*tank->mov_flags));
+  tank_rotate(tank, tank_flags_turn(*tank->mov_flags));
+}
 
-  if (tank->mov_flags->flag_left == 1) {
-    tank_rotate(tank, TANK_ROTATION);
-  }
-  if (tank->mov_flags->flag_right == 1) {
-    tank_rotate(tank, -TANK_ROTATION);
-  }
-  if (tank->mov_flags->flag_left == 0 && tank->mov_flags->flag_right == 0) {
-    tank_rotate(tank, 0.0);
+double tank_flags_speed(mov_flags_t flags) {
+  if (flags.flag_backwards == 1) {
+    return -TANK_SPEED/3.;
   }
+  return flags.flag_forwards == 1 ? TANK_SPEED : 0.0;
+}
+
+double tank_flags_turn(mov_flags_t flags) {
+  return (flags.flag_left == 1 ? TANK_ROTATION : 0.0) + (flags.flag_right == 1 ? -TANK_ROTATION : 0.0);
 }
 
 void spawn_tank_debris(vector_t center, rgb_color_t color, double orientation, double speed, state_t *state) {
-  vector_t *debris1 = malloc(sizeof(vector_t));
-  vector_t *debris2 = malloc(sizeof(vector_t));
-  vector_t *debris3 = malloc(sizeof(vector_t));
-  assert(debris1 != NULL);
-  assert(debris2 != NULL);
-  assert(debris3 != NULL);
-
-  *debris1 = (vector_t){.x = center.x + 10*DEBRIS_SIZE, .y = center.y - 4*DEBRIS_SIZE};
-  *debris2 = (vector_t){.x = center.x - 8*DEBRIS_SIZE, .y = center.y - 4*DEBRIS_SIZE};
-  *debris3 = (vector_t){.x = center.x, .y = center.y + 8*DEBRIS_SIZE};
-
-  list_t *debris = list_init(8, free);
-  list_add(debris, debris1);
-  list_add(debris, debris2);
-  list_add(debris, debris3);
-  body_t *body = body_init_with_info(debris, DEBRIS_MASS, color, NULL, NULL, 1);
-  scene_add_body(state->scene, body);
-  create_drag(state->scene, DEBRIS_DRAG, body);
-  body_set_velocity(body, vec_multiply(speed, (vector_t) {.x = cos(orientation), .y = sin(orientation)}));
-  body_set_rotation(body, 5);
-  create_decay_force(state, NULL, body, DEBRIS_DECAY);
+  vector_t velocity = vec_multiply(speed, (vector_t) {.x = cos(orientation), .y = sin(orientation)});
+  particles_emit(state->particles, center, velocity, color, DEBRIS_SIZE, DEBRIS_SPIN, DEBRIS_DECAY);
 }
 
 void tank_debris(tank_t *tank, state_t *state) {
-  for (size_t i = 0; i < 8; i++) {
-    spawn_tank_debris(tank->body->center, tank->body->color, i* TAU / 8., DEBRIS_VELOCITY, state);
+  for (size_t i = 0; i < DEBRIS_PIECES; i++) {
+    spawn_tank_debris(tank->body->center, tank->body->color, i * TAU / DEBRIS_PIECES, DEBRIS_VELOCITY, state);
   }
 }
 
 void tank_remove(tank_t *tank, state_t *state) {
-  Mix_Chunk *death_sound = Mix_LoadWAV(DEATH_SOUND_PATH);
   tank_debris(tank, state);
   body_remove(tank->body);
   free(tank);
-  Mix_PlayChannel(-1, death_sound, 0);
+  audio_play(&state->audio, SOUND_DEATH);
 }
 
 typedef struct tank_maze_aux {
   tank_t *true_tank;
   maze_t *maze;
   size_t size;
-  vector_t last_velocity;
-  double last_rotation;
   state_t *state;
-  double last_dt;
 } tank_maze_aux_t;
 
 void tank_maze_force(void *aux) {
@@ -335,15 +315,15 @@ void tank_maze_force(void *aux) {
   }
 
   if (at_least_one_wall_collided != 0) {
-    vector_t translate_vector = vec_multiply(cable->last_dt, cable->last_velocity);
+    vector_t translate_vector = vec_multiply(tank->last_dt, tank->last_velocity);
     body_translate(tank->body, vec_negate(translate_vector));
     body_translate(tank->hitbox, vec_negate(translate_vector));
-    body_rotate(tank->body, -1*cable->last_rotation, tank->body->center);
-    body_rotate(tank->hitbox, -1*cable->last_rotation, tank->hitbox->center);
+    body_rotate(tank->body, -1*tank->last_rotation, tank->body->center);
+    body_rotate(tank->hitbox, -1*tank->last_rotation, tank->hitbox->center);
   }
-  cable->last_dt = cable->state->dt;
-  cable->last_velocity = temp_vel;
-  cable->last_rotation = temp_rotate;
+  tank->last_dt = cable->state->dt;
+  tank->last_velocity = temp_vel;
+  tank->last_rotation = temp_rotate;
 }
 
 void add_tank_maze_force(state_t *state, maze_t *maze, tank_t *tank, size_t tank_size) {
@@ -352,10 +332,86 @@ void add_tank_maze_force(state_t *state, maze_t *maze, tank_t *tank, size_t tank
   aux->true_tank = tank;
   aux->size = tank_size;
   aux->state = state;
-  aux->last_velocity = VEC_ZERO;
-  aux->last_rotation = 0;
-  aux->last_dt = 0;
   list_t *bodies = list_init(1, NULL);
   list_add(bodies, tank->hitbox);
   scene_add_bodies_force_creator(state->scene, tank_maze_force, aux, bodies, free);
-}
\ No newline at end of file
+}
+
+void tank_translate(tank_t *tank, vector_t translation) {
+  body_translate(tank->body, translation);
+  body_translate(tank->hitbox, translation);
+}
+
+/**
+ * Returns the depth of the overlap of two shapes projected on an axis.
+ */
+double tank_penetration(list_t *shape1, list_t *shape2, vector_t axis) {
+  double min1 = INFINITY;
+  double max1 = -INFINITY;
+  double min2 = INFINITY;
+  double max2 = -INFINITY;
+  for (size_t i = 0; i < list_size(shape1); i++) {
+    double projection = vec_dot(*(vector_t *)list_get(shape1, i), axis);
+    min1 = fmin(min1, projection);
+    max1 = fmax(max1, projection);
+  }
+  for (size_t i = 0; i < list_size(shape2); i++) {
+    double projection = vec_dot(*(vector_t *)list_get(shape2, i), axis);
+    min2 = fmin(min2, projection);
+    max2 = fmax(max2, projection);
+  }
+  return fmin(max1, max2) - fmax(min1, min2);
+}
+
+/**
+ * Tells whether a tank moved by a translation would overlap a wall.
+ */
+bool tank_blocked(maze_t *maze, tank_t *tank, vector_t translation) {
+  return maze_box_hits_wall(maze, vec_add(tank->body->center, translation), TANK_SIZE, tank->body->orientation);
+}
+
+void tanks_separate(broadphase_t *broadphase, maze_t *maze, tank_t **tanks, size_t count) {
+  size_t first[TANK_PAIR_BUDGET];
+  size_t second[TANK_PAIR_BUDGET];
+  broadphase_clear(broadphase);
+  for (size_t i = 0; i < count; i++) {
+    body_t *hitbox = tanks[i]->hitbox;
+    vector_t center = body_get_center(hitbox);
+    double radius = 0;
+    for (size_t k = 0; k < list_size(hitbox->shape); k++) {
+      vector_t offset = vec_subtract(*(vector_t *)list_get(hitbox->shape, k), center);
+      radius = fmax(radius, sqrt(vec_dot(offset, offset)));
+    }
+    broadphase_insert(broadphase, i, i, center, radius);
+  }
+  broadphase_build(broadphase);
+  size_t pairs = broadphase_pairs(broadphase, first, second, TANK_PAIR_BUDGET);
+
+  for (size_t i = 0; i < pairs; i++) {
+    tank_t *tank1 = tanks[first[i]];
+    tank_t *tank2 = tanks[second[i]];
+    collision_info_t collision_info = find_collision(tank1->hitbox->shape, tank2->hitbox->shape);
+    if (!collision_info.collided) {
+      continue;
+    }
+    vector_t axis = collision_info.axis;
+    vector_t apart = vec_subtract(body_get_center(tank1->hitbox), body_get_center(tank2->hitbox));
+    if (vec_dot(apart, axis) < 0) {
+      axis = vec_negate(axis);
+    }
+    double depth = tank_penetration(tank1->hitbox->shape, tank2->hitbox->shape, axis);
+    vector_t half = vec_multiply(depth / 2., axis);
+    vector_t whole = vec_multiply(depth, axis);
+    // runs after the walls have pushed back, so a push into a wall is never undone; a tank against one stays put
+    bool free1 = !tank_blocked(maze, tank1, half);
+    bool free2 = !tank_blocked(maze, tank2, vec_negate(half));
+    if (free1 && free2) {
+      tank_translate(tank1, half);
+      tank_translate(tank2, vec_negate(half));
+    } else if (free1) {
+      tank_translate(tank1, tank_blocked(maze, tank1, whole) ? half : whole);
+    } else if (free2) {
+      tank_translate(tank2, tank_blocked(maze, tank2, vec_negate(whole)) ? vec_negate(half) : vec_negate(whole));
+    }
+  }
+}
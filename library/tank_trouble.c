@@ -1,388 +1,282 @@
-#include "body.h"
-#include "collision.h"
-#include "forces.h"
+#include "ai.h"
+#include "game.h"
 #include "math.h"
-#include "scene.h"
 #include "sdl_wrapper.h"
-#include "tank.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include "powerups.h"
+#include <string.h>
+#include <time.h>
+#include "render.h"
+#include "sound.h"
+#include "assets.h"
+#include "snapshot.h"
+#include "key_queue.h"
+#include "pacer.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 
-#define TAU (2 * 3.14159265358979)
-
 // window constants
-const vector_t WINDOW = (vector_t){.x = 1000., .y = 500.};
 const size_t MAGIC_NUMBER = 8;
 
-// game constants
-const double COUNT_DOWN_NEXT_GAME = 5.;
-const double CANNON_EVENT_2099 = 0.0001;
-
-// maze constants
-size_t MAZE_COLUMNS = 10;
-size_t MAZE_ROWS = 5;
-
-// tank constants
-const rgb_color_t RED_PLAYER_COLOR = {.r = 1., .g = 0., .b = 0.};
-const rgb_color_t GREEN_PLAYER_COLOR = {.r = 0., .g = 1., .b = 0.};
-const rgb_color_t BLUE_PLAYER_COLOR = {.r = 0., .g = 0., .b = 1.};
-const size_t TANK_SIZE = 50;
-const size_t BULLET_LIMIT = 5;
+// pacing constants; the simulation runs at a fixed rate, since tanks turn by a fixed angle per tick
+#ifdef __EMSCRIPTEN__
+const double SIMULATION_RATE = 0; // the browser calls emscripten_main once per animation frame
+const double RENDER_RATE = 0;
+#else
+const double SIMULATION_RATE = 60.;
+const double RENDER_RATE = 60.; // unless vsync paces the renderer
+#endif
 
-// powerup constants
-const double POWERUP_SPAWN_INTERVAL = 5;
-const double POWERUP_SPAWN_PROB = .25;
+// player constants; bit i set if tank i (red, green, blue) is driven by the computer, which then ignores its keys
+const uint8_t CPU_TANKS = 0;
+// of those, the tanks that search futures of the match on worker threads instead of reacting
+const uint8_t CPU_LOOKAHEAD_TANKS = 0;
+const size_t CPU_LOOKAHEAD_WORKERS = 2;
 
-void tank_shoot(state_t *state, tank_t *tank) {
-  if (tank->powerup_shots_left <= 0) {
-    tank->bang = normal_shot;
-  }
-  tank->bang(state, tank, TANK_SIZE);
-}
+// asset constants
+const char *ASSET_ARCHIVE_PATH = "assets/assets.pak";
 
-void on_key(char key, key_event_type_t key_type, double held_time, void *state) {
-  tank_t *red_player;
-  tank_t *blue_player;
-  tank_t *green_player;
-  if (((state_t *)state)->tank_controls == 0) {
-    red_player = ((state_t *)state)->red_player;
-    blue_player = ((state_t *)state)->blue_player;
-    green_player = ((state_t *)state)->green_player;
-  } else if (((state_t *)state)->tank_controls == 1) {
-    green_player = ((state_t *)state)->red_player;
-    red_player = ((state_t *)state)->blue_player;
-    blue_player = ((state_t *)state)->green_player;
-  } else {
-    blue_player = ((state_t *)state)->red_player;
-    green_player = ((state_t *)state)->blue_player;
-    red_player = ((state_t *)state)->green_player;
-  }
+// replay constants; every session is recorded, and the headless build plays the file back
+const char *REPLAY_PATH = "/tmp/last_replay.ttr";
 
-  if (key_type == KEY_PRESSED) {
-    if (red_player != NULL) {
-      switch (key) {
-        case SDLK_q:
-          if (red_player->bullets_onscreen < BULLET_LIMIT) {
-            tank_shoot(state, red_player);
-          }
-          else {
-            Mix_Chunk *empty_sound = Mix_LoadWAV("assets/empty_shot.wav");
-            Mix_PlayChannel(-1, empty_sound, 0);
-          }
-          break;
-        case SDLK_w:
-          tank_set_flags(red_player, 1, 2, 2, 2);
-          break;
-        case SDLK_s:
-          tank_set_flags(red_player, 2, 1, 2, 2);
-          break;
-        case SDLK_a:
-          tank_set_flags(red_player, 2, 2, 1, 2);
-          break;
-        case SDLK_d:
-          tank_set_flags(red_player, 2, 2, 2, 1);
-          break;
-      }
-    }
-
-    if (green_player != NULL) {
-      switch (key) {
-        case SDLK_u:
-          if (green_player->bullets_onscreen < BULLET_LIMIT) {
-            tank_shoot(state, green_player);
-          }
-          else {
-            Mix_Chunk *empty_sound = Mix_LoadWAV("assets/empty_shot.wav");
-            Mix_PlayChannel(-1, empty_sound, 0);
-          }
-          break;
-        case SDLK_i:
-          tank_set_flags(green_player, 1, 2, 2, 2);
-          break;
-        case SDLK_k:
-          tank_set_flags(green_player, 2, 1, 2, 2);
-          break;
-        case SDLK_j:
-          tank_set_flags(green_player, 2, 2, 1, 2);
-          break;
-        case SDLK_l:
-          tank_set_flags(green_player, 2, 2, 2, 1);
-          break;
-      }
-    }
+// startup timing, reported once the first frame has been drawn
+#define STARTUP_MAX_PHASES 8
+const char *startup_phase_names[STARTUP_MAX_PHASES];
+double startup_phase_seconds[STARTUP_MAX_PHASES];
+size_t startup_phase_count = 0;
+Uint64 startup_begin = 0;
+Uint64 startup_last = 0;
+bool startup_reported = false;
 
-    if (blue_player != NULL) {
-      switch (key) {
-        case SPACE_BAR:
-          if (blue_player->bullets_onscreen < BULLET_LIMIT) {
-            tank_shoot(state, blue_player);
-          }
-          else {
-            Mix_Chunk *empty_sound = Mix_LoadWAV("assets/empty_shot.wav");
-            Mix_PlayChannel(-1, empty_sound, 0);
-          }
-          break;
-        case UP_ARROW:
-          tank_set_flags(blue_player, 1, 2, 2, 2);
-          break;
-        case DOWN_ARROW:
-          tank_set_flags(blue_player, 2, 1, 2, 2);
-          break;
-        case LEFT_ARROW:
-          tank_set_flags(blue_player, 2, 2, 1, 2);
-          break;
-        case RIGHT_ARROW:
-          tank_set_flags(blue_player, 2, 2, 2, 1);
-          break;
-      }
-    }            
-  }
+// frame time report constants
+const double FRAME_REPORT_INTERVAL = 5.;
+Uint64 frame_report_start = 0;
+double frame_report_render_time = 0;
+double frame_report_sim_time = 0;
+size_t frame_report_frames = 0;
+size_t frame_report_first_tick = 0;
 
-  if (key_type == KEY_RELEASED) {
-    if (red_player != NULL) {
-      switch (key) {
-        case SDLK_w:
-          tank_set_flags(red_player, 0, 2, 2, 2);
-          break;
-        case SDLK_s:
-          tank_set_flags(red_player, 2, 0, 2, 2);
-          break;
-        case SDLK_a:
-          tank_set_flags(red_player, 2, 2, 0, 2);
-          break;
-        case SDLK_d:
-          tank_set_flags(red_player, 2, 2, 2, 0);
-          break;
-      }
-    }
+/**
+ * What the windowed game keeps beside the match. The engine hands the
+ * callbacks only the state, so there is one, owned by this file.
+ */
+typedef struct front_end {
+  asset_archive_t *assets;
+  sound_bank_t *sounds;
+  snapshot_buffer_t *snapshots;
+  frame_pacer_t *sim_pacer;
+  frame_pacer_t *render_pacer;
+  key_queue_t *keys; // input events waiting for the simulation thread
+  replay_writer_t *recorder; // records every input and tick when not NULL
+  ai_t *cpu; // drives the tanks no one plays, NULL if every tank has a player
+} front_end_t;
 
-    if (green_player != NULL) {
-      switch (key) {
-        case SDLK_i:
-          tank_set_flags(green_player, 0, 2, 2, 2);
-          break;
-        case SDLK_k:
-          tank_set_flags(green_player, 2, 0, 2, 2);
-          break;
-        case SDLK_j:
-          tank_set_flags(green_player, 2, 2, 0, 2);
-          break;
-        case SDLK_l:
-          tank_set_flags(green_player, 2, 2, 2, 0);
-          break;
-      }
-    }
+front_end_t front_end;
 
-    if (blue_player != NULL) {
-      switch (key) {
-        case UP_ARROW:
-          tank_set_flags(blue_player, 0, 2, 2, 2);
-          break;
-        case DOWN_ARROW:
-          tank_set_flags(blue_player, 2, 0, 2, 2);
-          break;
-        case LEFT_ARROW:
-          tank_set_flags(blue_player, 2, 2, 0, 2);
-          break;
-        case RIGHT_ARROW:
-          tank_set_flags(blue_player, 2, 2, 2, 0);
-          break;
-      }
-    }            
+/**
+ * Maps a key to the player and control it stands for.
+ *
+ * @return false if the key controls nothing
+ */
+bool key_to_input(char key, input_event_t *event) {
+  switch (key) {
+    case SDLK_w: *event = (input_event_t){.player = 0, .action = INPUT_FORWARD}; return true;
+    case SDLK_s: *event = (input_event_t){.player = 0, .action = INPUT_BACKWARD}; return true;
+    case SDLK_a: *event = (input_event_t){.player = 0, .action = INPUT_LEFT}; return true;
+    case SDLK_d: *event = (input_event_t){.player = 0, .action = INPUT_RIGHT}; return true;
+    case SDLK_q: *event = (input_event_t){.player = 0, .action = INPUT_SHOOT}; return true;
+    case SDLK_i: *event = (input_event_t){.player = 1, .action = INPUT_FORWARD}; return true;
+    case SDLK_k: *event = (input_event_t){.player = 1, .action = INPUT_BACKWARD}; return true;
+    case SDLK_j: *event = (input_event_t){.player = 1, .action = INPUT_LEFT}; return true;
+    case SDLK_l: *event = (input_event_t){.player = 1, .action = INPUT_RIGHT}; return true;
+    case SDLK_u: *event = (input_event_t){.player = 1, .action = INPUT_SHOOT}; return true;
+    case UP_ARROW: *event = (input_event_t){.player = 2, .action = INPUT_FORWARD}; return true;
+    case DOWN_ARROW: *event = (input_event_t){.player = 2, .action = INPUT_BACKWARD}; return true;
+    case LEFT_ARROW: *event = (input_event_t){.player = 2, .action = INPUT_LEFT}; return true;
+    case RIGHT_ARROW: *event = (input_event_t){.player = 2, .action = INPUT_RIGHT}; return true;
+    case SPACE_BAR: *event = (input_event_t){.player = 2, .action = INPUT_SHOOT}; return true;
   }
+  return false;
 }
 
-tank_t *tank_player_init_force(state_t *state, vector_t init_pos, rgb_color_t color) {
-  tank_t *tank_body = tank_init(init_pos, TANK_SIZE, color);
-  scene_add_body(state->scene, get_tank_body(tank_body));
-  scene_add_body(state->scene, get_tank_hitbox(tank_body));
-  add_tank_maze_force(state, state->maze, tank_body, TANK_SIZE);
-  return tank_body;
-}
-
-void reset_state(state_t *state) {
-  scene_free(state->scene);
-  scene_t *scene = scene_init();
-  state->scene = scene;
-
-  state->count_down_until_next_game_start = 0;
-  state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
-  state->tank_controls = 0;
-
-  maze_free(state->maze);
-  state->maze = maze_init(MAZE_COLUMNS, MAZE_ROWS, VEC_ZERO, WINDOW);
-  for (size_t i = 0; i < list_size(state->maze->vertical_walls); i++) {
-    scene_add_body(scene, list_get(state->maze->vertical_walls, i));
+/**
+ * Runs on whichever thread polls SDL events; the input is applied by the
+ * simulation at the start of its next tick.
+ */
+void queue_key(char key, key_event_type_t key_type, double held_time, void *state) {
+  input_event_t event;
+  if (!key_to_input(key, &event)) {
+    return;
   }
-  for (size_t i = 0; i < list_size(state->maze->horizontal_walls); i++) {
-    scene_add_body(scene, list_get(state->maze->horizontal_walls, i));
-  }
-
-  list_t *random_vectors = get_random_cell_centers(state->maze, 3);
-  state->red_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 0), RED_PLAYER_COLOR);
-  state->blue_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 1), BLUE_PLAYER_COLOR);
-  state->green_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 2), GREEN_PLAYER_COLOR);
-  list_free(random_vectors);
-  sdl_on_key(on_key);
-  
-  FILE *fptr = fopen("/tmp/savedat.txt", "w");
-  fprintf(fptr, "%zu %zu %zu %zu", state->red_wins, state->blue_wins, state->green_wins, state->games_played);
-  fclose(fptr);
+  event.pressed = key_type == KEY_PRESSED;
+  key_queue_push(front_end.keys, event);
 }
 
-void check_game_over(state_t *state) {
-  bool red_null = state->red_player == NULL;
-  bool blue_null = state->blue_player == NULL;
-  bool green_null = state->green_player == NULL;
-  
-  bool red_win = !red_null && blue_null && green_null;
-  bool blue_win = red_null && !blue_null && green_null;
-  bool green_win = red_null && blue_null && !green_null;
-  bool draw = red_null && blue_null && green_null;
-
-  if (red_win || blue_win || green_win || draw) {
-    printf("\n--------------------------\n");
-    state->games_played = state->games_played + 1;
-    state->count_down_until_next_game_start = COUNT_DOWN_NEXT_GAME;
-    if (red_win) {
-      printf("Red player wins!");
-      state->red_wins = state->red_wins + 1;
-    }
-    if (blue_win) {
-      printf("Blue player wins!");
-      state->blue_wins = state->blue_wins + 1;
-    }
-    if (green_win) {
-      printf("Green player wins!");
-      state->green_wins = state->green_wins + 1;
-    }
-    if (draw) {
-      printf("It's a draw!");
+/**
+ * Applies the queued keys, except those of controls that drive a CPU
+ * player's tank, so the keyboard and ai_tick() never fight over a tank.
+ */
+void apply_queued_keys(front_end_t *front_end, state_t *state) {
+  input_event_t event;
+  while (key_queue_pop(front_end->keys, &event)) {
+    if (event.player < INPUT_PLAYERS && CPU_TANKS >> game_input_tank(state, event.player) & 1) {
+      continue;
     }
-    printf(" The next game will start in %zu seconds\n", (size_t)COUNT_DOWN_NEXT_GAME);
-    printf("Current score:\nRed: %zu, Blue: %zu, Green: %zu\n", state->red_wins, state->blue_wins, state->green_wins);
-    printf("--------------------------\n\n");
+    game_apply_input(state, event);
   }
 }
 
-void add_random_powerup(state_t *state) {
-  double r = rand_num();
-  if (r < POWERUP_SPAWN_PROB) {
-    add_powerup(state, RAILGUN);
-  } else if (r < 2*POWERUP_SPAWN_PROB) {
-    add_powerup(state, LASER);
-  } else if (r < 3*POWERUP_SPAWN_PROB) {
-    add_powerup(state, SHOTGUN);
-  } else {
-    add_powerup(state, MOON);
+/**
+ * Records the time spent since the previous startup phase ended.
+ */
+void startup_phase(const char *name) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (startup_phase_count < STARTUP_MAX_PHASES) {
+    startup_phase_names[startup_phase_count] = name;
+    startup_phase_seconds[startup_phase_count] = (double)(now - startup_last) / SDL_GetPerformanceFrequency();
+    startup_phase_count = startup_phase_count + 1;
   }
+  startup_last = now;
 }
 
-void run_cannon_event(state_t *state) {
-  double r = rand_num();
-  if (r < CANNON_EVENT_2099) {
-    Mix_Chunk *empty_sound = Mix_LoadWAV("assets/cannon_event.wav");
-    Mix_PlayChannel(-1, empty_sound, 0);
-    state->tank_controls = (state->tank_controls + 1) % 2;
-    if (state->red_player != NULL) {
-      tank_set_flags(state->red_player, 0, 0, 0, 0);
-    }
-    if (state->green_player != NULL) {
-      tank_set_flags(state->green_player, 0, 0, 0, 0);
-    }
-    if (state->blue_player != NULL) {
-      tank_set_flags(state->blue_player, 0, 0, 0, 0);
-    }
+/**
+ * Prints how long each startup phase took, and the memory the sound bank
+ * holds once every sound has been decoded.
+ */
+void startup_report(sound_bank_t *sounds) {
+  printf("Time to first frame: %.1f ms\n",
+         1000. * (startup_last - startup_begin) / SDL_GetPerformanceFrequency());
+  for (size_t i = 0; i < startup_phase_count; i++) {
+    printf("  %-16s %7.1f ms\n", startup_phase_names[i], 1000. * startup_phase_seconds[i]);
   }
+  printf("Sound bank: %zu KiB\n", sound_bank_memory(sounds) / 1024);
+  startup_reported = true;
 }
 
 state_t *emscripten_init() {
-  scene_t *scene = scene_init();
+  startup_begin = SDL_GetPerformanceCounter();
+  startup_last = startup_begin;
   vector_t min = VEC_ZERO;
-  vector_t max = WINDOW;
+  vector_t max = GAME_WINDOW;
   sdl_init(min, max);
-  state_t *state = malloc(sizeof(state_t));
-  state->scene = scene;
-  state->count_down_until_next_game_start = 0;
-  state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
+  render_init(min, max);
+  startup_phase("sdl");
   Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-  maze_t *maze = maze_init(MAZE_COLUMNS, MAZE_ROWS, VEC_ZERO, WINDOW);
-  for (size_t i = 0; i < list_size(maze->vertical_walls); i++) {
-    scene_add_body(scene, list_get(maze->vertical_walls, i));
-  }
-  for (size_t i = 0; i < list_size(maze->horizontal_walls); i++) {
-    scene_add_body(scene, list_get(maze->horizontal_walls, i));
+  startup_phase("audio");
+  asset_archive_t *assets = assets_open(ASSET_ARCHIVE_PATH);
+  // the sounds decode on worker threads while the maze is generated
+  sound_bank_t *sounds = sound_bank_init(assets);
+  startup_phase("assets");
+  game_config_t config = game_default_config(time(NULL));
+  config.keep_score = true;
+  state_t *state = game_init(config, sound_bank_audio(sounds));
+  front_end.assets = assets;
+  front_end.sounds = sounds;
+  front_end.snapshots = snapshot_buffer_init();
+  front_end.sim_pacer = pacer_init("sim", SIMULATION_RATE);
+  front_end.render_pacer = pacer_init("render", render_has_vsync() ? 0 : RENDER_RATE);
+  front_end.keys = key_queue_init();
+  front_end.cpu = CPU_TANKS != 0 ? ai_init(CPU_TANKS) : NULL;
+  for (size_t i = 0; i < INPUT_PLAYERS; i++) {
+    if (CPU_TANKS & CPU_LOOKAHEAD_TANKS & 1 << i) {
+      // never waits on the workers, so a slow search costs moves, not frames
+      if (!ai_use_lookahead(front_end.cpu, state, i, CPU_LOOKAHEAD_WORKERS, 0)) {
+        fprintf(stderr, "The maze is too large to search; CPU tank %zu reacts instead\n", i);
+      }
+    }
   }
-  state->red_wins = 0;
-  state->blue_wins = 0;
-  state->green_wins = 0;
-  state->games_played = 0;
-  FILE *fptr = fopen("/savedat.txt", "r");
-  if (fptr != NULL) {
-    fscanf(fptr, "%zu %zu %zu %zu", &(state->red_wins), &(state->blue_wins), &(state->green_wins), &(state->games_played));
-    fclose(fptr);
+  front_end.recorder = replay_writer_init(REPLAY_PATH, game_replay_header(state));
+  if (front_end.recorder == NULL) {
+    fprintf(stderr, "Could not record the replay to %s\n", REPLAY_PATH);
   }
-  state->maze = maze;
-  state->tank_controls = 0;
-  list_t *random_vectors = get_random_cell_centers(maze, 3);
-  state->red_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 0), RED_PLAYER_COLOR);
-  state->blue_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 1), BLUE_PLAYER_COLOR);
-  state->green_player = tank_player_init_force(state, *(vector_t *)list_get(random_vectors, 2), GREEN_PLAYER_COLOR);
-  Mix_Music *music = Mix_LoadMUS("assets/soul_sanctum.ogg");
-  Mix_PlayMusic(music, -1);
-  list_free(random_vectors);
-  sdl_on_key(on_key);
-  printf("Welcome to Tank Trouble!\nThese are the controls:\nRed player: awsd + q     Green player: ijkl + u     Blue player: arrows + space bar\n");
+  startup_phase("maze");
+  sound_bank_wait(front_end.sounds);
+  startup_phase("sound decode");
+  sound_play_music(front_end.sounds);
+  sdl_on_key(queue_key);
   return state;
 }
 
 void emscripten_main(state_t *state) {
-  double dt = time_since_last_tick();
-  state->dt = dt;
-  if (state->count_down_until_next_game_start == 0) {
-    check_game_over(state);
-  } else if (state->count_down_until_next_game_start > 0) {
-    state->count_down_until_next_game_start = state->count_down_until_next_game_start - dt;
-    if (state->count_down_until_next_game_start <= 0) {
-      reset_state(state);
-    }
-  }
-  run_cannon_event(state);
-  scene_tick(state->scene, dt);
-  state->count_down_until_next_powerup = state->count_down_until_next_powerup - dt;
-  if (state->count_down_until_next_powerup < 0) {
-    add_random_powerup(state);
-    state->count_down_until_next_powerup = POWERUP_SPAWN_INTERVAL;
+  pacer_wait(front_end.sim_pacer);
+  Uint64 tick_start = SDL_GetPerformanceCounter();
+  double dt = pacer_tick(front_end.sim_pacer);
+  apply_queued_keys(&front_end, state);
+  if (front_end.cpu != NULL) {
+    ai_tick(front_end.cpu, state);
   }
-  if (state->red_player != NULL && state->red_player->exists == 0) {
-    tank_remove(state->red_player, state);
-    state->red_player = NULL;
+  game_tick(state, dt);
+  if (front_end.recorder != NULL) {
+    game_record_tick(state, front_end.recorder);
   }
-  if (state->green_player != NULL && state->green_player->exists == 0) {
-    tank_remove(state->green_player, state);
-    state->green_player = NULL;
-  }
-  if (state->blue_player != NULL && state->blue_player->exists == 0) {
-    tank_remove(state->blue_player, state);
-    state->blue_player = NULL;
+  double sim_frame_time = (double)(SDL_GetPerformanceCounter() - tick_start) / SDL_GetPerformanceFrequency();
+  frame_snapshot_t *snapshot = snapshot_begin_write(front_end.snapshots);
+  game_capture(state, snapshot);
+  snapshot->sim_frame_time = sim_frame_time;
+  snapshot_publish(front_end.snapshots);
+}
+
+/**
+ * Prints the average simulation and render times every few seconds,
+ * along with how many ticks the simulation ran per frame drawn and the
+ * render pacer's frame time percentiles.
+ */
+void report_frame_times(frame_pacer_t *render_pacer, frame_snapshot_t *snapshot, double render_time) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (frame_report_frames == 0) {
+    frame_report_first_tick = snapshot->tick;
+    frame_report_start = now;
   }
-  if (state->red_player != NULL) {
-    tank_execute_flags(state->red_player);
+  frame_report_frames = frame_report_frames + 1;
+  frame_report_render_time = frame_report_render_time + render_time;
+  frame_report_sim_time = frame_report_sim_time + snapshot->sim_frame_time;
+  if ((double)(now - frame_report_start) / SDL_GetPerformanceFrequency() < FRAME_REPORT_INTERVAL) {
+    return;
   }
-  if (state->blue_player != NULL) {
-    tank_execute_flags(state->blue_player);
+  size_t ticks = snapshot->tick - frame_report_first_tick;
+  printf("sim %.2f ms/tick, render %.2f ms/frame, %.2f ticks/frame\n",
+         1000. * frame_report_sim_time / frame_report_frames,
+         1000. * frame_report_render_time / frame_report_frames,
+         (double)ticks / frame_report_frames);
+  pacer_report(render_pacer);
+  frame_report_render_time = 0;
+  frame_report_sim_time = 0;
+  frame_report_frames = 0;
+}
+
+void emscripten_render(state_t *state) {
+  pacer_wait(front_end.render_pacer);
+  pacer_tick(front_end.render_pacer);
+  Uint64 frame_start = SDL_GetPerformanceCounter();
+  frame_snapshot_t *snapshot = snapshot_acquire(front_end.snapshots);
+  if (snapshot == NULL) {
+    return;
   }
-  if (state->green_player != NULL) {
-    tank_execute_flags(state->green_player);
+  render_snapshot(snapshot);
+  if (!startup_reported) {
+    startup_phase("first frame");
+    startup_report(front_end.sounds);
   }
-  sdl_render_scene(state->scene);
+  report_frame_times(front_end.render_pacer, snapshot, (double)(SDL_GetPerformanceCounter() - frame_start) / SDL_GetPerformanceFrequency());
 }
 
 void emscripten_free(state_t *state) {
-  scene_free(state->scene);
-  free(state);
+  if (front_end.recorder != NULL) {
+    replay_writer_free(front_end.recorder);
+  }
+  sound_bank_free(front_end.sounds);
+  snapshot_buffer_free(front_end.snapshots);
+  key_queue_free(front_end.keys);
+  if (front_end.cpu != NULL) {
+    ai_free(front_end.cpu);
+  }
+  // the simulation has stopped ticking its pacer by now, so its whole run is reported from here
+  pacer_report(front_end.sim_pacer);
+  pacer_free(front_end.sim_pacer);
+  pacer_free(front_end.render_pacer);
+  if (front_end.assets != NULL) {
+    assets_close(front_end.assets);
+  }
+  game_free(state);
 }
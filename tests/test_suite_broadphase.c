@@ -0,0 +1,129 @@
+#include "broadphase.h"
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define TEST_OBJECTS 300
+#define TEST_MAX_PAIRS (TEST_OBJECTS * TEST_OBJECTS / 2)
+
+const double TEST_CELL_SIZE = 40;
+const vector_t TEST_LOWER_LEFT = {.x = 0, .y = 0};
+const vector_t TEST_UPPER_RIGHT = {.x = 800, .y = 600};
+
+typedef struct test_object {
+  vector_t center;
+  double radius;
+  size_t group;
+} test_object_t;
+
+void random_objects(rng_t *rng, test_object_t *objects, size_t count, size_t groups) {
+  for (size_t i = 0; i < count; i++) {
+    objects[i] = (test_object_t){
+      .center = {.x = rng_double(rng) * TEST_UPPER_RIGHT.x, .y = rng_double(rng) * TEST_UPPER_RIGHT.y},
+      .radius = 2 + rng_double(rng) * (TEST_CELL_SIZE / 2 - 2),
+      .group = rng_below(rng, groups),
+    };
+  }
+}
+
+// in single precision, as the grid stores the circles
+bool overlap(const test_object_t *a, const test_object_t *b) {
+  float dx = (float)a->center.x - (float)b->center.x;
+  float dy = (float)a->center.y - (float)b->center.y;
+  float reach = (float)a->radius + (float)b->radius;
+  return dx * dx + dy * dy <= reach * reach;
+}
+
+broadphase_t *built_grid(const test_object_t *objects, size_t count) {
+  broadphase_t *broadphase = broadphase_init(TEST_LOWER_LEFT, TEST_UPPER_RIGHT, TEST_CELL_SIZE, count);
+  for (size_t i = 0; i < count; i++) {
+    broadphase_insert(broadphase, i, objects[i].group, objects[i].center, objects[i].radius);
+  }
+  broadphase_build(broadphase);
+  return broadphase;
+}
+
+// every overlapping pair of different groups is found once, and nothing else
+void test_pairs_match_brute_force() {
+  rng_t rng = rng_init(27);
+  test_object_t *objects = malloc(sizeof(test_object_t) * TEST_OBJECTS);
+  bool *found = malloc(sizeof(bool) * TEST_OBJECTS * TEST_OBJECTS);
+  size_t *first = malloc(sizeof(size_t) * TEST_MAX_PAIRS);
+  size_t *second = malloc(sizeof(size_t) * TEST_MAX_PAIRS);
+  assert(objects != NULL && found != NULL && first != NULL && second != NULL);
+  for (size_t round = 0; round < 20; round++) {
+    random_objects(&rng, objects, TEST_OBJECTS, 1 + round % 5);
+    broadphase_t *broadphase = built_grid(objects, TEST_OBJECTS);
+    size_t count = broadphase_pairs(broadphase, first, second, TEST_MAX_PAIRS);
+    for (size_t i = 0; i < TEST_OBJECTS * TEST_OBJECTS; i++) {
+      found[i] = false;
+    }
+    for (size_t k = 0; k < count; k++) {
+      size_t a = first[k] < second[k] ? first[k] : second[k];
+      size_t b = first[k] < second[k] ? second[k] : first[k];
+      assert(a != b && !found[a * TEST_OBJECTS + b]);
+      found[a * TEST_OBJECTS + b] = true;
+    }
+    size_t expected = 0;
+    for (size_t a = 0; a < TEST_OBJECTS; a++) {
+      for (size_t b = a + 1; b < TEST_OBJECTS; b++) {
+        bool pair = objects[a].group != objects[b].group && overlap(&objects[a], &objects[b]);
+        assert(found[a * TEST_OBJECTS + b] == pair);
+        expected += pair;
+      }
+    }
+    assert(count == expected);
+    broadphase_free(broadphase);
+  }
+  free(objects);
+  free(found);
+  free(first);
+  free(second);
+}
+
+// a pile of one group's objects does not use up the budget before another group's pair
+void test_same_group_pairs_do_not_count() {
+  test_object_t objects[12];
+  for (size_t i = 0; i < 10; i++) {
+    objects[i] = (test_object_t){.center = {.x = 100 + i, .y = 100}, .radius = 5, .group = 0};
+  }
+  objects[10] = (test_object_t){.center = {.x = 400, .y = 300}, .radius = 5, .group = 1};
+  objects[11] = (test_object_t){.center = {.x = 404, .y = 300}, .radius = 5, .group = 2};
+  broadphase_t *broadphase = built_grid(objects, 12);
+  size_t first[1];
+  size_t second[1];
+  assert(broadphase_pairs(broadphase, first, second, 1) == 1);
+  assert((first[0] == 10 && second[0] == 11) || (first[0] == 11 && second[0] == 10));
+  broadphase_free(broadphase);
+}
+
+void test_budget_bounds_pairs() {
+  test_object_t objects[8];
+  for (size_t i = 0; i < 8; i++) {
+    objects[i] = (test_object_t){.center = {.x = 200 + i, .y = 200}, .radius = 5, .group = i};
+  }
+  broadphase_t *broadphase = built_grid(objects, 8);
+  size_t first[28];
+  size_t second[28];
+  assert(broadphase_pairs(broadphase, first, second, 28) == 28);
+  assert(broadphase_pairs(broadphase, first, second, 5) == 5);
+  broadphase_clear(broadphase);
+  broadphase_build(broadphase);
+  assert(broadphase_pairs(broadphase, first, second, 28) == 0);
+  broadphase_free(broadphase);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_pairs_match_brute_force)
+  DO_TEST(test_same_group_pairs_do_not_count)
+  DO_TEST(test_budget_bounds_pairs)
+
+  puts("broadphase_test PASS");
+}
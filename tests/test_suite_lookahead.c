@@ -0,0 +1,148 @@
+#include "lookahead.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+const double TEST_DT = 1. / 60.;
+
+/**
+ * An open 5 x 5 maze of 100 x 100 cells with only its border walls, whose
+ * inner faces a shot of radius 6 bounces off 9 from the edge.
+ */
+maze_t open_walls(uint8_t *cell_walls) {
+  maze_t walls = {
+    .columns = 5,
+    .rows = 5,
+    .lower_left = {.x = 0, .y = 0},
+    .upper_right = {.x = 500, .y = 500},
+    .cell_walls = cell_walls,
+  };
+  memset(cell_walls, 0, 25);
+  for (size_t i = 0; i < 5; i++) {
+    cell_walls[5 * i] |= WALL_LEFT;
+    cell_walls[5 * i + 4] |= WALL_RIGHT;
+    cell_walls[i] |= WALL_DOWN;
+    cell_walls[20 + i] |= WALL_UP;
+  }
+  return walls;
+}
+
+/**
+ * A world with only the red tank alive, at the center facing right.
+ */
+lookahead_world_t lone_tank_world() {
+  lookahead_world_t world;
+  memset(&world, 0, sizeof(world));
+  world.tanks[0] = (lookahead_tank_t){.center = {.x = 250, .y = 250}, .alive = true};
+  return world;
+}
+
+// the scene moves a body by the velocity of the tick before, so a tank starts moving a tick after its button
+void test_tank_moves_a_tick_late() {
+  uint8_t cells[25];
+  maze_t walls = open_walls(cells);
+  lookahead_world_t world = lone_tank_world();
+  const uint8_t forward[INPUT_PLAYERS] = {1 << INPUT_FORWARD, 0, 0};
+  lookahead_step(&world, &walls, forward, TEST_DT);
+  assert(vec_isclose(world.tanks[0].center, (vector_t) {.x = 250, .y = 250}));
+  assert(vec_isclose(world.tanks[0].velocity, (vector_t) {.x = 300, .y = 0}));
+  lookahead_step(&world, &walls, forward, TEST_DT);
+  assert(vec_isclose(world.tanks[0].center, (vector_t) {.x = 255, .y = 250}));
+
+  const uint8_t left[INPUT_PLAYERS] = {1 << INPUT_LEFT, 0, 0};
+  lookahead_step(&world, &walls, left, TEST_DT);
+  assert(vec_isclose(world.tanks[0].center, (vector_t) {.x = 260, .y = 250}));
+  assert(isclose(world.tanks[0].angle, tank_flags_turn((mov_flags_t) {.flag_left = 1})));
+  assert(vec_isclose(world.tanks[0].velocity, VEC_ZERO));
+}
+
+// a shot leaves when the button goes down, not while it is held
+void test_shot_fires_on_press() {
+  uint8_t cells[25];
+  maze_t walls = open_walls(cells);
+  lookahead_world_t world = lone_tank_world();
+  const uint8_t shoot[INPUT_PLAYERS] = {1 << INPUT_SHOOT, 0, 0};
+  const uint8_t none[INPUT_PLAYERS] = {0, 0, 0};
+  lookahead_step(&world, &walls, shoot, TEST_DT);
+  assert(world.shot_count == 1 && world.tanks[0].bullets == 1);
+  // 35 ahead of the tank, then a tick of flight at 200 per second
+  assert(vec_isclose(world.shots[0].position, (vector_t) {.x = 285 + 200 * TEST_DT, .y = 250}));
+  lookahead_step(&world, &walls, shoot, TEST_DT);
+  assert(world.shot_count == 1);
+  lookahead_step(&world, &walls, none, TEST_DT);
+  lookahead_step(&world, &walls, shoot, TEST_DT);
+  assert(world.shot_count == 2 && world.tanks[0].bullets == 2);
+}
+
+void test_shot_bounces_off_wall() {
+  uint8_t cells[25];
+  maze_t walls = open_walls(cells);
+  lookahead_world_t world = lone_tank_world();
+  world.tanks[0].alive = false;
+  world.shot_count = 1;
+  world.shots[0] = (lookahead_shot_t){
+    .position = {.x = 485, .y = 250}, .velocity = {.x = 600, .y = 0}, .radius = 6, .time_left = 5,
+  };
+  const uint8_t none[INPUT_PLAYERS] = {0, 0, 0};
+  lookahead_step(&world, &walls, none, TEST_DT);
+  // 6 to the face at 491, then the other 4 back
+  assert(world.shot_count == 1);
+  assert(vec_isclose(world.shots[0].position, (vector_t) {.x = 487, .y = 250}));
+  assert(vec_isclose(world.shots[0].velocity, (vector_t) {.x = -600, .y = 0}));
+}
+
+void test_shot_kills_tank() {
+  uint8_t cells[25];
+  maze_t walls = open_walls(cells);
+  lookahead_world_t world = lone_tank_world();
+  world.tanks[0].alive = false;
+  world.tanks[1] = (lookahead_tank_t){.center = {.x = 300, .y = 250}, .alive = true};
+  world.tanks[0].bullets = 1;
+  world.shot_count = 1;
+  world.shots[0] = (lookahead_shot_t){
+    .position = {.x = 260, .y = 250}, .velocity = {.x = 300, .y = 0}, .radius = 6, .time_left = 5, .owner = 0,
+  };
+  const uint8_t none[INPUT_PLAYERS] = {0, 0, 0};
+  // the hitbox reaches 275, so the shot touches it past 269
+  lookahead_step(&world, &walls, none, TEST_DT);
+  assert(world.tanks[1].alive && world.shot_count == 1);
+  lookahead_step(&world, &walls, none, TEST_DT);
+  assert(!world.tanks[1].alive && world.shot_count == 0 && world.tanks[0].bullets == 0);
+}
+
+// a world and its clone, stepped alike, stay alike
+void test_clone_steps_alike() {
+  uint8_t cells[25];
+  maze_t walls = open_walls(cells);
+  lookahead_world_t world = lone_tank_world();
+  world.tanks[2] = (lookahead_tank_t){.center = {.x = 100, .y = 400}, .angle = 1, .alive = true};
+  lookahead_world_t clone;
+  const uint8_t buttons[INPUT_PLAYERS] = {1 << INPUT_FORWARD | 1 << INPUT_SHOOT, 0, 1 << INPUT_LEFT | 1 << INPUT_SHOOT};
+  for (size_t tick = 0; tick < 20; tick++) {
+    lookahead_step(&world, &walls, buttons, TEST_DT);
+  }
+  lookahead_clone(&clone, &world);
+  for (size_t tick = 0; tick < 60; tick++) {
+    lookahead_step(&world, &walls, buttons, TEST_DT);
+    lookahead_step(&clone, &walls, buttons, TEST_DT);
+  }
+  assert(world.shot_count == clone.shot_count);
+  assert(memcmp(&world, &clone, offsetof(lookahead_world_t, shots) + sizeof(lookahead_shot_t) * world.shot_count) == 0);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_tank_moves_a_tick_late)
+  DO_TEST(test_shot_fires_on_press)
+  DO_TEST(test_shot_bounces_off_wall)
+  DO_TEST(test_shot_kills_tank)
+  DO_TEST(test_clone_steps_alike)
+
+  puts("lookahead_test PASS");
+}
@@ -0,0 +1,90 @@
+#include "maze.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/**
+ * A fixed 3 x 3 maze of 100 x 100 cells with its border and one inner wall,
+ * on the line x = 100 between y = 100 and y = 200. The wall's lower end
+ * stops short of the cells below it.
+ */
+maze_t *fixed_maze() {
+  maze_t *maze = calloc(1, sizeof(maze_t));
+  assert(maze != NULL);
+  maze->columns = 3;
+  maze->rows = 3;
+  maze->lower_left = (vector_t) {.x = 0, .y = 0};
+  maze->upper_right = (vector_t) {.x = 300, .y = 300};
+  maze->cell_walls = calloc(9, sizeof(uint8_t));
+  assert(maze->cell_walls != NULL);
+  for (size_t i = 0; i < 3; i++) {
+    maze->cell_walls[3 * i] |= WALL_LEFT;
+    maze->cell_walls[3 * i + 2] |= WALL_RIGHT;
+    maze->cell_walls[i] |= WALL_DOWN;
+    maze->cell_walls[6 + i] |= WALL_UP;
+  }
+  maze->cell_walls[3] |= WALL_RIGHT;
+  maze->cell_walls[4] |= WALL_LEFT;
+  return maze;
+}
+
+void free_fixed_maze(maze_t *maze) {
+  free(maze->cell_walls);
+  free(maze);
+}
+
+void test_raycast_border() {
+  maze_t *maze = fixed_maze();
+  vector_t hits[2];
+  size_t count = maze_raycast(maze, (vector_t) {.x = 50, .y = 50}, (vector_t) {.x = 2, .y = 1}, 2, 1, 1000, hits);
+  assert(count == 2);
+  assert(vec_isclose(hits[0], (vector_t) {.x = 295, .y = 172.5}));
+  assert(vec_isclose(hits[1], (vector_t) {.x = 50, .y = 295}));
+  free_fixed_maze(maze);
+}
+
+void test_raycast_end_point() {
+  maze_t *maze = fixed_maze();
+  vector_t hits[3];
+  size_t count = maze_raycast(maze, (vector_t) {.x = 50, .y = 50}, (vector_t) {.x = 0, .y = -1}, 0, 2, 100, hits);
+  assert(count == 2);
+  assert(vec_isclose(hits[0], (vector_t) {.x = 50, .y = 3}));
+  assert(vec_isclose(hits[1], (vector_t) {.x = 50, .y = 56}));
+  free_fixed_maze(maze);
+}
+
+// passing just below the inner wall, the ray meets the end cap reaching past it
+void test_raycast_end_cap_side() {
+  maze_t *maze = fixed_maze();
+  vector_t hits[2];
+  size_t count = maze_raycast(maze, (vector_t) {.x = 20, .y = 98.5}, (vector_t) {.x = 1, .y = 0}, 0, 1, 1000, hits);
+  assert(count == 2);
+  assert(vec_isclose(hits[0], (vector_t) {.x = 97, .y = 98.5}));
+  assert(vec_isclose(hits[1], (vector_t) {.x = 3, .y = 98.5}));
+  free_fixed_maze(maze);
+}
+
+void test_raycast_end_cap_front() {
+  maze_t *maze = fixed_maze();
+  vector_t hits[2];
+  size_t count = maze_raycast(maze, (vector_t) {.x = 101, .y = 20}, (vector_t) {.x = 0, .y = 1}, 1, 1, 1000, hits);
+  assert(count == 2);
+  assert(vec_isclose(hits[0], (vector_t) {.x = 101, .y = 96}));
+  assert(vec_isclose(hits[1], (vector_t) {.x = 101, .y = 4}));
+  free_fixed_maze(maze);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_raycast_border)
+  DO_TEST(test_raycast_end_point)
+  DO_TEST(test_raycast_end_cap_side)
+  DO_TEST(test_raycast_end_cap_front)
+
+  puts("maze_test PASS");
+}
@@ -0,0 +1,135 @@
+#include "netcode.h"
+#include "script.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+const double TEST_DT = 1. / 60.;
+
+/**
+ * Tells whether two snapshots hold the same match. The tick travels in the
+ * datagram header, not in the coded snapshot, so it is not compared.
+ */
+bool same_snapshot(const net_snapshot_t *a, const net_snapshot_t *b) {
+  return memcmp(a->match, b->match, sizeof(a->match)) == 0
+         && a->cell_count == b->cell_count
+         && memcmp(a->cell_walls, b->cell_walls, a->cell_count) == 0
+         && a->entity_count == b->entity_count
+         && memcmp(a->entities, b->entities, sizeof(net_entity_t) * a->entity_count) == 0;
+}
+
+/**
+ * Encodes a snapshot against a baseline, decodes it against the same
+ * baseline, and returns the number of bytes it took.
+ */
+size_t round_trip(const net_snapshot_t *snapshot, const net_snapshot_t *baseline, net_snapshot_t *decoded) {
+  uint8_t data[NET_MAX_DATAGRAM];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_snapshot_encode(&writer, snapshot, baseline);
+  assert(!writer.overflow);
+  net_reader_t reader = net_reader_init(data, writer.length);
+  assert(net_snapshot_decode(&reader, decoded, baseline));
+  assert(reader.offset == writer.length);
+  return writer.length;
+}
+
+void test_varints() {
+  const uint64_t unsigned_values[] = {0, 1, 127, 128, 300, UINT32_MAX, UINT64_MAX};
+  const int64_t signed_values[] = {0, -1, 1, -64, 64, INT32_MIN, INT64_MIN, INT64_MAX};
+  uint8_t data[64];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  for (size_t i = 0; i < 7; i++) {
+    net_put_varint(&writer, unsigned_values[i]);
+  }
+  for (size_t i = 0; i < 8; i++) {
+    net_put_svarint(&writer, signed_values[i]);
+  }
+  assert(!writer.overflow);
+  // small numbers of either sign take one byte
+  assert(data[0] == 0 && data[1] == 1 && data[2] == 127);
+
+  net_reader_t reader = net_reader_init(data, writer.length);
+  for (size_t i = 0; i < 7; i++) {
+    assert(net_get_varint(&reader) == unsigned_values[i]);
+  }
+  for (size_t i = 0; i < 8; i++) {
+    assert(net_get_svarint(&reader) == signed_values[i]);
+  }
+  assert(!reader.error && reader.offset == writer.length);
+  assert(net_get_u8(&reader) == 0 && reader.error);
+}
+
+void test_whole_snapshot_round_trip() {
+  state_t *state = game_init(game_default_config(3), audio_silent());
+  script_play(state, 300, TEST_DT);
+  net_snapshot_t *snapshot = net_snapshot_init();
+  net_snapshot_t *decoded = net_snapshot_init();
+  net_snapshot_capture(snapshot, state);
+  assert(snapshot->entity_count > 0);
+  round_trip(snapshot, NULL, decoded);
+  assert(same_snapshot(snapshot, decoded));
+  net_snapshot_free(snapshot);
+  net_snapshot_free(decoded);
+  game_free(state);
+}
+
+void test_delta_snapshot_round_trip() {
+  state_t *state = game_init(game_default_config(3), audio_silent());
+  script_play(state, 300, TEST_DT);
+  net_snapshot_t *baseline = net_snapshot_init();
+  net_snapshot_t *snapshot = net_snapshot_init();
+  net_snapshot_t *decoded = net_snapshot_init();
+  net_snapshot_capture(baseline, state);
+  for (size_t step = 0; step < 40; step++) {
+    script_play(state, 2, TEST_DT);
+    net_snapshot_capture(snapshot, state);
+    size_t delta = round_trip(snapshot, baseline, decoded);
+    assert(same_snapshot(snapshot, decoded));
+    size_t whole = round_trip(snapshot, NULL, decoded);
+    assert(same_snapshot(snapshot, decoded));
+    // a new maze changes every entity, so only within a game must the delta be smaller
+    if (snapshot->match[NET_MATCH_GENERATION] == baseline->match[NET_MATCH_GENERATION]) {
+      assert(delta < whole);
+    }
+    net_snapshot_copy(baseline, snapshot);
+  }
+  // against itself, a snapshot is an empty match mask and two zero counts
+  assert(round_trip(snapshot, snapshot, decoded) == 3);
+  assert(same_snapshot(snapshot, decoded));
+  net_snapshot_free(baseline);
+  net_snapshot_free(snapshot);
+  net_snapshot_free(decoded);
+  game_free(state);
+}
+
+void test_truncated_snapshot_is_rejected() {
+  state_t *state = game_init(game_default_config(5), audio_silent());
+  script_play(state, 200, TEST_DT);
+  net_snapshot_t *snapshot = net_snapshot_init();
+  net_snapshot_t *decoded = net_snapshot_init();
+  net_snapshot_capture(snapshot, state);
+  uint8_t data[NET_MAX_DATAGRAM];
+  net_writer_t writer = net_writer_init(data, sizeof(data));
+  net_snapshot_encode(&writer, snapshot, NULL);
+  net_reader_t reader = net_reader_init(data, writer.length - 1);
+  assert(!net_snapshot_decode(&reader, decoded, NULL));
+  net_snapshot_free(snapshot);
+  net_snapshot_free(decoded);
+  game_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_varints)
+  DO_TEST(test_whole_snapshot_round_trip)
+  DO_TEST(test_delta_snapshot_round_trip)
+  DO_TEST(test_truncated_snapshot_is_rejected)
+
+  puts("netcode_test PASS");
+}
@@ -0,0 +1,108 @@
+#include "raster.h"
+#include "script.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const double TEST_DT = 1. / 60.;
+#define TEST_MATCHES 3
+
+/**
+ * Plays matches side by side and checks after every tick that the batch
+ * updated in place matches a full redraw of every match.
+ */
+void check_update_matches_redraw(size_t pixels_per_cell, size_t ticks) {
+  state_t *states[TEST_MATCHES];
+  for (size_t i = 0; i < TEST_MATCHES; i++) {
+    states[i] = game_init(game_default_config(100 + i), audio_silent());
+  }
+  raster_shape_t shape = raster_shape(states[0]->maze, pixels_per_cell);
+  raster_t *raster = raster_init(shape, TEST_MATCHES);
+  uint8_t *redrawn = malloc(TEST_MATCHES * raster_size(shape));
+  assert(redrawn != NULL);
+  size_t generation = states[0]->maze_generation;
+  size_t new_mazes = 0;
+  for (size_t tick = 0; tick < ticks; tick++) {
+    for (size_t i = 0; i < TEST_MATCHES; i++) {
+      script_play(states[i], 1, TEST_DT);
+    }
+    if (states[0]->maze_generation != generation) {
+      generation = states[0]->maze_generation;
+      new_mazes++;
+    }
+    raster_update(raster, states);
+    raster_observe_batch(states, TEST_MATCHES, shape, redrawn);
+    assert(memcmp(raster->observations, redrawn, TEST_MATCHES * raster_size(shape)) == 0);
+  }
+  // the run must cover a new maze being drawn over an old one
+  assert(new_mazes > 0);
+  free(redrawn);
+  raster_free(raster);
+  for (size_t i = 0; i < TEST_MATCHES; i++) {
+    game_free(states[i]);
+  }
+}
+
+void test_update_matches_redraw_one_pixel() {
+  check_update_matches_redraw(1, 1500);
+}
+
+void test_update_matches_redraw_four_pixels() {
+  check_update_matches_redraw(4, 1500);
+}
+
+// a slot handed a different match is drawn in full, leaving nothing of the old one
+void test_update_after_swapping_matches() {
+  state_t *states[2];
+  for (size_t i = 0; i < 2; i++) {
+    states[i] = game_init(game_default_config(7 + i), audio_silent());
+    script_play(states[i], 200, TEST_DT);
+  }
+  raster_shape_t shape = raster_shape(states[0]->maze, 2);
+  raster_t *raster = raster_init(shape, 2);
+  uint8_t *redrawn = malloc(2 * raster_size(shape));
+  assert(redrawn != NULL);
+  raster_update(raster, states);
+  state_t *swapped[2] = {states[1], states[0]};
+  raster_update(raster, swapped);
+  raster_observe_batch(swapped, 2, shape, redrawn);
+  assert(memcmp(raster->observations, redrawn, 2 * raster_size(shape)) == 0);
+  free(redrawn);
+  raster_free(raster);
+  game_free(states[0]);
+  game_free(states[1]);
+}
+
+// with one pixel per cell, the wall plane holds each cell's wall bits
+void test_one_pixel_walls_are_cell_bits() {
+  state_t *state = game_init(game_default_config(1), audio_silent());
+  raster_shape_t shape = raster_shape(state->maze, 1);
+  assert(shape.width == state->maze->columns && shape.height == state->maze->rows);
+  uint8_t *out = malloc(raster_size(shape));
+  assert(out != NULL);
+  raster_observe(state, shape, out);
+  const uint8_t *walls = out + RASTER_WALLS * shape.width * shape.height;
+  for (size_t y = 0; y < shape.height; y++) {
+    for (size_t x = 0; x < shape.width; x++) {
+      assert(walls[y * shape.width + x] == state->maze->cell_walls[x + state->maze->columns * y]);
+    }
+  }
+  free(out);
+  game_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_update_matches_redraw_one_pixel)
+  DO_TEST(test_update_matches_redraw_four_pixels)
+  DO_TEST(test_update_after_swapping_matches)
+  DO_TEST(test_one_pixel_walls_are_cell_bits)
+
+  puts("raster_test PASS");
+}
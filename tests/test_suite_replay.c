@@ -0,0 +1,138 @@
+#include "game.h"
+#include "replay.h"
+#include "script.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+const char *TEST_REPLAY_PATH = "/tmp/test_suite_replay.ttr";
+const double TEST_DT = 1. / 60.;
+
+long file_size(const char *path) {
+  FILE *file = fopen(path, "rb");
+  assert(file != NULL);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+void test_ticks_round_trip() {
+  replay_header_t header = {.maze_columns = 8, .maze_rows = 6, .seed = 0x123456789abcdef};
+  replay_writer_t *writer = replay_writer_init(TEST_REPLAY_PATH, header);
+  assert(writer != NULL);
+  const int64_t dts[] = {16667, 16667, 16667, 33333, 1, 16667, 0, 100000};
+  for (size_t t = 0; t < 8; t++) {
+    for (size_t i = 0; i < t % 3; i++) {
+      replay_record_input(writer, (input_event_t){.player = t % INPUT_PLAYERS, .action = i, .pressed = t & 1});
+    }
+    replay_record_tick(writer, dts[t], 0x9e3779b9 * t);
+  }
+  replay_writer_free(writer);
+
+  replay_reader_t *reader = replay_reader_init(TEST_REPLAY_PATH);
+  assert(reader != NULL);
+  assert(reader->header.maze_columns == 8 && reader->header.maze_rows == 6);
+  assert(reader->header.seed == 0x123456789abcdef);
+  replay_tick_t tick;
+  for (size_t t = 0; t < 8; t++) {
+    assert(replay_read_tick(reader, &tick));
+    assert(tick.dt == dts[t] && tick.hash == (uint32_t)(0x9e3779b9 * t));
+    assert(tick.input_count == t % 3);
+    for (size_t i = 0; i < tick.input_count; i++) {
+      assert(tick.inputs[i].player == t % INPUT_PLAYERS && tick.inputs[i].action == i);
+      assert(tick.inputs[i].pressed == (bool)(t & 1));
+    }
+  }
+  assert(!replay_read_tick(reader, &tick));
+  replay_reader_free(reader);
+  remove(TEST_REPLAY_PATH);
+}
+
+// a tick with no inputs and the same dt as the one before is one byte of count plus the hash
+void test_steady_ticks_take_five_bytes() {
+  replay_header_t header = {.maze_columns = 8, .maze_rows = 6, .seed = 1};
+  replay_writer_t *writer = replay_writer_init(TEST_REPLAY_PATH, header);
+  replay_record_tick(writer, 16667, 0);
+  replay_writer_free(writer);
+  long one_tick = file_size(TEST_REPLAY_PATH);
+
+  writer = replay_writer_init(TEST_REPLAY_PATH, header);
+  for (size_t t = 0; t < 1001; t++) {
+    replay_record_tick(writer, 16667, t);
+  }
+  replay_writer_free(writer);
+  assert(file_size(TEST_REPLAY_PATH) - one_tick == 5 * 1000);
+  remove(TEST_REPLAY_PATH);
+}
+
+void test_cut_short_replay_ends() {
+  replay_header_t header = {.maze_columns = 8, .maze_rows = 6, .seed = 1};
+  replay_writer_t *writer = replay_writer_init(TEST_REPLAY_PATH, header);
+  for (size_t t = 0; t < 10; t++) {
+    replay_record_tick(writer, 16667, t);
+  }
+  replay_writer_free(writer);
+  assert(truncate(TEST_REPLAY_PATH, file_size(TEST_REPLAY_PATH) - 2) == 0);
+
+  replay_reader_t *reader = replay_reader_init(TEST_REPLAY_PATH);
+  assert(reader != NULL);
+  replay_tick_t tick;
+  size_t ticks = 0;
+  while (replay_read_tick(reader, &tick)) {
+    ticks++;
+  }
+  assert(ticks == 9);
+  replay_reader_free(reader);
+  remove(TEST_REPLAY_PATH);
+}
+
+// a recorded match played back from its file reaches the same hash after every tick
+void test_match_replays() {
+  state_t *state = game_init(game_default_config(44), audio_silent());
+  replay_writer_t *recorder = replay_writer_init(TEST_REPLAY_PATH, game_replay_header(state));
+  assert(recorder != NULL);
+  for (size_t t = 0; t < 3000; t++) {
+    script_play(state, 1, t % 7 == 0 ? 2 * TEST_DT : TEST_DT);
+    game_record_tick(state, recorder);
+  }
+  size_t ticks = state->tick;
+  size_t games = state->games_played;
+  replay_writer_free(recorder);
+  game_free(state);
+
+  replay_reader_t *reader = replay_reader_init(TEST_REPLAY_PATH);
+  assert(reader != NULL);
+  state = game_init(game_replay_config(reader->header), audio_silent());
+  replay_tick_t tick;
+  size_t inputs = 0;
+  while (replay_read_tick(reader, &tick)) {
+    inputs += tick.input_count;
+    for (size_t i = 0; i < tick.input_count; i++) {
+      game_apply_input(state, tick.inputs[i]);
+    }
+    game_tick(state, (double)tick.dt / REPLAY_DT_UNITS);
+    assert(game_hash(state) == tick.hash);
+  }
+  assert(state->tick == ticks && state->games_played == games && inputs > 0);
+  game_free(state);
+  replay_reader_free(reader);
+  remove(TEST_REPLAY_PATH);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_ticks_round_trip)
+  DO_TEST(test_steady_ticks_take_five_bytes)
+  DO_TEST(test_cut_short_replay_ends)
+  DO_TEST(test_match_replays)
+
+  puts("replay_test PASS");
+}
@@ -0,0 +1,71 @@
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+
+// the first outputs of xoshiro256** from the state {1, 2, 3, 4}, as its reference implementation gives them
+void test_next_known_answers() {
+  rng_t rng = {.s = {1, 2, 3, 4}};
+  assert(rng_next(&rng) == 11520);
+  assert(rng_next(&rng) == 0);
+  assert(rng_next(&rng) == 1509978240);
+  assert(rng_next(&rng) == 1215971899390074240);
+}
+
+// the state is the first four outputs of splitmix64 from the seed
+void test_init_known_answers() {
+  rng_t rng = rng_init(0);
+  assert(rng.s[0] == 0xe220a8397b1dcdaf);
+  assert(rng.s[1] == 0x6e789e6aa1b965f4);
+  assert(rng.s[2] == 0x06c45d188009454f);
+  assert(rng.s[3] == 0xf88bb8a8724c81ec);
+  assert(rng_next(&rng) == 0x99ec5f36cb75f2b4);
+  assert(rng_next(&rng) == 0xbf6e1f784956452a);
+}
+
+void test_jump_known_answers() {
+  rng_t rng = rng_init(0);
+  rng_jump(&rng);
+  assert(rng_next(&rng) == 0x376215edc846d62c);
+  assert(rng_next(&rng) == 0x57c0611de8350ca7);
+}
+
+void test_streams_are_jumps_apart() {
+  rng_streams_t streams = rng_streams_init(42);
+  rng_t expected = rng_init(42);
+  rng_t *ordered[] = {&streams.maze, &streams.spawns, &streams.powerups, &streams.events};
+  for (size_t i = 0; i < 4; i++) {
+    for (size_t k = 0; k < 4; k++) {
+      assert(ordered[i]->s[k] == expected.s[k]);
+    }
+    rng_jump(&expected);
+  }
+}
+
+void test_double_and_below() {
+  rng_t rng = rng_init(0);
+  rng_t copy = rng;
+  // 0x99ec5f36cb75f2b4 scaled to [0, 1) and to [0, 10)
+  assert(isclose(rng_double(&rng), 0.6012629994179048));
+  assert(rng_below(&copy, 10) == 6);
+  for (size_t i = 0; i < 100000; i++) {
+    double x = rng_double(&rng);
+    assert(0 <= x && x < 1);
+    assert(rng_below(&rng, 7) < 7);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_next_known_answers)
+  DO_TEST(test_init_known_answers)
+  DO_TEST(test_jump_known_answers)
+  DO_TEST(test_streams_are_jumps_apart)
+  DO_TEST(test_double_and_below)
+
+  puts("rng_test PASS");
+}
@@ -0,0 +1,140 @@
+#include "audio.h"
+#include "body.h"
+#include "game.h"
+#include "powerups.h"
+#include "savestate.h"
+#include "scene.h"
+#include "script.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+const double TEST_DT = 1. / 60.;
+const size_t TEST_WARMUP_TICKS = 300;
+const size_t TEST_REPLAY_TICKS = 120;
+
+state_t *played_state(uint64_t seed, size_t ticks) {
+  state_t *state = game_init(game_default_config(seed), audio_silent());
+  script_play(state, ticks, TEST_DT);
+  return state;
+}
+
+void test_restore_replays_same_hashes() {
+  state_t *state = played_state(3, TEST_WARMUP_TICKS);
+  savestate_t *savestate = savestate_init();
+  savestate_capture(savestate, state);
+  uint32_t saved_hash = game_hash(state);
+  uint32_t hashes[TEST_REPLAY_TICKS];
+  for (size_t i = 0; i < TEST_REPLAY_TICKS; i++) {
+    script_play(state, 1, TEST_DT);
+    hashes[i] = game_hash(state);
+  }
+
+  assert(savestate_restore(savestate, state));
+  assert(game_hash(state) == saved_hash);
+  for (size_t i = 0; i < TEST_REPLAY_TICKS; i++) {
+    script_play(state, 1, TEST_DT);
+    assert(game_hash(state) == hashes[i]);
+  }
+  savestate_free(savestate);
+  game_free(state);
+}
+
+void test_capture_is_repeatable() {
+  state_t *state = played_state(5, TEST_WARMUP_TICKS);
+  savestate_t *first = savestate_init();
+  savestate_t *second = savestate_init();
+  savestate_capture(first, state);
+  assert(savestate_restore(first, state));
+  savestate_capture(second, state);
+  assert(first->length == second->length);
+  assert(memcmp(first->data, second->data, first->length) == 0);
+  savestate_free(first);
+  savestate_free(second);
+  game_free(state);
+}
+
+/**
+ * Returns a cell center at least three tank lengths from every tank, where
+ * a powerup can sit through a tick untouched.
+ */
+vector_t clear_cell_center(state_t *state, size_t skip) {
+  for (size_t y = 0; y < state->maze->rows; y++) {
+    for (size_t x = 0; x < state->maze->columns; x++) {
+      vector_t center = cell_to_vector(state->maze, (cell_t) {.x = x, .y = y});
+      bool clear = true;
+      for (size_t i = 0; i < 3; i++) {
+        tank_t *tank = player_tank(state, i);
+        if (tank == NULL) {
+          continue;
+        }
+        vector_t offset = vec_subtract(body_get_center(tank->body), center);
+        if (sqrt(vec_dot(offset, offset)) < 3 * TANK_SIZE) {
+          clear = false;
+        }
+      }
+      if (clear && skip-- == 0) {
+        return center;
+      }
+    }
+  }
+  assert(false);
+  return VEC_ZERO;
+}
+
+/**
+ * Returns the types of the powerups in the order the scene holds them.
+ */
+size_t scene_powerup_types(state_t *state, powerup_type_t *types) {
+  size_t count = 0;
+  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
+    body_t *body = scene_get_body(state->scene, i);
+    for (size_t slot = 0; slot < state->powerups->capacity; slot++) {
+      if (state->powerups->bodies[slot] == body && !body_is_removed(body)) {
+        types[count] = state->powerups->pulses[slot]->type;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// the laser takes the second slot and the shotgun reuses the first, so slot order is not insertion order
+void test_restore_keeps_powerup_order() {
+  state_t *state = game_init(game_default_config(11), audio_silent());
+  state->count_down_until_next_powerup = INFINITY;
+  powerup_pulse_t *first = powerup_spawn(state, RAILGUN, clear_cell_center(state, 0));
+  powerup_pulse_t *laser = powerup_spawn(state, LASER, clear_cell_center(state, 1));
+  assert(first->slot < laser->slot);
+  body_remove(first->body);
+  game_tick(state, TEST_DT);
+  powerup_pulse_t *shotgun = powerup_spawn(state, SHOTGUN, clear_cell_center(state, 2));
+  assert(shotgun->slot < laser->slot);
+
+  powerup_type_t before[4];
+  assert(scene_powerup_types(state, before) == 2);
+  assert(before[0] == LASER && before[1] == SHOTGUN);
+  savestate_t *savestate = savestate_init();
+  savestate_capture(savestate, state);
+  assert(savestate_restore(savestate, state));
+  powerup_type_t after[4];
+  assert(scene_powerup_types(state, after) == 2);
+  assert(after[0] == LASER && after[1] == SHOTGUN);
+  savestate_free(savestate);
+  game_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  bool all_tests = argc == 1;
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_restore_replays_same_hashes)
+  DO_TEST(test_capture_is_repeatable)
+  DO_TEST(test_restore_keeps_powerup_order)
+
+  puts("savestate_test PASS");
+}
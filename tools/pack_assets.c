@@ -0,0 +1,19 @@
+#include "assets.h"
+#include <stdio.h>
+
+/**
+ * Packs the given files into an asset archive:
+ *   pack_assets assets.pak assets/normalshot.wav assets/soul_sanctum.ogg ...
+ * Run it from the directory the game runs in, since entries are named by path.
+ */
+int main(int argc, const char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <archive> <file>...\n", argv[0]);
+    return 1;
+  }
+  if (!assets_pack(argv[1], &argv[2], argc - 2)) {
+    return 1;
+  }
+  printf("Packed %d assets into %s\n", argc - 2, argv[1]);
+  return 0;
+}